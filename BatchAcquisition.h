@@ -187,6 +187,35 @@ enum ReconstructionMethod_
 
 
 
+//! Selects how arctangent is computed during phase estimation.
+/*!
+  Phase may be computed using the C runtime atan2 or using a fast vectorized
+  polynomial approximation with bounded error.
+*/
+typedef
+enum PhaseAtan2Method_
+  {
+    PHASE_ATAN2_LIBM, /*!< Use C runtime atan2. */
+    PHASE_ATAN2_FAST, /*!< Use fast vectorized polynomial approximation. */
+  } PhaseAtan2Method;
+
+
+
+//! Selects floating point precision of the MPS decoding.
+/*!
+  Wrapped phases and orthographic projections may be stored and computed in
+  double or in single precision. Nearest-constellation search and the output
+  absolute phase always use double precision.
+*/
+typedef
+enum MPSPrecision_
+  {
+    MPS_PRECISION_DOUBLE, /*!< Use double precision. */
+    MPS_PRECISION_SINGLE, /*!< Use single precision. */
+  } MPSPrecision;
+
+
+
 /****** PIXELS ******/
 
 /* Default pixel values for DirectX and WIC.
@@ -33,6 +33,7 @@
 
 
 #include "BatchAcquisitionImageConversion.h"
+#include "BatchAcquisitionImageDemosaic.h"
 #include "BatchAcquisitionDebug.h"
 
 
@@ -2423,77 +2424,26 @@ RawBufferToBGRcvMat(
       break;
 
     case IDT_8U_BayerGR:
-      {
-        cv::Mat msrc((int)(height), (int)(width), CV_8U, (void *)(src), (int)(stride));
-        mdst = new cv::Mat((int)(height), (int)(width), CV_8UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerGB2BGR);
-      }
-      break;
-
     case IDT_8U_BayerRG:
-      {
-        cv::Mat msrc((int)(height), (int)(width), CV_8U, (void *)(src), (int)(stride));
-        mdst = new cv::Mat((int)(height), (int)(width), CV_8UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerBG2BGR);
-      }
-      break;
-
     case IDT_8U_BayerGB:
-      {
-        cv::Mat msrc((int)(height), (int)(width), CV_8U, (void *)(src), (int)(stride));
-        mdst = new cv::Mat((int)(height), (int)(width), CV_8UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerGR2BGR);
-      }
-      break;
-
     case IDT_8U_BayerBG:
       {
         cv::Mat msrc((int)(height), (int)(width), CV_8U, (void *)(src), (int)(stride));
         mdst = new cv::Mat((int)(height), (int)(width), CV_8UC3);
         assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerRG2BGR);
+        if (NULL != mdst)
+          {
+            bool const demosaic = DemosaicBayer(&msrc, type, DEMOSAIC_BILINEAR, mdst);
+            assert(true == demosaic);
+            if (false == demosaic) SAFE_DELETE( mdst );
+          }
+        /* if */
       }
       break;
 
     case IDT_10U_BayerGR:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = ShiftLeftMono16(6, width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerGB2BGR);
-      }
-      break;
-
     case IDT_10U_BayerRG:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = ShiftLeftMono16(6, width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerBG2BGR);
-      }
-      break;
-
     case IDT_10U_BayerGB:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = ShiftLeftMono16(6, width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerGR2BGR);
-      }
-      break;
-
     case IDT_10U_BayerBG:
       {
         cv::Mat mtmp((int)(height), (int)(width), CV_16U);
@@ -2502,46 +2452,19 @@ RawBufferToBGRcvMat(
 
         mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
         assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerRG2BGR);
+        if (NULL != mdst)
+          {
+            bool const demosaic = DemosaicBayer(&mtmp, type, DEMOSAIC_BILINEAR, mdst);
+            assert(true == demosaic);
+            if (false == demosaic) SAFE_DELETE( mdst );
+          }
+        /* if */
       }
       break;
 
     case IDT_12U_BayerGR_Packed:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = Expand12BitTo16Bit(width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerGB2BGR);
-      }
-      break;
-
     case IDT_12U_BayerRG_Packed:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = Expand12BitTo16Bit(width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerBG2BGR);
-      }
-      break;
-
     case IDT_12U_BayerGB_Packed:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = Expand12BitTo16Bit(width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerGR2BGR);
-      }
-      break;
-
     case IDT_12U_BayerBG_Packed:
       {
         cv::Mat mtmp((int)(height), (int)(width), CV_16U);
@@ -2550,82 +2473,37 @@ RawBufferToBGRcvMat(
 
         mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
         assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerRG2BGR);
+        if (NULL != mdst)
+          {
+            bool const demosaic = DemosaicBayer(&mtmp, type, DEMOSAIC_BILINEAR, mdst);
+            assert(true == demosaic);
+            if (false == demosaic) SAFE_DELETE( mdst );
+          }
+        /* if */
       }
       break;
 
     case IDT_16U_BayerGR:
-      {
-        cv::Mat msrc((int)(height), (int)(width), CV_16U, (void *)(src), (int)(stride));
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerGB2BGR);
-      }
-      break;
-
     case IDT_16U_BayerRG:
-      {
-        cv::Mat msrc((int)(height), (int)(width), CV_16U, (void *)(src), (int)(stride));
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerBG2BGR);
-      }
-      break;
-
     case IDT_16U_BayerGB:
-      {
-        cv::Mat msrc((int)(height), (int)(width), CV_16U, (void *)(src), (int)(stride));
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerGR2BGR);
-      }
-      break;
-
     case IDT_16U_BayerBG:
       {
         cv::Mat msrc((int)(height), (int)(width), CV_16U, (void *)(src), (int)(stride));
         mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
         assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(msrc, *(mdst), cv::COLOR_BayerRG2BGR);
+        if (NULL != mdst)
+          {
+            bool const demosaic = DemosaicBayer(&msrc, type, DEMOSAIC_BILINEAR, mdst);
+            assert(true == demosaic);
+            if (false == demosaic) SAFE_DELETE( mdst );
+          }
+        /* if */
       }
       break;
 
     case IDT_16U_BayerGR_BigEndian:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = SwapBytesMono16(width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerGB2BGR);
-      }
-      break;
-
     case IDT_16U_BayerRG_BigEndian:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = SwapBytesMono16(width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerBG2BGR);
-      }
-      break;
-
     case IDT_16U_BayerGB_BigEndian:
-      {
-        cv::Mat mtmp((int)(height), (int)(width), CV_16U);
-        HRESULT const hr = SwapBytesMono16(width, height, stride, src, (unsigned int)(mtmp.step[0]), mtmp.data);
-        assert( SUCCEEDED(hr) );
-
-        mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
-        assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerGR2BGR);
-      }
-      break;
-
     case IDT_16U_BayerBG_BigEndian:
       {
         cv::Mat mtmp((int)(height), (int)(width), CV_16U);
@@ -2634,7 +2512,13 @@ RawBufferToBGRcvMat(
 
         mdst = new cv::Mat((int)(height), (int)(width), CV_16UC3);
         assert(NULL != mdst);
-        if (NULL != mdst) cv::cvtColor(mtmp, *(mdst), cv::COLOR_BayerRG2BGR);
+        if (NULL != mdst)
+          {
+            bool const demosaic = DemosaicBayer(&mtmp, type, DEMOSAIC_BILINEAR, mdst);
+            assert(true == demosaic);
+            if (false == demosaic) SAFE_DELETE( mdst );
+          }
+        /* if */
       }
       break;
 
@@ -0,0 +1,622 @@
+/*
+ * UniZG - FER
+ * University of Zagreb (http://www.unizg.hr/)
+ * Faculty of Electrical Engineering and Computing (http://www.fer.unizg.hr/)
+ * Unska 3, HR-10000 Zagreb, Croatia
+ *
+ * (c) 2026 UniZG, Zagreb. All rights reserved.
+ * (c) 2026 FER, Zagreb. All rights reserved.
+ */
+
+/*!
+  \file   BatchAcquisitionImageDemosaic.cpp
+  \brief  Bayer demosaicing.
+
+  Demosaicing engine for all IDT_*_Bayer* pixel formats. Input image must be
+  decoded to one of CV_8UC1, CV_16UC1, or CV_32FC1 types and output may be
+  any of CV_8UC3, CV_16UC3, or CV_32FC3 types; single precision output is
+  intended for texture accumulators which should not be rounded before
+  scaling.
+
+  Image is processed in bands of rows in parallel. Each band converts its
+  rows, including a border of DEMOSAIC_BORDER rows and columns which is
+  filled by reflection, to single precision using SSE2 for 8-bit and 16-bit
+  inputs. Reflection preserves the parity of Bayer pattern so border pixels
+  are interpolated in the same way as interior ones.
+
+  Two methods are available:
+
+  DEMOSAIC_BILINEAR   missing colors are averages of the nearest neighbours
+  of the same color; this is the method used by OpenCV;
+
+  DEMOSAIC_EDGE_AWARE green is interpolated along the direction of the
+  smaller gradient using the Hamilton-Adams estimator, and red and blue
+  are interpolated from color differences with respect to green.
+
+  \author agent
+  \date   2026-10-16
+*/
+
+
+#include "BatchAcquisitionStdAfx.h"
+
+
+#ifndef __BATCHACQUISITIONIMAGEDEMOSAIC_CPP
+#define __BATCHACQUISITIONIMAGEDEMOSAIC_CPP
+
+
+#include "BatchAcquisitionImageDemosaic.h"
+
+
+
+//! Width of the border which is added around each band.
+#define DEMOSAIC_BORDER 3
+
+//! Number of rows in one demosaicing band.
+#define DEMOSAIC_BAND_HEIGHT 64
+
+
+
+/****** HELPER FUNCTIONS ******/
+
+//! Gets position of red pixel in Bayer pattern.
+/*!
+  Returns position of red pixel in the top-left 2x2 block of the Bayer pattern.
+  Blue pixel is diagonal to the red one and the remaining two pixels are green.
+
+  \param type   Image data type; must be one of IDT_*_Bayer* types.
+  \param rx     Address where column parity of red pixel will be stored.
+  \param ry     Address where row parity of red pixel will be stored.
+  \return Returns true if successfull, false otherwise.
+*/
+inline
+bool
+GetBayerRedPosition_inline(
+                           ImageDataType const type,
+                           int * const rx,
+                           int * const ry
+                           )
+{
+  assert( (NULL != rx) && (NULL != ry) );
+  if ( (NULL == rx) || (NULL == ry) ) return false;
+
+  switch (type)
+    {
+    case IDT_8U_BayerGR:
+    case IDT_10U_BayerGR:
+    case IDT_12U_BayerGR_Packed:
+    case IDT_16U_BayerGR:
+    case IDT_16U_BayerGR_BigEndian:
+      *rx = 1;
+      *ry = 0;
+      return true;
+
+    case IDT_8U_BayerRG:
+    case IDT_10U_BayerRG:
+    case IDT_12U_BayerRG_Packed:
+    case IDT_16U_BayerRG:
+    case IDT_16U_BayerRG_BigEndian:
+      *rx = 0;
+      *ry = 0;
+      return true;
+
+    case IDT_8U_BayerGB:
+    case IDT_10U_BayerGB:
+    case IDT_12U_BayerGB_Packed:
+    case IDT_16U_BayerGB:
+    case IDT_16U_BayerGB_BigEndian:
+      *rx = 0;
+      *ry = 1;
+      return true;
+
+    case IDT_8U_BayerBG:
+    case IDT_10U_BayerBG:
+    case IDT_12U_BayerBG_Packed:
+    case IDT_16U_BayerBG:
+    case IDT_16U_BayerBG_BigEndian:
+      *rx = 1;
+      *ry = 1;
+      return true;
+    }
+  /* switch */
+
+  return false;
+}
+/* GetBayerRedPosition_inline */
+
+
+
+//! Reflects index.
+/*!
+  Reflects index about the first and the last element without repeating them.
+  Reflection is valid only for indices which are less than n elements away
+  from the valid range.
+
+  \param i      Index.
+  \param n      Number of elements.
+  \return Returns reflected index in range [0, n-1].
+*/
+inline
+int
+ReflectIndex_inline(
+                    int const i,
+                    int const n
+                    )
+{
+  if (0 > i) return -i;
+  if (n <= i) return 2 * n - 2 - i;
+  return i;
+}
+/* ReflectIndex_inline */
+
+
+
+//! Converts row to single precision.
+/*!
+  Converts row of n elements to single precision.
+
+  \param src    Pointer to source row.
+  \param dst    Pointer to destination row.
+  \param n      Number of elements.
+*/
+template <typename T>
+inline
+void
+ConvertRowToFloat_inline(
+                         T const * const src,
+                         float * const dst,
+                         int const n
+                         )
+{
+  for (int x = 0; x < n; ++x) dst[x] = (float)( src[x] );
+}
+/* ConvertRowToFloat_inline */
+
+
+
+//! Converts 8-bit row to single precision.
+/*!
+  Converts row of n unsigned 8-bit elements to single precision using SSE2.
+
+  \param src    Pointer to source row.
+  \param dst    Pointer to destination row.
+  \param n      Number of elements.
+*/
+template <>
+inline
+void
+ConvertRowToFloat_inline<unsigned char>(
+                                        unsigned char const * const src,
+                                        float * const dst,
+                                        int const n
+                                        )
+{
+  __m128i const zero = _mm_setzero_si128();
+
+  int x = 0;
+  int const max_x = n - 15;
+  for (; x < max_x; x += 16)
+    {
+      __m128i const v8 = _mm_loadu_si128( (__m128i const *)(src + x) );
+      __m128i const lo16 = _mm_unpacklo_epi8(v8, zero);
+      __m128i const hi16 = _mm_unpackhi_epi8(v8, zero);
+      _mm_storeu_ps( dst + x     , _mm_cvtepi32_ps( _mm_unpacklo_epi16(lo16, zero) ) );
+      _mm_storeu_ps( dst + x +  4, _mm_cvtepi32_ps( _mm_unpackhi_epi16(lo16, zero) ) );
+      _mm_storeu_ps( dst + x +  8, _mm_cvtepi32_ps( _mm_unpacklo_epi16(hi16, zero) ) );
+      _mm_storeu_ps( dst + x + 12, _mm_cvtepi32_ps( _mm_unpackhi_epi16(hi16, zero) ) );
+    }
+  /* for */
+
+  // Complete to end.
+  for (; x < n; ++x) dst[x] = (float)( src[x] );
+}
+/* ConvertRowToFloat_inline<unsigned char> */
+
+
+
+//! Converts 16-bit row to single precision.
+/*!
+  Converts row of n unsigned 16-bit elements to single precision using SSE2.
+
+  \param src    Pointer to source row.
+  \param dst    Pointer to destination row.
+  \param n      Number of elements.
+*/
+template <>
+inline
+void
+ConvertRowToFloat_inline<unsigned short>(
+                                         unsigned short const * const src,
+                                         float * const dst,
+                                         int const n
+                                         )
+{
+  __m128i const zero = _mm_setzero_si128();
+
+  int x = 0;
+  int const max_x = n - 7;
+  for (; x < max_x; x += 8)
+    {
+      __m128i const v16 = _mm_loadu_si128( (__m128i const *)(src + x) );
+      _mm_storeu_ps( dst + x    , _mm_cvtepi32_ps( _mm_unpacklo_epi16(v16, zero) ) );
+      _mm_storeu_ps( dst + x + 4, _mm_cvtepi32_ps( _mm_unpackhi_epi16(v16, zero) ) );
+    }
+  /* for */
+
+  // Complete to end.
+  for (; x < n; ++x) dst[x] = (float)( src[x] );
+}
+/* ConvertRowToFloat_inline<unsigned short> */
+
+
+
+//! Fetches padded row.
+/*!
+  Converts image row to single precision and fills DEMOSAIC_BORDER elements
+  on both sides of the row by reflection. Row index is reflected if it is
+  outside of the image.
+
+  \param src    Pointer to source image (CV_8UC1, CV_16UC1, or CV_32FC1).
+  \param y      Row index; may be up to DEMOSAIC_BORDER rows outside of the image.
+  \param row    Pointer to output row which has src->cols + 2 * DEMOSAIC_BORDER elements.
+  \return Returns true if successfull, false otherwise.
+*/
+inline
+bool
+FetchPaddedRow_inline(
+                      cv::Mat const * const src,
+                      int const y,
+                      float * const row
+                      )
+{
+  int const cols = src->cols;
+  int const yr = ReflectIndex_inline(y, src->rows);
+  void const * const src_row = (void *)( (BYTE *)(src->data) + src->step[0] * yr );
+  float * const dst = row + DEMOSAIC_BORDER;
+
+  switch ( src->depth() )
+    {
+    case CV_8U: ConvertRowToFloat_inline<unsigned char>( (unsigned char const *)src_row, dst, cols ); break;
+    case CV_16U: ConvertRowToFloat_inline<unsigned short>( (unsigned short const *)src_row, dst, cols ); break;
+    case CV_32F: memcpy( dst, src_row, sizeof(float) * cols ); break;
+    default: return false;
+    }
+  /* switch */
+
+  for (int k = 1; k <= DEMOSAIC_BORDER; ++k)
+    {
+      dst[-k] = dst[k];
+      dst[cols - 1 + k] = dst[cols - 1 - k];
+    }
+  /* for */
+
+  return true;
+}
+/* FetchPaddedRow_inline */
+
+
+
+//! Stores single precision row.
+/*!
+  Stores row of n single precision elements to row of the requested depth.
+  Conversion to 8-bit and 16-bit unsigned integers is done using SSE2 and
+  values are rounded and saturated in the same way as by cv::saturate_cast.
+
+  \param src    Pointer to source row.
+  \param dst    Pointer to destination row.
+  \param depth  Destination depth; one of CV_8U, CV_16U, or CV_32F.
+  \param n      Number of elements.
+*/
+inline
+void
+StoreRowFromFloat_inline(
+                         float const * const src,
+                         void * const dst,
+                         int const depth,
+                         int const n
+                         )
+{
+  int x = 0;
+  int const max_x = n - 7;
+
+  switch (depth)
+    {
+    case CV_8U:
+      {
+        unsigned char * const dst_row = (unsigned char *)(dst);
+        __m128 const min_value = _mm_setzero_ps();
+        __m128 const max_value = _mm_set1_ps(255.0f);
+        for (; x < max_x; x += 8)
+          {
+            __m128i const lo = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_loadu_ps(src + x    ), min_value ), max_value ) );
+            __m128i const hi = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_loadu_ps(src + x + 4), min_value ), max_value ) );
+            __m128i const v16 = _mm_packs_epi32(lo, hi);
+            _mm_storel_epi64( (__m128i *)(dst_row + x), _mm_packus_epi16(v16, v16) );
+          }
+        /* for */
+        for (; x < n; ++x) dst_row[x] = cv::saturate_cast<unsigned char>( src[x] );
+      }
+      break;
+
+    case CV_16U:
+      {
+        // SSE2 has no unsigned 32-bit to 16-bit pack so values are biased to signed range.
+        unsigned short * const dst_row = (unsigned short *)(dst);
+        __m128 const min_value = _mm_setzero_ps();
+        __m128 const max_value = _mm_set1_ps(65535.0f);
+        __m128i const bias32 = _mm_set1_epi32(32768);
+        __m128i const bias16 = _mm_set1_epi16( (short)(0x8000) );
+        for (; x < max_x; x += 8)
+          {
+            __m128i const lo = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_loadu_ps(src + x    ), min_value ), max_value ) );
+            __m128i const hi = _mm_cvtps_epi32( _mm_min_ps( _mm_max_ps( _mm_loadu_ps(src + x + 4), min_value ), max_value ) );
+            __m128i const v16 = _mm_packs_epi32( _mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32) );
+            _mm_storeu_si128( (__m128i *)(dst_row + x), _mm_xor_si128(v16, bias16) );
+          }
+        /* for */
+        for (; x < n; ++x) dst_row[x] = cv::saturate_cast<unsigned short>( src[x] );
+      }
+      break;
+
+    case CV_32F:
+      memcpy( dst, src, sizeof(float) * n );
+      break;
+    }
+  /* switch */
+}
+/* StoreRowFromFloat_inline */
+
+
+
+/****** DEMOSAICING ******/
+
+//! Parallel demosaicing.
+/*!
+  Each invocation demosaics one band of rows. Band rows together with
+  DEMOSAIC_BORDER rows above and below are converted to single precision
+  into a per-invocation buffer. For edge-aware method the full green
+  channel is first interpolated for band rows and one row above and below,
+  and red and blue are then interpolated using color differences.
+*/
+struct DemosaicBayerParallel_ : public cv::ParallelLoopBody
+{
+  cv::Mat const * src; //!< Input Bayer image (CV_8UC1, CV_16UC1, or CV_32FC1).
+  cv::Mat * dst; //!< Output BGR image (CV_8UC3, CV_16UC3, or CV_32FC3).
+  int rx; //!< Column parity of red pixels.
+  int ry; //!< Row parity of red pixels.
+  DemosaicMethod method; //!< Demosaicing method.
+
+  //! Constructor.
+  DemosaicBayerParallel_(
+                         cv::Mat const * const src_in,
+                         cv::Mat * const dst_in,
+                         int const rx_in,
+                         int const ry_in,
+                         DemosaicMethod const method_in
+                         )
+  {
+    this->src = src_in;
+    this->dst = dst_in;
+    this->rx = rx_in;
+    this->ry = ry_in;
+    this->method = method_in;
+  }
+
+  //! Demosaics a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const cols = this->src->cols;
+    int const num_rows = r.end - r.start;
+    int const depth = this->dst->depth();
+    bool const edge_aware = (DEMOSAIC_EDGE_AWARE == this->method);
+
+    int const raw_step = cols + 2 * DEMOSAIC_BORDER;
+    int const raw_rows = num_rows + 2 * DEMOSAIC_BORDER;
+    int const green_step = cols + 2;
+    int const green_rows = num_rows + 2;
+
+    float * raw = new float[raw_rows * raw_step];
+    float * green = (true == edge_aware)? new float[green_rows * green_step] : NULL;
+    float * bgr = new float[3 * cols];
+    assert( (NULL != raw) && ( (false == edge_aware) || (NULL != green) ) && (NULL != bgr) );
+
+    bool const allocated = (NULL != raw) && ( (false == edge_aware) || (NULL != green) ) && (NULL != bgr);
+    if (true == allocated)
+      {
+        // Fetch band rows including the border.
+        for (int i = 0; i < raw_rows; ++i)
+          {
+            bool const fetched = FetchPaddedRow_inline(this->src, r.start - DEMOSAIC_BORDER + i, raw + raw_step * i);
+            assert(true == fetched);
+          }
+        /* for */
+
+        // Interpolate green along the direction of the smaller gradient.
+        if (true == edge_aware)
+          {
+            for (int i = 0; i < green_rows; ++i)
+              {
+                int const y = r.start - 1 + i;
+                float const * const c0 = raw + raw_step * (i - 1 + DEMOSAIC_BORDER) + DEMOSAIC_BORDER;
+                float const * const cm1 = c0 - raw_step;
+                float const * const cm2 = c0 - 2 * raw_step;
+                float const * const cp1 = c0 + raw_step;
+                float const * const cp2 = c0 + 2 * raw_step;
+                float * const g = green + green_step * i + 1;
+                int const gx = ( (y & 1) == this->ry )? 1 - this->rx : this->rx;
+
+                for (int x = -1; x <= cols; ++x)
+                  {
+                    if ( gx == (x & 1) )
+                      {
+                        g[x] = c0[x];
+                      }
+                    else
+                      {
+                        float const lh = 2.0f * c0[x] - c0[x - 2] - c0[x + 2];
+                        float const lv = 2.0f * c0[x] - cm2[x] - cp2[x];
+                        float const dh = fabs(c0[x - 1] - c0[x + 1]) + fabs(lh);
+                        float const dv = fabs(cm1[x] - cp1[x]) + fabs(lv);
+                        float const gh = 0.5f * (c0[x - 1] + c0[x + 1]) + 0.25f * lh;
+                        float const gv = 0.5f * (cm1[x] + cp1[x]) + 0.25f * lv;
+                        g[x] = (dh < dv)? gh : ( (dv < dh)? gv : 0.5f * (gh + gv) );
+                      }
+                    /* if */
+                  }
+                /* for */
+              }
+            /* for */
+          }
+        /* if */
+
+        // Interpolate all colors and store output rows.
+        for (int y = r.start; y < r.end; ++y)
+          {
+            int const i = y - r.start;
+            float const * const c0 = raw + raw_step * (i + DEMOSAIC_BORDER) + DEMOSAIC_BORDER;
+            float const * const cm1 = c0 - raw_step;
+            float const * const cp1 = c0 + raw_step;
+            float const * const g0 = (true == edge_aware)? green + green_step * (i + 1) + 1 : NULL;
+            float const * const gm1 = (true == edge_aware)? g0 - green_step : NULL;
+            float const * const gp1 = (true == edge_aware)? g0 + green_step : NULL;
+
+            bool const red_row = ( (y & 1) == this->ry );
+            int const gx = (true == red_row)? 1 - this->rx : this->rx;
+
+            for (int x = 0; x < cols; ++x)
+              {
+                float R = 0.0f;
+                float G = 0.0f;
+                float B = 0.0f;
+
+                if ( gx == (x & 1) )
+                  {
+                    // Green pixel; horizontal neighbours are red in red rows and blue otherwise.
+                    float h = 0.0f;
+                    float v = 0.0f;
+                    G = c0[x];
+                    if (true == edge_aware)
+                      {
+                        h = G + 0.5f * ( (c0[x - 1] - g0[x - 1]) + (c0[x + 1] - g0[x + 1]) );
+                        v = G + 0.5f * ( (cm1[x] - gm1[x]) + (cp1[x] - gp1[x]) );
+                      }
+                    else
+                      {
+                        h = 0.5f * (c0[x - 1] + c0[x + 1]);
+                        v = 0.5f * (cm1[x] + cp1[x]);
+                      }
+                    /* if */
+                    R = (true == red_row)? h : v;
+                    B = (true == red_row)? v : h;
+                  }
+                else
+                  {
+                    // Red or blue pixel; diagonal neighbours have the other color.
+                    float d = 0.0f;
+                    if (true == edge_aware)
+                      {
+                        G = g0[x];
+                        d = G + 0.25f * (
+                                         (cm1[x - 1] - gm1[x - 1]) + (cm1[x + 1] - gm1[x + 1]) +
+                                         (cp1[x - 1] - gp1[x - 1]) + (cp1[x + 1] - gp1[x + 1])
+                                         );
+                      }
+                    else
+                      {
+                        G = 0.25f * (c0[x - 1] + c0[x + 1] + cm1[x] + cp1[x]);
+                        d = 0.25f * (cm1[x - 1] + cm1[x + 1] + cp1[x - 1] + cp1[x + 1]);
+                      }
+                    /* if */
+                    R = (true == red_row)? c0[x] : d;
+                    B = (true == red_row)? d : c0[x];
+                  }
+                /* if */
+
+                bgr[3 * x    ] = B;
+                bgr[3 * x + 1] = G;
+                bgr[3 * x + 2] = R;
+              }
+            /* for */
+
+            void * const dst_row = (void *)( (BYTE *)(this->dst->data) + this->dst->step[0] * y );
+            StoreRowFromFloat_inline(bgr, dst_row, depth, 3 * cols);
+          }
+        /* for */
+      }
+    /* if */
+
+    SAFE_DELETE_ARRAY( raw );
+    SAFE_DELETE_ARRAY( green );
+    SAFE_DELETE_ARRAY( bgr );
+  }
+};
+/* DemosaicBayerParallel_ */
+
+
+
+//! Demosaic Bayer image.
+/*!
+  Function demosaics Bayer image. Bayer pattern is determined from the image
+  data type. Input must be decoded to CV_8UC1, CV_16UC1, or CV_32FC1 type,
+  e.g. 10-bit and 12-bit packed formats must first be expanded to 16 bits.
+  Output must be preallocated and must have the same size as the input; its
+  type determines output depth and may be CV_8UC3, CV_16UC3, or CV_32FC3.
+  Channels are stored in BGR order.
+
+  \param src    Pointer to input Bayer image.
+  \param type   Image data type; must be one of IDT_*_Bayer* types.
+  \param method Demosaicing method.
+  \param dst    Pointer to preallocated output image.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+DemosaicBayer(
+              cv::Mat const * const src,
+              ImageDataType const type,
+              DemosaicMethod const method,
+              cv::Mat * const dst
+              )
+{
+  assert( (NULL != src) && (NULL != src->data) );
+  if ( (NULL == src) || (NULL == src->data) ) return false;
+
+  assert( (NULL != dst) && (NULL != dst->data) );
+  if ( (NULL == dst) || (NULL == dst->data) ) return false;
+
+  int const src_depth = src->depth();
+  bool const src_supported = (1 == src->channels()) && ( (CV_8U == src_depth) || (CV_16U == src_depth) || (CV_32F == src_depth) );
+  assert(true == src_supported);
+  if (false == src_supported) return false;
+
+  int const dst_depth = dst->depth();
+  bool const dst_supported = (3 == dst->channels()) && ( (CV_8U == dst_depth) || (CV_16U == dst_depth) || (CV_32F == dst_depth) );
+  assert(true == dst_supported);
+  if (false == dst_supported) return false;
+
+  assert( (src->rows == dst->rows) && (src->cols == dst->cols) );
+  if ( (src->rows != dst->rows) || (src->cols != dst->cols) ) return false;
+
+  // Reflection of the border requires image to be larger than the border.
+  assert( (DEMOSAIC_BORDER < src->rows) && (DEMOSAIC_BORDER < src->cols) );
+  if ( (DEMOSAIC_BORDER >= src->rows) || (DEMOSAIC_BORDER >= src->cols) ) return false;
+
+  int rx = 0;
+  int ry = 0;
+  bool const have_pattern = GetBayerRedPosition_inline(type, &rx, &ry);
+  assert(true == have_pattern);
+  if (false == have_pattern) return false;
+
+  // Process bands of rows in parallel.
+  {
+    int const rows = src->rows;
+    DemosaicBayerParallel_ body(src, dst, rx, ry, method);
+    cv::parallel_for_( cv::Range(0, rows), body, (double)(rows) / (double)(DEMOSAIC_BAND_HEIGHT) );
+  }
+
+  return true;
+}
+/* DemosaicBayer */
+
+
+
+#endif /* !__BATCHACQUISITIONIMAGEDEMOSAIC_CPP */
@@ -0,0 +1,46 @@
+/*
+ * UniZG - FER
+ * University of Zagreb (http://www.unizg.hr/)
+ * Faculty of Electrical Engineering and Computing (http://www.fer.unizg.hr/)
+ * Unska 3, HR-10000 Zagreb, Croatia
+ *
+ * (c) 2026 UniZG, Zagreb. All rights reserved.
+ * (c) 2026 FER, Zagreb. All rights reserved.
+ */
+
+/*!
+  \file   BatchAcquisitionImageDemosaic.h
+  \brief  Bayer demosaicing.
+
+  Multi-threaded demosaicing of Bayer images which supports 8-bit, 16-bit,
+  and single precision input and output.
+
+  \author agent
+  \date   2026-10-16
+*/
+
+
+#ifndef __BATCHACQUISITIONIMAGEDEMOSAIC_H
+#define __BATCHACQUISITIONIMAGEDEMOSAIC_H
+
+
+#include "BatchAcquisition.h"
+
+
+
+//! Demosaicing methods.
+typedef
+enum DemosaicMethod_
+  {
+    DEMOSAIC_BILINEAR, /*!< Bilinear interpolation of all color channels. */
+    DEMOSAIC_EDGE_AWARE /*!< Edge-directed green interpolation followed by color difference interpolation of red and blue. */
+  } DemosaicMethod;
+
+
+
+//! Demosaic Bayer image.
+bool DemosaicBayer(cv::Mat const * const, ImageDataType const, DemosaicMethod const, cv::Mat * const);
+
+
+
+#endif /* !__BATCHACQUISITIONIMAGEDEMOSAIC_H */
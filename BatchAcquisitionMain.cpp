@@ -38,6 +38,10 @@
 #include "BatchAcquisitionSwapChain.h"
 #include "BatchAcquisitionKeyboard.h"
 #include "BatchAcquisitionVTK.h"
+#include "BatchAcquisitionProcessingPhaseShift.h"
+#include "BatchAcquisitionProcessingMethod.h"
+#include "BatchAcquisitionProcessingDistortion.h"
+#include "BatchAcquisitionProcessingTriangulation.h"
 #include "BatchAcquisitionWindowStorage.h"
 
 #include "conio.h"
@@ -2369,6 +2373,16 @@ _tmain(
   // Parameters for 3D reconstruction.
   double rel_thr = 0.02;
   double dst_thr = 25.0;
+  int stat_win = 5;
+  PhaseAtan2Method atan2_method = PHASE_ATAN2_LIBM;
+  MPSPrecision mps_precision = MPS_PRECISION_DOUBLE;
+  int max_concurrent = RECONSTRUCTION_MAX_CONCURRENT_CAMERAS;
+  int roi_x = 0;
+  int roi_y = 0;
+  int roi_w = 0;
+  int roi_h = 0;
+  cv::Mat * roi_mask = NULL;
+  std::wstring default_method = L"MPS 3PS(n20)+3PS(n21)+3PS(n25) column row";
 
   // Print main menu.
   wprintf(L"\n");
@@ -5260,7 +5274,7 @@ _tmain(
 
                 // Print reconstruction method selection message.
                 {
-                  int const cnt = wprintf(gMsgReconstructionMenu);
+                  int const cnt = wprintf(gMsgReconstructionMenu, default_method.c_str());
                   assert(0 < cnt);
                 }
 
@@ -5289,13 +5303,63 @@ _tmain(
                     }
 
                     {
-                      int const cnt = wprintf(gMsgReconstructionMenuConfigurationParameters, rel_thr, dst_thr);
+                      int const cnt = wprintf(
+                                              gMsgReconstructionMenuConfigurationParameters,
+                                              rel_thr, dst_thr, (PHASE_ATAN2_FAST == atan2_method)? L"fast" : L"atan2", default_method.c_str(),
+                                              (MPS_PRECISION_SINGLE == mps_precision)? L"single" : L"double",
+                                              roi_x, roi_y, roi_w, roi_h,
+                                              (NULL != roi_mask)? L"loaded" : L"none",
+                                              max_concurrent,
+                                              stat_win
+                                              );
                       assert(0 < cnt);
                     }
 
-                    int const pressed_key = TimedWaitForNumberKey(timeout_ms, 10, true, true, (HWND)NULL);
+                    // Number keys select items 0 to 9 and letter keys select the remaining items.
+                    wchar_t const * const keys = L"0123456789CW";
+                    int const pressed_key = TimedWaitForSelectedKeys(timeout_ms, 10, NULL, (wint_t const *)keys, 12);
 
-                    if (1 == pressed_key)
+                    if (10 == pressed_key)
+                      {
+                        int const max_concurrent_old = max_concurrent;
+
+                        wprintf(gMsgReconstructionConfigurationConcurrencyPrint, max_concurrent_old);
+
+                        wprintf(gMsgReconstructionConfigurationConcurrencyQuery);
+                        int max_concurrent_new = max_concurrent_old;
+                        int const scan = scanf_s("%d", &max_concurrent_new);
+                        if ( (1 == scan) && (1 <= max_concurrent_new) && (max_concurrent_new != max_concurrent_old) )
+                          {
+                            max_concurrent = max_concurrent_new;
+                            wprintf(gMsgReconstructionConfigurationConcurrencyChanged, max_concurrent_old, max_concurrent_new);
+                          }
+                        else
+                          {
+                            wprintf(gMsgReconstructionConfigurationConcurrencyNotChanged, max_concurrent_old);
+                          }
+                        /* if */
+                      }
+                    else if (11 == pressed_key)
+                      {
+                        int const stat_win_old = stat_win;
+
+                        wprintf(gMsgReconstructionConfigurationStatisticsWindowPrint, stat_win_old, stat_win_old);
+
+                        wprintf(gMsgReconstructionConfigurationStatisticsWindowQuery);
+                        int stat_win_new = stat_win_old;
+                        int const scan = scanf_s("%d", &stat_win_new);
+                        if ( (1 == scan) && (3 <= stat_win_new) && (1 == stat_win_new % 2) && (stat_win_new != stat_win_old) )
+                          {
+                            stat_win = stat_win_new;
+                            wprintf(gMsgReconstructionConfigurationStatisticsWindowChanged, stat_win_old, stat_win_old, stat_win_new, stat_win_new);
+                          }
+                        else
+                          {
+                            wprintf(gMsgReconstructionConfigurationStatisticsWindowNotChanged, stat_win_old, stat_win_old);
+                          }
+                        /* if */
+                      }
+                    else if (1 == pressed_key)
                       {
                         double const rel_thr_old = rel_thr;
 
@@ -5335,6 +5399,168 @@ _tmain(
                           }
                         /* if */
                       }
+                    else if (3 == pressed_key)
+                      {
+                        if (PHASE_ATAN2_FAST == atan2_method)
+                          {
+                            atan2_method = PHASE_ATAN2_LIBM;
+                            wprintf(gMsgReconstructionConfigurationArctangentChanged, L"atan2");
+                          }
+                        else
+                          {
+                            atan2_method = PHASE_ATAN2_FAST;
+                            wprintf(gMsgReconstructionConfigurationArctangentChanged, L"fast");
+                          }
+                        /* if */
+                      }
+                    else if (4 == pressed_key)
+                      {
+                        bool const benchmark = BenchmarkRelativePhaseEstimation(pDefaultImageEncoder->pAllImages, 10);
+                        if (false == benchmark) wprintf(gMsgReconstructionBenchmarkFailed);
+
+                        bool const benchmark_rays = BenchmarkCameraRayTable(pDefaultImageEncoder->pAllImages, fname_geometry.c_str(), 5);
+                        if (false == benchmark_rays) wprintf(gMsgReconstructionBenchmarkCameraRayTableFailed);
+
+                        bool const benchmark_model = BenchmarkPhaseToXYZModel(pDefaultImageEncoder->pAllImages, fname_geometry.c_str(), 5);
+                        if (false == benchmark_model) wprintf(gMsgReconstructionBenchmarkPhaseToXYZModelFailed);
+                      }
+                    else if (5 == pressed_key)
+                      {
+                        wprintf(gMsgReconstructionConfigurationMethodQuery);
+                        int const buffer_sz = 1024;
+                        wchar_t buffer[buffer_sz + 1];
+                        wchar_t * const scan = _getws_s(buffer, (unsigned)_countof(buffer));
+                        if (NULL != scan)
+                          {
+                            buffer[buffer_sz] = 0;
+
+                            // Copy user input to string and trim whitespaces and tabs.
+                            std::wstring method_new(buffer);
+                            method_new.erase(0, method_new.find_first_not_of(L" \t"));
+                            method_new.erase(method_new.find_last_not_of(L" \t") + 1);
+
+                            SLDecodePlan decode_plan;
+                            bool const parse = ParseMethodDescriptor(method_new.c_str(), &decode_plan);
+                            if (true == parse)
+                              {
+                                default_method = method_new;
+                                wprintf(gMsgReconstructionConfigurationMethodChanged, default_method.c_str(), decode_plan.num_images);
+                              }
+                            else
+                              {
+                                wprintf(gMsgReconstructionConfigurationMethodInvalid, method_new.c_str(), default_method.c_str());
+                              }
+                            /* if */
+                          }
+                        /* if */
+                      }
+                    else if (6 == pressed_key)
+                      {
+                        if (MPS_PRECISION_SINGLE == mps_precision)
+                          {
+                            mps_precision = MPS_PRECISION_DOUBLE;
+                            wprintf(gMsgReconstructionConfigurationPrecisionChanged, L"double");
+                          }
+                        else
+                          {
+                            mps_precision = MPS_PRECISION_SINGLE;
+                            wprintf(gMsgReconstructionConfigurationPrecisionChanged, L"single");
+                          }
+                        /* if */
+                      }
+                    else if (7 == pressed_key)
+                      {
+                        bool const validate = ValidateMPSSinglePrecision(
+                                                                         pDefaultImageEncoder->pAllImages,
+                                                                         default_method.c_str(),
+                                                                         fname_geometry.c_str(),
+                                                                         rel_thr,
+                                                                         atan2_method
+                                                                         );
+                        if (false == validate) wprintf(gMsgReconstructionValidationFailed);
+                      }
+                    else if (8 == pressed_key)
+                      {
+                        wprintf(gMsgReconstructionConfigurationROIQuery);
+                        int x = 0;
+                        int y = 0;
+                        int w = 0;
+                        int h = 0;
+                        int const scan = scanf_s("%d %d %d %d", &x, &y, &w, &h);
+                        if ( (4 == scan) && (0 == w) && (0 == h) )
+                          {
+                            roi_x = 0;
+                            roi_y = 0;
+                            roi_w = 0;
+                            roi_h = 0;
+                            wprintf(gMsgReconstructionConfigurationROIFullFrame);
+                          }
+                        else if ( (4 == scan) && (0 <= x) && (0 <= y) && (0 < w) && (0 < h) )
+                          {
+                            roi_x = x;
+                            roi_y = y;
+                            roi_w = w;
+                            roi_h = h;
+                            wprintf(gMsgReconstructionConfigurationROIChanged, roi_w, roi_h, roi_x, roi_y);
+                          }
+                        else
+                          {
+                            wprintf(gMsgReconstructionConfigurationROINotChanged);
+                          }
+                        /* if */
+                      }
+                    else if (9 == pressed_key)
+                      {
+                        wprintf(gMsgReconstructionConfigurationMaskQuery);
+                        int const buffer_sz = MAX_PATH;
+                        wchar_t buffer[buffer_sz + 1];
+                        wchar_t * const scan = _getws_s(buffer, (unsigned)_countof(buffer));
+                        if (NULL != scan)
+                          {
+                            buffer[buffer_sz] = 0;
+
+                            // Copy user input to string and trim whitespaces and tabs.
+                            std::wstring filename(buffer);
+                            filename.erase(0, filename.find_first_not_of(L" \t"));
+                            filename.erase(filename.find_last_not_of(L" \t") + 1);
+
+                            if (true == filename.empty())
+                              {
+                                SAFE_DELETE(roi_mask);
+                                wprintf(gMsgReconstructionConfigurationMaskCleared);
+                              }
+                            else
+                              {
+                                char cfilename[MAX_PATH + 1];
+                                int const numch = WideCharToMultiByte(CP_ACP, 0, filename.c_str(), -1, cfilename, MAX_PATH, NULL, NULL);
+
+                                cv::Mat * mask_new = NULL;
+                                if ( (0 < numch) && (numch < MAX_PATH) )
+                                  {
+                                    mask_new = new cv::Mat();
+                                    assert(NULL != mask_new);
+                                    if (NULL != mask_new) *mask_new = cv::imread(cfilename, cv::IMREAD_GRAYSCALE);
+                                  }
+                                /* if */
+
+                                if ( (NULL != mask_new) && (NULL != mask_new->data) )
+                                  {
+                                    SAFE_DELETE(roi_mask);
+                                    SWAP_ONE_VALID_PTR(roi_mask, mask_new);
+                                    wprintf(gMsgReconstructionConfigurationMaskLoaded, roi_mask->cols, roi_mask->rows, filename.c_str());
+                                  }
+                                else
+                                  {
+                                    wprintf(gMsgReconstructionConfigurationMaskInvalid, filename.c_str());
+                                  }
+                                /* if */
+
+                                SAFE_DELETE(mask_new);
+                              }
+                            /* if */
+                          }
+                        /* if */
+                      }
                     else
                       {
                         wprintf(gMsgReconstructionConfigurationNoChange);
@@ -5347,59 +5573,71 @@ _tmain(
 
                 // Set selected method description string.
                 std::wstring method;
-                int num_images = 0;
                 switch ( selected_method )
                   {
                   case RECONSTRUCTION_PSGC_COL:
                     method = L"PS+GC 8PS+(4+4)GC+B+W column";
-                    num_images = 18;
                     break;
 
                   case RECONSTRUCTION_PSGC_ROW:
                     method = L"PS+GC 8PS+(4+4)GC+B+W row";
-                    num_images = 18;
                     break;
 
                   case RECONSTRUCTION_PSGC_ALL:
                     method = L"PS+GC 8PS+(4+4)GC+B+W+8PS+(4+4)GC column row";
-                    num_images = 34;
                     break;
 
                   case RECONSTRUCTION_MPS2_COL:
                     method = L"MPS 8PS(n15)+8PS(n19) column";
-                    num_images = 16;
                     break;
 
                   case RECONSTRUCTION_MPS2_ROW:
                     method = L"MPS 8PS(n15)+8PS(n19) row";
-                    num_images = 16;
                     break;
 
                   case RECONSTRUCTION_MPS2_ALL:
                     method = L"MPS 8PS(n15)+8PS(n19) column row";
-                    num_images = 32;
                     break;
 
                   case RECONSTRUCTION_MPS3_COL:
                     method = L"MPS 3PS(n20)+3PS(n21)+3PS(n25) column";
-                    num_images = 9;
                     break;
 
                   case RECONSTRUCTION_MPS3_ROW:
                     method = L"MPS 3PS(n20)+3PS(n21)+3PS(n25) row";
-                    num_images = 9;
                     break;
 
                   case RECONSTRUCTION_MPS3_ALL:
+                    method = L"MPS 3PS(n20)+3PS(n21)+3PS(n25) column row";
+                    break;
+
                   case RECONSTRUCTION_DEFAULT:
                   default:
-                    method = L"MPS 3PS(n20)+3PS(n21)+3PS(n25) column row";
-                    num_images = 18;
+                    method = default_method;
                     break;
                   }
                 /* switch */
 
-                // For each attached camera and projector perform the 3D reconstruction.
+                // Get number of required images from the method descriptor.
+                int num_images = 0;
+                {
+                  SLDecodePlan decode_plan;
+                  bool const parse = ParseMethodDescriptor(method.c_str(), &decode_plan);
+                  if (false == parse)
+                    {
+                      int const cnt = wprintf(gMsgReconstructionInvalidMethod, method.c_str());
+                      assert(0 < cnt);
+                      break;
+                    }
+                  /* if */
+                  num_images = decode_plan.num_images;
+                }
+
+                // For each attached camera and projector prepare the 3D reconstruction.
+                std::vector<ProcessAcquiredImagesTask> tasks;
+                std::vector<int> task_camera_ids;
+                std::vector<int> task_projector_ids;
+
                 for (int CameraID = 0; CameraID < (int)(sAcquisition.size()); ++CameraID)
                   {
                     AcquisitionParameters * const pAcquisition = get_ptr_inline(sAcquisition, CameraID, &ThreadStorageLock);
@@ -5445,17 +5683,39 @@ _tmain(
                     // Set default name.
                     pImageEncoder->pAllImages->SetName(pImageEncoder->pSubdirectoryRecording);
 
-                    // Do 3D reconstruction.
-                    bool const res = ProcessAcquiredImages(
-                                                           pImageEncoder->pAllImages,
-                                                           method.c_str(),
-                                                           fname_geometry.c_str(),
-                                                           pWindowVTK,
-                                                           rel_thr,
-                                                           dst_thr * dst_thr
-                                                           );
-
-                    if (true == res)
+                    // Queue 3D reconstruction.
+                    ProcessAcquiredImagesTask task;
+                    task.AllImages = pImageEncoder->pAllImages;
+                    task.method = method.c_str();
+                    task.fname_geometry = fname_geometry.c_str();
+                    task.pWindowVTK = pWindowVTK;
+                    task.rel_thr = rel_thr;
+                    task.dst2_thr = dst_thr * dst_thr;
+                    task.stat_win = stat_win;
+                    task.atan2_method = atan2_method;
+                    task.mps_precision = mps_precision;
+                    task.roi_x = roi_x;
+                    task.roi_y = roi_y;
+                    task.roi_w = roi_w;
+                    task.roi_h = roi_h;
+                    task.mask = roi_mask;
+                    task.result = false;
+
+                    tasks.push_back(task);
+                    task_camera_ids.push_back(CameraID);
+                    task_projector_ids.push_back(ProjectorID);
+                  }
+                /* for */
+
+                // Do 3D reconstruction; cameras are reconstructed concurrently.
+                ProcessAcquiredImagesConcurrently(&tasks, max_concurrent);
+
+                for (int i = 0; i < (int)(tasks.size()); ++i)
+                  {
+                    int const CameraID = task_camera_ids[i];
+                    int const ProjectorID = task_projector_ids[i];
+
+                    if (true == tasks[i].result)
                       {
                         int const cnt = wprintf(gMsgReconstructionForCameraCompleted, CameraID + 1, ProjectorID + 1);
                         assert(0 < cnt);
@@ -5711,6 +5971,11 @@ _tmain(
 
   DeleteSynchronizationEventsStructure(pSynchronization);
 
+  mps_plan_cache_clear();
+  UndistortionLUTCacheClear();
+  CameraRayTableCacheClear();
+  PhaseToXYZModelCacheClear();
+
   while ( !sConnectedCameras.empty() )
     {
       std::wstring * pCameraName = sConnectedCameras.back();
@@ -5729,6 +5994,7 @@ _tmain(
 
 
   SAFE_DELETE(pAcquisitionTag);
+  SAFE_DELETE(roi_mask);
 
   SAFE_RELEASE(pD2DFactory);
   SAFE_RELEASE(pDXGIFactory1);
@@ -638,13 +638,23 @@ static const TCHAR gMsgReconstructionMenu[] =
   L"6) MPS using 8PS(n15)+8PS(n19) column and row code\n"
   L"7) MPS using 3PS(n20)+3PS(n21)+3PS(n25) column code\n"
   L"8) MPS using 3PS(n20)+3PS(n21)+3PS(n25) row code\n"
-  L"9) MPS using 3PS(n20)+3PS(n21)+3PS(n25) column and row code (default)\n";
+  L"9) MPS using 3PS(n20)+3PS(n21)+3PS(n25) column and row code\n"
+  L"Default method is %s\n";
 
 static const TCHAR gMsgReconstructionMenuConfigurationParameters[] =
   L"SET 3D RECONSTRUCTION PARAMETERS:\n"
   L"0) Return to 3D reconstruction menu (default)\n"
   L"1) Set relative dynamic range threshold (rel_thr = %.2lf)\n"
-  L"2) Set distance threshold in mm (dst_thr = %.2lf)\n";
+  L"2) Set distance threshold in mm (dst_thr = %.2lf)\n"
+  L"3) Toggle phase arctangent method (atan2_method = %s)\n"
+  L"4) Benchmark phase estimation, camera ray table, single-pass triangulation, and phase-to-XYZ models on acquired images\n"
+  L"5) Set default method descriptor (method = %s)\n"
+  L"6) Toggle MPS decoding precision (mps_precision = %s)\n"
+  L"7) Validate single precision MPS decoding of default method on acquired images\n"
+  L"8) Set region of interest (roi_x = %d, roi_y = %d, roi_w = %d, roi_h = %d)\n"
+  L"9) Load reconstruction mask from image file (mask = %s)\n"
+  L"C) Set largest number of concurrently reconstructed cameras (max_concurrent = %d)\n"
+  L"W) Set phase statistics window size in pixels (stat_win = %d)\n";
 
 static const TCHAR gMsgReconstructionConfigurationRelativeThresholdPrint[] =
   L"Relative dynamic range threshold set to %lf.\n";
@@ -672,6 +682,89 @@ static const TCHAR gMsgReconstructionConfigurationDistanceThresholdChanged[] =
 static const TCHAR gMsgReconstructionConfigurationDistanceThresholdNotChanged[] =
   L"Distance threshold remains %lf mm.\n";
 
+static const TCHAR gMsgReconstructionConfigurationConcurrencyPrint[] =
+  L"At most %d cameras are reconstructed concurrently.\n";
+
+static const TCHAR gMsgReconstructionConfigurationConcurrencyQuery[] =
+  L"Enter new largest number of concurrently reconstructed cameras (1 reconstructs cameras one after another):\n"
+  L">";
+
+static const TCHAR gMsgReconstructionConfigurationConcurrencyChanged[] =
+  L"Largest number of concurrently reconstructed cameras changed from %d to %d.\n";
+
+static const TCHAR gMsgReconstructionConfigurationConcurrencyNotChanged[] =
+  L"Largest number of concurrently reconstructed cameras remains %d.\n";
+
+static const TCHAR gMsgReconstructionConfigurationStatisticsWindowPrint[] =
+  L"Phase statistics window size set to %dx%d pixels.\n";
+
+static const TCHAR gMsgReconstructionConfigurationStatisticsWindowQuery[] =
+  L"Enter new phase statistics window size in pixels (odd number, at least 3):\n"
+  L">";
+
+static const TCHAR gMsgReconstructionConfigurationStatisticsWindowChanged[] =
+  L"Phase statistics window size changed from %dx%d to %dx%d pixels.\n";
+
+static const TCHAR gMsgReconstructionConfigurationStatisticsWindowNotChanged[] =
+  L"Phase statistics window size remains %dx%d pixels.\n";
+
+static const TCHAR gMsgReconstructionConfigurationArctangentChanged[] =
+  L"Phase arctangent method changed to %s.\n";
+
+static const TCHAR gMsgReconstructionBenchmarkFailed[] =
+  L"[ERROR] Benchmark of phase estimation kernels failed.\n";
+
+static const TCHAR gMsgReconstructionBenchmarkCameraRayTableFailed[] =
+  L"[ERROR] Benchmark of camera ray table failed.\n";
+
+static const TCHAR gMsgReconstructionBenchmarkPhaseToXYZModelFailed[] =
+  L"[ERROR] Benchmark of phase-to-XYZ model failed.\n";
+
+static const TCHAR gMsgReconstructionConfigurationPrecisionChanged[] =
+  L"MPS decoding precision changed to %s.\n";
+
+static const TCHAR gMsgReconstructionValidationFailed[] =
+  L"[ERROR] Validation of single precision MPS decoding failed.\n";
+
+static const TCHAR gMsgReconstructionConfigurationROIQuery[] =
+  L"Enter region of interest as x y width height; enter 0 0 0 0 to process the full frame:\n"
+  L">";
+
+static const TCHAR gMsgReconstructionConfigurationROIChanged[] =
+  L"Region of interest changed to %d x %d region at (%d, %d).\n";
+
+static const TCHAR gMsgReconstructionConfigurationROIFullFrame[] =
+  L"Region of interest reset to full frame.\n";
+
+static const TCHAR gMsgReconstructionConfigurationROINotChanged[] =
+  L"Region of interest was not changed.\n";
+
+static const TCHAR gMsgReconstructionConfigurationMaskQuery[] =
+  L"Enter mask image filename where non-zero pixels mark the region to reconstruct; leave empty to clear the mask:\n"
+  L">";
+
+static const TCHAR gMsgReconstructionConfigurationMaskLoaded[] =
+  L"Loaded %d x %d reconstruction mask from %s.\n";
+
+static const TCHAR gMsgReconstructionConfigurationMaskCleared[] =
+  L"Reconstruction mask cleared.\n";
+
+static const TCHAR gMsgReconstructionConfigurationMaskInvalid[] =
+  L"[ERROR] Cannot load reconstruction mask from %s.\n";
+
+static const TCHAR gMsgReconstructionConfigurationMethodQuery[] =
+  L"Enter method descriptor, e.g. MPS 3PS(n20)+3PS(n21)+3PS(n25) column row:\n"
+  L">";
+
+static const TCHAR gMsgReconstructionConfigurationMethodChanged[] =
+  L"Default method changed to %s (%d images).\n";
+
+static const TCHAR gMsgReconstructionConfigurationMethodInvalid[] =
+  L"[ERROR] Invalid method descriptor %s. Default method is %s.\n";
+
+static const TCHAR gMsgReconstructionInvalidMethod[] =
+  L"[ERROR] Invalid method descriptor %s. Aborting reconstruction!\n";
+
 static const TCHAR gMsgReconstructionConfigurationNoChange[] =
   L"Reconstruction parameters were not changed. Returing to 3D reconstruction menu.\n";
 
@@ -1363,26 +1456,38 @@ static const TCHAR gMsgProcessingProjectorResolutionMismatch[] =
 static const TCHAR gMsgProcessingDecodeSLCode[] =
   L"[CAM %d]+[PRJ %d] Decoding %s code.\n";
 
+static const TCHAR gMsgProcessingInvalidMethodDescriptor[] =
+  L"[ERROR] [CAM %d]+[PRJ %d] Invalid method descriptor %s.\n";
+
+static const TCHAR gMsgProcessingNotEnoughImages[] =
+  L"[ERROR] [CAM %d]+[PRJ %d] Method requires %d images but only %d images are available.\n";
+
+static const TCHAR gMsgProcessingInvalidMask[] =
+  L"[ERROR] [CAM %d]+[PRJ %d] Mask must be a %d x %d 8-bit single channel image.\n";
+
+static const TCHAR gMsgProcessingEmptyRegionOfInterest[] =
+  L"[ERROR] [CAM %d]+[PRJ %d] Region of interest does not contain any pixels.\n";
+
+static const TCHAR gMsgProcessingRegionOfInterestIgnored[] =
+  L"[WARNING] [CAM %d]+[PRJ %d] Region of interest cannot be addressed in place for %s images; processing full frame.\n";
+
+static const TCHAR gMsgProcessingRegionOfInterest[] =
+  L"[CAM %d]+[PRJ %d] Processing %d x %d region at (%d, %d) which is %.1lf%% of the frame.\n";
+
 static const TCHAR gMsgProcessingDecodeSLCodeDuration[] =
   L"[CAM %d]+[PRJ %d] SL decoding took %.2lf ms.\n";
 
-static const TCHAR gMsgProcessingPSGCPhaseEstimationDuration[] =
-  L"[CAM %d]+[PRJ %d] Phase estimation took %.2lf ms.\n";
+static const TCHAR gMsgProcessingPSGCStreamingUnwrappingDuration[] =
+  L"[CAM %d]+[PRJ %d] Phase estimation, dynamic range computation, and unwrapping took %.2lf ms.\n";
 
-static const TCHAR gMsgProcessingPSGCDynamicRangeComputationDuration[] =
-  L"[CAM %d]+[PRJ %d] Dynamic range computation took %.2lf ms.\n";
-
-static const TCHAR gMsgProcessingPSGCPhaseUnwrappingDuration[] =
-  L"[CAM %d]+[PRJ %d] Phase unwrapping took %.2lf ms.\n";
+static const TCHAR gMsgProcessingMPSNearestCenterSearch[] =
+  L"[CAM %d]+[PRJ %d] Using %s for nearest-center search.\n";
 
 static const TCHAR gMsgProcessingMPSPreparationDuration[] =
-  L"[CAM %d]+[PRJ %d] KD tree construction took %.2lf ms.\n";
+  L"[CAM %d]+[PRJ %d] Fetching unwrapping plan took %.2lf ms.\n";
 
 static const TCHAR gMsgProcessingMPSPhaseEstimationDuration[] =
-  L"[CAM %d]+[PRJ %d] Phase estimation took %.2lf ms.\n";
-
-static const TCHAR gMsgProcessingMPSDynamicRangeAndTextureComputationDuration[] =
-  L"[CAM %d]+[PRJ %d] Dynamic range and texture computation took %.2lf ms.\n";
+  L"[CAM %d]+[PRJ %d] Phase estimation with dynamic range and texture computation took %.2lf ms.\n";
 
 static const TCHAR gMsgProcessingMPSPhaseUnwrappingDuration[] =
   L"[CAM %d]+[PRJ %d] Phase unwrapping took %.2lf ms.\n";
@@ -1396,6 +1501,9 @@ static const TCHAR gMsgProcessingPrepareTextureDuration[] =
 static const TCHAR gMsgProcessingPrepareDataForFiltering[] =
   L"[CAM %d]+[PRJ %d] Precomputing data required for point cloud filtering.\n";
 
+static const TCHAR gMsgProcessingPhaseStatisticsSkipped[] =
+  L"[CAM %d]+[PRJ %d] Skipping phase statistics as %dx%d region is not larger than %dx%d window.\n";
+
 static const TCHAR gMsgProcessingPrepareDataForFilteringDuration[] =
   L"[CAM %d]+[PRJ %d] Precomputation took %.2lf ms.\n";
 
@@ -1414,6 +1522,30 @@ static const TCHAR gMsgProcessingPrepareDataForVTKDuration[] =
 static const TCHAR gMsgProcessingDone[] =
   L"[CAM %d]+[PRJ %d] Point cloud pushed to VTK visualization window.\n";
 
+static const TCHAR gMsgProcessingConcurrentReconstruction[] =
+  L"Reconstructing %d cameras with at most %d concurrent reconstructions using %d threads each.\n";
+
+static const TCHAR gMsgValidateMPSNotMPSMethod[] =
+  L"[ERROR] Method %s is not a valid MPS method descriptor.\n";
+
+static const TCHAR gMsgValidateMPSSinglePrecisionAll[] =
+  L"MPS %s code, all pixels: max. phase difference %.3e, changed period orders %.4lf %% of %d pixels.\n";
+
+static const TCHAR gMsgValidateMPSSinglePrecisionValid[] =
+  L"MPS %s code, valid pixels: max. phase difference %.3e, changed period orders %.4lf %% of %d pixels.\n";
+
+static const TCHAR gMsgValidateMPSSinglePrecisionDuration[] =
+  L"MPS %s code: unwrapping took %.2lf ms in double and %.2lf ms in single precision (%.2lfx speedup).\n";
+
+static const TCHAR gMsgBenchmarkCameraRayTable[] =
+  L"Camera ray table for %d x %d sensor (%.1lf MP): %.1lf MB, computed in %.2lf ms; triangulation %.2lf ms without and %.2lf ms with table (%.2lfx speedup), max. point difference %.3e mm.\n";
+
+static const TCHAR gMsgBenchmarkPhaseToXYZModel[] =
+  L"Phase-to-XYZ model for %d x %d sensor (%.1lf MP): %.1lf MB, fitted in %.2lf ms with max. error %.3e px; reconstruction %.2lf ms with re-triangulation and %.2lf ms with model (%.2lfx speedup), %.2lf %% of points reconstructed, max. point difference %.3e mm.\n";
+
+static const TCHAR gMsgBenchmarkSingleDirectionTriangulation[] =
+  L"Single-pass triangulation with %d iterations: %.2lf ms (%.2lfx speedup over re-triangulation), max. point difference %.3e mm to re-triangulation and %.3e mm to model.\n";
+
 #endif /* __BATCHACQUISITIONPROCESSING_CPP */
 
 
@@ -1437,11 +1569,63 @@ static const TCHAR gDbgFringeCountsAreNotWholeNumbers[] =
 static const TCHAR gDbgPeriodsAreNotRelativelyPrime[] =
   L"Periods are not relatively prime integers.\n";
 
+static const TCHAR gDbgMPSPlanNotWritten[] =
+  L"Cannot write MPS unwrapping plan to file %s.\n";
+
+static const TCHAR gDbgMPSPlanStale[] =
+  L"MPS unwrapping plan file %s does not match the current inputs and will be rebuilt.\n";
+
+static const TCHAR gMsgBenchmarkRelativePhaseEstimation[] =
+  L"%d-step phase estimation: generic %.2lf ms, specialized %.2lf ms (%.2lfx speedup), max. difference %.3e rad.\n";
+
+static const TCHAR gMsgBenchmarkRelativePhaseEstimationFastAtan2[] =
+  L"%d-step phase estimation: specialized with fast atan2 %.2lf ms (%.2lfx speedup), max. difference %.3e rad.\n";
+
+static const TCHAR gMsgBenchmarkFastAtan2Error[] =
+  L"Fast atan2: max. error against atan2 is %.3e rad (bound %.1e rad) -- %s.\n";
+
+static const TCHAR gMsgBenchmarkRelativePhaseEstimationSkipped[] =
+  L"%d-step phase estimation: not enough acquired images, skipping benchmark.\n";
+
 
 
 #endif /* __BATCHACQUISITIONPROCESSINGPHASESHIFT_CPP */
 
 
+#ifdef __BATCHACQUISITIONPROCESSINGDISTORTION_CPP
+
+static const TCHAR gDbgUndistortionLUTComputed[] =
+  L"Computed %d x %d undistortion table for camera %s in %.2lf ms using %.1lf MB; %d cached tables use %.1lf MB.\n";
+
+static const TCHAR gDbgProjectorUndistortionLUTValidated[] =
+  L"Computed %d x %d undistortion table with %.2lf px spacing for projector %s in %.2lf ms; validation took %.2lf ms, max. error %.3e px (tolerance %.1e px).\n";
+
+static const TCHAR gDbgProjectorUndistortionLUTRejected[] =
+  L"Undistortion table for projector %s exceeds error tolerance; using analytic undistortion.\n";
+
+static const TCHAR gDbgProjectorUndistortionLUTComputed[] =
+  L"Undistortion table for projector %s uses %.1lf MB; %d cached projector tables use %.1lf MB.\n";
+
+#endif /* __BATCHACQUISITIONPROCESSINGDISTORTION_CPP */
+
+
+#ifdef __BATCHACQUISITIONPROCESSINGTRIANGULATION_CPP
+
+static const TCHAR gDbgCameraRayTableComputed[] =
+  L"Computed %d x %d ray table for camera %s in %.2lf ms using %.1lf MB; %d cached tables use %.1lf MB.\n";
+
+static const TCHAR gDbgPhaseToXYZModelComputed[] =
+  L"Fitted %s phase-to-XYZ model of camera %s and projector %s for %d x %d sensor in %.2lf ms; %d pixels are valid, max. error %.3e px (tolerance %.1e px).\n";
+
+static const TCHAR gDbgPhaseToXYZModelRejected[] =
+  L"Phase-to-XYZ model of camera %s and projector %s exceeds error tolerance or has no valid pixels; using triangulation.\n";
+
+static const TCHAR gDbgPhaseToXYZModelCached[] =
+  L"Phase-to-XYZ model uses %.1lf MB; %d cached models use %.1lf MB.\n";
+
+#endif /* __BATCHACQUISITIONPROCESSINGTRIANGULATION_CPP */
+
+
 #ifdef __BATCHACQUISITIONVTK_CPP
 
 static const char gMsgWindowTitleNoData[] =
@@ -29,6 +29,7 @@
 #include "BatchAcquisitionMessages.h"
 #include "BatchAcquisitionProcessing.h"
 #include "BatchAcquisitionProcessingPhaseShift.h"
+#include "BatchAcquisitionProcessingMethod.h"
 #include "BatchAcquisitionProcessingPixelSelector.h"
 #include "BatchAcquisitionProcessingDistortion.h"
 #include "BatchAcquisitionProcessingTriangulation.h"
@@ -781,6 +782,201 @@ ImageSet_::IsGrayscale(
 
 
 
+//! Get shallow ROI view.
+/*!
+  Fills the view structure so it addresses the rectangular region of interest
+  of all stored images without copying any data. The ROI is first clipped
+  to the image and then expanded to the nearest pixel group boundaries,
+  e.g. ROI of a Bayer image always starts at an even row and column so the
+  color filter arrangement of the view is the same as the one of the full
+  image, and ROI of a packed 12-bit image always starts at an even column.
+
+  The view only borrows the data block and does not hold any of the
+  allocated strings so it must be blanked using Blank() before it is destroyed.
+
+  \param x      X coordinate of the upper left corner of the ROI.
+  \param y      Y coordinate of the upper left corner of the ROI.
+  \param w      Width in pixels of the ROI.
+  \param h      Height in pixels of the ROI.
+  \param view   Pointer to structure which will receive the view.
+  \param x_out  Address where the X coordinate of the upper left corner of the aligned ROI will be stored.
+  \param y_out  Address where the Y coordinate of the upper left corner of the aligned ROI will be stored.
+  \return Returns true if successfull, false otherwise. Function fails for pixel formats
+  which cannot be addressed in place such as planar RGB or if the ROI does not intersect the image.
+*/
+bool
+ImageSet_::GetROIView(
+                      int const x,
+                      int const y,
+                      int const w,
+                      int const h,
+                      ImageSet_ * const view,
+                      int * const x_out,
+                      int * const y_out
+                      )
+{
+  assert(NULL != view);
+  if (NULL == view) return false;
+
+  assert(this != view);
+  if (this == view) return false;
+
+  assert(NULL != this->data);
+  if (NULL == this->data) return false;
+
+  assert( (0 < w) && (0 < h) );
+  if ( (0 >= w) || (0 >= h) ) return false;
+
+  // Get pixel group size; bytes_num bytes are used to store bytes_den pixels.
+  int align_x = 1;
+  int align_y = 1;
+  int bytes_num = -1;
+  int bytes_den = 1;
+  switch (this->PixelFormat)
+    {
+    case IDT_8U_BINARY:
+    case IDT_8U_GRAY:
+    case IDT_8S_GRAY:
+      bytes_num = 1;
+      break;
+
+    case IDT_10U_GRAY:
+    case IDT_16U_GRAY:
+    case IDT_16U_GRAY_BigEndian:
+    case IDT_16S_GRAY:
+    case IDT_16S_GRAY_BigEndian:
+      bytes_num = 2;
+      break;
+
+    case IDT_32U_GRAY:
+    case IDT_32S_GRAY:
+      bytes_num = 4;
+      break;
+
+    case IDT_12U_GRAY_Packed:
+      align_x = 2;
+      bytes_num = 3;
+      bytes_den = 2;
+      break;
+
+    case IDT_8U_BayerGR:
+    case IDT_8U_BayerRG:
+    case IDT_8U_BayerGB:
+    case IDT_8U_BayerBG:
+      align_x = 2;
+      align_y = 2;
+      bytes_num = 1;
+      break;
+
+    case IDT_10U_BayerGR:
+    case IDT_10U_BayerRG:
+    case IDT_10U_BayerGB:
+    case IDT_10U_BayerBG:
+    case IDT_16U_BayerGR:
+    case IDT_16U_BayerRG:
+    case IDT_16U_BayerGB:
+    case IDT_16U_BayerBG:
+    case IDT_16U_BayerGR_BigEndian:
+    case IDT_16U_BayerRG_BigEndian:
+    case IDT_16U_BayerGB_BigEndian:
+    case IDT_16U_BayerBG_BigEndian:
+      align_x = 2;
+      align_y = 2;
+      bytes_num = 2;
+      break;
+
+    case IDT_12U_BayerGR_Packed:
+    case IDT_12U_BayerRG_Packed:
+    case IDT_12U_BayerGB_Packed:
+    case IDT_12U_BayerBG_Packed:
+      align_x = 2;
+      align_y = 2;
+      bytes_num = 3;
+      bytes_den = 2;
+      break;
+
+    case IDT_8U_RGB:
+    case IDT_8U_BGR:
+    case IDT_8U_YUV444:
+    case IDT_8U_UYV444:
+      bytes_num = 3;
+      break;
+
+    case IDT_8U_RGBA:
+    case IDT_8U_BGRA:
+      bytes_num = 4;
+      break;
+
+    case IDT_16U_BGR:
+      bytes_num = 6;
+      break;
+
+    case IDT_8U_YUV411:
+      align_x = 4;
+      bytes_num = 6;
+      bytes_den = 4;
+      break;
+
+    case IDT_8U_YUV422:
+    case IDT_8U_YUV422_BT601:
+    case IDT_8U_YUV422_BT709:
+      align_x = 2;
+      bytes_num = 4;
+      bytes_den = 2;
+      break;
+    }
+  /* switch */
+
+  if (0 >= bytes_num) return false;
+
+  // Clip ROI to image.
+  int x0 = x;
+  int y0 = y;
+  int x1 = x + w;
+  int y1 = y + h;
+  if (0 > x0) x0 = 0;
+  if (0 > y0) y0 = 0;
+  if (this->width < x1) x1 = this->width;
+  if (this->height < y1) y1 = this->height;
+  if ( (x1 <= x0) || (y1 <= y0) ) return false;
+
+  // Expand ROI to pixel group boundaries.
+  x0 = (x0 / align_x) * align_x;
+  y0 = (y0 / align_y) * align_y;
+  x1 = ( (x1 + align_x - 1) / align_x ) * align_x;
+  y1 = ( (y1 + align_y - 1) / align_y ) * align_y;
+  if (this->width < x1) x1 = this->width;
+  if (this->height < y1) y1 = this->height;
+
+  // Fill the view.
+  view->Blank();
+
+  view->data = this->data + (size_t)(this->row_step) * y0 + (size_t)( (x0 / bytes_den) * bytes_num );
+  view->num_images = this->num_images;
+  view->width = x1 - x0;
+  view->height = y1 - y0;
+  view->row_step = this->row_step;
+  view->image_step = this->image_step;
+  view->PixelFormat = this->PixelFormat;
+  view->buffer_size = this->buffer_size - (size_t)(view->data - this->data);
+
+  view->window_width = this->window_width;
+  view->window_height = this->window_height;
+  view->rcScreen = this->rcScreen;
+  view->rcWindow = this->rcWindow;
+  view->CameraID = this->CameraID;
+  view->ProjectorID = this->ProjectorID;
+  view->acquisition_method = this->acquisition_method;
+
+  if (NULL != x_out) *x_out = x0;
+  if (NULL != y_out) *y_out = y0;
+
+  return true;
+}
+/* ImageSet_::GetROIView */
+
+
+
 //! Destructor.
 /*!
   Blanks class variables.
@@ -1206,7 +1402,8 @@ ProjectiveGeometry_::ReadFromXMLFile(
 
   if ( SUCCEEDED(hr) )
     {
-      hr = SHCreateStreamOnFileEx(filename, STGM_READ, FILE_ATTRIBUTE_NORMAL, FALSE, NULL, &pFileStream);
+      // Allow concurrent readers as geometry of several cameras may be loaded at the same time.
+      hr = SHCreateStreamOnFileEx(filename, STGM_READ | STGM_SHARE_DENY_WRITE, FILE_ATTRIBUTE_NORMAL, FALSE, NULL, &pFileStream);
       assert( SUCCEEDED(hr) );
     }
   /* if */
@@ -1704,6 +1901,117 @@ WritecvMatToRAWFile(
 
 /****** 3D RECONSTRUCTION ******/
 
+//! Get mask bounding box.
+/*!
+  Computes the smallest rectangle which contains all non-zero pixels of the mask.
+
+  \param mask   Pointer to 8-bit single channel mask image.
+  \param x_out  Address where the X coordinate of the upper left corner will be stored.
+  \param y_out  Address where the Y coordinate of the upper left corner will be stored.
+  \param w_out  Address where the width will be stored.
+  \param h_out  Address where the height will be stored.
+  \return Returns true if the mask contains at least one non-zero pixel.
+*/
+static
+bool
+GetMaskBoundingBox(
+                   cv::Mat const * const mask,
+                   int * const x_out,
+                   int * const y_out,
+                   int * const w_out,
+                   int * const h_out
+                   )
+{
+  assert( (NULL != mask) && (NULL != mask->data) );
+  if ( (NULL == mask) || (NULL == mask->data) ) return false;
+
+  assert( CV_8UC1 == mask->type() );
+  if ( CV_8UC1 != mask->type() ) return false;
+
+  int const cols = mask->cols;
+  int const rows = mask->rows;
+
+  int x0 = cols;
+  int x1 = -1;
+  int y0 = rows;
+  int y1 = -1;
+
+  for (int y = 0; y < rows; ++y)
+    {
+      UINT8 const * const row_mask = (UINT8 *)( (BYTE *)(mask->data) + mask->step[0] * y );
+
+      int first = 0;
+      while ( (first < cols) && (0 == row_mask[first]) ) ++first;
+      if (first == cols) continue;
+
+      int last = cols - 1;
+      while (0 == row_mask[last]) --last;
+
+      if (y0 > y) y0 = y;
+      y1 = y;
+      if (x0 > first) x0 = first;
+      if (x1 < last) x1 = last;
+    }
+  /* for */
+
+  if ( (x1 < x0) || (y1 < y0) ) return false;
+
+  if (NULL != x_out) *x_out = x0;
+  if (NULL != y_out) *y_out = y0;
+  if (NULL != w_out) *w_out = x1 - x0 + 1;
+  if (NULL != h_out) *h_out = y1 - y0 + 1;
+
+  return true;
+}
+/* GetMaskBoundingBox */
+
+
+
+//! Apply mask to dynamic range.
+/*!
+  Sets dynamic range of all pixels outside the mask to zero so they are
+  rejected by the pixel selection and are never triangulated.
+
+  \param dynamic_range  Pointer to single precision dynamic range image.
+  \param mask   Pointer to 8-bit single channel mask of the same size; non-zero values mark pixels to keep.
+  \return Returns true if successfull.
+*/
+static
+bool
+ApplyMaskToDynamicRange(
+                        cv::Mat * const dynamic_range,
+                        cv::Mat const * const mask
+                        )
+{
+  assert( (NULL != dynamic_range) && (NULL != dynamic_range->data) );
+  if ( (NULL == dynamic_range) || (NULL == dynamic_range->data) ) return false;
+
+  assert( (NULL != mask) && (NULL != mask->data) );
+  if ( (NULL == mask) || (NULL == mask->data) ) return false;
+
+  assert( (CV_32FC1 == dynamic_range->type()) && (CV_8UC1 == mask->type()) );
+  if ( (CV_32FC1 != dynamic_range->type()) || (CV_8UC1 != mask->type()) ) return false;
+
+  assert( (dynamic_range->cols == mask->cols) && (dynamic_range->rows == mask->rows) );
+  if ( (dynamic_range->cols != mask->cols) || (dynamic_range->rows != mask->rows) ) return false;
+
+  int const cols = dynamic_range->cols;
+  int const rows = dynamic_range->rows;
+
+  for (int y = 0; y < rows; ++y)
+    {
+      UINT8 const * const row_mask = (UINT8 *)( (BYTE *)(mask->data) + mask->step[0] * y );
+      float * const row_dynamic_range = (float *)( (BYTE *)(dynamic_range->data) + dynamic_range->step[0] * y );
+      for (int x = 0; x < cols; ++x) if (0 == row_mask[x]) row_dynamic_range[x] = 0.0f;
+    }
+  /* for */
+
+  return true;
+}
+/* ApplyMaskToDynamicRange */
+
+
+
 //! Process acquired images.
 /*!
   Function processes all acquired images, computes 3D point cloud reconstruction, and pushes
@@ -1715,6 +2023,15 @@ WritecvMatToRAWFile(
   \param pWindowVTK      Pointer to VTK visualization window.
   \param rel_thr         Relative threshold to determine illuminated pixels. Must be in [0,1] range.
   \param dst2_thr        Absolute threshold to determine quality of 3D reconstruction. Usually in mm. Should be positive.
+  \param stat_win        Size of the square sliding window used to compute phase order and deviation. Should be odd.
+  \param atan2_method    Arctangent computation method used for phase estimation.
+  \param mps_precision   Floating point precision of wrapped phases for MPS decoding.
+  \param roi_x           X coordinate of the upper left corner of the region of interest.
+  \param roi_y           Y coordinate of the upper left corner of the region of interest.
+  \param roi_w           Width of the region of interest. Set width or height to zero to process the full frame.
+  \param roi_h           Height of the region of interest.
+  \param mask            Pointer to 8-bit single channel mask of the same size as acquired images where non-zero
+  values mark pixels to reconstruct. May be NULL.
 */
 bool
 ProcessAcquiredImages(
@@ -1723,7 +2040,15 @@ ProcessAcquiredImages(
                       wchar_t const * fname_geometry,
                       VTKdisplaythreaddata * const pWindowVTK,
                       double const rel_thr,
-                      double const dst2_thr
+                      double const dst2_thr,
+                      int const stat_win,
+                      PhaseAtan2Method const atan2_method,
+                      MPSPrecision const mps_precision,
+                      int const roi_x,
+                      int const roi_y,
+                      int const roi_w,
+                      int const roi_h,
+                      cv::Mat const * const mask
                       )
 {
   assert(NULL != AllImages);
@@ -1751,13 +2076,10 @@ ProcessAcquiredImages(
 
   cv::Mat * abs_phase_col = NULL; // Unwrapped normalized phase image for projector column.
   cv::Mat * abs_phase_col_distance = NULL; // Distance to constellation for projector column.
-  cv::Mat * abs_phase_col_order = NULL; // Order of unwrapped phase for projector column.
-  cv::Mat * abs_phase_col_deviation = NULL; // Standard deviation of unwrapped phase  for projector column.
   cv::Mat * abs_phase_row = NULL; // Unwrapped normalized phase image for projector row.
   cv::Mat * abs_phase_row_distance = NULL; // Distance to constellation for projector row.
-  cv::Mat * abs_phase_row_order = NULL; // Order of unwrapped phase for projector row.
-  cv::Mat * abs_phase_row_deviation = NULL; // Standard deviation of unwrapped phase for projector row.
   cv::Mat * abs_phase_distance = NULL; // Combined distance to constellation.
+  cv::Mat * abs_phase_order = NULL; // Combined order of unwrapped phase.
   cv::Mat * abs_phase_deviation = NULL; // Combined phase deviation.
   cv::Mat * dynamic_range = NULL; // Lowest observed dynamic range for each pixel.
   cv::Mat * crd_x_image = NULL; // Image column indices for valid pixels.
@@ -1765,10 +2087,10 @@ ProcessAcquiredImages(
   cv::Mat * range_image = NULL; // Dynamic range for valid pixels.
   cv::Mat * crd_x_camera = NULL; // Undistorted camera x coordinate.
   cv::Mat * crd_y_camera = NULL; // Undistorted camera y coordinate.
+  CameraRayTable const * ray_table = NULL; // Camera rays for all sensor pixels; owned by the cache and released on exit.
+  PhaseToXYZModel const * xyz_model = NULL; // Phase-to-XYZ model for single-direction codes; owned by the cache and released on exit.
   cv::Mat * projector_col = NULL; // Index of projector column.
   cv::Mat * projector_row = NULL; // Index of projector row.
-  cv::Mat * projector_col_est = NULL; // Estimated projector column.
-  cv::Mat * projector_row_est = NULL; // Estimated projector row.
   cv::Mat * crd_x_projector = NULL; // Undistorted projector x coordinate.
   cv::Mat * crd_y_projector = NULL; // Undistorted projector y coordinate.
   cv::Mat * x_3D = NULL; // Reconstructed x coordinate.
@@ -1783,6 +2105,12 @@ ProcessAcquiredImages(
   int texture_n = 0; // Number of summed textures.
   int texture_idx = -1; // Texture image index.
 
+  ImageSet ROIImages; // Shallow view of the region of interest; must be blanked before it goes out of scope.
+  ImageSet * Images = AllImages; // Images to decode; either all images or the view of the region of interest.
+  int offset_x = 0; // Column of the region of interest in the full frame.
+  int offset_y = 0; // Row of the region of interest in the full frame.
+  cv::Mat * mask_roi = NULL; // Shallow copy of the mask restricted to the region of interest.
+
   bool failed = false; // Assume success.
 
   // Load projective geometry for camera and projector.
@@ -1895,193 +2223,351 @@ ProcessAcquiredImages(
     }
   /* if */
 
-  // Set flags based on input method.
-  // TODO: Implement regexp parser for PS and MPS.
-  bool const ps_gc_col = ( 0 == _wcsicmp(method, L"PS+GC 8PS+(4+4)GC+B+W column") );
-  bool const ps_gc_row = ( 0 == _wcsicmp(method, L"PS+GC 8PS+(4+4)GC+B+W row") );
-  bool const ps_gc_all = ( 0 == _wcsicmp(method, L"PS+GC 8PS+(4+4)GC+B+W+8PS+(4+4)GC column row") );
-
-  bool const mps_two_col = ( 0 == _wcsicmp(method, L"MPS 8PS(n15)+8PS(n19) column") );
-  bool const mps_two_row = ( 0 == _wcsicmp(method, L"MPS 8PS(n15)+8PS(n19) row") );
-  bool const mps_two_all = ( 0 == _wcsicmp(method, L"MPS 8PS(n15)+8PS(n19) column row") );
-
-  bool const mps_three_col = ( 0 == _wcsicmp(method, L"MPS 3PS(n20)+3PS(n21)+3PS(n25) column") );
-  bool const mps_three_row = ( 0 == _wcsicmp(method, L"MPS 3PS(n20)+3PS(n21)+3PS(n25) row") );
-  bool const mps_three_all = ( 0 == _wcsicmp(method, L"MPS 3PS(n20)+3PS(n21)+3PS(n25) column row") );
-
-  double const elapsed_to_decoding = DebugTimerQueryStart( debug_timer );
-
-  // Decode projector coordinate.
-  if ( (true == ps_gc_col) || (true == ps_gc_row) || (true == ps_gc_all) )
+  // Compile method descriptor into decode plan.
+  SLDecodePlan decode_plan;
+  if (false == failed)
     {
-      /****** Phase shift and Gray code ******/
-
-      int const ps_col_begin = 0; // First eight images are phase shifted sine.
-      int const ps_col_end = 7;
-
-      int const gc1_col_begin = 8; // Next four images are Gray code aligned with the sine.
-      int const gc1_col_end = 11;
-      int const gc2_col_begin = 12; // Next four images are Gray code shifted by half-period.
-      int const gc2_col_end = 15;
-
-      int const black = 16; // Projector dimmed.
-      int const white = 17; // Scene under white projector illumination.
+      bool const parse = ParseMethodDescriptor(method, &decode_plan);
+      if (false == parse)
+        {
+          int const cnt = wprintf(gMsgProcessingInvalidMethodDescriptor, CameraID + 1, ProjectorID + 1, method);
+          assert(0 < cnt);
 
-      int const ps_row_begin = 18; // Next eight imags are phase shifted sine.
-      int const ps_row_end = 25;
+          failed = true;
+        }
+      else if (AllImages->num_images < decode_plan.num_images)
+        {
+          int const cnt = wprintf(gMsgProcessingNotEnoughImages, CameraID + 1, ProjectorID + 1, decode_plan.num_images, AllImages->num_images);
+          assert(0 < cnt);
 
-      int const gc1_row_begin = 26; // Next four images are Gray code aligned with the sine.
-      int const gc1_row_end = 29;
-      int const gc2_row_begin = 30; // Next four images are Gray code shifted by half-period.
-      int const gc2_row_end = 33;
+          failed = true;
+        }
+      /* if */
+    }
+  /* if */
 
-      cv::Mat * rel_phase_col = NULL; // Wrapped phase image for projector column.
-      cv::Mat * gray_code_1_col = NULL; // Decoded in-phase Gray code for projector column.
-      cv::Mat * gray_code_2_col = NULL; // Decoded half-period shifted Gray code for projector column.
+  // Restrict decoding to the region of interest, i.e. to the intersection of the ROI and the mask bounding box.
+  if (false == failed)
+    {
+      int x = 0;
+      int y = 0;
+      int w = AllImages->width;
+      int h = AllImages->height;
+      bool const have_roi = (0 < roi_w) && (0 < roi_h);
+      bool have_pixels = true;
+
+      if (true == have_roi)
+        {
+          x = roi_x;
+          y = roi_y;
+          w = roi_w;
+          h = roi_h;
+        }
+      /* if */
 
-      cv::Mat * rel_phase_row = NULL; // Wrapped phase image for projector row.
-      cv::Mat * gray_code_1_row = NULL; // Decoded in-phase Gray code for projector row.
-      cv::Mat * gray_code_2_row = NULL; // Decoded half-period shifted Gray code for projector row.
+      if (NULL != mask)
+        {
+          if ( (NULL == mask->data) || (CV_8UC1 != mask->type()) || (AllImages->width != mask->cols) || (AllImages->height != mask->rows) )
+            {
+              int const cnt = wprintf(gMsgProcessingInvalidMask, CameraID + 1, ProjectorID + 1, AllImages->width, AllImages->height);
+              assert(0 < cnt);
 
-      texture_idx = white; // Select texture image.
+              failed = true;
+            }
+          else
+            {
+              int mx = 0;
+              int my = 0;
+              int mw = 0;
+              int mh = 0;
+              have_pixels = GetMaskBoundingBox(mask, &mx, &my, &mw, &mh);
+
+              int const x1 = (x + w < mx + mw)? x + w : mx + mw;
+              int const y1 = (y + h < my + mh)? y + h : my + mh;
+              if (x < mx) x = mx;
+              if (y < my) y = my;
+              w = x1 - x;
+              h = y1 - y;
+            }
+          /* if */
+        }
+      /* if */
 
-      assert(false == failed);
+      // Clip to image.
+      {
+        int const x_end = (x + w < AllImages->width)? x + w : AllImages->width;
+        int const y_end = (y + h < AllImages->height)? y + h : AllImages->height;
+        if (0 > x) x = 0;
+        if (0 > y) y = 0;
+        w = x_end - x;
+        h = y_end - y;
+      }
 
-      // Compute relative phase.
-      if (false == failed)
+      if ( (false == failed) && ( (false == have_pixels) || (0 >= w) || (0 >= h) ) )
         {
-          rel_phase_col = EstimateRelativePhase(AllImages, ps_col_begin, ps_col_end);
-          assert(NULL != rel_phase_col);
-          failed = (NULL == rel_phase_col);
+          int const cnt = wprintf(gMsgProcessingEmptyRegionOfInterest, CameraID + 1, ProjectorID + 1);
+          assert(0 < cnt);
+
+          failed = true;
         }
       /* if */
 
-      if (false == failed)
+      if ( (false == failed) && ( (0 != x) || (0 != y) || (AllImages->width != w) || (AllImages->height != h) ) )
         {
-          double const duration = DebugTimerQueryLast( debug_timer );
-          Debugfwprintf(stderr, gMsgProcessingPSGCPhaseEstimationDuration, CameraID + 1, ProjectorID + 1, duration);
+          bool const view = AllImages->GetROIView(x, y, w, h, &ROIImages, &offset_x, &offset_y);
+          if (true == view)
+            {
+              Images = &ROIImages;
+
+              double const fraction = 100.0 * (double)(Images->width) * (double)(Images->height) / ( (double)(AllImages->width) * (double)(AllImages->height) );
+              Debugfwprintf(stderr, gMsgProcessingRegionOfInterest, CameraID + 1, ProjectorID + 1, Images->width, Images->height, offset_x, offset_y, fraction);
+            }
+          else
+            {
+              ROIImages.Blank();
+              offset_x = 0;
+              offset_y = 0;
+
+              int const cnt = wprintf(gMsgProcessingRegionOfInterestIgnored, CameraID + 1, ProjectorID + 1, StringFromImageDataType_inline(AllImages->PixelFormat));
+              assert(0 < cnt);
+            }
+          /* if */
         }
       /* if */
 
-      // Estimate dynamic range and texture.
-      if (false == failed)
+      if ( (false == failed) && (NULL != mask) )
         {
-          bool const update = UpdateDynamicRangeAndTexture(AllImages, ps_col_begin, ps_col_end, &dynamic_range, NULL);
-          assert( (true == update) && (NULL != dynamic_range) );
-          failed = (false == update);
-          if ( (true == update) && (NULL != texture) ) ++texture_n;
+          void * const data = (void *)( (BYTE *)(mask->data) + mask->step[0] * offset_y + offset_x );
+          mask_roi = new cv::Mat(Images->height, Images->width, CV_8UC1, data, mask->step[0]);
+          assert(NULL != mask_roi);
+          failed = (NULL == mask_roi);
         }
       /* if */
+    }
+  /* if */
 
-      if (false == failed)
+  double const elapsed_to_decoding = DebugTimerQueryStart( debug_timer );
+
+  // Decode projector coordinate.
+  if ( (false == failed) && (SL_METHOD_PSGC == decode_plan.family) )
+    {
+      /****** Phase shift and Gray code ******/
+
+      int const black = decode_plan.black; // Projector dimmed.
+      int const white = decode_plan.white; // Scene under white projector illumination.
+
+      texture_idx = white; // Select texture image.
+
+      for (int j = 0; j < decode_plan.num_directions; ++j)
         {
-          double const duration = DebugTimerQueryLast( debug_timer );
-          Debugfwprintf(stderr, gMsgProcessingPSGCDynamicRangeComputationDuration, CameraID + 1, ProjectorID + 1, duration);
+          SLDirectionPlan const * const dir = decode_plan.direction + j;
+
+          cv::Mat * abs_phase_dir = NULL; // Unwrapped normalized phase image for the current direction.
+
+          // Compute relative phase, dynamic range, and unwrap phase in a single pass.
+          if (false == failed)
+            {
+              abs_phase_dir = UnwrapPhasePSAndGCStreaming(
+                                                          Images,
+                                                          dir->ps_begin[0], dir->ps_end[0],
+                                                          dir->gc1_begin, dir->gc1_end,
+                                                          dir->gc2_begin, dir->gc2_end,
+                                                          black, white,
+                                                          true, atan2_method,
+                                                          0.0, NULL,
+                                                          &dynamic_range, NULL
+                                                          );
+              assert( (NULL != abs_phase_dir) && (NULL != dynamic_range) );
+              failed = (NULL == abs_phase_dir);
+              if ( (false == failed) && (NULL != texture) ) ++texture_n;
+            }
+          /* if */
+
+          if (false == failed)
+            {
+              double const duration = DebugTimerQueryLast( debug_timer );
+              Debugfwprintf(stderr, gMsgProcessingPSGCStreamingUnwrappingDuration, CameraID + 1, ProjectorID + 1, duration);
+            }
+          /* if */
+
+          // Store unwrapped phase.
+          if (false == failed)
+            {
+              if (true == dir->is_row)
+                {
+                  SWAP_ONE_VALID_PTR( abs_phase_row, abs_phase_dir );
+                }
+              else
+                {
+                  SWAP_ONE_VALID_PTR( abs_phase_col, abs_phase_dir );
+                }
+              /* if */
+            }
+          /* if */
+
+          SAFE_DELETE( abs_phase_dir );
         }
-      /* if */
+      /* for */
 
-      // Unwrap relative phase.
-      if (false == failed)
+      // Discard pixels outside the mask.
+      if ( (false == failed) && (NULL != mask_roi) )
         {
-          abs_phase_col = UnwrapPhasePSAndGC(
-                                             AllImages,
-                                             gc1_col_begin, gc1_col_end,
-                                             gc2_col_begin, gc2_col_end,
-                                             black, white,
-                                             rel_phase_col,
-                                             &gray_code_1_col, &gray_code_2_col
-                                             );
-          assert(NULL != abs_phase_col);
-          assert(NULL != gray_code_1_col);
-          assert(NULL != gray_code_2_col);
-          failed = (NULL == abs_phase_col) || (NULL == gray_code_1_col) || (NULL == gray_code_2_col);
+          bool const res = ApplyMaskToDynamicRange(dynamic_range, mask_roi);
+          assert(true == res);
+          failed = (true != res);
         }
       /* if */
 
+      // Get pixel coordinates.
       if (false == failed)
         {
-          double const duration = DebugTimerQueryLast( debug_timer );
-          Debugfwprintf(stderr, gMsgProcessingPSGCPhaseUnwrappingDuration, CameraID + 1, ProjectorID + 1, duration);
+          bool const res = GetValidPixelCoordinates(dynamic_range, abs_thr, &crd_x_image, &crd_y_image, &range_image);
+          assert(true == res);
+          failed = (true != res);
         }
       /* if */
+    }
+  else if ( (false == failed) && (SL_METHOD_MPS == decode_plan.family) )
+    {
+      /****** Multiple phase-shift ******/
+
+      texture_idx = -1; // There is no special texture image; texture is computed from phase shifted images instead.
 
-      // Swap row and column data if only row pattern is recorded.
-      if (true == ps_gc_row)
+      for (int j = 0; j < decode_plan.num_directions; ++j)
         {
-          assert(false == ps_gc_col);
+          SLDirectionPlan const * const dir = decode_plan.direction + j;
 
-          SWAP_ONE_VALID_PTR( rel_phase_row, rel_phase_col );
-          SWAP_ONE_VALID_PTR( gray_code_1_row, gray_code_1_col);
-          SWAP_ONE_VALID_PTR( gray_code_2_row, gray_code_2_col);
+          int const n_frq = dir->n_frq; // Number of frequencies.
+          std::vector<double> counts(dir->counts, dir->counts + n_frq); // Number of period counts per whole screen.
 
-          SWAP_ONE_VALID_PTR( abs_phase_row, abs_phase_col);
-        }
-      /* if */
+          cv::Mat * WP = NULL; // Interleaved relative phase image; one channel for each frequency.
+
+          cv::Mat * abs_phase_dir = NULL; // Unwrapped normalized phase image for the current direction.
+          cv::Mat * abs_phase_dir_idx = NULL; // Index into period-order vector array.
+          cv::Mat * abs_phase_dir_distance = NULL; // Distance to constellation.
+
+          MPSPlan * plan = NULL; // Unwrapping plan; owned by the plan cache.
+
+          // Fetch unwrapping parameters; the plan is constructed only once for each set of fringe counts.
+          if (false == failed)
+            {
+              plan = mps_plan_cache_get(counts, method, fname_geometry);
+              assert(NULL != plan);
+              failed = (NULL == plan);
+            }
+          /* if */
 
-      // Decode row data if both column and row pattern is recorded.
-      if (true == ps_gc_all)
-        {
-          // Compute relative phase.
           if (false == failed)
             {
-              rel_phase_row = EstimateRelativePhase(AllImages, ps_row_begin, ps_row_end);
-              assert(NULL != rel_phase_row);
-              failed = (NULL == rel_phase_row);
+              Debugfwprintf(stderr, gMsgProcessingMPSNearestCenterSearch, CameraID + 1, ProjectorID + 1, (NULL != plan->lut)? L"grid lookup table" : L"KD tree");
             }
           /* if */
 
           if (false == failed)
             {
               double const duration = DebugTimerQueryLast( debug_timer );
-              Debugfwprintf(stderr, gMsgProcessingPSGCPhaseEstimationDuration, CameraID + 1, ProjectorID + 1, duration);
+              Debugfwprintf(stderr, gMsgProcessingMPSPreparationDuration, CameraID + 1, ProjectorID + 1, duration);
             }
           /* if */
 
-          // Estimate dynamic range and texture.
+          // Allocate interleaved relative phase image.
           if (false == failed)
             {
-              bool const update = UpdateDynamicRangeAndTexture(AllImages, ps_row_begin, ps_row_end, &dynamic_range, NULL);
-              assert( (true == update) && (NULL != dynamic_range) );
-              failed = (false == update);
-              if ( (true == update) && (NULL != texture) ) ++texture_n;
+              assert( (2 <= n_frq) && (n_frq <= MPS_MAX_WAVELENGTHS) );
+              failed = (2 > n_frq) || (n_frq > MPS_MAX_WAVELENGTHS);
             }
           /* if */
 
           if (false == failed)
             {
-              double const duration = DebugTimerQueryLast( debug_timer );
-              Debugfwprintf(stderr, gMsgProcessingPSGCDynamicRangeComputationDuration, CameraID + 1, ProjectorID + 1, duration);
+              int const depth = (MPS_PRECISION_SINGLE == mps_precision)? CV_32F : CV_64F;
+              WP = new cv::Mat(Images->height, Images->width, CV_MAKETYPE(depth, n_frq));
+              assert( (NULL != WP) && (NULL != WP->data) );
+              failed = (NULL == WP) || (NULL == WP->data);
             }
           /* if */
 
-          // Unwrap relative phase.
+          // Process frames.
+          {
+            for (int i = 0; i < n_frq; ++i)
+              {
+                int const idx_begin = dir->ps_begin[i]; // Starting frame index.
+                int const idx_end = dir->ps_end[i]; // Ending frame index.
+
+                // Compute relative phases, dynamic ranges, and texture in one pass over the frames.
+                if (false == failed)
+                  {
+                    bool const estimate =
+                      EstimateRelativePhaseDynamicRangeAndTextureTiled(
+                                                                       Images, idx_begin, idx_end, true, atan2_method, WP, i,
+                                                                       &dynamic_range, &texture
+                                                                       );
+                    assert( (true == estimate) && (NULL != dynamic_range) && (NULL != texture) );
+                    failed = (false == estimate);
+                    if ( (true == estimate) && (NULL != texture) ) ++texture_n;
+                  }
+                /* if */
+              }
+            /* for */
+
+            if (false == failed)
+              {
+                double const duration = DebugTimerQueryLast( debug_timer );
+                Debugfwprintf(stderr, gMsgProcessingMPSPhaseEstimationDuration, CameraID + 1, ProjectorID + 1, duration);
+              }
+            /* if */
+          }
+
+          // Unwrap phase.
           if (false == failed)
             {
-              abs_phase_row = UnwrapPhasePSAndGC(
-                                                 AllImages,
-                                                 gc1_row_begin, gc1_row_end,
-                                                 gc2_row_begin, gc2_row_end,
-                                                 black, white,
-                                                 rel_phase_row,
-                                                 &gray_code_1_row, &gray_code_2_row
-                                                 );
-              assert(NULL != abs_phase_row);
-              assert(NULL != gray_code_1_row);
-              assert(NULL != gray_code_2_row);
-              failed = (NULL == abs_phase_row) || (NULL == gray_code_1_row) || (NULL == gray_code_2_row);
+              bool const unwrap = mps_unwrap_phase(
+                                                   WP, plan->O, plan->X, plan->K, plan->tree, plan->lut, *(plan->n), *(plan->wgt),
+                                                   &abs_phase_dir_idx, &abs_phase_dir_distance, &abs_phase_dir
+                                                   );
+              assert(true == unwrap);
+              failed = (false == unwrap);
             }
           /* if */
 
           if (false == failed)
             {
               double const duration = DebugTimerQueryLast( debug_timer );
-              Debugfwprintf(stderr, gMsgProcessingPSGCPhaseUnwrappingDuration, CameraID + 1, ProjectorID + 1, duration);
+              Debugfwprintf(stderr, gMsgProcessingMPSPhaseUnwrappingDuration, CameraID + 1, ProjectorID + 1, duration);
+            }
+          /* if */
+
+          // Store unwrapped phase and distance to constellation.
+          if (false == failed)
+            {
+              if (true == dir->is_row)
+                {
+                  SWAP_ONE_VALID_PTR( abs_phase_row, abs_phase_dir );
+                  SWAP_ONE_VALID_PTR( abs_phase_row_distance, abs_phase_dir_distance );
+                }
+              else
+                {
+                  SWAP_ONE_VALID_PTR( abs_phase_col, abs_phase_dir );
+                  SWAP_ONE_VALID_PTR( abs_phase_col_distance, abs_phase_dir_distance );
+                }
+              /* if */
             }
           /* if */
+
+          // Release memory.
+          SAFE_DELETE( WP );
+          SAFE_DELETE( abs_phase_dir );
+          SAFE_DELETE( abs_phase_dir_idx );
+          SAFE_DELETE( abs_phase_dir_distance );
         }
-      else
+      /* for */
+
+      // Discard pixels outside the mask.
+      if ( (false == failed) && (NULL != mask_roi) )
         {
-          assert(NULL != dynamic_range);
+          bool const res = ApplyMaskToDynamicRange(dynamic_range, mask_roi);
+          assert(true == res);
+          failed = (true != res);
         }
       /* if */
 
@@ -2093,382 +2579,23 @@ ProcessAcquiredImages(
           failed = (true != res);
         }
       /* if */
-
-      SAFE_DELETE( rel_phase_col );
-      SAFE_DELETE( gray_code_1_col );
-      SAFE_DELETE( gray_code_2_col );
-
-      SAFE_DELETE( rel_phase_row );
-      SAFE_DELETE( gray_code_1_row );
-      SAFE_DELETE( gray_code_2_row );
     }
-  else if ( (true == mps_two_col) || (true == mps_two_row) || (true == mps_two_all) ||
-            (true == mps_three_col) || (true == mps_three_row) || (true == mps_three_all)
-            )
+  else
     {
-      /****** Multiple phase-shift ******/
+      failed = true;
+    }
+  /* if */
 
-      std::vector<double> counts; // Number of period counts per whole screen.
-      std::vector<int> ps_begin; // Starting image index for each frequency.
-      std::vector<int> ps_end; // Ending image index for each frequency.
+  // Prepare texture. Failure of this operation does not affect further processing.
+  if (false == failed)
+    {
+      {
+        double const duration = DebugTimerQueryStart( debug_timer ) - elapsed_to_decoding;
+        Debugfwprintf(stderr, gMsgProcessingDecodeSLCodeDuration, CameraID + 1, ProjectorID + 1, duration);
 
-      int n_frq = 0; // Number of frequencies.
-      int n_phs = 0; // Number of relative phases.
-
-      if ( (true == mps_two_col) || (true == mps_two_row) || (true == mps_two_all) )
-        {
-          n_frq = 2;
-          n_phs = 2 * n_frq; // We assume both column and row codes are projected.
-
-          counts.reserve( (size_t)n_frq ); // Number of periods per screen for each frequency.
-          counts.push_back(15.0); // Number of periods per screen for the first frequency.
-          counts.push_back(19.0); // Number of periods per screen for the second frequency.
-
-          ps_begin.reserve( (size_t)n_phs ); // Starting image index for each frequency; first column then row code.
-          ps_begin.push_back(0);
-          ps_begin.push_back(8);
-          ps_begin.push_back(16);
-          ps_begin.push_back(24);
-
-          ps_end.reserve( (size_t)n_phs ); // Ending image index for each frequency; first column then row code.
-          ps_end.push_back(7);
-          ps_end.push_back(15);
-          ps_end.push_back(23);
-          ps_end.push_back(31);
-
-          texture_idx = -1; // There is no special texture image; texture is computed from phase shifted images instead.
-
-          assert(false == failed);
-        }
-      else if ( (true == mps_three_col) || (true == mps_three_row) || (true == mps_three_all) )
-        {
-          n_frq = 3; // Number of frequencies.
-          n_phs = 2 * n_frq; // We assume both column and row codes are projected.
-
-          counts.reserve( (size_t)n_frq );
-          counts.push_back(20.0);
-          counts.push_back(21.0);
-          counts.push_back(25.0);
-
-          ps_begin.reserve( (size_t)n_phs ); // Starting image index for each frequency; first column then row code.
-          ps_begin.push_back(0);
-          ps_begin.push_back(3);
-          ps_begin.push_back(6);
-          ps_begin.push_back(9);
-          ps_begin.push_back(12);
-          ps_begin.push_back(15);
-
-          ps_end.reserve( (size_t)n_phs ); // Ending image index for each frequency; first column then row code.
-          ps_end.push_back(2);
-          ps_end.push_back(5);
-          ps_end.push_back(8);
-          ps_end.push_back(11);
-          ps_end.push_back(14);
-          ps_end.push_back(17);
-
-          texture_idx = -1; // There is no special texture image; texture is computed from phase shifted images instead.
-
-          assert(false == failed);
-        }
-      else
-        {
-          failed = true;
-        }
-      /* if */
-
-      assert( ps_begin.size() == ps_end.size() );
-
-      std::vector<cv::Mat *> WP_col; // Relative phase images for columns.
-      WP_col.reserve( (size_t)n_frq );
-
-      std::vector<cv::Mat *> WP_row; // Relative phase images for rows.
-      WP_row.reserve( (size_t)n_frq );
-
-      cv::Mat * abs_phase_col_idx = NULL; // Index into period-order vector array.
-      cv::Mat * abs_phase_row_idx = NULL; // Index into period-order vector array.
-
-      cv::Mat * O = NULL; // Orthographic projection matrix.
-      cv::Mat * Xk = NULL; // Regular constellation points.
-      cv::Mat * kk = NULL; // Regular period-order vectors.
-      cv::Mat * Xw = NULL; // Wrapped constellation points.
-      cv::Mat * kw = NULL; // Wrapped period-order vectors.
-      cv::Mat * X = NULL; // All constellation points.
-      cv::Mat * K = NULL; // All period-order vectors.
-
-      KDTreeRoot * tree = NULL; // KD tree.
-
-      std::vector<int> * k_max = NULL; // Maximal period number for each wavelength.
-      std::vector<double> * wgt = NULL; // Vector of weights used to combine unwrapped phases.
-      std::vector<double> * lambda = NULL; // Vector of wavelengths.
-
-      // Pre-compute unwrapping parameters.
-      double width = std::numeric_limits<double>::quiet_NaN();
-      if (false == failed)
-        {
-          // Get wavelengths and width from period counts.
-          bool const get = mps_periods_from_fringe_counts(counts, width, &lambda, &width);
-          assert(true == get);
-          failed = (false == get) && (NULL != lambda);
-        }
-      /* if */
-
-      if (false == failed)
-        {
-          // Get orthographic projection matrix and centers.
-          bool const get = mps_get_projection_matrix_and_centers(*lambda, width, &O, &Xk, &kk, &Xw, &kw, NULL, &width);
-          assert(true == get);
-          failed = (false == get);
-        }
-      /* if */
-
-      if (false == failed)
-        {
-          // Construct KD tree.
-          bool const get = mps_get_kd_tree(Xk, kk, Xw, kw, &X, &K, &k_max, &tree);
-          assert(true == get);
-          failed = (false == get);
-
-          // Release unneeded storage.
-          SAFE_DELETE( Xk );
-          SAFE_DELETE( kk );
-          SAFE_DELETE( Xw );
-          SAFE_DELETE( kw );
-        }
-      /* if */
-
-      if (false == failed)
-        {
-          // Get standard weights.
-          bool const get = mps_get_weights(*lambda, &wgt);
-          assert(true == get);
-          failed = (false == get);
-        }
-      /* if */
-
-      if (false == failed)
-        {
-          double const duration = DebugTimerQueryLast( debug_timer );
-          Debugfwprintf(stderr, gMsgProcessingMPSPreparationDuration, CameraID + 1, ProjectorID + 1, duration);
-        }
-      /* if */
-
-      // Process column frames.
-      {
-        double duration_phase = 0.0;
-        double duration_dynamic_range_and_texture = 0.0;
-
-        for (int i = 0; i < n_frq; ++i)
-          {
-            int const idx_begin = ps_begin[i]; // Starting frame index.
-            int const idx_end = ps_end[i]; // Ending frame index.
-
-            // Compute relative phases.
-            if (false == failed)
-              {
-                DebugTimerQueryTic( debug_timer );
-
-                cv::Mat * const rel_phase = EstimateRelativePhase(AllImages, idx_begin, idx_end);
-                assert(NULL != rel_phase);
-                failed = (NULL == rel_phase);
-
-                WP_col.push_back(rel_phase);
-
-                duration_phase += DebugTimerQueryToc( debug_timer );
-              }
-            /* if */
-
-            // Compute dynamic ranges and texture.
-            if (false == failed)
-              {
-                DebugTimerQueryTic( debug_timer );
-
-                bool const update = UpdateDynamicRangeAndTexture(AllImages, idx_begin, idx_end, &dynamic_range, &texture);
-                assert( (true == update) && (NULL != dynamic_range) && (NULL != texture) );
-                failed = (false == update);
-                if ( (true == update) && (NULL != texture) ) ++texture_n;
-
-                duration_dynamic_range_and_texture += DebugTimerQueryToc( debug_timer );
-              }
-            /* if */
-          }
-        /* for */
-
-        if (false == failed)
-          {
-            double const duration = DebugTimerQueryLast( debug_timer );
-
-            Debugfwprintf(stderr, gMsgProcessingMPSPhaseEstimationDuration, CameraID + 1, ProjectorID + 1, duration_phase);
-            Debugfwprintf(stderr, gMsgProcessingMPSDynamicRangeAndTextureComputationDuration, CameraID + 1, ProjectorID + 1, duration_dynamic_range_and_texture);
-          }
-        /* if */
-      }
-
-      // Unwrap phase.
-      if (false == failed)
-        {
-          std::vector<double> n; // Maximal fringe counts for each wavelength.
-          n.reserve( k_max->size() );
-          int const i_max = (int)k_max->size();
-          for (int i = 0; i < i_max; ++i) n.push_back((double)((*k_max)[i] + 1));
-
-          bool const unwrap = mps_unwrap_phase(WP_col, O, X, K, tree, n, *wgt, &abs_phase_col_idx, &abs_phase_col_distance, &abs_phase_col);
-          assert(true == unwrap);
-          failed = (false == unwrap);
-        }
-      /* if */
-
-      if (false == failed)
-        {
-          double const duration = DebugTimerQueryLast( debug_timer );
-          Debugfwprintf(stderr, gMsgProcessingMPSPhaseUnwrappingDuration, CameraID + 1, ProjectorID + 1, duration);
-        }
-      /* if */
-
-      // Swap row and column data if only row pattern is recorded.
-      if ( (true == mps_two_row) || (true == mps_three_row) )
-        {
-          assert(false == mps_two_col);
-          assert(false == mps_three_col);
-
-          std::swap(WP_col, WP_row);
-
-          SWAP_ONE_VALID_PTR( abs_phase_row_idx, abs_phase_col_idx );
-          SWAP_ONE_VALID_PTR( abs_phase_row_distance, abs_phase_col_distance );
-          SWAP_ONE_VALID_PTR( abs_phase_row, abs_phase_col );
-        }
-      /* if */
-
-      // Decode row data if both column and row pattern is recorded.
-      if ( (true == mps_two_all) || (true == mps_three_all) )
-        {
-          // Process row frames.
-          {
-            double duration_phase = 0.0;
-            double duration_dynamic_range_and_texture = 0.0;
-
-            for (int i = 0; i < n_frq; ++i)
-              {
-                int const offset = n_frq;
-                int const idx_begin = ps_begin[offset + i]; // Starting frame index.
-                int const idx_end = ps_end[offset + i]; // Ending frame index.
-
-                // Compute relative phases.
-                if (false == failed)
-                  {
-                    DebugTimerQueryTic( debug_timer );
-
-                    cv::Mat * const rel_phase = EstimateRelativePhase(AllImages, idx_begin, idx_end);
-                    assert(NULL != rel_phase);
-                    failed = (NULL == rel_phase);
-
-                    WP_row.push_back(rel_phase);
-
-                    duration_phase += DebugTimerQueryToc( debug_timer );
-                  }
-                /* if */
-
-                // Compute dynamic ranges and texture.
-                if (false == failed)
-                  {
-                    DebugTimerQueryTic( debug_timer );
-
-                    bool const update = UpdateDynamicRangeAndTexture(AllImages, idx_begin, idx_end, &dynamic_range, &texture);
-                    assert( (true == update) && (NULL != dynamic_range) && (NULL != texture) );
-                    failed = (false == update);
-                    if ( (true == update) && (NULL != texture) ) ++texture_n;
-
-                    duration_dynamic_range_and_texture += DebugTimerQueryToc( debug_timer );
-                  }
-                /* if */
-              }
-            /* for */
-
-            if (false == failed)
-              {
-                double const duration = DebugTimerQueryLast( debug_timer );
-
-                Debugfwprintf(stderr, gMsgProcessingMPSPhaseEstimationDuration, CameraID + 1, ProjectorID + 1, duration_phase);
-                Debugfwprintf(stderr, gMsgProcessingMPSDynamicRangeAndTextureComputationDuration, CameraID + 1, ProjectorID + 1, duration_dynamic_range_and_texture);
-              }
-            /* if */
-          }
-
-          // Unwrap phase.
-          if (false == failed)
-            {
-              std::vector<double> n; // Maximal fringe counts for each wavelength.
-              n.reserve( k_max->size() );
-              int const i_max = (int)k_max->size();
-              for (int i = 0; i < i_max; ++i) n.push_back((double)((*k_max)[i] + 1));
-
-              bool const unwrap = mps_unwrap_phase(WP_row, O, X, K, tree, n, *wgt, &abs_phase_row_idx, &abs_phase_row_distance, &abs_phase_row);
-              assert(true == unwrap);
-              failed = (false == unwrap);
-            }
-          /* if */
-
-          if (false == failed)
-            {
-              double const duration = DebugTimerQueryLast( debug_timer );
-              Debugfwprintf(stderr, gMsgProcessingMPSPhaseUnwrappingDuration, CameraID + 1, ProjectorID + 1, duration);
-            }
-          /* if */
-        }
-      /* if */
-
-      // Get pixel coordinates.
-      if (false == failed)
-        {
-          bool const res = GetValidPixelCoordinates(dynamic_range, abs_thr, &crd_x_image, &crd_y_image, &range_image);
-          assert(true == res);
-          failed = (true != res);
-        }
-      /* if */
-
-      // Release memory.
-      {
-        int const max_i = (int)WP_col.size();
-        for (int i = 0; i < max_i; ++i) SAFE_DELETE( WP_col[i] );
-      }
-
-      {
-        int const max_i = (int)WP_row.size();
-        for (int i = 0; i < max_i; ++i) SAFE_DELETE( WP_row[i] );
-      }
-
-      SAFE_DELETE( abs_phase_col_idx );
-      SAFE_DELETE( abs_phase_row_idx );
-
-      SAFE_DELETE( O );
-      SAFE_DELETE( Xk );
-      SAFE_DELETE( kk );
-      SAFE_DELETE( Xw );
-      SAFE_DELETE( kw );
-      SAFE_DELETE( X );
-      SAFE_DELETE( K );
-
-      SAFE_DELETE( tree );
-
-      SAFE_DELETE( k_max );
-      SAFE_DELETE( wgt );
-      SAFE_DELETE( lambda );
-    }
-  else
-    {
-      failed = true;
-    }
-  /* if */
-
-  // Prepare texture. Failure of this operation does not affect further processing.
-  if (false == failed)
-    {
-      {
-        double const duration = DebugTimerQueryStart( debug_timer ) - elapsed_to_decoding;
-        Debugfwprintf(stderr, gMsgProcessingDecodeSLCodeDuration, CameraID + 1, ProjectorID + 1, duration);
-
-        int const count = Debugfwprintf(stderr, gMsgProcessingPrepareTexture, CameraID + 1, ProjectorID + 1);
-        assert(0 < count);
-      }
+        int const count = Debugfwprintf(stderr, gMsgProcessingPrepareTexture, CameraID + 1, ProjectorID + 1);
+        assert(0 < count);
+      }
 
       if (NULL != texture)
         {
@@ -2484,7 +2611,7 @@ ProcessAcquiredImages(
         }
       else
         {
-          texture = FetchTexture(AllImages, texture_idx);
+          texture = FetchTexture(Images, texture_idx);
           assert(NULL != texture);
         }
       /* if */
@@ -2502,38 +2629,20 @@ ProcessAcquiredImages(
         assert(0 < count);
       }
 
-      // Get statistics for columns.
-      if (NULL != abs_phase_col)
+      // Get statistics for columns and rows and combine them; statistics are skipped if the processed region is not larger than the window.
+      cv::Mat const * const abs_phase_any = (NULL != abs_phase_col)? abs_phase_col : abs_phase_row;
+      if ( (NULL != abs_phase_any) && ( (abs_phase_any->cols <= stat_win) || (abs_phase_any->rows <= stat_win) ) )
         {
-          bool const res = GetAbsolutePhaseOrderAndDeviation(abs_phase_col, 5, 5, &abs_phase_col_order, &abs_phase_col_deviation);
-          assert(true == res);
+          int const count = Debugfwprintf(stderr, gMsgProcessingPhaseStatisticsSkipped, CameraID + 1, ProjectorID + 1, abs_phase_any->cols, abs_phase_any->rows, stat_win, stat_win);
+          assert(0 < count);
         }
-      /* if */
-
-      // Get statistics for rows.
-      if (NULL != abs_phase_row)
+      else if (NULL != abs_phase_any)
         {
-          bool const res = GetAbsolutePhaseOrderAndDeviation(abs_phase_row, 5, 5, &abs_phase_row_order, &abs_phase_row_deviation);
+          bool const res = GetCombinedAbsolutePhaseOrderAndDeviation(abs_phase_col, abs_phase_row, stat_win, stat_win, &abs_phase_order, &abs_phase_deviation);
           assert(true == res);
         }
       /* if */
 
-      // Combine phase deviations.
-      if ( (NULL != abs_phase_col_deviation) && (NULL != abs_phase_row_deviation) )
-        {
-          abs_phase_deviation = CombinePhaseDeviationOrDistance(abs_phase_col_deviation, abs_phase_row_deviation);
-          assert(NULL != abs_phase_deviation);
-        }
-      else if ( (NULL != abs_phase_col_deviation) && (NULL == abs_phase_row_deviation) )
-        {
-          SWAP_ONE_VALID_PTR( abs_phase_deviation, abs_phase_col_deviation );
-        }
-      else if ( (NULL == abs_phase_col_deviation) && (NULL != abs_phase_row_deviation) )
-        {
-          SWAP_ONE_VALID_PTR( abs_phase_deviation, abs_phase_row_deviation );
-        }
-      /* if */
-
       // Combine distances to constellation.
       if ( (NULL != abs_phase_col_distance) && (NULL != abs_phase_row_distance) )
         {
@@ -2551,18 +2660,9 @@ ProcessAcquiredImages(
       else
         {
           // Substituted distance to constellation with phase order.
-          if ( (NULL != abs_phase_col_order) && (NULL != abs_phase_row_order) )
-            {
-              abs_phase_distance = CombinePhaseDeviationOrDistance(abs_phase_col_order, abs_phase_row_order);
-              assert(NULL != abs_phase_distance);
-            }
-          else if ( (NULL != abs_phase_col_order) && (NULL == abs_phase_row_order) )
-            {
-              SWAP_ONE_VALID_PTR( abs_phase_distance, abs_phase_col_order );
-            }
-          else if ( (NULL == abs_phase_col_order) && (NULL != abs_phase_row_order) )
+          if (NULL != abs_phase_order)
             {
-              SWAP_ONE_VALID_PTR( abs_phase_distance, abs_phase_row_order ); 
+              SWAP_ONE_VALID_PTR( abs_phase_distance, abs_phase_order );
             }
           /* if */
         }
@@ -2570,11 +2670,8 @@ ProcessAcquiredImages(
 
       // Release un-needed memory.
       SAFE_DELETE( abs_phase_col_distance );
-      SAFE_DELETE( abs_phase_col_order );
-      SAFE_DELETE( abs_phase_col_deviation );
       SAFE_DELETE( abs_phase_row_distance );
-      SAFE_DELETE( abs_phase_row_order );
-      SAFE_DELETE( abs_phase_row_deviation );      
+      SAFE_DELETE( abs_phase_order );
     }
   /* if */
 
@@ -2588,30 +2685,91 @@ ProcessAcquiredImages(
     }
   /* if */
 
-  // Undistort pixel coordinates.
+  // Test what coordinates we have.
+  bool const have_col = (NULL != abs_phase_col);
+  bool const have_row = (NULL != abs_phase_row);
+  bool const have_both = (have_col && have_row);
+
+  // Get cached phase-to-XYZ model of the full sensor for single-direction codes; if there is no model then views are triangulated.
+  if ( (false == failed) && (false == have_both) )
+    {
+      xyz_model = PhaseToXYZModelCacheGet(
+                                          &camera, &projector, // Camera and projector geometry.
+                                          AllImages->width, AllImages->height, // Sensor size.
+                                          1, 1, // Shift to get Matlab coordinates from OpenCV coordinates.
+                                          (true == have_col)? 0 : 1, // Decoded projector coordinate.
+                                          (true == have_col)? pr_width : pr_height // Projector size.
+                                          );
+    }
+  /* if */
+
+  // Get cached camera rays of the full sensor; if there is no table then pixel coordinates are undistorted.
+  // Table is also used for points which are rejected by the phase-to-XYZ model.
   if (false == failed)
     {
-      bool const res =
-        UndistortImageCoordinatesForRadialDistorsion(
-                                                     crd_x_image, crd_y_image, // OpenCV image coordinates.
-                                                     1, 1, // Shift to get Matlab coordinates from OpenCV coordinates.
-                                                     camera.fx, camera.fy, // Internal camera parameters.
-                                                     camera.cx, camera.cy,
-                                                     camera.k0, camera.k1,
-                                                     &crd_x_camera, &crd_y_camera // Undistorted camera coordinates.
-                                                     );
+      ray_table = CameraRayTableCacheGet(
+                                         &camera, // Camera geometry.
+                                         AllImages->width, AllImages->height, // Sensor size.
+                                         1, 1 // Shift to get Matlab coordinates from OpenCV coordinates.
+                                         );
+    }
+  /* if */
+
+  // Compute points directly from absolute phase.
+  if ( (false == failed) && (NULL != xyz_model) )
+    {
+      bool const res = TriangulateUsingPhaseToXYZModel(
+                                                       xyz_model, ray_table,
+                                                       crd_x_image, crd_y_image, // OpenCV image coordinates relative to the ROI.
+                                                       offset_x, offset_y, // Position of the ROI in the full frame.
+                                                       (true == have_col)? abs_phase_col : abs_phase_row, // Absolute phase.
+                                                       &x_3D, &y_3D, &z_3D // Triangulated points.
+                                                       );
       assert(true == res);
       failed = (true != res);
     }
   /* if */
 
-  // Test what coordinates we have.
-  bool const have_col = (NULL != abs_phase_col);
-  bool const have_row = (NULL != abs_phase_row);
-  bool const have_both = (have_col && have_row);
+  // Undistort pixel coordinates by fetching them from the cached undistortion table of the full sensor.
+  if ( (false == failed) && (NULL == xyz_model) && (NULL == ray_table) )
+    {
+      UndistortionLUT const * const lut = UndistortionLUTCacheGet(
+                                                                  &camera, // Internal camera parameters.
+                                                                  AllImages->width, AllImages->height, // Sensor size.
+                                                                  1, 1 // Shift to get Matlab coordinates from OpenCV coordinates.
+                                                                  );
+      assert(NULL != lut);
+
+      bool res = false;
+      if (NULL != lut)
+        {
+          res = UndistortImageCoordinatesUsingLUT(
+                                                  crd_x_image, crd_y_image, // OpenCV image coordinates relative to the ROI.
+                                                  offset_x, offset_y, // Position of the ROI in the full frame.
+                                                  lut,
+                                                  &crd_x_camera, &crd_y_camera // Undistorted camera coordinates.
+                                                  );
+        }
+      else
+        {
+          res = UndistortImageCoordinatesForRadialDistorsion(
+                                                             crd_x_image, crd_y_image, // OpenCV image coordinates relative to the ROI.
+                                                             1 + offset_x, 1 + offset_y, // Shift to get full frame Matlab coordinates from OpenCV coordinates.
+                                                             camera.fx, camera.fy, // Internal camera parameters.
+                                                             camera.cx, camera.cy,
+                                                             camera.k0, camera.k1,
+                                                             &crd_x_camera, &crd_y_camera // Undistorted camera coordinates.
+                                                             );
+        }
+      /* if */
+      UndistortionLUTCacheRelease( lut );
+      assert(true == res);
+      failed = (true != res);
+    }
+  /* if */
 
   // Get projector coordinates.
-  if (false == failed)
+  if ( (false == failed) && (NULL == xyz_model) )
     {
       if (true == have_col)
         {
@@ -2638,130 +2796,88 @@ ProcessAcquiredImages(
     }
   /* if */
 
-  // Triangulate views using one projector coordinate only and reproject points to projector plane.
-  if ( false == have_both )
+  // Triangulate views using one projector coordinate only; missing projector coordinate is refined in the same pass.
+  if ( (false == failed) && (false == have_both) && (NULL == xyz_model) )
     {
-      if (true == have_col)
-        {
-          assert(false == have_row);
-          if (false == failed)
-            {
-              bool const res = TriangulateTwoViews(
-                                                   &camera,
-                                                   crd_x_camera, crd_y_camera, // Undistorted camera coordinates.
-                                                   &projector,
-                                                   projector_col, NULL, // Projector column index, distorted.
-                                                   &x_3D, &y_3D, &z_3D, // Triangulated points.
-                                                   NULL // Distance is not required.
-                                                   );
-              assert(true == res);
-              failed = (true != res);
-            }
-          /* if */
-        }
-      /* if */
-
-      if (true == have_row)
-        {
-          assert(false == have_col);
-          if (false == failed)
-            {
-              bool const res = TriangulateTwoViews(
-                                                   &camera,
-                                                   crd_x_camera, crd_y_camera, // Undistorted camera coordinates.
-                                                   &projector,
-                                                   NULL, projector_row, // Projector row index, distorted.
-                                                   &x_3D, &y_3D, &z_3D, // Triangulated points.
-                                                   NULL // Distance is not required.
-                                                   );
-              assert(true == res);
-              failed = (true != res);
-            }
-          /* if */
-        }
-      /* if */
-
-      // Re-project to projector plane.
-      if (false == failed)
-        {
-          bool const res = ProjectPoints(&projector, x_3D, y_3D, z_3D, &projector_col_est, &projector_row_est);
-          assert(true == res);
-          failed = (true != res);
-        }
-      /* if */
+      bool const res = TriangulateSingleDirection(
+                                                  &camera, ray_table,
+                                                  (NULL != ray_table)? crd_x_image : crd_x_camera, // OpenCV image coordinates relative to the ROI or undistorted camera coordinates.
+                                                  (NULL != ray_table)? crd_y_image : crd_y_camera,
+                                                  offset_x, offset_y, // Position of the ROI in the full frame.
+                                                  &projector,
+                                                  projector_col, projector_row, // Projector column or row index, distorted.
+                                                  SINGLE_DIRECTION_TRIANGULATION_ITERATIONS,
+                                                  &x_3D, &y_3D, &z_3D, // Triangulated points.
+                                                  &dst2_3D
+                                                  );
+      assert(true == res);
+      failed = (true != res);
     }
   /* if */
 
-
   // Undistort projector coordinates.
-  if (false == failed)
+  if ( (false == failed) && (true == have_both) )
     {
-      if (true == have_both)
+      ProjectorUndistortionLUT const * const lut = ProjectorUndistortionLUTCacheGet(
+                                                                                    &projector, // Internal projector parameters.
+                                                                                    PROJECTOR_UNDISTORTION_LUT_STEP,
+                                                                                    PROJECTOR_UNDISTORTION_LUT_TOLERANCE
+                                                                                    );
+
+      bool res = false;
+      if (NULL != lut)
         {
-          bool const res =
-            UndistortImageCoordinatesForRadialDistorsion(
-                                                         projector_col, projector_row, // OpenCV image coordinates.
-                                                         projector.fx, projector.fy, // Internal projector parameters.
-                                                         projector.cx, projector.cy,
-                                                         projector.k0, projector.k1,
-                                                         &crd_x_projector, &crd_y_projector // Undistorted projector coordinates.
-                                                         );
-          assert(true == res);
-          failed = (true != res);
+          res = UndistortProjectorCoordinatesUsingLUT(
+                                                      projector_col, projector_row, // OpenCV image coordinates.
+                                                      lut,
+                                                      &crd_x_projector, &crd_y_projector // Undistorted projector coordinates.
+                                                      );
         }
       else
         {
-          if (true == have_col)
-            {
-              assert( (false == have_row) && (NULL == projector_row) );
-              bool const res =
-                UndistortImageCoordinatesForRadialDistorsion(
-                                                             projector_col, projector_row_est, // OpenCV image coordinates.
+          res = UndistortImageCoordinatesForRadialDistorsion(
+                                                             projector_col, projector_row, // OpenCV image coordinates.
                                                              projector.fx, projector.fy, // Internal projector parameters.
                                                              projector.cx, projector.cy,
                                                              projector.k0, projector.k1,
                                                              &crd_x_projector, &crd_y_projector // Undistorted projector coordinates.
                                                              );
-              assert(true == res);
-              failed = (true != res);
-            }
-          /* if */
-
-          if (true == have_row)
-            {
-              assert( (false == have_col) && (NULL == projector_col) );
-              bool const res =
-                UndistortImageCoordinatesForRadialDistorsion(
-                                                             projector_col_est, projector_row, // OpenCV image coordinates.
-                                                             projector.fx, projector.fy, // Internal projector parameters.
-                                                             projector.cx, projector.cy,
-                                                             projector.k0, projector.k1,
-                                                             &crd_x_projector, &crd_y_projector // Undistorted projector coordinates.
-                                                             );
-              assert(true == res);
-              failed = (true != res);
-            }
-          /* if */
         }
       /* if */
+      ProjectorUndistortionLUTCacheRelease( lut );
+      assert(true == res);
+      failed = (true != res);
     }
   /* if */
 
-  // Re-triangulate views.
-  if (false == failed)
+  // Triangulate views.
+  if ( (false == failed) && (true == have_both) )
     {
-      SAFE_DELETE( x_3D );
-      SAFE_DELETE( y_3D );
-      SAFE_DELETE( z_3D );
-
-      bool const res = TriangulateTwoViews(
-                                           &camera,
-                                           crd_x_camera, crd_y_camera, // Undistorted camera coordinates.
-                                           &projector,
-                                           crd_x_projector, crd_y_projector, // Undistorted projector coordinates.
-                                           &x_3D, &y_3D, &z_3D, // Triangulated points.
-                                           &dst2_3D
-                                           );
+      bool res = false;
+      if (NULL != ray_table)
+        {
+          res = TriangulateTwoViewsUsingRayTable(
+                                                 &camera, ray_table,
+                                                 crd_x_image, crd_y_image, // OpenCV image coordinates relative to the ROI.
+                                                 offset_x, offset_y, // Position of the ROI in the full frame.
+                                                 &projector,
+                                                 crd_x_projector, crd_y_projector, // Undistorted projector coordinates.
+                                                 &x_3D, &y_3D, &z_3D, // Triangulated points.
+                                                 &dst2_3D
+                                                 );
+        }
+      else
+        {
+          res = TriangulateTwoViews(
+                                    &camera,
+                                    crd_x_camera, crd_y_camera, // Undistorted camera coordinates.
+                                    &projector,
+                                    crd_x_projector, crd_y_projector, // Undistorted projector coordinates.
+                                    &x_3D, &y_3D, &z_3D, // Triangulated points.
+                                    &dst2_3D
+                                    );
+        }
+      /* if */
       assert(true == res);
       failed = (true != res);
     }
@@ -2786,7 +2902,7 @@ ProcessAcquiredImages(
                                                               dst2_thr, // Uncertainty threshold.
                                                               crd_x_image, crd_y_image, // Camera image coordinates.
                                                               range_image, // Dynamic range.
-                                                              AllImages, // Image buffers.
+                                                              Images, // Image buffers.
                                                               texture, // Texture image.
                                                               abs_phase_distance, // Distance to constellation of unwrapped phase.
                                                               abs_phase_deviation, // Standard deviation of unwrapped phase.
@@ -2832,16 +2948,17 @@ ProcessAcquiredImages(
 
  ProcessAcquiredImages_EXIT:
 
+  // Release cached tables.
+  PhaseToXYZModelCacheRelease( xyz_model );
+  CameraRayTableCacheRelease( ray_table );
+
   // Deallocate storage.
   SAFE_DELETE( abs_phase_col );
   SAFE_DELETE( abs_phase_col_distance );
-  SAFE_DELETE( abs_phase_col_order );
-  SAFE_DELETE( abs_phase_col_deviation );
   SAFE_DELETE( abs_phase_row );
   SAFE_DELETE( abs_phase_row_distance );
-  SAFE_DELETE( abs_phase_row_order );
-  SAFE_DELETE( abs_phase_row_deviation );
   SAFE_DELETE( abs_phase_distance );
+  SAFE_DELETE( abs_phase_order );
   SAFE_DELETE( abs_phase_deviation );
   SAFE_DELETE( dynamic_range );
   SAFE_DELETE( crd_x_image );
@@ -2851,8 +2968,6 @@ ProcessAcquiredImages(
   SAFE_DELETE( crd_y_camera );
   SAFE_DELETE( projector_col );
   SAFE_DELETE( projector_row );
-  SAFE_DELETE( projector_col_est );
-  SAFE_DELETE( projector_row_est );
   SAFE_DELETE( crd_x_projector );
   SAFE_DELETE( crd_y_projector );
   SAFE_DELETE( x_3D );
@@ -2863,6 +2978,10 @@ ProcessAcquiredImages(
   SAFE_DELETE( colors_3D );
   SAFE_DELETE( data_3D );
   SAFE_DELETE( texture );
+  SAFE_DELETE( mask_roi );
+
+  // The view does not own any data.
+  ROIImages.Blank();
 
   DebugTimerDestroy( debug_timer );
 
@@ -2872,4 +2991,968 @@ ProcessAcquiredImages(
 
 
 
+//! Thread pool callback for 3D reconstruction.
+/*!
+  Function processes one reconstruction task; it is executed by a thread of the
+  thread pool created in ProcessAcquiredImagesConcurrently.
+
+  \param Instance       Callback instance. Unused.
+  \param Context        Pointer to reconstruction task.
+  \param Work   Work object. Unused.
+*/
+VOID
+CALLBACK
+ProcessAcquiredImagesHelper(
+                            PTP_CALLBACK_INSTANCE Instance,
+                            PVOID Context,
+                            PTP_WORK Work
+                            )
+{
+  ProcessAcquiredImagesTask * const task = (ProcessAcquiredImagesTask *)( Context );
+  assert(NULL != task);
+  if (NULL == task) return;
+
+  // Exceptions must not leave the thread pool callback; failed task is reported by its result.
+  task->result = false;
+  try
+    {
+      task->result = ProcessAcquiredImages(
+                                           task->AllImages,
+                                           task->method,
+                                           task->fname_geometry,
+                                           task->pWindowVTK,
+                                           task->rel_thr,
+                                           task->dst2_thr,
+                                           task->stat_win,
+                                           task->atan2_method,
+                                           task->mps_precision,
+                                           task->roi_x, task->roi_y, task->roi_w, task->roi_h,
+                                           task->mask
+                                           );
+    }
+  catch (...)
+    {
+      task->result = false;
+    }
+  /* try */
+}
+/* ProcessAcquiredImagesHelper */
+
+
+
+//! Process acquired images of several cameras concurrently.
+/*!
+  Function executes reconstruction tasks of several cameras on a shared thread pool.
+  At most max_concurrent tasks are processed at the same time. As kernels of one
+  reconstruction are already parallelized using cv::parallel_for_ the number of threads
+  OpenCV uses is divided between concurrent reconstructions while tasks run on the
+  thread pool so the total number of busy threads does not exceed the number of processors.
+  The number of OpenCV threads is restored before the function returns; tasks catch all
+  exceptions so there is no path which skips the restore.
+  If the thread pool cannot be created or if only one task may run at a time
+  then tasks are processed one after another in the calling thread.
+
+  Caches of undistortion tables, camera ray tables, phase-to-XYZ models, and MPS plans
+  are shared between concurrent reconstructions. Cache access is guarded by the
+  cache locks and each task holds a reference to every cached table it uses until
+  it releases it, so a table replaced by another task is not deleted while still in use.
+  VTK pushes are serialized by the display thread.
+
+  \param tasks  Pointer to reconstruction tasks. Result of each task is stored in the task.
+  \param max_concurrent Largest number of concurrent reconstructions.
+  \return Function returns true if all tasks were successfull, false otherwise.
+*/
+bool
+ProcessAcquiredImagesConcurrently(
+                                  std::vector<ProcessAcquiredImagesTask> * const tasks,
+                                  int const max_concurrent
+                                  )
+{
+  assert(NULL != tasks);
+  if (NULL == tasks) return false;
+
+  int const num_tasks = (int)( tasks->size() );
+  if (0 == num_tasks) return true;
+
+  for (int i = 0; i < num_tasks; ++i) (*tasks)[i].result = false;
+
+  // Limit the number of concurrent reconstructions.
+  int num_concurrent = (0 < max_concurrent)? max_concurrent : 1;
+  if (num_concurrent > num_tasks) num_concurrent = num_tasks;
+
+  int num_threads = cv::getNumberOfCPUs() / num_concurrent;
+  if (1 > num_threads) num_threads = 1;
+
+  int const num_threads_old = cv::getNumThreads();
+
+  std::vector<PTP_WORK> work(num_tasks, (PTP_WORK)( NULL ));
+
+  PTP_POOL pool = NULL;
+  if (1 < num_concurrent)
+    {
+      pool = CreateThreadpool(NULL);
+      assert(NULL != pool);
+    }
+  /* if */
+
+  if (NULL != pool)
+    {
+      SetThreadpoolThreadMaximum(pool, (DWORD)( num_concurrent ));
+      BOOL const set_min = SetThreadpoolThreadMinimum(pool, 1);
+      assert(TRUE == set_min);
+
+      TP_CALLBACK_ENVIRON environment;
+      InitializeThreadpoolEnvironment( &environment );
+      SetThreadpoolCallbackPool( &environment, pool );
+
+      cv::setNumThreads(num_threads);
+
+      {
+        int const cnt = wprintf(gMsgProcessingConcurrentReconstruction, num_tasks, num_concurrent, num_threads);
+        assert(0 < cnt);
+      }
+
+      for (int i = 0; i < num_tasks; ++i)
+        {
+          work[i] = CreateThreadpoolWork(ProcessAcquiredImagesHelper, &( (*tasks)[i] ), &environment);
+          assert(NULL != work[i]);
+          if (NULL != work[i]) SubmitThreadpoolWork(work[i]);
+        }
+      /* for */
+
+      // Wait for all submitted reconstructions to finish.
+      for (int i = 0; i < num_tasks; ++i)
+        {
+          if (NULL == work[i]) continue;
+          WaitForThreadpoolWorkCallbacks(work[i], FALSE);
+          CloseThreadpoolWork(work[i]);
+        }
+      /* for */
+
+      DestroyThreadpoolEnvironment( &environment );
+      CloseThreadpool(pool);
+      pool = NULL;
+    }
+  /* if */
+
+  // Restore the number of OpenCV threads before processing remaining tasks in the calling thread.
+  cv::setNumThreads(num_threads_old);
+
+  // Process tasks which were not submitted to the thread pool.
+  for (int i = 0; i < num_tasks; ++i)
+    {
+      if (NULL != work[i]) continue;
+      ProcessAcquiredImagesHelper(NULL, &( (*tasks)[i] ), NULL);
+    }
+  /* for */
+
+  bool result = true;
+  for (int i = 0; i < num_tasks; ++i) result = result && (*tasks)[i].result;
+
+  return result;
+}
+/* ProcessAcquiredImagesConcurrently */
+
+
+
+/****** MPS PRECISION VALIDATION ******/
+
+//! Validates single precision MPS decoding.
+/*!
+  Function decodes all MPS directions of the given method descriptor twice,
+  once using double precision and once using single precision wrapped phases,
+  and compares the results. For each direction the maximal absolute difference
+  of unwrapped phases and the percentage of pixels whose period-order
+  vector changed are printed, both for all pixels and for pixels whose dynamic
+  range is above the threshold. Execution times of both unwrapping passes are
+  printed as well.
+
+  \param AllImages       Pointer to structure holding all acquired images.
+  \param method          MPS method descriptor.
+  \param fname_geometry  Filename of XML configuration which holds projector and camera geometry.
+  \param rel_thr         Relative threshold to determine illuminated pixels. Must be in [0,1] range.
+  \param atan2_method    Arctangent computation method used for phase estimation.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+ValidateMPSSinglePrecision(
+                           ImageSet * const AllImages,
+                           wchar_t const * method,
+                           wchar_t const * fname_geometry,
+                           double const rel_thr,
+                           PhaseAtan2Method const atan2_method
+                           )
+{
+  assert(NULL != AllImages);
+  if (NULL == AllImages) return false;
+
+  assert(NULL != method);
+  if (NULL == method) return false;
+
+  assert(NULL != fname_geometry);
+  if (NULL == fname_geometry) return false;
+
+  LARGE_INTEGER frequency;
+  BOOL const qpf = QueryPerformanceFrequency( &frequency );
+  assert(TRUE == qpf);
+  if ( (TRUE != qpf) || (0 >= frequency.QuadPart) ) return false;
+
+  double const ms_per_tick = 1000.0 / (double)( frequency.QuadPart );
+
+  // Parse method descriptor; only MPS methods may be validated.
+  SLDecodePlan decode_plan;
+  bool const parse = ParseMethodDescriptor(method, &decode_plan);
+  if ( (false == parse) || (SL_METHOD_MPS != decode_plan.family) )
+    {
+      int const cnt = wprintf(gMsgValidateMPSNotMPSMethod, method);
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if (AllImages->num_images < decode_plan.num_images)
+    {
+      int const cnt = wprintf(gMsgProcessingNotEnoughImages, AllImages->CameraID + 1, AllImages->ProjectorID + 1, decode_plan.num_images, AllImages->num_images);
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  double const abs_thr = GetAbsoluteThreshold(AllImages, rel_thr);
+  assert( false == isnan_inline(abs_thr) );
+  if ( true == isnan_inline(abs_thr) ) return false;
+
+  bool result = true; // Assume success.
+
+  for (int j = 0; (j < decode_plan.num_directions) && (true == result); ++j)
+    {
+      SLDirectionPlan const * const dir = decode_plan.direction + j;
+
+      int const n_frq = dir->n_frq;
+      std::vector<double> counts(dir->counts, dir->counts + n_frq);
+
+      cv::Mat * WP_double = NULL;
+      cv::Mat * WP_single = NULL;
+      cv::Mat * dynamic_range = NULL;
+      cv::Mat * idx_double = NULL;
+      cv::Mat * idx_single = NULL;
+      cv::Mat * abs_phase_double = NULL;
+      cv::Mat * abs_phase_single = NULL;
+
+      double duration_double = 0.0;
+      double duration_single = 0.0;
+
+      MPSPlan * const plan = mps_plan_cache_get(counts, method, fname_geometry);
+      assert(NULL != plan);
+      result = (NULL != plan) && (2 <= n_frq) && (n_frq <= MPS_MAX_WAVELENGTHS);
+
+      if (true == result)
+        {
+          WP_double = new cv::Mat(AllImages->height, AllImages->width, CV_64FC(n_frq));
+          WP_single = new cv::Mat(AllImages->height, AllImages->width, CV_32FC(n_frq));
+          assert( (NULL != WP_double) && (NULL != WP_double->data) );
+          assert( (NULL != WP_single) && (NULL != WP_single->data) );
+          result = (NULL != WP_double) && (NULL != WP_double->data) && (NULL != WP_single) && (NULL != WP_single->data);
+        }
+      /* if */
+
+      // Estimate relative phases in both precisions and compute dynamic range.
+      for (int i = 0; (i < n_frq) && (true == result); ++i)
+        {
+          bool const estimate_double = EstimateRelativePhaseTiledInterleaved(AllImages, dir->ps_begin[i], dir->ps_end[i], true, atan2_method, WP_double, i);
+          bool const estimate_single = EstimateRelativePhaseTiledInterleaved(AllImages, dir->ps_begin[i], dir->ps_end[i], true, atan2_method, WP_single, i);
+          bool const update = UpdateDynamicRangeAndTexture(AllImages, dir->ps_begin[i], dir->ps_end[i], &dynamic_range, NULL);
+          assert( (true == estimate_double) && (true == estimate_single) && (true == update) );
+          result = (true == estimate_double) && (true == estimate_single) && (true == update);
+        }
+      /* for */
+
+      // Unwrap phase in both precisions.
+      if (true == result)
+        {
+          LARGE_INTEGER tic, toc;
+
+          QueryPerformanceCounter( &tic );
+          bool const unwrap_double = mps_unwrap_phase(
+                                                      WP_double, plan->O, plan->X, plan->K, plan->tree, plan->lut, *(plan->n), *(plan->wgt),
+                                                      &idx_double, NULL, &abs_phase_double
+                                                      );
+          QueryPerformanceCounter( &toc );
+          duration_double = (double)( toc.QuadPart - tic.QuadPart ) * ms_per_tick;
+
+          QueryPerformanceCounter( &tic );
+          bool const unwrap_single = mps_unwrap_phase(
+                                                      WP_single, plan->O, plan->X, plan->K, plan->tree, plan->lut, *(plan->n), *(plan->wgt),
+                                                      &idx_single, NULL, &abs_phase_single
+                                                      );
+          QueryPerformanceCounter( &toc );
+          duration_single = (double)( toc.QuadPart - tic.QuadPart ) * ms_per_tick;
+
+          assert( (true == unwrap_double) && (true == unwrap_single) );
+          result = (true == unwrap_double) && (true == unwrap_single);
+        }
+      /* if */
+
+      // Compare results.
+      if (true == result)
+        {
+          double max_diff_all = 0.0;
+          double max_diff_valid = 0.0;
+          int num_changed_all = 0;
+          int num_changed_valid = 0;
+          int num_valid = 0;
+
+          int const rows = abs_phase_double->rows;
+          int const cols = abs_phase_double->cols;
+
+          for (int y = 0; y < rows; ++y)
+            {
+              double const * const row_double = (double *)( (BYTE *)(abs_phase_double->data) + abs_phase_double->step[0] * y );
+              double const * const row_single = (double *)( (BYTE *)(abs_phase_single->data) + abs_phase_single->step[0] * y );
+              int const * const row_idx_double = (int *)( (BYTE *)(idx_double->data) + idx_double->step[0] * y );
+              int const * const row_idx_single = (int *)( (BYTE *)(idx_single->data) + idx_single->step[0] * y );
+              float const * const row_range = (float *)( (BYTE *)(dynamic_range->data) + dynamic_range->step[0] * y );
+
+              for (int x = 0; x < cols; ++x)
+                {
+                  double const diff = fabs(row_double[x] - row_single[x]);
+                  bool const changed = (row_idx_double[x] != row_idx_single[x]);
+                  bool const valid = (abs_thr < row_range[x]);
+
+                  if (max_diff_all < diff) max_diff_all = diff;
+                  if (true == changed) ++num_changed_all;
+
+                  if (true == valid)
+                    {
+                      ++num_valid;
+                      if (max_diff_valid < diff) max_diff_valid = diff;
+                      if (true == changed) ++num_changed_valid;
+                    }
+                  /* if */
+                }
+              /* for */
+            }
+          /* for */
+
+          int const num_all = rows * cols;
+          double const changed_all = (0 < num_all)? 100.0 * (double)( num_changed_all ) / (double)( num_all ) : 0.0;
+          double const changed_valid = (0 < num_valid)? 100.0 * (double)( num_changed_valid ) / (double)( num_valid ) : 0.0;
+
+          wchar_t const * const name = (true == dir->is_row)? L"row" : L"column";
+          wprintf(gMsgValidateMPSSinglePrecisionAll, name, max_diff_all, changed_all, num_all);
+          wprintf(gMsgValidateMPSSinglePrecisionValid, name, max_diff_valid, changed_valid, num_valid);
+          wprintf(gMsgValidateMPSSinglePrecisionDuration, name, duration_double, duration_single, (0.0 < duration_single)? duration_double / duration_single : 0.0);
+        }
+      /* if */
+
+      SAFE_DELETE( WP_double );
+      SAFE_DELETE( WP_single );
+      SAFE_DELETE( dynamic_range );
+      SAFE_DELETE( idx_double );
+      SAFE_DELETE( idx_single );
+      SAFE_DELETE( abs_phase_double );
+      SAFE_DELETE( abs_phase_single );
+    }
+  /* for */
+
+  return result;
+}
+/* ValidateMPSSinglePrecision */
+
+
+
+/****** CAMERA RAY TABLE BENCHMARK ******/
+
+//! Benchmarks camera ray table.
+/*!
+  Function measures memory footprint and construction time of the camera ray
+  table and compares the execution time of triangulation which undistorts
+  camera coordinates and computes camera rays for every point to triangulation
+  which fetches camera rays from the table. Measurements are done for
+  5 MP (2448 x 2048) and 12 MP (4000 x 3000) sensors where every pixel is
+  triangulated against a synthetic projector column. Camera and projector
+  geometry are loaded for cameras and projectors of the given image set.
+  The largest difference between triangulated points is printed as well.
+
+  \param AllImages       Pointer to structure holding all acquired images.
+  \param fname_geometry  Filename of XML configuration which holds projector and camera geometry.
+  \param repeats        Number of repetitions for each variant.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+BenchmarkCameraRayTable(
+                        ImageSet * const AllImages,
+                        wchar_t const * fname_geometry,
+                        int const repeats
+                        )
+{
+  assert(NULL != AllImages);
+  if (NULL == AllImages) return false;
+
+  assert(NULL != fname_geometry);
+  if (NULL == fname_geometry) return false;
+
+  assert(0 < repeats);
+  if (0 >= repeats) return false;
+
+  LARGE_INTEGER frequency;
+  BOOL const qpf = QueryPerformanceFrequency( &frequency );
+  assert(TRUE == qpf);
+  if ( (TRUE != qpf) || (0 >= frequency.QuadPart) ) return false;
+
+  double const ms_per_tick = 1000.0 / (double)( frequency.QuadPart );
+
+  // Load camera and projector geometry.
+  ProjectiveGeometry camera;
+  ProjectiveGeometry projector;
+
+  if (NULL == AllImages->camera_name)
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadCameraGeometryNoName);
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if ( !SUCCEEDED( camera.ReadFromXMLFile(fname_geometry, AllImages->camera_name->c_str()) ) )
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadCameraGeometry, AllImages->camera_name->c_str());
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if (NULL == AllImages->projector_name)
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadProjectorGeometryNoName);
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if ( !SUCCEEDED( projector.ReadFromXMLFile(fname_geometry, AllImages->projector_name->c_str()) ) )
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadProjectorGeometry, AllImages->projector_name->c_str());
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  int const sensor_width[] = {2448, 4000};
+  int const sensor_height[] = {2048, 3000};
+  int const num_sensors = sizeof(sensor_width) / sizeof(sensor_width[0]);
+
+  bool result = true; // Assume success.
+
+  for (int j = 0; (j < num_sensors) && (true == result); ++j)
+    {
+      int const width = sensor_width[j];
+      int const height = sensor_height[j];
+      int const N = width * height;
+
+      cv::Mat * crd_x = new cv::Mat(1, N, CV_32S);
+      cv::Mat * crd_y = new cv::Mat(1, N, CV_32S);
+      cv::Mat * projector_col = new cv::Mat(1, N, CV_64F);
+      CameraRayTable * table = NULL;
+      cv::Mat * x_3D[2] = {NULL, NULL};
+      cv::Mat * y_3D[2] = {NULL, NULL};
+      cv::Mat * z_3D[2] = {NULL, NULL};
+      double duration[2] = {0.0, 0.0};
+      double duration_table = 0.0;
+      double max_difference = 0.0;
+
+      assert( (NULL != crd_x) && (NULL != crd_y) && (NULL != projector_col) );
+      result = (NULL != crd_x) && (NULL != crd_y) && (NULL != projector_col);
+
+      // Every pixel is valid; projector columns sweep across the projector.
+      if (true == result)
+        {
+          int * const row_x = (int *)( (BYTE *)(crd_x->data) + crd_x->step[0] * 0 );
+          int * const row_y = (int *)( (BYTE *)(crd_y->data) + crd_y->step[0] * 0 );
+          double * const row_col = (double *)( (BYTE *)(projector_col->data) + projector_col->step[0] * 0 );
+          double const scale = projector.w / (double)( width );
+          for (int i = 0; i < N; ++i)
+            {
+              row_x[i] = i % width;
+              row_y[i] = i / width;
+              row_col[i] = (double)( row_x[i] ) * scale;
+            }
+          /* for */
+        }
+      /* if */
+
+      // Build the table outside of the cache.
+      if (true == result)
+        {
+          LARGE_INTEGER start, stop;
+          QueryPerformanceCounter( &start );
+          table = CameraRayTableCompute(&camera, width, height, 1, 1);
+          QueryPerformanceCounter( &stop );
+          duration_table = (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+
+          assert(NULL != table);
+          result = (NULL != table);
+        }
+      /* if */
+
+      // Time undistortion followed by triangulation and triangulation which uses the table.
+      for (int r = 0; (r < repeats) && (true == result); ++r)
+        {
+          for (int k = 0; k < 2; ++k)
+            {
+              SAFE_DELETE( x_3D[k] );
+              SAFE_DELETE( y_3D[k] );
+              SAFE_DELETE( z_3D[k] );
+            }
+          /* for */
+
+          LARGE_INTEGER start, stop;
+          QueryPerformanceCounter( &start );
+          {
+            cv::Mat * crd_x_camera = NULL;
+            cv::Mat * crd_y_camera = NULL;
+            bool const res_un = UndistortImageCoordinatesForRadialDistorsion(
+                                                                             crd_x, crd_y, 1, 1,
+                                                                             camera.fx, camera.fy, camera.cx, camera.cy, camera.k0, camera.k1,
+                                                                             &crd_x_camera, &crd_y_camera
+                                                                             );
+            bool const res_tr = (true == res_un) && TriangulateTwoViews(
+                                                                        &camera, crd_x_camera, crd_y_camera,
+                                                                        &projector, projector_col, NULL,
+                                                                        x_3D + 0, y_3D + 0, z_3D + 0, NULL
+                                                                        );
+            assert(true == res_tr);
+            if (true != res_tr) result = false;
+            SAFE_DELETE( crd_x_camera );
+            SAFE_DELETE( crd_y_camera );
+          }
+          QueryPerformanceCounter( &stop );
+          duration[0] += (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+
+          QueryPerformanceCounter( &start );
+          {
+            bool const res_tr = TriangulateTwoViewsUsingRayTable(
+                                                                 &camera, table, crd_x, crd_y, 0, 0,
+                                                                 &projector, projector_col, NULL,
+                                                                 x_3D + 1, y_3D + 1, z_3D + 1, NULL
+                                                                 );
+            assert(true == res_tr);
+            if (true != res_tr) result = false;
+          }
+          QueryPerformanceCounter( &stop );
+          duration[1] += (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+        }
+      /* for */
+
+      // Compare triangulated points.
+      if ( (true == result) && (NULL != z_3D[0]) && (NULL != z_3D[1]) )
+        {
+          double const * const row_x0 = (double *)( (BYTE *)(x_3D[0]->data) + x_3D[0]->step[0] * 0 );
+          double const * const row_y0 = (double *)( (BYTE *)(y_3D[0]->data) + y_3D[0]->step[0] * 0 );
+          double const * const row_z0 = (double *)( (BYTE *)(z_3D[0]->data) + z_3D[0]->step[0] * 0 );
+          double const * const row_x1 = (double *)( (BYTE *)(x_3D[1]->data) + x_3D[1]->step[0] * 0 );
+          double const * const row_y1 = (double *)( (BYTE *)(y_3D[1]->data) + y_3D[1]->step[0] * 0 );
+          double const * const row_z1 = (double *)( (BYTE *)(z_3D[1]->data) + z_3D[1]->step[0] * 0 );
+          for (int i = 0; i < N; ++i)
+            {
+              double const dx = row_x0[i] - row_x1[i];
+              double const dy = row_y0[i] - row_y1[i];
+              double const dz = row_z0[i] - row_z1[i];
+              double const difference = sqrt(dx * dx + dy * dy + dz * dz);
+              if (max_difference < difference) max_difference = difference;
+            }
+          /* for */
+        }
+      /* if */
+
+      if (true == result)
+        {
+          duration[0] /= (double)( repeats );
+          duration[1] /= (double)( repeats );
+          double const speedup = (0.0 < duration[1])? duration[0] / duration[1] : 0.0;
+          wprintf(
+                  gMsgBenchmarkCameraRayTable,
+                  width, height, (double)( N ) / 1.0e6,
+                  (double)( table->SizeInBytes() ) / 1048576.0, duration_table,
+                  duration[0], duration[1], speedup, max_difference
+                  );
+        }
+      /* if */
+
+      for (int k = 0; k < 2; ++k)
+        {
+          SAFE_DELETE( x_3D[k] );
+          SAFE_DELETE( y_3D[k] );
+          SAFE_DELETE( z_3D[k] );
+        }
+      /* for */
+      SAFE_DELETE( table );
+      SAFE_DELETE( crd_x );
+      SAFE_DELETE( crd_y );
+      SAFE_DELETE( projector_col );
+    }
+  /* for */
+
+  return result;
+}
+/* BenchmarkCameraRayTable */
+
+
+
+//! Benchmarks phase-to-XYZ model.
+/*!
+  Function measures memory footprint, fitting time, and fitting error of the
+  phase-to-XYZ model and compares the execution time of single-direction
+  reconstruction which triangulates views, re-projects points to the projector,
+  undistorts projector coordinates, and re-triangulates views using the camera
+  ray table to single-pass triangulation which refines the missing projector
+  coordinate in registers and to reconstruction which evaluates the model
+  directly from absolute phase.
+  Measurements are done for 5 MP (2448 x 2048) and 12 MP (4000 x 3000) sensors
+  where every pixel has a synthetic absolute phase of projector columns.
+  Camera and projector geometry are loaded for cameras and projectors of the
+  given image set. Points rejected by the model are triangulated so the
+  percentage of reconstructed points and the largest differences between
+  reconstructed points are printed as well.
+
+  \param AllImages       Pointer to structure holding all acquired images.
+  \param fname_geometry  Filename of XML configuration which holds projector and camera geometry.
+  \param repeats        Number of repetitions for each variant.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+BenchmarkPhaseToXYZModel(
+                         ImageSet * const AllImages,
+                         wchar_t const * fname_geometry,
+                         int const repeats
+                         )
+{
+  assert(NULL != AllImages);
+  if (NULL == AllImages) return false;
+
+  assert(NULL != fname_geometry);
+  if (NULL == fname_geometry) return false;
+
+  assert(0 < repeats);
+  if (0 >= repeats) return false;
+
+  LARGE_INTEGER frequency;
+  BOOL const qpf = QueryPerformanceFrequency( &frequency );
+  assert(TRUE == qpf);
+  if ( (TRUE != qpf) || (0 >= frequency.QuadPart) ) return false;
+
+  double const ms_per_tick = 1000.0 / (double)( frequency.QuadPart );
+
+  // Load camera and projector geometry.
+  ProjectiveGeometry camera;
+  ProjectiveGeometry projector;
+
+  if (NULL == AllImages->camera_name)
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadCameraGeometryNoName);
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if ( !SUCCEEDED( camera.ReadFromXMLFile(fname_geometry, AllImages->camera_name->c_str()) ) )
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadCameraGeometry, AllImages->camera_name->c_str());
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if (NULL == AllImages->projector_name)
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadProjectorGeometryNoName);
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  if ( !SUCCEEDED( projector.ReadFromXMLFile(fname_geometry, AllImages->projector_name->c_str()) ) )
+    {
+      int const cnt = wprintf(gMsgProcessingCannotLoadProjectorGeometry, AllImages->projector_name->c_str());
+      assert(0 < cnt);
+      return false;
+    }
+  /* if */
+
+  int const sensor_width[] = {2448, 4000};
+  int const sensor_height[] = {2048, 3000};
+  int const num_sensors = sizeof(sensor_width) / sizeof(sensor_width[0]);
+
+  double const pr_width = projector.w;
+
+  bool result = true; // Assume success.
+
+  for (int j = 0; (j < num_sensors) && (true == result); ++j)
+    {
+      int const width = sensor_width[j];
+      int const height = sensor_height[j];
+      int const N = width * height;
+
+      cv::Mat * crd_x = new cv::Mat(1, N, CV_32S);
+      cv::Mat * crd_y = new cv::Mat(1, N, CV_32S);
+      cv::Mat * abs_phase = new cv::Mat(height, width, CV_64F);
+      CameraRayTable * table = NULL;
+      PhaseToXYZModel * model = NULL;
+      cv::Mat * x_3D[3] = {NULL, NULL, NULL};
+      cv::Mat * y_3D[3] = {NULL, NULL, NULL};
+      cv::Mat * z_3D[3] = {NULL, NULL, NULL};
+      double duration[3] = {0.0, 0.0, 0.0};
+      double duration_model = 0.0;
+      double max_difference = 0.0;
+      double max_difference_single = 0.0;
+      double max_difference_model = 0.0;
+      int num_reconstructed = 0;
+
+      assert( (NULL != crd_x) && (NULL != crd_y) && (NULL != abs_phase) );
+      result = (NULL != crd_x) && (NULL != crd_y) && (NULL != abs_phase);
+
+      // Every pixel is valid; absolute phase sweeps across projector columns.
+      if (true == result)
+        {
+          int * const row_x = (int *)( (BYTE *)(crd_x->data) + crd_x->step[0] * 0 );
+          int * const row_y = (int *)( (BYTE *)(crd_y->data) + crd_y->step[0] * 0 );
+          for (int i = 0; i < N; ++i)
+            {
+              row_x[i] = i % width;
+              row_y[i] = i / width;
+            }
+          /* for */
+
+          for (int y = 0; y < height; ++y)
+            {
+              double * const row_phase = (double *)( (BYTE *)(abs_phase->data) + abs_phase->step[0] * y );
+              for (int x = 0; x < width; ++x) row_phase[x] = (double)( x ) / (double)( width );
+            }
+          /* for */
+        }
+      /* if */
+
+      // Build the ray table and fit the model outside of the cache.
+      if (true == result)
+        {
+          table = CameraRayTableCompute(&camera, width, height, 1, 1);
+          assert(NULL != table);
+          result = (NULL != table);
+        }
+      /* if */
+
+      if (true == result)
+        {
+          LARGE_INTEGER start, stop;
+          QueryPerformanceCounter( &start );
+          model = PhaseToXYZModelCompute(&camera, &projector, width, height, 1, 1, 0, pr_width);
+          QueryPerformanceCounter( &stop );
+          duration_model = (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+
+          assert(NULL != model);
+          result = (NULL != model) && (0 < model->num_valid);
+        }
+      /* if */
+
+      // Time triangulation followed by re-projection and re-triangulation, single-pass triangulation, and evaluation of the model.
+      for (int r = 0; (r < repeats) && (true == result); ++r)
+        {
+          for (int k = 0; k < 3; ++k)
+            {
+              SAFE_DELETE( x_3D[k] );
+              SAFE_DELETE( y_3D[k] );
+              SAFE_DELETE( z_3D[k] );
+            }
+          /* for */
+
+          LARGE_INTEGER start, stop;
+          QueryPerformanceCounter( &start );
+          {
+            cv::Mat * projector_col = NULL;
+            cv::Mat * projector_col_est = NULL;
+            cv::Mat * projector_row_est = NULL;
+            cv::Mat * crd_x_projector = NULL;
+            cv::Mat * crd_y_projector = NULL;
+            cv::Mat * dst2_3D = NULL;
+
+            bool res = GetProjectorCoordinate(crd_x, crd_y, abs_phase, pr_width, &projector_col);
+
+            res = res && TriangulateTwoViewsUsingRayTable(
+                                                          &camera, table, crd_x, crd_y, 0, 0,
+                                                          &projector, projector_col, NULL,
+                                                          x_3D + 0, y_3D + 0, z_3D + 0, NULL
+                                                          );
+
+            res = res && ProjectPoints(&projector, x_3D[0], y_3D[0], z_3D[0], &projector_col_est, &projector_row_est);
+
+            ProjectorUndistortionLUT const * const lut = ProjectorUndistortionLUTCacheGet(
+                                                                                          &projector,
+                                                                                          PROJECTOR_UNDISTORTION_LUT_STEP,
+                                                                                          PROJECTOR_UNDISTORTION_LUT_TOLERANCE
+                                                                                          );
+            if (NULL != lut)
+              {
+                res = res && UndistortProjectorCoordinatesUsingLUT(projector_col, projector_row_est, lut, &crd_x_projector, &crd_y_projector);
+              }
+            else
+              {
+                res = res && UndistortImageCoordinatesForRadialDistorsion(
+                                                                          projector_col, projector_row_est,
+                                                                          projector.fx, projector.fy, projector.cx, projector.cy, projector.k0, projector.k1,
+                                                                          &crd_x_projector, &crd_y_projector
+                                                                          );
+              }
+            /* if */
+            ProjectorUndistortionLUTCacheRelease( lut );
+
+            SAFE_DELETE( x_3D[0] );
+            SAFE_DELETE( y_3D[0] );
+            SAFE_DELETE( z_3D[0] );
+
+            res = res && TriangulateTwoViewsUsingRayTable(
+                                                          &camera, table, crd_x, crd_y, 0, 0,
+                                                          &projector, crd_x_projector, crd_y_projector,
+                                                          x_3D + 0, y_3D + 0, z_3D + 0, &dst2_3D
+                                                          );
+            assert(true == res);
+            if (true != res) result = false;
+
+            SAFE_DELETE( projector_col );
+            SAFE_DELETE( projector_col_est );
+            SAFE_DELETE( projector_row_est );
+            SAFE_DELETE( crd_x_projector );
+            SAFE_DELETE( crd_y_projector );
+            SAFE_DELETE( dst2_3D );
+          }
+          QueryPerformanceCounter( &stop );
+          duration[0] += (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+
+          QueryPerformanceCounter( &start );
+          {
+            cv::Mat * projector_col = NULL;
+            cv::Mat * dst2_3D = NULL;
+
+            bool res = GetProjectorCoordinate(crd_x, crd_y, abs_phase, pr_width, &projector_col);
+
+            res = res && TriangulateSingleDirection(
+                                                    &camera, table, crd_x, crd_y, 0, 0,
+                                                    &projector, projector_col, NULL,
+                                                    SINGLE_DIRECTION_TRIANGULATION_ITERATIONS,
+                                                    x_3D + 1, y_3D + 1, z_3D + 1, &dst2_3D
+                                                    );
+            assert(true == res);
+            if (true != res) result = false;
+
+            SAFE_DELETE( projector_col );
+            SAFE_DELETE( dst2_3D );
+          }
+          QueryPerformanceCounter( &stop );
+          duration[1] += (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+
+          QueryPerformanceCounter( &start );
+          {
+            bool const res = TriangulateUsingPhaseToXYZModel(
+                                                             model, table, crd_x, crd_y, 0, 0, abs_phase,
+                                                             x_3D + 2, y_3D + 2, z_3D + 2
+                                                             );
+            assert(true == res);
+            if (true != res) result = false;
+          }
+          QueryPerformanceCounter( &stop );
+          duration[2] += (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+        }
+      /* for */
+
+      // Compare reconstructed points; model is compared only where it gives a valid point.
+      if ( (true == result) && (NULL != z_3D[0]) && (NULL != z_3D[1]) && (NULL != z_3D[2]) )
+        {
+          double const * const row_x0 = (double *)( (BYTE *)(x_3D[0]->data) + x_3D[0]->step[0] * 0 );
+          double const * const row_y0 = (double *)( (BYTE *)(y_3D[0]->data) + y_3D[0]->step[0] * 0 );
+          double const * const row_z0 = (double *)( (BYTE *)(z_3D[0]->data) + z_3D[0]->step[0] * 0 );
+          double const * const row_x1 = (double *)( (BYTE *)(x_3D[1]->data) + x_3D[1]->step[0] * 0 );
+          double const * const row_y1 = (double *)( (BYTE *)(y_3D[1]->data) + y_3D[1]->step[0] * 0 );
+          double const * const row_z1 = (double *)( (BYTE *)(z_3D[1]->data) + z_3D[1]->step[0] * 0 );
+          double const * const row_x2 = (double *)( (BYTE *)(x_3D[2]->data) + x_3D[2]->step[0] * 0 );
+          double const * const row_y2 = (double *)( (BYTE *)(y_3D[2]->data) + y_3D[2]->step[0] * 0 );
+          double const * const row_z2 = (double *)( (BYTE *)(z_3D[2]->data) + z_3D[2]->step[0] * 0 );
+          for (int i = 0; i < N; ++i)
+            {
+              if ( !isnanorinf_inline(row_x0[i]) && !isnanorinf_inline(row_y0[i]) && !isnanorinf_inline(row_z0[i]) )
+                {
+                  double const dx = row_x0[i] - row_x1[i];
+                  double const dy = row_y0[i] - row_y1[i];
+                  double const dz = row_z0[i] - row_z1[i];
+                  double const difference = sqrt(dx * dx + dy * dy + dz * dz);
+
+                  // Comparison is written so NaN difference is propagated.
+                  if ( !(difference <= max_difference_single) ) max_difference_single = difference;
+                }
+              /* if */
+
+              if ( isnanorinf_inline(row_x2[i]) || isnanorinf_inline(row_y2[i]) || isnanorinf_inline(row_z2[i]) ) continue;
+              ++num_reconstructed;
+
+              {
+                double const dx = row_x0[i] - row_x2[i];
+                double const dy = row_y0[i] - row_y2[i];
+                double const dz = row_z0[i] - row_z2[i];
+                double const difference = sqrt(dx * dx + dy * dy + dz * dz);
+                if ( !(difference <= max_difference) ) max_difference = difference;
+              }
+
+              {
+                double const dx = row_x1[i] - row_x2[i];
+                double const dy = row_y1[i] - row_y2[i];
+                double const dz = row_z1[i] - row_z2[i];
+                double const difference = sqrt(dx * dx + dy * dy + dz * dz);
+                if ( !(difference <= max_difference_model) ) max_difference_model = difference;
+              }
+            }
+          /* for */
+        }
+      /* if */
+
+      if (true == result)
+        {
+          duration[0] /= (double)( repeats );
+          duration[1] /= (double)( repeats );
+          duration[2] /= (double)( repeats );
+          double const speedup_model = (0.0 < duration[2])? duration[0] / duration[2] : 0.0;
+          double const speedup_single = (0.0 < duration[1])? duration[0] / duration[1] : 0.0;
+          wprintf(
+                  gMsgBenchmarkPhaseToXYZModel,
+                  width, height, (double)( N ) / 1.0e6,
+                  (double)( model->SizeInBytes() ) / 1048576.0, duration_model, model->max_error,
+                  duration[0], duration[2], speedup_model,
+                  100.0 * (double)( num_reconstructed ) / (double)( N ), max_difference
+                  );
+          wprintf(
+                  gMsgBenchmarkSingleDirectionTriangulation,
+                  SINGLE_DIRECTION_TRIANGULATION_ITERATIONS, duration[1], speedup_single,
+                  max_difference_single, max_difference_model
+                  );
+        }
+      /* if */
+
+      for (int k = 0; k < 3; ++k)
+        {
+          SAFE_DELETE( x_3D[k] );
+          SAFE_DELETE( y_3D[k] );
+          SAFE_DELETE( z_3D[k] );
+        }
+      /* for */
+      SAFE_DELETE( model );
+      SAFE_DELETE( table );
+      SAFE_DELETE( crd_x );
+      SAFE_DELETE( crd_y );
+      SAFE_DELETE( abs_phase );
+    }
+  /* for */
+
+  return result;
+}
+/* BenchmarkPhaseToXYZModel */
+
+
+
 #endif /* !__BATCHACQUISITIONPROCESSING_CPP */
@@ -136,6 +136,9 @@ struct ImageSet_
   //! Check if input images are grayscale.
   bool IsGrayscale(void);
 
+  //! Get shallow ROI view.
+  bool GetROIView(int const, int const, int const, int const, ImageSet_ * const, int * const, int * const);
+
   //! Destructor.
   ~ImageSet_();
 
@@ -257,6 +260,37 @@ int WritecvMatToRAWFile(wchar_t const * const, cv::Mat * const);
 
 /****** 3D RECONSTRUCTION ******/
 
+//! Default largest number of cameras which are reconstructed concurrently; may be changed in the reconstruction parameters menu.
+#define RECONSTRUCTION_MAX_CONCURRENT_CAMERAS 4
+
+
+//! Reconstruction task.
+/*!
+  Structure holds inputs of ProcessAcquiredImages for one camera and the result
+  of the reconstruction. Tasks of different cameras share all inputs except the image set
+  so they may be processed concurrently.
+*/
+typedef
+struct ProcessAcquiredImagesTask_
+{
+  ImageSet * AllImages; //!< Images acquired by the camera.
+  wchar_t const * method; //!< Method descriptor.
+  wchar_t const * fname_geometry; //!< Filename of XML configuration which holds projector and camera geometry.
+  VTKdisplaythreaddata_ * pWindowVTK; //!< Pointer to VTK visualization window.
+  double rel_thr; //!< Relative threshold to determine illuminated pixels.
+  double dst2_thr; //!< Absolute threshold to determine quality of 3D reconstruction.
+  int stat_win; //!< Size of the sliding window used to compute phase statistics.
+  PhaseAtan2Method atan2_method; //!< Arctangent computation method used for phase estimation.
+  MPSPrecision mps_precision; //!< Floating point precision of wrapped phases for MPS decoding.
+  int roi_x; //!< X coordinate of the upper left corner of the region of interest.
+  int roi_y; //!< Y coordinate of the upper left corner of the region of interest.
+  int roi_w; //!< Width of the region of interest.
+  int roi_h; //!< Height of the region of interest.
+  cv::Mat const * mask; //!< Reconstruction mask; may be NULL.
+  bool result; //!< Result of the reconstruction.
+} ProcessAcquiredImagesTask;
+
+
 //! Process acquired images.
 bool
 ProcessAcquiredImages(
@@ -265,9 +299,50 @@ ProcessAcquiredImages(
                       wchar_t const *,
                       VTKdisplaythreaddata_ * const,
                       double const,
-                      double const
+                      double const,
+                      int const,
+                      PhaseAtan2Method const,
+                      MPSPrecision const,
+                      int const,
+                      int const,
+                      int const,
+                      int const,
+                      cv::Mat const * const
                       );
 
+//! Process acquired images of several cameras concurrently.
+bool
+ProcessAcquiredImagesConcurrently(
+                                  std::vector<ProcessAcquiredImagesTask> * const,
+                                  int const
+                                  );
+
+//! Validates single precision MPS decoding.
+bool
+ValidateMPSSinglePrecision(
+                           ImageSet * const,
+                           wchar_t const *,
+                           wchar_t const *,
+                           double const,
+                           PhaseAtan2Method const
+                           );
+
+//! Benchmarks camera ray table.
+bool
+BenchmarkCameraRayTable(
+                        ImageSet * const,
+                        wchar_t const *,
+                        int const
+                        );
+
+//! Benchmarks phase-to-XYZ model.
+bool
+BenchmarkPhaseToXYZModel(
+                         ImageSet * const,
+                         wchar_t const *,
+                         int const
+                         );
+
 
 /****** INLINE FUNCTIONS ******/
 
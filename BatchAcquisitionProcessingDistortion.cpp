@@ -26,8 +26,10 @@
 #define __BATCHACQUISITIONPROCESSINGDISTORTION_CPP
 
 
+#include "BatchAcquisitionMessages.h"
 #include "BatchAcquisitionProcessingDistortion.h"
 #include "BatchAcquisitionProcessingPixelSelector.h"
+#include "BatchAcquisitionDebug.h"
 
 
 
@@ -226,4 +228,1383 @@ UndistortImageCoordinatesForRadialDistorsion(
 
 
 
+/****** UNDISTORTION LOOKUP TABLES ******/
+
+//! Height of the band of rows processed by one thread when filling the lookup table.
+#define UNDISTORTION_LUT_BAND_HEIGHT 32
+
+
+
+//! Cache of undistortion lookup tables; there is at most one table for each camera name.
+static std::vector<UndistortionLUT *> gUndistortionLUTCache;
+
+//! Slim Reader/Writer lock for undistortion lookup table cache.
+static SRWLOCK gUndistortionLUTCacheLock = SRWLOCK_INIT;
+
+//! Undistortion lookup tables replaced in the cache while still in use; each is deleted by UndistortionLUTCacheRelease when released by its last user.
+static std::vector<UndistortionLUT *> gUndistortionLUTRetired;
+
+
+//! Cache of projector undistortion lookup tables; there is at most one table for each projector name.
+static std::vector<ProjectorUndistortionLUT *> gProjectorUndistortionLUTCache;
+
+//! Slim Reader/Writer lock for projector undistortion lookup table cache.
+static SRWLOCK gProjectorUndistortionLUTCacheLock = SRWLOCK_INIT;
+
+//! Projector undistortion lookup tables replaced in the cache while still in use; each is deleted by ProjectorUndistortionLUTCacheRelease when released by its last user.
+static std::vector<ProjectorUndistortionLUT *> gProjectorUndistortionLUTRetired;
+
+
+
+//! Constructor.
+/*!
+  Blanks class variables.
+*/
+UndistortionLUT_::UndistortionLUT_()
+{
+  this->Blank();
+}
+/* UndistortionLUT_::UndistortionLUT_ */
+
+
+
+//! Destructor.
+/*!
+  Deletes undistorted coordinate maps.
+*/
+UndistortionLUT_::~UndistortionLUT_()
+{
+  SAFE_DELETE( this->x_un );
+  SAFE_DELETE( this->y_un );
+
+  this->Blank();
+}
+/* UndistortionLUT_::~UndistortionLUT_ */
+
+
+
+//! Blank class variables.
+/*!
+  Initializes all class variables.
+*/
+void
+UndistortionLUT_::Blank(
+                        void
+                        )
+{
+  this->name.clear();
+
+  this->fx = BATCHACQUISITION_qNaN_dv;
+  this->fy = BATCHACQUISITION_qNaN_dv;
+  this->cx = BATCHACQUISITION_qNaN_dv;
+  this->cy = BATCHACQUISITION_qNaN_dv;
+  this->k0 = BATCHACQUISITION_qNaN_dv;
+  this->k1 = BATCHACQUISITION_qNaN_dv;
+
+  this->shift_x = 0;
+  this->shift_y = 0;
+  this->width = 0;
+  this->height = 0;
+
+  this->x_un = NULL;
+  this->y_un = NULL;
+
+  this->refcount = 0;
+}
+/* UndistortionLUT_::Blank */
+
+
+
+//! Check if table matches geometry.
+/*!
+  Checks if the lookup table was computed for the given internal parameters and sensor size.
+  Parameters must match exactly as they are always read from the same geometry file.
+
+  \param geometry       Pointer to camera geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices.
+  \param shift_y        Row shift applied to pixel indices.
+  \return Returns true if table is valid for the given geometry.
+*/
+bool
+UndistortionLUT_::IsValidFor(
+                             ProjectiveGeometry_ const * const geometry,
+                             int const width,
+                             int const height,
+                             int const shift_x,
+                             int const shift_y
+                             ) const
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return false;
+
+  return
+    (NULL != this->x_un) && (NULL != this->y_un) &&
+    (this->width == width) && (this->height == height) &&
+    (this->shift_x == shift_x) && (this->shift_y == shift_y) &&
+    (this->fx == geometry->fx) && (this->fy == geometry->fy) &&
+    (this->cx == geometry->cx) && (this->cy == geometry->cy) &&
+    (this->k0 == geometry->k0) && (this->k1 == geometry->k1);
+}
+/* UndistortionLUT_::IsValidFor */
+
+
+
+//! Memory used by the table.
+/*!
+  Returns number of bytes used to store the undistorted coordinate maps.
+
+  \return Size in bytes.
+*/
+size_t
+UndistortionLUT_::SizeInBytes(
+                              void
+                              ) const
+{
+  size_t size = 0;
+  if ( (NULL != this->x_un) && (NULL != this->x_un->data) ) size += this->x_un->step[0] * (size_t)(this->x_un->rows);
+  if ( (NULL != this->y_un) && (NULL != this->y_un->data) ) size += this->y_un->step[0] * (size_t)(this->y_un->rows);
+  return size;
+}
+/* UndistortionLUT_::SizeInBytes */
+
+
+
+//! Parallel computation of the undistortion lookup table.
+/*!
+  Each invocation undistorts all pixel centers in a band of rows.
+  Expressions are evaluated in the same order as in UndistortImageCoordinatesForRadialDistorsion
+  so table entries are bitwise identical to directly computed coordinates.
+*/
+struct UndistortionLUTParallel_ : public cv::ParallelLoopBody
+{
+  UndistortionLUT * lut; //!< Lookup table to fill.
+
+  //! Constructor.
+  UndistortionLUTParallel_(
+                           UndistortionLUT * const lut_in
+                           )
+  {
+    this->lut = lut_in;
+  }
+
+  //! Fills a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const width = this->lut->width;
+
+    double const fx = this->lut->fx;
+    double const fy = this->lut->fy;
+    double const cx = this->lut->cx;
+    double const cy = this->lut->cy;
+    double const kappa2 = this->lut->k0;
+    double const kappa4 = this->lut->k1;
+
+    double const fx_inv = 1.0 / fx;
+    double const fy_inv = 1.0 / fy;
+
+    for (int j = r.start; j < r.end; ++j)
+      {
+        double * const row_x_un = (double *)( (BYTE *)(this->lut->x_un->data) + this->lut->x_un->step[0] * j );
+        double * const row_y_un = (double *)( (BYTE *)(this->lut->y_un->data) + this->lut->y_un->step[0] * j );
+
+        double const y = ( (double)( j + this->lut->shift_y ) - cy ) * fy_inv;
+        double const y2 = y*y;
+
+        for (int i = 0; i < width; ++i)
+          {
+            double const x = ( (double)( i + this->lut->shift_x ) - cx ) * fx_inv;
+
+            double const r2 = x*x + y2;
+            double const L = 1.0 + (kappa2 + kappa4 * r2 ) * r2;
+            double const L_inv = 1.0 / L;
+
+            row_x_un[i] = cx + fx * x * L_inv;
+            row_y_un[i] = cy + fy * y * L_inv;
+          }
+        /* for */
+      }
+    /* for */
+  }
+};
+/* UndistortionLUTParallel_ */
+
+
+
+//! Find cached table.
+/*!
+  Searches the cache for a table computed for the named camera.
+  Cache lock must be held by the caller.
+
+  \param name   Unique camera name.
+  \param idx_out        Address where the index of the table in the cache will be stored. May be NULL.
+  \return Returns pointer to the table or NULL if there is no such table.
+*/
+inline
+UndistortionLUT *
+UndistortionLUTCacheFind_inline(
+                                std::wstring const & name,
+                                int * const idx_out
+                                )
+{
+  int const i_max = (int)( gUndistortionLUTCache.size() );
+  for (int i = 0; i < i_max; ++i)
+    {
+      UndistortionLUT * const lut = gUndistortionLUTCache[i];
+      if ( (NULL != lut) && (lut->name == name) )
+        {
+          if (NULL != idx_out) *idx_out = i;
+          return lut;
+        }
+      /* if */
+    }
+  /* for */
+  if (NULL != idx_out) *idx_out = -1;
+  return NULL;
+}
+/* UndistortionLUTCacheFind_inline */
+
+
+
+//! Get cached undistortion lookup table.
+/*!
+  Returns lookup table of undistorted coordinates for every pixel of the sensor.
+  There is one table per camera name; if internal parameters or sensor size
+  of the camera changed then the table is recomputed and replaces the old one.
+
+  Returned table is owned by the cache and must not be modified or deleted.
+  Caller must release the returned table by calling UndistortionLUTCacheRelease
+  once it is no longer used.
+  A table which is replaced by a table for changed geometry of the same camera is deleted
+  when its last user releases it.
+
+  \param geometry       Pointer to camera geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices. Set to 1 if internal camera parameters were computed for Matlab indices, and to 0 otherwise.
+  \param shift_y        Row shift applied to pixel indices.
+  \return Returns pointer to the table or NULL if unsuccessfull.
+*/
+UndistortionLUT_ *
+UndistortionLUTCacheGet(
+                        ProjectiveGeometry_ const * const geometry,
+                        int const width,
+                        int const height,
+                        int const shift_x,
+                        int const shift_y
+                        )
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return NULL;
+
+  assert( (0 < width) && (0 < height) );
+  if ( (0 >= width) || (0 >= height) ) return NULL;
+
+  std::wstring const name = (NULL != geometry->name)? *(geometry->name) : std::wstring();
+
+  UndistortionLUT * lut = NULL;
+
+  // Check in-memory cache.
+  AcquireSRWLockShared( &gUndistortionLUTCacheLock );
+  lut = UndistortionLUTCacheFind_inline(name, NULL);
+  if ( (NULL != lut) && (false == lut->IsValidFor(geometry, width, height, shift_x, shift_y)) ) lut = NULL;
+  if (NULL != lut) InterlockedIncrement( &(lut->refcount) );
+  ReleaseSRWLockShared( &gUndistortionLUTCacheLock );
+
+  if (NULL != lut) return lut;
+
+  // Compute new table.
+  DEBUG_TIMER * const debug_timer = DebugTimerInit();
+
+  UndistortionLUT * new_lut = new UndistortionLUT();
+  assert(NULL != new_lut);
+  if (NULL == new_lut) return NULL;
+
+  new_lut->name = name;
+  new_lut->fx = geometry->fx;
+  new_lut->fy = geometry->fy;
+  new_lut->cx = geometry->cx;
+  new_lut->cy = geometry->cy;
+  new_lut->k0 = geometry->k0;
+  new_lut->k1 = geometry->k1;
+  new_lut->shift_x = shift_x;
+  new_lut->shift_y = shift_y;
+  new_lut->width = width;
+  new_lut->height = height;
+
+  new_lut->x_un = new cv::Mat(height, width, CV_64FC1);
+  new_lut->y_un = new cv::Mat(height, width, CV_64FC1);
+  assert( (NULL != new_lut->x_un) && (NULL != new_lut->x_un->data) );
+  assert( (NULL != new_lut->y_un) && (NULL != new_lut->y_un->data) );
+  if ( (NULL == new_lut->x_un) || (NULL == new_lut->x_un->data) ||
+       (NULL == new_lut->y_un) || (NULL == new_lut->y_un->data)
+       )
+    {
+      SAFE_DELETE( new_lut );
+      DebugTimerDestroy( debug_timer );
+      return NULL;
+    }
+  /* if */
+
+  {
+    UndistortionLUTParallel_ body(new_lut);
+    cv::parallel_for_(cv::Range(0, height), body, (double)(height) / (double)(UNDISTORTION_LUT_BAND_HEIGHT));
+  }
+
+  double const duration = DebugTimerQueryStart( debug_timer );
+  DebugTimerDestroy( debug_timer );
+
+  // Store the table; another thread may have stored the same table in the meantime.
+  size_t cache_size = 0;
+  int cache_count = 0;
+
+  UndistortionLUT * replaced = NULL;
+
+  AcquireSRWLockExclusive( &gUndistortionLUTCacheLock );
+
+  int idx = -1;
+  lut = UndistortionLUTCacheFind_inline(name, &idx);
+  if ( (NULL != lut) && (true == lut->IsValidFor(geometry, width, height, shift_x, shift_y)) )
+    {
+      // Keep existing table.
+    }
+  else if (NULL != lut)
+    {
+      assert( (0 <= idx) && (idx < (int)(gUndistortionLUTCache.size())) );
+      // Retire replaced table if it is in use, otherwise delete it after the lock is released.
+      if (0 < lut->refcount) gUndistortionLUTRetired.push_back( lut );
+      else replaced = lut;
+      gUndistortionLUTCache[idx] = NULL;
+      lut = NULL;
+      SWAP_ONE_VALID_PTR( lut, new_lut );
+      gUndistortionLUTCache[idx] = lut;
+    }
+  else
+    {
+      gUndistortionLUTCache.push_back(new_lut);
+      SWAP_ONE_VALID_PTR( lut, new_lut );
+    }
+  /* if */
+
+  // Caller holds the returned table until it calls UndistortionLUTCacheRelease.
+  InterlockedIncrement( &(lut->refcount) );
+
+  cache_count = (int)( gUndistortionLUTCache.size() );
+  for (int i = 0; i < cache_count; ++i)
+    {
+      if (NULL != gUndistortionLUTCache[i]) cache_size += gUndistortionLUTCache[i]->SizeInBytes();
+    }
+  /* for */
+
+  ReleaseSRWLockExclusive( &gUndistortionLUTCacheLock );
+
+  if (NULL == new_lut)
+    {
+      Debugfwprintf(
+                    stderr, gDbgUndistortionLUTComputed,
+                    width, height, name.c_str(), duration,
+                    (double)( lut->SizeInBytes() ) / 1048576.0, cache_count, (double)(cache_size) / 1048576.0
+                    );
+    }
+  /* if */
+
+  SAFE_DELETE( new_lut );
+  SAFE_DELETE( replaced );
+
+  return lut;
+}
+/* UndistortionLUTCacheGet */
+
+
+
+//! Release cached undistortion lookup table.
+/*!
+  Releases table returned by UndistortionLUTCacheGet. Every returned table must be released
+  exactly once. A table which was replaced in the cache is deleted when
+  its last user releases it.
+
+  \param lut    Pointer to the table. May be NULL.
+*/
+void
+UndistortionLUTCacheRelease(
+                            UndistortionLUT_ const * const lut
+                            )
+{
+  if (NULL == lut) return;
+
+  UndistortionLUT * retired = NULL;
+
+  AcquireSRWLockExclusive( &gUndistortionLUTCacheLock );
+
+  assert(0 < lut->refcount);
+  LONG const refcount = InterlockedDecrement( &(lut->refcount) );
+  if (0 == refcount)
+    {
+      int const k_max = (int)( gUndistortionLUTRetired.size() );
+      for (int k = 0; k < k_max; ++k)
+        {
+          if (lut != gUndistortionLUTRetired[k]) continue;
+          retired = gUndistortionLUTRetired[k];
+          gUndistortionLUTRetired.erase( gUndistortionLUTRetired.begin() + k );
+          break;
+        }
+      /* for */
+    }
+  /* if */
+
+  ReleaseSRWLockExclusive( &gUndistortionLUTCacheLock );
+
+  SAFE_DELETE( retired );
+}
+/* UndistortionLUTCacheRelease */
+
+
+
+//! Clear undistortion lookup table cache.
+/*!
+  Deletes all cached and retired camera and projector undistortion lookup tables.
+  Function must not be called while any reconstruction is in progress.
+*/
+void
+UndistortionLUTCacheClear(
+                          void
+                          )
+{
+  AcquireSRWLockExclusive( &gUndistortionLUTCacheLock );
+
+  int const i_max = (int)( gUndistortionLUTCache.size() );
+  for (int i = 0; i < i_max; ++i) SAFE_DELETE( gUndistortionLUTCache[i] );
+  gUndistortionLUTCache.clear();
+
+  int const k_max = (int)( gUndistortionLUTRetired.size() );
+  for (int k = 0; k < k_max; ++k) SAFE_DELETE( gUndistortionLUTRetired[k] );
+  gUndistortionLUTRetired.clear();
+
+  ReleaseSRWLockExclusive( &gUndistortionLUTCacheLock );
+
+  AcquireSRWLockExclusive( &gProjectorUndistortionLUTCacheLock );
+
+  int const j_max = (int)( gProjectorUndistortionLUTCache.size() );
+  for (int j = 0; j < j_max; ++j) SAFE_DELETE( gProjectorUndistortionLUTCache[j] );
+  gProjectorUndistortionLUTCache.clear();
+
+  int const l_max = (int)( gProjectorUndistortionLUTRetired.size() );
+  for (int l = 0; l < l_max; ++l) SAFE_DELETE( gProjectorUndistortionLUTRetired[l] );
+  gProjectorUndistortionLUTRetired.clear();
+
+  ReleaseSRWLockExclusive( &gProjectorUndistortionLUTCacheLock );
+}
+/* UndistortionLUTCacheClear */
+
+
+
+//! Undistort image coordinates using lookup table.
+/*!
+  Function undistorts image coordinates by fetching precomputed undistorted coordinates
+  from the lookup table. Results are identical to the ones returned by
+  UndistortImageCoordinatesForRadialDistorsion for the same shift.
+  Coordinates which fall outside of the table are undistorted directly.
+
+  \param x_dis  Image column index. Must be CV_32S type.
+  \param y_dis  Image row index. Must be CV_32S type.
+  \param offset_x       Column of the first pixel of the image in the sensor, e.g. non-zero if the image is a ROI.
+  \param offset_y       Row of the first pixel of the image in the sensor.
+  \param lut    Pointer to undistortion lookup table for the sensor.
+  \param x_un_out       Address where pointer to undistorted x coordinates will be stored.
+  \param y_un_out       Address where pointer to undistorted y coordinates will be stored.
+  \return Function returns true if successfull.
+*/
+bool
+UndistortImageCoordinatesUsingLUT(
+                                  cv::Mat * const x_dis,
+                                  cv::Mat * const y_dis,
+                                  int const offset_x,
+                                  int const offset_y,
+                                  UndistortionLUT_ const * const lut,
+                                  cv::Mat * * const x_un_out,
+                                  cv::Mat * * const y_un_out
+                                  )
+{
+  bool const valid = CheckCoordinateArrays_inline(x_dis, y_dis, CV_32S);
+  if (true != valid) return valid;
+
+  assert( (NULL != lut) && (NULL != lut->x_un) && (NULL != lut->y_un) );
+  if ( (NULL == lut) || (NULL == lut->x_un) || (NULL == lut->y_un) ) return false;
+
+  bool result = true; // Assume processing succeeded.
+
+  int const N = x_dis->cols;
+  assert(1 == x_dis->rows);
+  assert(N == y_dis->cols);
+  assert(1 == y_dis->rows);
+
+  cv::Mat * x_un = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x_un);
+
+  cv::Mat * y_un = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y_un);
+
+  if ( (NULL == x_un) || (NULL == y_un) )
+    {
+      result = false;
+      goto UndistortImageCoordinatesUsingLUT_EXIT;
+    }
+  /* if */
+
+  {
+    int const width = lut->width;
+    int const height = lut->height;
+
+    // Invert focal distances so only operations are multiplications.
+    double const fx_inv = 1.0 / lut->fx;
+    double const fy_inv = 1.0 / lut->fy;
+
+    // Get row pointers.
+    int const * const ptr_x_dis = (int *)( (BYTE *)(x_dis->data) + x_dis->step[0] * 0 );
+    int const * const ptr_y_dis = (int *)( (BYTE *)(y_dis->data) + y_dis->step[0] * 0 );
+    double * const ptr_x_un = (double *)( (BYTE *)(x_un->data) + x_un->step[0] * 0 );
+    double * const ptr_y_un = (double *)( (BYTE *)(y_un->data) + y_un->step[0] * 0 );
+
+    // Gather undistorted coordinates.
+    for (int i = 0; i < N; ++i)
+      {
+        int const x = ptr_x_dis[i] + offset_x;
+        int const y = ptr_y_dis[i] + offset_y;
+
+        if ( (0 <= x) && (x < width) && (0 <= y) && (y < height) )
+          {
+            ptr_x_un[i] = ( (double *)( (BYTE *)(lut->x_un->data) + lut->x_un->step[0] * y ) )[x];
+            ptr_y_un[i] = ( (double *)( (BYTE *)(lut->y_un->data) + lut->y_un->step[0] * y ) )[x];
+          }
+        else
+          {
+            double const xn = ( (double)( x + lut->shift_x ) - lut->cx ) * fx_inv;
+            double const yn = ( (double)( y + lut->shift_y ) - lut->cy ) * fy_inv;
+
+            double const r2 = xn*xn + yn*yn;
+            double const L_inv = 1.0 / ( 1.0 + (lut->k0 + lut->k1 * r2) * r2 );
+
+            ptr_x_un[i] = lut->cx + lut->fx * xn * L_inv;
+            ptr_y_un[i] = lut->cy + lut->fy * yn * L_inv;
+          }
+        /* if */
+      }
+    /* for */
+  }
+
+  SAFE_ASSIGN_PTR( x_un, x_un_out );
+  SAFE_ASSIGN_PTR( y_un, y_un_out );
+
+ UndistortImageCoordinatesUsingLUT_EXIT:
+
+  SAFE_DELETE( x_un );
+  SAFE_DELETE( y_un );
+
+  return result;
+}
+/* UndistortImageCoordinatesUsingLUT */
+
+
+
+/****** PROJECTOR UNDISTORTION LOOKUP TABLES ******/
+
+//! Margin in projector pixels added around projector resolution when sampling the table.
+#define PROJECTOR_UNDISTORTION_LUT_MARGIN 8
+
+//! Height of the band of grid rows processed by one thread when filling or validating the table.
+#define PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT 16
+
+//! Number of random points tested in each band of grid rows during validation.
+#define PROJECTOR_UNDISTORTION_LUT_RANDOM_POINTS 64
+
+
+
+//! Constructor.
+/*!
+  Blanks class variables.
+*/
+ProjectorUndistortionLUT_::ProjectorUndistortionLUT_()
+{
+  this->Blank();
+}
+/* ProjectorUndistortionLUT_::ProjectorUndistortionLUT_ */
+
+
+
+//! Destructor.
+/*!
+  Deletes the offset map.
+*/
+ProjectorUndistortionLUT_::~ProjectorUndistortionLUT_()
+{
+  SAFE_DELETE( this->offset );
+
+  this->Blank();
+}
+/* ProjectorUndistortionLUT_::~ProjectorUndistortionLUT_ */
+
+
+
+//! Blank class variables.
+/*!
+  Initializes all class variables.
+*/
+void
+ProjectorUndistortionLUT_::Blank(
+                                 void
+                                 )
+{
+  this->name.clear();
+
+  this->fx = BATCHACQUISITION_qNaN_dv;
+  this->fy = BATCHACQUISITION_qNaN_dv;
+  this->cx = BATCHACQUISITION_qNaN_dv;
+  this->cy = BATCHACQUISITION_qNaN_dv;
+  this->k0 = BATCHACQUISITION_qNaN_dv;
+  this->k1 = BATCHACQUISITION_qNaN_dv;
+  this->w = BATCHACQUISITION_qNaN_dv;
+  this->h = BATCHACQUISITION_qNaN_dv;
+
+  this->step = BATCHACQUISITION_qNaN_dv;
+  this->x0 = BATCHACQUISITION_qNaN_dv;
+  this->y0 = BATCHACQUISITION_qNaN_dv;
+  this->max_error = BATCHACQUISITION_qNaN_dv;
+
+  this->offset = NULL;
+
+  this->refcount = 0;
+}
+/* ProjectorUndistortionLUT_::Blank */
+
+
+
+//! Check if table matches geometry.
+/*!
+  Checks if the lookup table was computed for the given internal parameters,
+  projector resolution, and grid spacing.
+
+  \param geometry       Pointer to projector geometry.
+  \param step   Grid spacing in projector pixels.
+  \return Returns true if table is valid for the given geometry.
+*/
+bool
+ProjectorUndistortionLUT_::IsValidFor(
+                                      ProjectiveGeometry_ const * const geometry,
+                                      double const step
+                                      ) const
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return false;
+
+  return
+    (NULL != this->offset) && (this->step == step) &&
+    (this->w == geometry->w) && (this->h == geometry->h) &&
+    (this->fx == geometry->fx) && (this->fy == geometry->fy) &&
+    (this->cx == geometry->cx) && (this->cy == geometry->cy) &&
+    (this->k0 == geometry->k0) && (this->k1 == geometry->k1);
+}
+/* ProjectorUndistortionLUT_::IsValidFor */
+
+
+
+//! Memory used by the table.
+/*!
+  Returns number of bytes used to store the offset map.
+
+  \return Size in bytes.
+*/
+size_t
+ProjectorUndistortionLUT_::SizeInBytes(
+                                       void
+                                       ) const
+{
+  if ( (NULL == this->offset) || (NULL == this->offset->data) ) return 0;
+  return this->offset->step[0] * (size_t)(this->offset->rows);
+}
+/* ProjectorUndistortionLUT_::SizeInBytes */
+
+
+
+//! Undistort one point.
+/*!
+  Evaluates the analytic radial undistortion model for one point.
+  Expressions are evaluated in the same order as in UndistortImageCoordinatesForRadialDistorsion.
+
+  \param x_dis  Distorted x coordinate.
+  \param y_dis  Distorted y coordinate.
+  \param fx     Focal distance.
+  \param fy     Focal distance.
+  \param fx_inv Inverse of focal distance.
+  \param fy_inv Inverse of focal distance.
+  \param cx     Optical axis center.
+  \param cy     Optical axis center.
+  \param kappa2  Tylor expansion coefficient of radial distortion offset for squared radius.
+  \param kappa4  Tylor expansion coefficient of radial distortion offset for double squared radius.
+  \param x_un   Address where undistorted x coordinate will be stored.
+  \param y_un   Address where undistorted y coordinate will be stored.
+*/
+inline
+void
+UndistortPointForRadialDistorsion_inline(
+                                         double const x_dis,
+                                         double const y_dis,
+                                         double const fx,
+                                         double const fy,
+                                         double const fx_inv,
+                                         double const fy_inv,
+                                         double const cx,
+                                         double const cy,
+                                         double const kappa2,
+                                         double const kappa4,
+                                         double * const x_un,
+                                         double * const y_un
+                                         )
+{
+  double const x = ( x_dis - cx ) * fx_inv;
+  double const y = ( y_dis - cy ) * fy_inv;
+
+  double const r2 = x*x + y*y;
+  double const L = 1.0 + (kappa2 + kappa4 * r2 ) * r2;
+  double const L_inv = 1.0 / L;
+
+  *x_un = cx + fx * x * L_inv;
+  *y_un = cy + fy * y * L_inv;
+}
+/* UndistortPointForRadialDistorsion_inline */
+
+
+
+//! Interpolate undistorted point.
+/*!
+  Bilinearly interpolates offset from distorted to undistorted coordinates.
+
+  \param lut    Pointer to projector undistortion lookup table.
+  \param step_inv       Inverse of grid spacing.
+  \param x_dis  Distorted x coordinate.
+  \param y_dis  Distorted y coordinate.
+  \param x_un   Address where undistorted x coordinate will be stored.
+  \param y_un   Address where undistorted y coordinate will be stored.
+  \return Returns false if the point is outside of the table.
+*/
+inline
+bool
+InterpolateProjectorUndistortionLUT_inline(
+                                           ProjectorUndistortionLUT_ const * const lut,
+                                           double const step_inv,
+                                           double const x_dis,
+                                           double const y_dis,
+                                           double * const x_un,
+                                           double * const y_un
+                                           )
+{
+  double const u = (x_dis - lut->x0) * step_inv;
+  double const v = (y_dis - lut->y0) * step_inv;
+
+  // Comparisons are written so NaN coordinates are rejected.
+  if ( !( (0.0 <= u) && (u < (double)(lut->offset->cols - 1)) ) ) return false;
+  if ( !( (0.0 <= v) && (v < (double)(lut->offset->rows - 1)) ) ) return false;
+
+  int const i = (int)(u);
+  int const j = (int)(v);
+  double const a = u - (double)(i);
+  double const b = v - (double)(j);
+
+  float const * const row0 = (float *)( (BYTE *)(lut->offset->data) + lut->offset->step[0] * j ) + 2 * i;
+  float const * const row1 = (float *)( (BYTE *)(row0) + lut->offset->step[0] );
+
+  double const dx0 = (double)(row0[0]) + a * ( (double)(row0[2]) - (double)(row0[0]) );
+  double const dy0 = (double)(row0[1]) + a * ( (double)(row0[3]) - (double)(row0[1]) );
+  double const dx1 = (double)(row1[0]) + a * ( (double)(row1[2]) - (double)(row1[0]) );
+  double const dy1 = (double)(row1[1]) + a * ( (double)(row1[3]) - (double)(row1[1]) );
+
+  *x_un = x_dis + dx0 + b * (dx1 - dx0);
+  *y_un = y_dis + dy0 + b * (dy1 - dy0);
+
+  return true;
+}
+/* InterpolateProjectorUndistortionLUT_inline */
+
+
+
+//! Parallel computation of the projector undistortion lookup table.
+/*!
+  Each invocation stores offsets from distorted to undistorted coordinates
+  for all grid nodes in a band of grid rows. Offsets are small so they are stored
+  in single precision without noticeable loss of accuracy.
+*/
+struct ProjectorUndistortionLUTParallel_ : public cv::ParallelLoopBody
+{
+  ProjectorUndistortionLUT * lut; //!< Lookup table to fill.
+
+  //! Constructor.
+  ProjectorUndistortionLUTParallel_(
+                                    ProjectorUndistortionLUT * const lut_in
+                                    )
+  {
+    this->lut = lut_in;
+  }
+
+  //! Fills a band of grid rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const cols = this->lut->offset->cols;
+
+    double const fx_inv = 1.0 / this->lut->fx;
+    double const fy_inv = 1.0 / this->lut->fy;
+
+    for (int j = r.start; j < r.end; ++j)
+      {
+        float * const row_offset = (float *)( (BYTE *)(this->lut->offset->data) + this->lut->offset->step[0] * j );
+
+        double const y_dis = this->lut->y0 + this->lut->step * (double)(j);
+
+        for (int i = 0; i < cols; ++i)
+          {
+            double const x_dis = this->lut->x0 + this->lut->step * (double)(i);
+
+            double x_un = 0.0;
+            double y_un = 0.0;
+            UndistortPointForRadialDistorsion_inline(
+                                                     x_dis, y_dis,
+                                                     this->lut->fx, this->lut->fy, fx_inv, fy_inv,
+                                                     this->lut->cx, this->lut->cy, this->lut->k0, this->lut->k1,
+                                                     &x_un, &y_un
+                                                     );
+
+            row_offset[2 * i    ] = (float)(x_un - x_dis);
+            row_offset[2 * i + 1] = (float)(y_un - y_dis);
+          }
+        /* for */
+      }
+    /* for */
+  }
+};
+/* ProjectorUndistortionLUTParallel_ */
+
+
+
+//! Interpolation error for one point.
+/*!
+  Compares interpolated and analytic undistorted coordinates for one point.
+
+  \param lut    Pointer to projector undistortion lookup table.
+  \param step_inv       Inverse of grid spacing.
+  \param fx_inv Inverse of focal distance.
+  \param fy_inv Inverse of focal distance.
+  \param x_dis  Distorted x coordinate.
+  \param y_dis  Distorted y coordinate.
+  \return Returns larger of the absolute errors of x and y coordinates in projector pixels,
+  zero if the point is outside of the table, or infinity if interpolation returned NaN.
+*/
+inline
+double
+ProjectorUndistortionLUTPointError_inline(
+                                          ProjectorUndistortionLUT_ const * const lut,
+                                          double const step_inv,
+                                          double const fx_inv,
+                                          double const fy_inv,
+                                          double const x_dis,
+                                          double const y_dis
+                                          )
+{
+  double x_ref = 0.0;
+  double y_ref = 0.0;
+  UndistortPointForRadialDistorsion_inline(
+                                           x_dis, y_dis,
+                                           lut->fx, lut->fy, fx_inv, fy_inv,
+                                           lut->cx, lut->cy, lut->k0, lut->k1,
+                                           &x_ref, &y_ref
+                                           );
+
+  double x_un = x_ref;
+  double y_un = y_ref;
+  bool const inside = InterpolateProjectorUndistortionLUT_inline(lut, step_inv, x_dis, y_dis, &x_un, &y_un);
+  if (false == inside) return 0.0;
+
+  double const ex = fabs(x_un - x_ref);
+  double const ey = fabs(y_un - y_ref);
+  if ( (ex != ex) || (ey != ey) ) return BATCHACQUISITION_pINF_dv;
+
+  return (ex < ey)? ey : ex;
+}
+/* ProjectorUndistortionLUTPointError_inline */
+
+
+
+//! Parallel validation of the projector undistortion lookup table.
+/*!
+  Each invocation compares interpolated and analytic undistorted coordinates
+  in a band of grid cells. Every cell is tested at its center, where bilinear
+  interpolation error of a smooth field is largest, and at the midpoints
+  of its top and left edges; additional points are placed randomly.
+  Maximal error for each band is stored so the result does not depend on
+  how bands are split between threads.
+*/
+struct ProjectorUndistortionLUTValidateParallel_ : public cv::ParallelLoopBody
+{
+  ProjectorUndistortionLUT const * lut; //!< Lookup table to test.
+  double * band_error; //!< Output maximal error in pixels for each band.
+
+  //! Constructor.
+  ProjectorUndistortionLUTValidateParallel_(
+                                            ProjectorUndistortionLUT const * const lut_in,
+                                            double * const band_error_in
+                                            )
+  {
+    this->lut = lut_in;
+    this->band_error = band_error_in;
+  }
+
+  //! Measures error of a band of grid cells.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const cols = this->lut->offset->cols - 1;
+    int const rows = this->lut->offset->rows - 1;
+
+    double const x0 = this->lut->x0;
+    double const y0 = this->lut->y0;
+    double const step = this->lut->step;
+    double const step_inv = 1.0 / step;
+    double const fx_inv = 1.0 / this->lut->fx;
+    double const fy_inv = 1.0 / this->lut->fy;
+
+    for (int band = r.start; band < r.end; ++band)
+      {
+        int const j_start = band * PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT;
+        int const j_end = (j_start + PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT < rows)? j_start + PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT : rows;
+
+        double max_error = 0.0;
+
+        // Test cell centers and edge midpoints.
+        for (int j = j_start; j < j_end; ++j)
+          {
+            double const y_top = y0 + step * (double)(j);
+            double const y_mid = y0 + step * ( (double)(j) + 0.5 );
+
+            for (int i = 0; i < cols; ++i)
+              {
+                double const x_left = x0 + step * (double)(i);
+                double const x_mid = x0 + step * ( (double)(i) + 0.5 );
+
+                double const e_center = ProjectorUndistortionLUTPointError_inline(this->lut, step_inv, fx_inv, fy_inv, x_mid, y_mid);
+                double const e_top = ProjectorUndistortionLUTPointError_inline(this->lut, step_inv, fx_inv, fy_inv, x_mid, y_top);
+                double const e_left = ProjectorUndistortionLUTPointError_inline(this->lut, step_inv, fx_inv, fy_inv, x_left, y_mid);
+
+                if (max_error < e_center) max_error = e_center;
+                if (max_error < e_top) max_error = e_top;
+                if (max_error < e_left) max_error = e_left;
+              }
+            /* for */
+          }
+        /* for */
+
+        // Test random points.
+        cv::RNG rng( (uint64_t)(band + 1) );
+        for (int k = 0; k < PROJECTOR_UNDISTORTION_LUT_RANDOM_POINTS; ++k)
+          {
+            double const x_dis = x0 + step * rng.uniform(0.0, (double)(cols));
+            double const y_dis = y0 + step * rng.uniform((double)(j_start), (double)(j_end));
+
+            double const e = ProjectorUndistortionLUTPointError_inline(this->lut, step_inv, fx_inv, fy_inv, x_dis, y_dis);
+            if (max_error < e) max_error = e;
+          }
+        /* for */
+
+        this->band_error[band] = max_error;
+      }
+    /* for */
+  }
+};
+/* ProjectorUndistortionLUTValidateParallel_ */
+
+
+
+//! Validate projector undistortion lookup table.
+/*!
+  Measures the largest difference between interpolated undistorted coordinates
+  and the analytic radial distortion model over the whole table.
+
+  \param lut    Pointer to projector undistortion lookup table.
+  \return Returns maximal absolute error in projector pixels or NaN if unsuccessfull.
+*/
+double
+ValidateProjectorUndistortionLUT(
+                                 ProjectorUndistortionLUT_ const * const lut
+                                 )
+{
+  assert( (NULL != lut) && (NULL != lut->offset) && (NULL != lut->offset->data) );
+  if ( (NULL == lut) || (NULL == lut->offset) || (NULL == lut->offset->data) ) return BATCHACQUISITION_qNaN_dv;
+
+  int const rows = lut->offset->rows - 1;
+  assert( (0 < rows) && (0 < lut->offset->cols - 1) );
+  if ( (0 >= rows) || (0 >= lut->offset->cols - 1) ) return BATCHACQUISITION_qNaN_dv;
+
+  int const num_bands = (rows + PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT - 1) / PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT;
+
+  double * band_error = new double[num_bands];
+  assert(NULL != band_error);
+  if (NULL == band_error) return BATCHACQUISITION_qNaN_dv;
+
+  {
+    ProjectorUndistortionLUTValidateParallel_ body(lut, band_error);
+    cv::parallel_for_(cv::Range(0, num_bands), body, (double)(num_bands));
+  }
+
+  double max_error = 0.0;
+  for (int i = 0; i < num_bands; ++i) if (max_error < band_error[i]) max_error = band_error[i];
+
+  SAFE_DELETE_ARRAY( band_error );
+
+  return max_error;
+}
+/* ValidateProjectorUndistortionLUT */
+
+
+
+//! Find cached table.
+/*!
+  Searches the cache for a table computed for the named projector.
+  Cache lock must be held by the caller.
+
+  \param name   Unique projector name.
+  \param idx_out        Address where the index of the table in the cache will be stored. May be NULL.
+  \return Returns pointer to the table or NULL if there is no such table.
+*/
+inline
+ProjectorUndistortionLUT *
+ProjectorUndistortionLUTCacheFind_inline(
+                                         std::wstring const & name,
+                                         int * const idx_out
+                                         )
+{
+  int const i_max = (int)( gProjectorUndistortionLUTCache.size() );
+  for (int i = 0; i < i_max; ++i)
+    {
+      ProjectorUndistortionLUT * const lut = gProjectorUndistortionLUTCache[i];
+      if ( (NULL != lut) && (lut->name == name) )
+        {
+          if (NULL != idx_out) *idx_out = i;
+          return lut;
+        }
+      /* if */
+    }
+  /* for */
+  if (NULL != idx_out) *idx_out = -1;
+  return NULL;
+}
+/* ProjectorUndistortionLUTCacheFind_inline */
+
+
+
+//! Get cached projector undistortion lookup table.
+/*!
+  Returns lookup table of offsets from distorted to undistorted projector coordinates
+  sampled on a regular grid which covers projector resolution plus a small margin.
+  There is one table per projector name; if internal parameters or resolution
+  of the projector changed then the table is recomputed and replaces the old one.
+
+  Each new table is validated against the analytic model. Table whose interpolation
+  error exceeds the tolerance is rejected and NULL is returned so the caller
+  may fall back to UndistortImageCoordinatesForRadialDistorsion.
+
+  Returned table is owned by the cache and must not be modified or deleted.
+  Caller must release the returned table by calling ProjectorUndistortionLUTCacheRelease
+  once it is no longer used.
+  A table which is replaced by a table for changed geometry of the same projector is deleted
+  when its last user releases it.
+
+  \param geometry       Pointer to projector geometry.
+  \param step   Grid spacing in projector pixels; values below 1 give a sub-pixel grid.
+  \param tolerance      Largest allowed interpolation error in projector pixels.
+  \return Returns pointer to the table or NULL if unsuccessfull.
+*/
+ProjectorUndistortionLUT_ *
+ProjectorUndistortionLUTCacheGet(
+                                 ProjectiveGeometry_ const * const geometry,
+                                 double const step,
+                                 double const tolerance
+                                 )
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return NULL;
+
+  assert( (0.0 < step) && (step <= 1.0) );
+  if ( !( (0.0 < step) && (step <= 1.0) ) ) return NULL;
+
+  // Comparisons are written so NaN resolution is rejected.
+  if ( !( (1.0 <= geometry->w) && (geometry->w <= 65536.0) ) ) return NULL;
+  if ( !( (1.0 <= geometry->h) && (geometry->h <= 65536.0) ) ) return NULL;
+
+  std::wstring const name = (NULL != geometry->name)? *(geometry->name) : std::wstring();
+
+  ProjectorUndistortionLUT * lut = NULL;
+
+  // Check in-memory cache.
+  AcquireSRWLockShared( &gProjectorUndistortionLUTCacheLock );
+  lut = ProjectorUndistortionLUTCacheFind_inline(name, NULL);
+  if ( (NULL != lut) && (false == lut->IsValidFor(geometry, step)) ) lut = NULL;
+  if (NULL != lut) InterlockedIncrement( &(lut->refcount) );
+  ReleaseSRWLockShared( &gProjectorUndistortionLUTCacheLock );
+
+  if (NULL != lut) return lut;
+
+  // Compute new table.
+  DEBUG_TIMER * const debug_timer = DebugTimerInit();
+
+  ProjectorUndistortionLUT * new_lut = new ProjectorUndistortionLUT();
+  assert(NULL != new_lut);
+  if (NULL == new_lut) return NULL;
+
+  new_lut->name = name;
+  new_lut->fx = geometry->fx;
+  new_lut->fy = geometry->fy;
+  new_lut->cx = geometry->cx;
+  new_lut->cy = geometry->cy;
+  new_lut->k0 = geometry->k0;
+  new_lut->k1 = geometry->k1;
+  new_lut->w = geometry->w;
+  new_lut->h = geometry->h;
+  new_lut->step = step;
+  new_lut->x0 = -(double)(PROJECTOR_UNDISTORTION_LUT_MARGIN);
+  new_lut->y0 = -(double)(PROJECTOR_UNDISTORTION_LUT_MARGIN);
+
+  int const cols = (int)( ceil( (geometry->w + 2.0 * PROJECTOR_UNDISTORTION_LUT_MARGIN) / step ) ) + 1;
+  int const rows = (int)( ceil( (geometry->h + 2.0 * PROJECTOR_UNDISTORTION_LUT_MARGIN) / step ) ) + 1;
+
+  new_lut->offset = new cv::Mat(rows, cols, CV_32FC2);
+  assert( (NULL != new_lut->offset) && (NULL != new_lut->offset->data) );
+  if ( (NULL == new_lut->offset) || (NULL == new_lut->offset->data) )
+    {
+      SAFE_DELETE( new_lut );
+      DebugTimerDestroy( debug_timer );
+      return NULL;
+    }
+  /* if */
+
+  {
+    ProjectorUndistortionLUTParallel_ body(new_lut);
+    cv::parallel_for_(cv::Range(0, rows), body, (double)(rows) / (double)(PROJECTOR_UNDISTORTION_LUT_BAND_HEIGHT));
+  }
+
+  double const duration_build = DebugTimerQueryStart( debug_timer );
+
+  new_lut->max_error = ValidateProjectorUndistortionLUT(new_lut);
+
+  double const duration = DebugTimerQueryStart( debug_timer );
+  DebugTimerDestroy( debug_timer );
+
+  Debugfwprintf(
+                stderr, gDbgProjectorUndistortionLUTValidated,
+                cols, rows, step, name.c_str(), duration_build, duration - duration_build,
+                new_lut->max_error, tolerance
+                );
+
+  // Comparison is written so NaN error is rejected.
+  if ( !(new_lut->max_error <= tolerance) )
+    {
+      Debugfwprintf(stderr, gDbgProjectorUndistortionLUTRejected, name.c_str());
+      SAFE_DELETE( new_lut );
+      return NULL;
+    }
+  /* if */
+
+  // Store the table; another thread may have stored the same table in the meantime.
+  size_t cache_size = 0;
+  int cache_count = 0;
+
+  ProjectorUndistortionLUT * replaced = NULL;
+
+  AcquireSRWLockExclusive( &gProjectorUndistortionLUTCacheLock );
+
+  int idx = -1;
+  lut = ProjectorUndistortionLUTCacheFind_inline(name, &idx);
+  if ( (NULL != lut) && (true == lut->IsValidFor(geometry, step)) )
+    {
+      // Keep existing table.
+    }
+  else if (NULL != lut)
+    {
+      assert( (0 <= idx) && (idx < (int)(gProjectorUndistortionLUTCache.size())) );
+      // Retire replaced table if it is in use, otherwise delete it after the lock is released.
+      if (0 < lut->refcount) gProjectorUndistortionLUTRetired.push_back( lut );
+      else replaced = lut;
+      gProjectorUndistortionLUTCache[idx] = NULL;
+      lut = NULL;
+      SWAP_ONE_VALID_PTR( lut, new_lut );
+      gProjectorUndistortionLUTCache[idx] = lut;
+    }
+  else
+    {
+      gProjectorUndistortionLUTCache.push_back(new_lut);
+      SWAP_ONE_VALID_PTR( lut, new_lut );
+    }
+  /* if */
+
+  // Caller holds the returned table until it calls ProjectorUndistortionLUTCacheRelease.
+  InterlockedIncrement( &(lut->refcount) );
+
+  cache_count = (int)( gProjectorUndistortionLUTCache.size() );
+  for (int i = 0; i < cache_count; ++i)
+    {
+      if (NULL != gProjectorUndistortionLUTCache[i]) cache_size += gProjectorUndistortionLUTCache[i]->SizeInBytes();
+    }
+  /* for */
+
+  ReleaseSRWLockExclusive( &gProjectorUndistortionLUTCacheLock );
+
+  if (NULL == new_lut)
+    {
+      Debugfwprintf(
+                    stderr, gDbgProjectorUndistortionLUTComputed,
+                    name.c_str(), (double)( lut->SizeInBytes() ) / 1048576.0, cache_count, (double)(cache_size) / 1048576.0
+                    );
+    }
+  /* if */
+
+  SAFE_DELETE( new_lut );
+  SAFE_DELETE( replaced );
+
+  return lut;
+}
+/* ProjectorUndistortionLUTCacheGet */
+
+
+
+//! Release cached projector undistortion lookup table.
+/*!
+  Releases table returned by ProjectorUndistortionLUTCacheGet. Every returned table must be released
+  exactly once. A table which was replaced in the cache is deleted when
+  its last user releases it.
+
+  \param lut    Pointer to the table. May be NULL.
+*/
+void
+ProjectorUndistortionLUTCacheRelease(
+                                     ProjectorUndistortionLUT_ const * const lut
+                                     )
+{
+  if (NULL == lut) return;
+
+  ProjectorUndistortionLUT * retired = NULL;
+
+  AcquireSRWLockExclusive( &gProjectorUndistortionLUTCacheLock );
+
+  assert(0 < lut->refcount);
+  LONG const refcount = InterlockedDecrement( &(lut->refcount) );
+  if (0 == refcount)
+    {
+      int const k_max = (int)( gProjectorUndistortionLUTRetired.size() );
+      for (int k = 0; k < k_max; ++k)
+        {
+          if (lut != gProjectorUndistortionLUTRetired[k]) continue;
+          retired = gProjectorUndistortionLUTRetired[k];
+          gProjectorUndistortionLUTRetired.erase( gProjectorUndistortionLUTRetired.begin() + k );
+          break;
+        }
+      /* for */
+    }
+  /* if */
+
+  ReleaseSRWLockExclusive( &gProjectorUndistortionLUTCacheLock );
+
+  SAFE_DELETE( retired );
+}
+/* ProjectorUndistortionLUTCacheRelease */
+
+
+
+//! Undistort projector coordinates using lookup table.
+/*!
+  Function undistorts continuous projector coordinates by bilinear interpolation
+  of the offsets stored in the projector undistortion lookup table.
+  Coordinates which fall outside of the table are undistorted directly.
+
+  \param x_dis  Projector column coordinate. Must be CV_64F type.
+  \param y_dis  Projector row coordinate. Must be CV_64F type.
+  \param lut    Pointer to projector undistortion lookup table.
+  \param x_un_out       Address where pointer to undistorted x coordinates will be stored.
+  \param y_un_out       Address where pointer to undistorted y coordinates will be stored.
+  \return Function returns true if successfull.
+*/
+bool
+UndistortProjectorCoordinatesUsingLUT(
+                                      cv::Mat * const x_dis,
+                                      cv::Mat * const y_dis,
+                                      ProjectorUndistortionLUT_ const * const lut,
+                                      cv::Mat * * const x_un_out,
+                                      cv::Mat * * const y_un_out
+                                      )
+{
+  bool const valid = CheckCoordinateArrays_inline(x_dis, y_dis, CV_64F);
+  if (true != valid) return valid;
+
+  assert( (NULL != lut) && (NULL != lut->offset) && (NULL != lut->offset->data) );
+  if ( (NULL == lut) || (NULL == lut->offset) || (NULL == lut->offset->data) ) return false;
+
+  bool result = true; // Assume processing succeeded.
+
+  int const N = x_dis->cols;
+  assert(1 == x_dis->rows);
+  assert(N == y_dis->cols);
+  assert(1 == y_dis->rows);
+
+  cv::Mat * x_un = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x_un);
+
+  cv::Mat * y_un = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y_un);
+
+  if ( (NULL == x_un) || (NULL == y_un) )
+    {
+      result = false;
+      goto UndistortProjectorCoordinatesUsingLUT_EXIT;
+    }
+  /* if */
+
+  {
+    double const step_inv = 1.0 / lut->step;
+
+    // Invert focal distances so only operations are multiplications.
+    double const fx_inv = 1.0 / lut->fx;
+    double const fy_inv = 1.0 / lut->fy;
+
+    // Get row pointers.
+    double const * const ptr_x_dis = (double *)( (BYTE *)(x_dis->data) + x_dis->step[0] * 0 );
+    double const * const ptr_y_dis = (double *)( (BYTE *)(y_dis->data) + y_dis->step[0] * 0 );
+    double * const ptr_x_un = (double *)( (BYTE *)(x_un->data) + x_un->step[0] * 0 );
+    double * const ptr_y_un = (double *)( (BYTE *)(y_un->data) + y_un->step[0] * 0 );
+
+    // Interpolate undistorted coordinates.
+    for (int i = 0; i < N; ++i)
+      {
+        bool const inside = InterpolateProjectorUndistortionLUT_inline(lut, step_inv, ptr_x_dis[i], ptr_y_dis[i], ptr_x_un + i, ptr_y_un + i);
+        if (false == inside)
+          {
+            UndistortPointForRadialDistorsion_inline(
+                                                     ptr_x_dis[i], ptr_y_dis[i],
+                                                     lut->fx, lut->fy, fx_inv, fy_inv,
+                                                     lut->cx, lut->cy, lut->k0, lut->k1,
+                                                     ptr_x_un + i, ptr_y_un + i
+                                                     );
+          }
+        /* if */
+      }
+    /* for */
+  }
+
+  SAFE_ASSIGN_PTR( x_un, x_un_out );
+  SAFE_ASSIGN_PTR( y_un, y_un_out );
+
+ UndistortProjectorCoordinatesUsingLUT_EXIT:
+
+  SAFE_DELETE( x_un );
+  SAFE_DELETE( y_un );
+
+  return result;
+}
+/* UndistortProjectorCoordinatesUsingLUT */
+
+
+
 #endif /* !__BATCHACQUISITIONPROCESSINGDISTORTION_CPP */
@@ -57,4 +57,171 @@ bool UndistortImageCoordinatesForRadialDistorsion(
                                                   );
 
 
+
+//! Undistortion lookup table.
+/*!
+  Structure holds undistorted coordinates of every pixel of the camera sensor.
+  The table depends only on internal camera parameters and on the sensor size
+  so it may be reused for all reconstructions which use the same camera.
+*/
+typedef
+struct UndistortionLUT_
+{
+  std::wstring name; //!< Unique name of the camera.
+
+  double fx; //!< Focus along x direction.
+  double fy; //!< Focus along y direction.
+  double cx; //!< Image center in x direction.
+  double cy; //!< Image center in y direction.
+  double k0; //!< First parameter for radial distortion; multiplies r^2.
+  double k1; //!< Second parameter for radial distortion; multiplies r^4.
+
+  int shift_x; //!< Column shift applied to pixel indices.
+  int shift_y; //!< Row shift applied to pixel indices.
+  int width; //!< Sensor width in pixels.
+  int height; //!< Sensor height in pixels.
+
+  cv::Mat * x_un; //!< Undistorted x coordinates (CV_64FC1 of sensor size).
+  cv::Mat * y_un; //!< Undistorted y coordinates (CV_64FC1 of sensor size).
+
+  mutable volatile LONG refcount; //!< Number of callers which hold the table; changed only by UndistortionLUTCacheGet and UndistortionLUTCacheRelease.
+
+  //! Constructor.
+  UndistortionLUT_();
+
+  //! Destructor.
+  ~UndistortionLUT_();
+
+  //! Blank class variables.
+  void Blank(void);
+
+  //! Check if table matches geometry.
+  bool IsValidFor(ProjectiveGeometry_ const * const, int const, int const, int const, int const) const;
+
+  //! Memory used by the table.
+  size_t SizeInBytes(void) const;
+
+} UndistortionLUT;
+
+
+//! Get cached undistortion lookup table.
+UndistortionLUT_ *
+UndistortionLUTCacheGet(
+                        ProjectiveGeometry_ const * const,
+                        int const,
+                        int const,
+                        int const,
+                        int const
+                        );
+
+//! Release cached undistortion lookup table.
+void
+UndistortionLUTCacheRelease(
+                            UndistortionLUT_ const * const
+                            );
+
+//! Clear undistortion lookup table cache.
+void
+UndistortionLUTCacheClear(
+                          void
+                          );
+
+//! Undistort image coordinates using lookup table.
+bool UndistortImageCoordinatesUsingLUT(
+                                       cv::Mat * const,
+                                       cv::Mat * const,
+                                       int const,
+                                       int const,
+                                       UndistortionLUT_ const * const,
+                                       cv::Mat * * const,
+                                       cv::Mat * * const
+                                       );
+
+
+//! Grid spacing of projector undistortion lookup table in projector pixels.
+#define PROJECTOR_UNDISTORTION_LUT_STEP 1.0
+
+//! Largest allowed interpolation error of projector undistortion lookup table in projector pixels.
+#define PROJECTOR_UNDISTORTION_LUT_TOLERANCE 1.0e-3
+
+
+//! Projector undistortion lookup table.
+/*!
+  Structure holds offsets from distorted to undistorted projector coordinates
+  sampled on a regular grid which covers projector resolution. Offsets of
+  continuous projector coordinates are obtained by bilinear interpolation.
+  The table depends only on internal projector parameters and on the projector
+  resolution so it may be reused for all reconstructions which use the same projector.
+*/
+typedef
+struct ProjectorUndistortionLUT_
+{
+  std::wstring name; //!< Unique name of the projector.
+
+  double fx; //!< Focus along x direction.
+  double fy; //!< Focus along y direction.
+  double cx; //!< Image center in x direction.
+  double cy; //!< Image center in y direction.
+  double k0; //!< First parameter for radial distortion; multiplies r^2.
+  double k1; //!< Second parameter for radial distortion; multiplies r^4.
+  double w; //!< Projector width in pixels.
+  double h; //!< Projector height in pixels.
+
+  double step; //!< Grid spacing in projector pixels.
+  double x0; //!< X coordinate of the first grid column.
+  double y0; //!< Y coordinate of the first grid row.
+  double max_error; //!< Largest interpolation error measured during validation.
+
+  cv::Mat * offset; //!< Interleaved x and y offsets (CV_32FC2).
+
+  mutable volatile LONG refcount; //!< Number of callers which hold the table; changed only by ProjectorUndistortionLUTCacheGet and ProjectorUndistortionLUTCacheRelease.
+
+  //! Constructor.
+  ProjectorUndistortionLUT_();
+
+  //! Destructor.
+  ~ProjectorUndistortionLUT_();
+
+  //! Blank class variables.
+  void Blank(void);
+
+  //! Check if table matches geometry.
+  bool IsValidFor(ProjectiveGeometry_ const * const, double const) const;
+
+  //! Memory used by the table.
+  size_t SizeInBytes(void) const;
+
+} ProjectorUndistortionLUT;
+
+
+//! Validate projector undistortion lookup table.
+double
+ValidateProjectorUndistortionLUT(
+                                 ProjectorUndistortionLUT_ const * const
+                                 );
+
+//! Get cached projector undistortion lookup table.
+ProjectorUndistortionLUT_ *
+ProjectorUndistortionLUTCacheGet(
+                                 ProjectiveGeometry_ const * const,
+                                 double const,
+                                 double const
+                                 );
+
+//! Release cached projector undistortion lookup table.
+void
+ProjectorUndistortionLUTCacheRelease(
+                                     ProjectorUndistortionLUT_ const * const
+                                     );
+
+//! Undistort projector coordinates using lookup table.
+bool UndistortProjectorCoordinatesUsingLUT(
+                                           cv::Mat * const,
+                                           cv::Mat * const,
+                                           ProjectorUndistortionLUT_ const * const,
+                                           cv::Mat * * const,
+                                           cv::Mat * * const
+                                           );
+
+
 #endif /* !__BATCHACQUISITIONPROCESSINGDISTORTION_H */
@@ -30,6 +30,7 @@
 #include "BatchAcquisitionProcessingDynamicRange.h"
 #include "BatchAcquisitionImage.h"
 #include "BatchAcquisitionImageConversion.h"
+#include "BatchAcquisitionImageDemosaic.h"
 
 
 
@@ -869,24 +870,11 @@ ScaleAndDeBayerTexture(
     }
   else if (true == is_bayer)
     {
-      // Get pixel format.
-      int flags = 0;
-      ImageDataType type = IDT_UNKNOWN;
-      bool const get_flags = GetBestMatchingcvMatFlags(PixelFormat, &type, &flags);
-      assert( (true == get_flags) && (1 == CV_MAT_CN(flags)) && (true == ImageDataTypeIsBayer_inline(type)) );
-
-      // Convert from float to best matching pixel format.
-      cv::Mat tmp_bayer;
-      texture_in->convertTo(tmp_bayer, flags, 1.0/(double)(N));
-
-      // Convert from Bayer to BGR.
-      int const width = tmp_bayer.cols;
-      int const height = tmp_bayer.rows;
-      int const stride = (int)( tmp_bayer.step[0] );
-      void const * const data = tmp_bayer.data;
-      cv::Mat * tmp_bgr = RawBufferToBGRcvMat(type, width, height, stride, data);
-      assert(NULL != tmp_bgr);
-      if (NULL == tmp_bgr)
+      // Demosaic accumulated texture in single precision so it is rounded only once.
+      cv::Mat tmp_bgr(texture_in->rows, texture_in->cols, CV_32FC3);
+      bool const demosaic = DemosaicBayer(texture_in, PixelFormat, DEMOSAIC_EDGE_AWARE, &tmp_bgr);
+      assert(true == demosaic);
+      if (false == demosaic)
         {
           SAFE_DELETE( texture );
           return texture;
@@ -894,13 +882,11 @@ ScaleAndDeBayerTexture(
       /* if */
 
       // Get scaling factor.
-      double const nbits = GetImagePixelMSBPosition(tmp_bgr);
-      double const scale = (false == isnan_inline(nbits))? 255.0 / (pow(2.0, nbits + 1.0) - 1.0) : 1.0;
+      uint const nbits = MSBPositionInOpenCVFromImageDataType_inline(PixelFormat);
+      double const scale = 255.0 / ( (double)(N) * ( pow( 2.0, double(nbits + 1) ) - 1.0 ) );
 
       // Copy and scale data.
-      tmp_bgr->convertTo(*texture, CV_8UC1, scale);
-
-      SAFE_DELETE( tmp_bgr );
+      tmp_bgr.convertTo(*texture, CV_8UC3, scale);
     }
   else
     {
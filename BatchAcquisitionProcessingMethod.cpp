@@ -0,0 +1,488 @@
+/*
+ * UniZG - FER
+ * University of Zagreb (http://www.unizg.hr/)
+ * Faculty of Electrical Engineering and Computing (http://www.fer.unizg.hr/)
+ * Unska 3, HR-10000 Zagreb, Croatia
+ *
+ * (c) 2026 UniZG, Zagreb. All rights reserved.
+ * (c) 2026 FER, Zagreb. All rights reserved.
+ */
+
+/*!
+  \file   BatchAcquisitionProcessingMethod.cpp
+  \brief  Structured light method descriptors.
+
+  Parser for structured light method descriptors.
+
+  Method descriptor has the form
+
+  FAMILY CODE DIRECTION [DIRECTION]
+
+  where FAMILY is PS+GC or MPS, DIRECTION is column or row, and CODE
+  is a list of terms joined with + which are projected in the given order:
+
+  NPS       N-step phase shifting, e.g. 8PS;
+  NPS(nC)   N-step phase shifting with C periods per screen, e.g. 3PS(n20);
+  (A+B)GC   A-bit normal Gray code followed by B-bit shifted Gray code;
+  AGC       A-bit normal Gray code only;
+  B         black image;
+  W         white image.
+
+  For MPS all terms must be phase shifted sequences with fringe counts and
+  CODE describes one projector direction. For PS+GC each phase shifted
+  sequence starts one projector direction and must be followed by Gray code.
+  If CODE describes one projector direction and two directions are given
+  then CODE is repeated for the second direction without black and white images.
+  All matching is case insensitive.
+
+  \author agent
+  \date   2026-10-16
+*/
+
+
+#include "BatchAcquisitionStdAfx.h"
+
+
+#ifndef __BATCHACQUISITIONPROCESSINGMETHOD_CPP
+#define __BATCHACQUISITIONPROCESSINGMETHOD_CPP
+
+
+#include "BatchAcquisitionProcessingMethod.h"
+
+
+
+/****** HELPER FUNCTIONS ******/
+
+//! Descriptor term types.
+typedef
+enum SLMethodTerm_
+  {
+    SL_TERM_PS, /*!< Phase shifted sequence. */
+    SL_TERM_GC, /*!< Normal and shifted Gray code. */
+    SL_TERM_BLACK, /*!< Black image. */
+    SL_TERM_WHITE, /*!< White image. */
+  } SLMethodTerm;
+
+
+
+//! One term of method descriptor.
+typedef
+struct SLCodeTerm_
+{
+  SLMethodTerm type; //!< Term type.
+  int n; //!< Number of phase steps or number of normal Gray code bits.
+  int m; //!< Number of shifted Gray code bits; zero if there is no shifted Gray code.
+  double count; //!< Number of periods per screen; NaN if not specified.
+  int group; //!< Index of projector direction the term belongs to.
+} SLCodeTerm;
+
+
+
+//! Skip whitespace.
+/*!
+  Advances string pointer to the first non-whitespace character.
+
+  \param str    Address of string pointer.
+*/
+inline
+void
+SkipWhitespace_inline(
+                      wchar_t const * * const str
+                      )
+{
+  while ( (0 != **str) && (0 != iswspace(**str)) ) ++(*str);
+}
+/* SkipWhitespace_inline */
+
+
+
+//! Match token.
+/*!
+  Tests if string starts with a token and advances string pointer if it does.
+  Comparison is case insensitive.
+
+  \param str    Address of string pointer.
+  \param token  Token to match.
+  \return Returns true if token is matched.
+*/
+inline
+bool
+MatchToken_inline(
+                  wchar_t const * * const str,
+                  wchar_t const * const token
+                  )
+{
+  size_t const len = wcslen(token);
+  if (0 != _wcsnicmp(*str, token, len)) return false;
+  *str += len;
+  return true;
+}
+/* MatchToken_inline */
+
+
+
+//! Match word.
+/*!
+  Tests if string starts with a whole word and advances string pointer if it does.
+  Word must be followed by whitespace or by the end of string.
+
+  \param str    Address of string pointer.
+  \param word   Word to match.
+  \return Returns true if word is matched.
+*/
+inline
+bool
+MatchWord_inline(
+                 wchar_t const * * const str,
+                 wchar_t const * const word
+                 )
+{
+  wchar_t const * ptr = *str;
+  if (false == MatchToken_inline(&ptr, word)) return false;
+  if ( (0 != *ptr) && (0 == iswspace(*ptr)) ) return false;
+  *str = ptr;
+  return true;
+}
+/* MatchWord_inline */
+
+
+
+//! Parse positive integer.
+/*!
+  Parses positive decimal integer and advances string pointer.
+
+  \param str    Address of string pointer.
+  \param value  Address where parsed value will be stored.
+  \return Returns true if successfull.
+*/
+inline
+bool
+ParsePositiveInteger_inline(
+                            wchar_t const * * const str,
+                            int * const value
+                            )
+{
+  if (0 == iswdigit(**str)) return false;
+
+  int result = 0;
+  while (0 != iswdigit(**str))
+    {
+      result = 10 * result + (int)(**str - L'0');
+      if (1000000 < result) return false;
+      ++(*str);
+    }
+  /* while */
+
+  if (0 >= result) return false;
+
+  *value = result;
+  return true;
+}
+/* ParsePositiveInteger_inline */
+
+
+
+//! Parse one descriptor term.
+/*!
+  Parses one term of the method code.
+
+  \param str    Address of string pointer.
+  \param term   Pointer to term structure.
+  \return Returns true if successfull.
+*/
+inline
+bool
+ParseTerm_inline(
+                 wchar_t const * * const str,
+                 SLCodeTerm * const term
+                 )
+{
+  term->n = 0;
+  term->m = 0;
+  term->count = std::numeric_limits<double>::quiet_NaN();
+  term->group = 0;
+
+  // Black or white image.
+  if ( (L'B' == **str) || (L'b' == **str) || (L'W' == **str) || (L'w' == **str) )
+    {
+      term->type = ( (L'B' == **str) || (L'b' == **str) )? SL_TERM_BLACK : SL_TERM_WHITE;
+      ++(*str);
+      return true;
+    }
+  /* if */
+
+  // Normal and shifted Gray code.
+  if (L'(' == **str)
+    {
+      ++(*str);
+      if (false == ParsePositiveInteger_inline(str, &(term->n))) return false;
+      if (L'+' == **str)
+        {
+          ++(*str);
+          if (false == ParsePositiveInteger_inline(str, &(term->m))) return false;
+        }
+      /* if */
+      if (L')' != **str) return false;
+      ++(*str);
+      if (false == MatchToken_inline(str, L"GC")) return false;
+      term->type = SL_TERM_GC;
+      return true;
+    }
+  /* if */
+
+  // Phase shifting or normal Gray code.
+  if (false == ParsePositiveInteger_inline(str, &(term->n))) return false;
+
+  if (true == MatchToken_inline(str, L"GC"))
+    {
+      term->type = SL_TERM_GC;
+      return true;
+    }
+  /* if */
+
+  if (false == MatchToken_inline(str, L"PS")) return false;
+  term->type = SL_TERM_PS;
+
+  // Optional fringe count.
+  if (true == MatchToken_inline(str, L"(n"))
+    {
+      wchar_t * end = NULL;
+      double const count = wcstod(*str, &end);
+      if ( (NULL == end) || (*str == end) || (L')' != *end) ) return false;
+      if ( !(0.0 < count) ) return false;
+      term->count = count;
+      *str = end + 1;
+    }
+  /* if */
+
+  return true;
+}
+/* ParseTerm_inline */
+
+
+
+/****** METHOD DESCRIPTOR ******/
+
+//! Parse method descriptor.
+/*!
+  Parses structured light method descriptor and compiles it into decode plan.
+  Images are assigned consecutive indices starting from zero in the order
+  in which terms are listed.
+
+  For example, "MPS 3PS(n20)+3PS(n21)+3PS(n25) column row" uses images 0-2, 3-5, and 6-8
+  for columns and images 9-11, 12-14, and 15-17 for rows, and
+  "PS+GC 8PS+(4+4)GC+B+W column" uses images 0-7 for phase, 8-11 for normal Gray code,
+  12-15 for shifted Gray code, and images 16 and 17 as black and white images.
+
+  \param descriptor     Method descriptor.
+  \param plan   Pointer to decode plan.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+ParseMethodDescriptor(
+                      wchar_t const * const descriptor,
+                      SLDecodePlan * const plan
+                      )
+{
+  assert(NULL != descriptor);
+  if (NULL == descriptor) return false;
+
+  assert(NULL != plan);
+  if (NULL == plan) return false;
+
+  ZeroMemory( plan, sizeof(SLDecodePlan) );
+  plan->family = SL_METHOD_UNKNOWN;
+  plan->black = -1;
+  plan->white = -1;
+
+  SLCodeTerm terms[2 * SL_METHOD_MAX_TERMS];
+  int num_terms = 0;
+
+  bool is_row[SL_METHOD_MAX_DIRECTIONS + 1];
+  int num_directions = 0;
+
+  SLMethodFamily family = SL_METHOD_UNKNOWN;
+
+  wchar_t const * str = descriptor;
+
+  // Parse method family.
+  SkipWhitespace_inline(&str);
+  if (true == MatchWord_inline(&str, L"PS+GC")) family = SL_METHOD_PSGC;
+  else if (true == MatchWord_inline(&str, L"MPS")) family = SL_METHOD_MPS;
+  else return false;
+
+  // Parse code.
+  SkipWhitespace_inline(&str);
+  while (true)
+    {
+      if (SL_METHOD_MAX_TERMS <= num_terms) return false;
+      if (false == ParseTerm_inline(&str, terms + num_terms)) return false;
+      ++num_terms;
+
+      if (L'+' != *str) break;
+      ++str;
+    }
+  /* while */
+  if ( (0 != *str) && (0 == iswspace(*str)) ) return false;
+
+  // Parse directions.
+  while (true)
+    {
+      SkipWhitespace_inline(&str);
+      if (0 == *str) break;
+      if (SL_METHOD_MAX_DIRECTIONS <= num_directions) return false;
+
+      if (true == MatchWord_inline(&str, L"column")) is_row[num_directions] = false;
+      else if (true == MatchWord_inline(&str, L"row")) is_row[num_directions] = true;
+      else return false;
+
+      for (int i = 0; i < num_directions; ++i) if (is_row[i] == is_row[num_directions]) return false;
+      ++num_directions;
+    }
+  /* while */
+  if (0 == num_directions) return false;
+
+  // Assign terms to projector directions.
+  int num_groups = 0;
+  if (SL_METHOD_PSGC == family)
+    {
+      for (int i = 0; i < num_terms; ++i)
+        {
+          if (SL_TERM_PS == terms[i].type) ++num_groups;
+          if (0 == num_groups) return false;
+          terms[i].group = num_groups - 1;
+        }
+      /* for */
+    }
+  else
+    {
+      num_groups = 1;
+    }
+  /* if */
+
+  if ( (1 == num_groups) && (2 == num_directions) )
+    {
+      // Repeat code for the second direction.
+      int const num_terms_in = num_terms;
+      for (int i = 0; i < num_terms_in; ++i)
+        {
+          if ( (SL_TERM_BLACK == terms[i].type) || (SL_TERM_WHITE == terms[i].type) ) continue;
+          terms[num_terms] = terms[i];
+          terms[num_terms].group = 1;
+          ++num_terms;
+        }
+      /* for */
+      num_groups = 2;
+    }
+  /* if */
+
+  if (num_groups != num_directions) return false;
+
+  // Compile decode plan.
+  for (int j = 0; j < num_directions; ++j)
+    {
+      SLDirectionPlan * const dir = plan->direction + j;
+      dir->is_row = is_row[j];
+      dir->n_frq = 0;
+      dir->gc1_begin = -1;
+      dir->gc1_end = -2;
+      dir->gc2_begin = -1;
+      dir->gc2_end = -2;
+    }
+  /* for */
+
+  int idx = 0;
+  for (int i = 0; i < num_terms; ++i)
+    {
+      SLCodeTerm const * const term = terms + i;
+      SLDirectionPlan * const dir = plan->direction + term->group;
+
+      switch (term->type)
+        {
+        case SL_TERM_PS:
+          {
+            if (3 > term->n) return false;
+            if (SL_METHOD_MAX_FREQUENCIES <= dir->n_frq) return false;
+            if ( (SL_METHOD_PSGC == family) && (0 < dir->n_frq) ) return false;
+            if ( (SL_METHOD_MPS == family) && (0 != _isnan(term->count)) ) return false;
+
+            dir->ps_begin[dir->n_frq] = idx;
+            dir->ps_end[dir->n_frq] = idx + term->n - 1;
+            dir->counts[dir->n_frq] = term->count;
+            ++(dir->n_frq);
+            idx += term->n;
+          }
+          break;
+
+        case SL_TERM_GC:
+          {
+            if (SL_METHOD_PSGC != family) return false;
+            if (0 <= dir->gc1_begin) return false;
+            if ( (0 < term->m) && (term->m != term->n) ) return false;
+
+            dir->gc1_begin = idx;
+            dir->gc1_end = idx + term->n - 1;
+            idx += term->n;
+
+            if (0 < term->m)
+              {
+                dir->gc2_begin = idx;
+                dir->gc2_end = idx + term->m - 1;
+                idx += term->m;
+              }
+            /* if */
+          }
+          break;
+
+        case SL_TERM_BLACK:
+          {
+            if (0 <= plan->black) return false;
+            plan->black = idx;
+            ++idx;
+          }
+          break;
+
+        case SL_TERM_WHITE:
+          {
+            if (0 <= plan->white) return false;
+            plan->white = idx;
+            ++idx;
+          }
+          break;
+
+        default:
+          return false;
+        }
+      /* switch */
+    }
+  /* for */
+
+  // Validate decode plan.
+  for (int j = 0; j < num_directions; ++j)
+    {
+      SLDirectionPlan const * const dir = plan->direction + j;
+      if (SL_METHOD_PSGC == family)
+        {
+          if ( (1 != dir->n_frq) || (0 > dir->gc1_begin) ) return false;
+        }
+      else
+        {
+          if (2 > dir->n_frq) return false;
+        }
+      /* if */
+    }
+  /* for */
+
+  if ( (SL_METHOD_PSGC == family) && ((0 > plan->black) || (0 > plan->white)) ) return false;
+
+  plan->family = family;
+  plan->num_directions = num_directions;
+  plan->num_images = idx;
+
+  return true;
+}
+/* ParseMethodDescriptor */
+
+
+
+#endif /* !__BATCHACQUISITIONPROCESSINGMETHOD_CPP */
@@ -0,0 +1,101 @@
+/*
+ * UniZG - FER
+ * University of Zagreb (http://www.unizg.hr/)
+ * Faculty of Electrical Engineering and Computing (http://www.fer.unizg.hr/)
+ * Unska 3, HR-10000 Zagreb, Croatia
+ *
+ * (c) 2026 UniZG, Zagreb. All rights reserved.
+ * (c) 2026 FER, Zagreb. All rights reserved.
+ */
+
+/*!
+  \file   BatchAcquisitionProcessingMethod.h
+  \brief  Structured light method descriptors.
+
+  Parser for structured light method descriptors such as
+  "MPS 3PS(n20)+3PS(n21)+3PS(n25) column row" or
+  "PS+GC 8PS+(4+4)GC+B+W column". Descriptor is compiled into
+  a decode plan which lists image indices for each projector direction.
+
+  \author agent
+  \date   2026-10-16
+*/
+
+
+#ifndef __BATCHACQUISITIONPROCESSINGMETHOD_H
+#define __BATCHACQUISITIONPROCESSINGMETHOD_H
+
+
+//! Maximal number of projector directions (column and row).
+#define SL_METHOD_MAX_DIRECTIONS 2
+
+//! Maximal number of phase shifted sequences per direction.
+#define SL_METHOD_MAX_FREQUENCIES 8
+
+//! Maximal number of terms in a method descriptor.
+#define SL_METHOD_MAX_TERMS 64
+
+
+
+//! Structured light method family.
+typedef
+enum SLMethodFamily_
+  {
+    SL_METHOD_UNKNOWN, /*!< Unknown or invalid method. */
+    SL_METHOD_PSGC, /*!< Phase shifting unwrapped using normal and shifted Gray code. */
+    SL_METHOD_MPS, /*!< Multiple phase shifting. */
+  } SLMethodFamily;
+
+
+
+//! Image indices for one projector direction.
+/*!
+  Structure holds indices of all images used to decode one projector direction.
+  All index ranges are inclusive; empty ranges have last index lower than the first index.
+*/
+typedef
+struct SLDirectionPlan_
+{
+  bool is_row; //!< Flag to indicate row code; column code otherwise.
+
+  int n_frq; //!< Number of phase shifted sequences; always 1 for PS+GC.
+  int ps_begin[SL_METHOD_MAX_FREQUENCIES]; //!< First image of each phase shifted sequence.
+  int ps_end[SL_METHOD_MAX_FREQUENCIES]; //!< Last image of each phase shifted sequence.
+  double counts[SL_METHOD_MAX_FREQUENCIES]; //!< Number of periods per screen for each sequence (MPS only).
+
+  int gc1_begin; //!< First image of normal Gray code (PS+GC only).
+  int gc1_end; //!< Last image of normal Gray code (PS+GC only).
+  int gc2_begin; //!< First image of shifted Gray code (PS+GC only).
+  int gc2_end; //!< Last image of shifted Gray code (PS+GC only).
+
+} SLDirectionPlan;
+
+
+
+//! Decode plan.
+/*!
+  Compiled structured light method descriptor.
+*/
+typedef
+struct SLDecodePlan_
+{
+  SLMethodFamily family; //!< Method family.
+
+  int num_directions; //!< Number of decoded projector directions; 1 or 2.
+  SLDirectionPlan direction[SL_METHOD_MAX_DIRECTIONS]; //!< Image indices for each direction in descriptor order.
+
+  int black; //!< Index of black image or -1 if there is none.
+  int white; //!< Index of white image or -1 if there is none.
+
+  int num_images; //!< Total number of images required by the method.
+
+} SLDecodePlan;
+
+
+
+//! Parse method descriptor.
+bool ParseMethodDescriptor(wchar_t const * const, SLDecodePlan * const);
+
+
+
+#endif /* !__BATCHACQUISITIONPROCESSINGMETHOD_H */
@@ -79,6 +79,398 @@ ValidateInputs_inline(
 
 
 
+/****** FAST ARCTANGENT ******/
+
+/* Fast arctangent approximates atan(t) for t in [0,1] as t * P(t^2) where P
+   is a degree 8 polynomial obtained by Chebyshev interpolation of atan(sqrt(u))/sqrt(u)
+   on [0,1]. Approximation error of the polynomial is below 1e-8 rad; range reduction
+   and quadrant correction add only rounding errors. ValidateFastAtan2 measures
+   the actual error against the C runtime library.
+*/
+
+#define FAST_ATAN2_C0  0.9999999817886557
+#define FAST_ATAN2_C1 -0.3333303670929285
+#define FAST_ATAN2_C2  0.19991872029264307
+#define FAST_ATAN2_C3 -0.14197797795407988
+#define FAST_ATAN2_C4  0.10618370642479312
+#define FAST_ATAN2_C5 -0.07456854838521723
+#define FAST_ATAN2_C6  0.04213762374570251
+#define FAST_ATAN2_C7 -0.015731249223588546
+#define FAST_ATAN2_C8  0.0027662835283182277
+
+
+
+//! Fast scalar arctangent.
+/*!
+  Computes approximation of atan2(y, x) using polynomial approximation.
+  Signed zeros are handled in the same way as in atan2.
+
+  \param y      Y coordinate.
+  \param x      X coordinate.
+  \return Returns angle in range [-pi, pi].
+*/
+inline
+double
+FastAtan2_inline(
+                 double const y,
+                 double const x
+                 )
+{
+  double const pi = 3.141592653589793238462643383279502884197169399375;
+  double const pi_2 = 1.570796326794896619231321691639751442098584699687;
+
+  double const ax = fabs(x);
+  double const ay = fabs(y);
+  double const mx = (ax > ay)? ax : ay;
+  double const mn = (ax > ay)? ay : ax;
+  double const t = (0.0 < mx)? mn / mx : 0.0;
+  double const u = t * t;
+
+  double p = FAST_ATAN2_C8;
+  p = p * u + FAST_ATAN2_C7;
+  p = p * u + FAST_ATAN2_C6;
+  p = p * u + FAST_ATAN2_C5;
+  p = p * u + FAST_ATAN2_C4;
+  p = p * u + FAST_ATAN2_C3;
+  p = p * u + FAST_ATAN2_C2;
+  p = p * u + FAST_ATAN2_C1;
+  p = p * u + FAST_ATAN2_C0;
+
+  double r = t * p;
+  if (ay > ax) r = pi_2 - r;
+  if (_copysign(1.0, x) < 0.0) r = pi - r;
+  return _copysign(r, y);
+}
+/* FastAtan2_inline */
+
+
+
+//! Fast arctangent of two SSE2 registers.
+/*!
+  Computes approximation of atan2(y, x) for two double precision values.
+
+  \param y      Y coordinates.
+  \param x      X coordinates.
+  \return Returns angles in range [-pi, pi].
+*/
+inline
+__m128d
+FastAtan2SSE2_inline(
+                     __m128d const y,
+                     __m128d const x
+                     )
+{
+  __m128d const sign_mask = _mm_set1_pd(-0.0);
+  __m128d const zero = _mm_setzero_pd();
+  __m128d const pi = _mm_set1_pd(3.141592653589793238462643383279502884197169399375);
+  __m128d const pi_2 = _mm_set1_pd(1.570796326794896619231321691639751442098584699687);
+
+  __m128d const ax = _mm_andnot_pd(sign_mask, x);
+  __m128d const ay = _mm_andnot_pd(sign_mask, y);
+  __m128d const mx = _mm_max_pd(ax, ay);
+  __m128d const mn = _mm_min_pd(ax, ay);
+  __m128d const t = _mm_and_pd( _mm_div_pd(mn, mx), _mm_cmpgt_pd(mx, zero) );
+  __m128d const u = _mm_mul_pd(t, t);
+
+  __m128d p = _mm_set1_pd(FAST_ATAN2_C8);
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C7) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C6) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C5) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C4) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C3) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C2) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C1) );
+  p = _mm_add_pd( _mm_mul_pd(p, u), _mm_set1_pd(FAST_ATAN2_C0) );
+
+  __m128d r = _mm_mul_pd(t, p);
+
+  // Correct for octant.
+  __m128d const swap = _mm_cmpgt_pd(ay, ax);
+  r = _mm_or_pd( _mm_and_pd(swap, _mm_sub_pd(pi_2, r)), _mm_andnot_pd(swap, r) );
+
+  // Correct for quadrant; sign bit of x is broadcast to the whole lane.
+  __m128d const negative_x = _mm_castsi128_pd( _mm_shuffle_epi32( _mm_srai_epi32(_mm_castpd_si128(x), 31), _MM_SHUFFLE(3, 3, 1, 1) ) );
+  r = _mm_or_pd( _mm_and_pd(negative_x, _mm_sub_pd(pi, r)), _mm_andnot_pd(negative_x, r) );
+
+  // Copy sign of y.
+  return _mm_or_pd( r, _mm_and_pd(sign_mask, y) );
+}
+/* FastAtan2SSE2_inline */
+
+
+
+//! Fast arctangent of two AVX registers.
+/*!
+  Computes approximation of atan2(y, x) for four double precision values.
+
+  \param y      Y coordinates.
+  \param x      X coordinates.
+  \return Returns angles in range [-pi, pi].
+*/
+inline
+__m256d
+FastAtan2AVX_inline(
+                    __m256d const y,
+                    __m256d const x
+                    )
+{
+  __m256d const sign_mask = _mm256_set1_pd(-0.0);
+  __m256d const zero = _mm256_setzero_pd();
+  __m256d const pi = _mm256_set1_pd(3.141592653589793238462643383279502884197169399375);
+  __m256d const pi_2 = _mm256_set1_pd(1.570796326794896619231321691639751442098584699687);
+
+  __m256d const ax = _mm256_andnot_pd(sign_mask, x);
+  __m256d const ay = _mm256_andnot_pd(sign_mask, y);
+  __m256d const mx = _mm256_max_pd(ax, ay);
+  __m256d const mn = _mm256_min_pd(ax, ay);
+  __m256d const t = _mm256_and_pd( _mm256_div_pd(mn, mx), _mm256_cmp_pd(mx, zero, _CMP_GT_OQ) );
+  __m256d const u = _mm256_mul_pd(t, t);
+
+  __m256d p = _mm256_set1_pd(FAST_ATAN2_C8);
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C7) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C6) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C5) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C4) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C3) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C2) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C1) );
+  p = _mm256_add_pd( _mm256_mul_pd(p, u), _mm256_set1_pd(FAST_ATAN2_C0) );
+
+  __m256d r = _mm256_mul_pd(t, p);
+
+  // Correct for octant and quadrant; blendv selects on the sign bit of x.
+  r = _mm256_blendv_pd( r, _mm256_sub_pd(pi_2, r), _mm256_cmp_pd(ay, ax, _CMP_GT_OQ) );
+  r = _mm256_blendv_pd( r, _mm256_sub_pd(pi, r), x );
+
+  // Copy sign of y.
+  return _mm256_or_pd( r, _mm256_and_pd(sign_mask, y) );
+}
+/* FastAtan2AVX_inline */
+
+
+
+//! Checks if AVX may be used.
+/*!
+  Checks if both CPU and OS support AVX instructions.
+
+  \return Returns true if AVX is available.
+*/
+inline
+bool
+CheckAVXSupport_inline(
+                       void
+                       )
+{
+  int info[4] = {0, 0, 0, 0};
+  __cpuid(info, 1);
+
+  bool const osxsave = (0 != (info[2] & (1 << 27)));
+  bool const avx = (0 != (info[2] & (1 << 28)));
+  if ( (false == osxsave) || (false == avx) ) return false;
+
+  // OS must save both XMM and YMM registers.
+  unsigned __int64 const xcr0 = _xgetbv(0);
+  return (6 == (xcr0 & 6));
+}
+/* CheckAVXSupport_inline */
+
+
+
+//! Checks if AVX may be used.
+/*!
+  Returns cached result of CheckAVXSupport_inline.
+
+  \return Returns true if AVX is available.
+*/
+inline
+bool
+HaveAVX_inline(
+               void
+               )
+{
+  static bool const have_avx = CheckAVXSupport_inline();
+  return have_avx;
+}
+/* HaveAVX_inline */
+
+
+
+//! Computes arctangent for an array.
+/*!
+  Computes dst[i] = atan2(y[i], x[i]) + offset for n elements.
+  Depending on the selected method either the C runtime atan2 or the fast
+  polynomial approximation is used. Fast approximation uses AVX if available,
+  SSE2 otherwise, and the scalar code for the remaining elements.
+
+  \param y      Pointer to Y coordinates.
+  \param x      Pointer to X coordinates.
+  \param dst    Pointer to output array.
+  \param n      Number of elements.
+  \param offset Constant which is added to the computed angle.
+  \param method Arctangent computation method.
+*/
+void
+Atan2Array(
+           double const * const y,
+           double const * const x,
+           double * const dst,
+           int const n,
+           double const offset,
+           PhaseAtan2Method const method
+           )
+{
+  assert( (NULL != y) && (NULL != x) && (NULL != dst) );
+  if ( (NULL == y) || (NULL == x) || (NULL == dst) ) return;
+
+  int i = 0;
+
+  if (PHASE_ATAN2_FAST == method)
+    {
+      if (true == HaveAVX_inline())
+        {
+          __m256d const o = _mm256_set1_pd(offset);
+          int const max_i = n - 3;
+          for (; i < max_i; i += 4)
+            {
+              __m256d const r = FastAtan2AVX_inline( _mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i) );
+              _mm256_storeu_pd( dst + i, _mm256_add_pd(r, o) );
+            }
+          /* for */
+          _mm256_zeroupper();
+        }
+      else
+        {
+          __m128d const o = _mm_set1_pd(offset);
+          int const max_i = n - 1;
+          for (; i < max_i; i += 2)
+            {
+              __m128d const r = FastAtan2SSE2_inline( _mm_loadu_pd(y + i), _mm_loadu_pd(x + i) );
+              _mm_storeu_pd( dst + i, _mm_add_pd(r, o) );
+            }
+          /* for */
+        }
+      /* if */
+
+      // Complete to end.
+      for (; i < n; ++i) dst[i] = FastAtan2_inline(y[i], x[i]) + offset;
+    }
+  else
+    {
+      // Unrolled for loop with step 4.
+      int const max_i = n - 3;
+      for (; i < max_i; i += 4)
+        {
+          dst[i    ] = atan2(y[i    ], x[i    ]) + offset;
+          dst[i + 1] = atan2(y[i + 1], x[i + 1]) + offset;
+          dst[i + 2] = atan2(y[i + 2], x[i + 2]) + offset;
+          dst[i + 3] = atan2(y[i + 3], x[i + 3]) + offset;
+        }
+      /* for */
+
+      // Complete to end.
+      for (; i < n; ++i) dst[i] = atan2(y[i], x[i]) + offset;
+    }
+  /* if */
+}
+/* Atan2Array */
+
+
+
+//! Validates fast arctangent.
+/*!
+  Function compares fast arctangent against the C runtime atan2 over the full
+  input range: angles are densely sampled over [-pi, pi] for radii that span
+  many orders of magnitude, and all combinations of signed zeros and axis
+  directions are tested. Both SIMD and scalar code paths are checked.
+
+  \param num_angles     Number of sampled angles for each radius.
+  \param max_error_out  Address where the maximal absolute error in radians will be stored. May be NULL.
+  \return Function returns true if the maximal error is below FAST_ATAN2_ERROR_BOUND.
+*/
+bool
+ValidateFastAtan2(
+                  int const num_angles,
+                  double * const max_error_out
+                  )
+{
+  assert(0 < num_angles);
+  if (0 >= num_angles) return false;
+
+  double const pi = 3.141592653589793238462643383279502884197169399375;
+  double const radius[] = {1.0e-6, 1.0e-3, 1.0, 255.0, 4095.0, 65535.0, 1.0e6, 1.0e12};
+  int const num_radius = sizeof(radius) / sizeof(radius[0]);
+
+  int const num_special = 16;
+  int const n = num_angles * num_radius + num_special;
+
+  double * const y = new double[n];
+  double * const x = new double[n];
+  double * const fast = new double[n];
+  assert( (NULL != y) && (NULL != x) && (NULL != fast) );
+
+  double max_error = 0.0;
+  bool valid = ( (NULL != y) && (NULL != x) && (NULL != fast) );
+  if (false == valid) goto ValidateFastAtan2_EXIT;
+
+  // Sample angles for all radii.
+  {
+    double const k = 2.0 * pi / (double)(num_angles);
+    for (int j = 0; j < num_radius; ++j)
+      {
+        for (int i = 0; i < num_angles; ++i)
+          {
+            double const phi = -pi + k * (double)(i);
+            y[j * num_angles + i] = radius[j] * sin(phi);
+            x[j * num_angles + i] = radius[j] * cos(phi);
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+  // Add signed zeros and axis directions.
+  {
+    double const v[4] = {0.0, -0.0, 1.0, -1.0};
+    int const base = num_angles * num_radius;
+    for (int i = 0; i < num_special; ++i)
+      {
+        y[base + i] = v[i / 4];
+        x[base + i] = v[i % 4];
+      }
+    /* for */
+  }
+
+  // Compare SIMD and scalar paths to the C runtime library.
+  Atan2Array(y, x, fast, n, 0.0, PHASE_ATAN2_FAST);
+
+  for (int i = 0; i < n; ++i)
+    {
+      double const reference = atan2(y[i], x[i]);
+
+      double const error_simd = fabs(fast[i] - reference);
+      if (max_error < error_simd) max_error = error_simd;
+
+      double const error_scalar = fabs(FastAtan2_inline(y[i], x[i]) - reference);
+      if (max_error < error_scalar) max_error = error_scalar;
+    }
+  /* for */
+
+  valid = (max_error < FAST_ATAN2_ERROR_BOUND);
+
+ ValidateFastAtan2_EXIT:
+
+  SAFE_DELETE_ARRAY( y );
+  SAFE_DELETE_ARRAY( x );
+  SAFE_DELETE_ARRAY( fast );
+
+  if (NULL != max_error_out) *max_error_out = max_error;
+
+  return valid;
+}
+/* ValidateFastAtan2 */
+
+
+
 /****** RELATIVE PHASE ESTIMATION ******/
 
 
@@ -424,1961 +816,5307 @@ EstimateRelativePhase(
 
 
 
-/****** GRAY CODE DECODING ******/
+/****** FUSED RELATIVE PHASE ESTIMATION ******/
 
+//! Tile width (in pixels) of the fused relative phase estimator.
+#define RELATIVE_PHASE_TILE_WIDTH 256
 
-//! Computes Gray code weights (double precision).
+//! Band height (in rows) of one parallel work unit of the fused relative phase estimator.
+#define RELATIVE_PHASE_BAND_HEIGHT 16
+
+
+
+//! Converts image row to double.
 /*!
-  Function computes weights required to decode Gray code into projector column or row index.
+  Converts part of an image row to double precision.
 
-  \param N      Number of bits reserved for the Gray code.
-  \return Function returns a pointer to an array of doubles that has 2^N elements or NULL if unsuccessfull.
+  \param src    Pointer to first source pixel.
+  \param dst    Pointer to destination buffer.
+  \param n      Number of pixels to convert.
 */
-double *
-CreateGrayCodeWeights(
-                      int const N
-                      )
+template <typename T>
+inline
+void
+ConvertRowToDouble_inline(
+                          T const * const src,
+                          double * const dst,
+                          int const n
+                          )
 {
-  assert(0 < N);
-  if (0 >= N) return NULL;
-
-  /* Pre-allocate storage. */
-  int * const idx = (int *)malloc( sizeof(int) * N );
-  assert(NULL != idx);
-
-  int const total = 1 << N;
+  // Unrolled for loop with step 4.
+  int x = 0;
+  int const max_x = n - 3;
+  for (; x < max_x; x += 4)
+    {
+      dst[x    ] = (double)( src[x    ] );
+      dst[x + 1] = (double)( src[x + 1] );
+      dst[x + 2] = (double)( src[x + 2] );
+      dst[x + 3] = (double)( src[x + 3] );
+    }
+  /* for */
 
-  int * const code = (int *)malloc( sizeof(int) * total );
-  assert(NULL != code);
+  // Complete to end.
+  for (; x < n; ++x) dst[x] = (double)( src[x] );
+}
+/* ConvertRowToDouble_inline */
 
-  double * const weight = (double *)malloc( sizeof(double) * total );
-  assert(NULL != weight);
 
-  if ( (NULL == idx) || (NULL == code) || (NULL == weight) )
-    {
-      if (NULL != idx) free(idx);
-      if (NULL != code) free(code);
-      if (NULL != weight) free(weight);
-      return NULL;
-    }
-  /* if */
 
-  /* Compute code. */
-  for (int i = 0; i < N; ++i) idx[i] = 1 << i;
+//! Converts 8-bit unsigned image row to double.
+/*!
+  Converts part of an 8-bit unsigned image row to double precision using SSE2.
 
-  code[0] = 0;
-  for (int i = 0; i < N; ++i)
-    {
-      for (int j = idx[i]; j < 2 * idx[i]; ++j)
-        {
-          assert( (0 <= j) && (j < total) );
-          int const k = j - 2 * (j - idx[i] + 1) + 1;
-          assert( (0 <= k) && (k < total) );
-          code[j] = code[k] + idx[i];
-        }
-      /* for */
-    }
-  /* for */
+  \param src    Pointer to first source pixel.
+  \param dst    Pointer to destination buffer.
+  \param n      Number of pixels to convert.
+*/
+template <>
+inline
+void
+ConvertRowToDouble_inline<unsigned char>(
+                                         unsigned char const * const src,
+                                         double * const dst,
+                                         int const n
+                                         )
+{
+  __m128i const zero = _mm_setzero_si128();
 
-  double const total_inv = 1.0 / (double)(total);
-  for (int i = 0; i < total; ++i)
+  // Unrolled for loop with step 8.
+  int x = 0;
+  int const max_x = n - 7;
+  for (; x < max_x; x += 8)
     {
-      int const j = code[i];
-      assert( (0 <= j) && (j < total) );
-      weight[j] = double(i) * total_inv;
+      __m128i const v16 = _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i const *)(src + x) ), zero );
+      __m128i const v32_lo = _mm_unpacklo_epi16(v16, zero);
+      __m128i const v32_hi = _mm_unpackhi_epi16(v16, zero);
+
+      _mm_storeu_pd(dst + x    , _mm_cvtepi32_pd(v32_lo));
+      _mm_storeu_pd(dst + x + 2, _mm_cvtepi32_pd( _mm_srli_si128(v32_lo, 8) ));
+      _mm_storeu_pd(dst + x + 4, _mm_cvtepi32_pd(v32_hi));
+      _mm_storeu_pd(dst + x + 6, _mm_cvtepi32_pd( _mm_srli_si128(v32_hi, 8) ));
     }
   /* for */
 
-  /* Deallocate temporary storage. */
-  free(idx);
-  free(code);
-
-  return weight;
+  // Complete to end.
+  for (; x < n; ++x) dst[x] = (double)( src[x] );
 }
-/* CreateGrayCodeWeights */
+/* ConvertRowToDouble_inline<unsigned char> */
 
 
 
-//! Deletes Gray code weights (double precision).
+//! Converts 16-bit unsigned image row to double.
 /*!
-  Function deletes Gray code weights.
+  Converts part of a 16-bit unsigned image row to double precision using SSE2.
 
-  \param weight Pointer to Gray code weights.
+  \param src    Pointer to first source pixel.
+  \param dst    Pointer to destination buffer.
+  \param n      Number of pixels to convert.
 */
+template <>
+inline
 void
-DeleteGrayCodeWeights(
-                      double * const weight
-                      )
+ConvertRowToDouble_inline<unsigned short>(
+                                          unsigned short const * const src,
+                                          double * const dst,
+                                          int const n
+                                          )
 {
-  if (NULL != weight) free( weight );
+  __m128i const zero = _mm_setzero_si128();
+
+  // Unrolled for loop with step 8.
+  int x = 0;
+  int const max_x = n - 7;
+  for (; x < max_x; x += 8)
+    {
+      __m128i const v16 = _mm_loadu_si128( (__m128i const *)(src + x) );
+      __m128i const v32_lo = _mm_unpacklo_epi16(v16, zero);
+      __m128i const v32_hi = _mm_unpackhi_epi16(v16, zero);
+
+      _mm_storeu_pd(dst + x    , _mm_cvtepi32_pd(v32_lo));
+      _mm_storeu_pd(dst + x + 2, _mm_cvtepi32_pd( _mm_srli_si128(v32_lo, 8) ));
+      _mm_storeu_pd(dst + x + 4, _mm_cvtepi32_pd(v32_hi));
+      _mm_storeu_pd(dst + x + 6, _mm_cvtepi32_pd( _mm_srli_si128(v32_hi, 8) ));
+    }
+  /* for */
+
+  // Complete to end.
+  for (; x < n; ++x) dst[x] = (double)( src[x] );
 }
-/* DeleteGrayCodeWeights */
+/* ConvertRowToDouble_inline<unsigned short> */
 
 
 
-//! Decodes Gray code (double precision).
+//! Fetches tile row as double.
 /*!
-  Decodes Gray code and returns normalized projector coordinate.
-  Function assumes images are consecutively stored in AllImages starting
-  from index first and ending with index last (inclusive).
-
-  \param AllImages      Pointer to class containing all acquired images.
-  \param threshold      Pointer to threshold image. Must be of CV_64FC1 type.
-  \param first  Index of the first Gray code image.
-  \param last   Index of the last Gray code image.
-  \return Function returns a pointer to valid cv::Mat or NULL if unsuccesffull.
+  Fetches n pixels of row y starting at column x0 and converts them to double precision.
+
+  \param img    Pointer to single channel image.
+  \param y      Row index.
+  \param x0     Index of the first column.
+  \param n      Number of pixels to fetch.
+  \param dst    Pointer to destination buffer.
+  \return Function returns true if successfull, false if image depth is not supported.
 */
-cv::Mat *
-DecodeGrayCode(
-               ImageSet * const AllImages,
-               cv::Mat * threshold,
-               int const first,
-               int const last
-               )
+inline
+bool
+FetchTileRowAsDouble_inline(
+                            cv::Mat const * const img,
+                            int const y,
+                            int const x0,
+                            int const n,
+                            double * const dst
+                            )
 {
-  cv::Mat * code = NULL; // Decoded Gray code.
+  void const * const row = (void *)( (BYTE *)(img->data) + img->step[0] * y );
 
-  bool const inputs_valid = ValidateInputs_inline(AllImages, first, last);
-  if (false == inputs_valid) return code;
+  switch ( img->depth() )
+    {
+    case CV_8U: ConvertRowToDouble_inline<unsigned char>( (unsigned char const *)row + x0, dst, n ); break;
+    case CV_8S: ConvertRowToDouble_inline<signed char>( (signed char const *)row + x0, dst, n ); break;
+    case CV_16U: ConvertRowToDouble_inline<unsigned short>( (unsigned short const *)row + x0, dst, n ); break;
+    case CV_16S: ConvertRowToDouble_inline<short>( (short const *)row + x0, dst, n ); break;
+    case CV_32S: ConvertRowToDouble_inline<int>( (int const *)row + x0, dst, n ); break;
+    case CV_32F: ConvertRowToDouble_inline<float>( (float const *)row + x0, dst, n ); break;
+    case CV_64F: ConvertRowToDouble_inline<double>( (double const *)row + x0, dst, n ); break;
+    default: return false;
+    }
+  /* switch */
 
-  assert(NULL != threshold);
-  if (NULL == threshold) return code;
+  return true;
+}
+/* FetchTileRowAsDouble_inline */
 
-  int const num_images = last - first + 1;
-  assert(0 < num_images);
 
-  // Fetch input image size.
-  int const cols = AllImages->width;
-  int const rows = AllImages->height;
 
-  // Check size and type of the threshold image.
-  assert( cols <= threshold->cols );
-  assert( rows <= threshold->rows );
-  if ( (cols > threshold->cols) || (rows > threshold->rows) ) return code;
-
-  assert( (CV_MAT_DEPTH(threshold->type()) == CV_64F) && (CV_MAT_CN(threshold->type()) == 1) );
-  if ( (CV_MAT_DEPTH(threshold->type()) != CV_64F) || (CV_MAT_CN(threshold->type()) != 1) ) return code;
+//! Accumulates weighted tile row.
+/*!
+  Adds weighted gray values to numerator and denominator accumulators using SSE2.
+  All buffers must be 16 byte aligned.
+
+  \param gray   Pointer to gray values.
+  \param k_num  Numerator weight.
+  \param k_den  Denominator weight.
+  \param acc_num        Pointer to numerator accumulator.
+  \param acc_den        Pointer to denominator accumulator.
+  \param n      Number of elements.
+*/
+inline
+void
+AccumulateWeightedRow_inline(
+                             double const * const gray,
+                             double const k_num,
+                             double const k_den,
+                             double * const acc_num,
+                             double * const acc_den,
+                             int const n
+                             )
+{
+  __m128d const w_num = _mm_set1_pd(k_num);
+  __m128d const w_den = _mm_set1_pd(k_den);
 
-  // Allocate data storage for temporray buffers and end result.
-  code = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
-  assert(NULL != code);
+  // Unrolled for loop with step 4.
+  int x = 0;
+  int const max_x = n - 3;
+  for (; x < max_x; x += 4)
+    {
+      __m128d const g0 = _mm_load_pd(gray + x    );
+      __m128d const g1 = _mm_load_pd(gray + x + 2);
 
-  cv::Mat * tmp_buffer = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
-  assert(NULL != tmp_buffer);
+      _mm_store_pd(acc_num + x    , _mm_add_pd( _mm_load_pd(acc_num + x    ), _mm_mul_pd(w_num, g0) ));
+      _mm_store_pd(acc_num + x + 2, _mm_add_pd( _mm_load_pd(acc_num + x + 2), _mm_mul_pd(w_num, g1) ));
 
-  double * const weight = CreateGrayCodeWeights(num_images);
-  assert(NULL != weight);
+      _mm_store_pd(acc_den + x    , _mm_add_pd( _mm_load_pd(acc_den + x    ), _mm_mul_pd(w_den, g0) ));
+      _mm_store_pd(acc_den + x + 2, _mm_add_pd( _mm_load_pd(acc_den + x + 2), _mm_mul_pd(w_den, g1) ));
+    }
+  /* for */
 
-  int const total = 1 << num_images;
+  // Complete to end.
+  for (; x < n; ++x)
+    {
+      acc_num[x] += k_num * gray[x];
+      acc_den[x] += k_den * gray[x];
+    }
+  /* for */
+}
+/* AccumulateWeightedRow_inline */
 
-  if ( (NULL == code) || (NULL == tmp_buffer) || (NULL == weight) ) goto DecodeGrayCode_EXIT;
 
-  // Decode Gray code.
-  for (int i = first; i <= last; ++i)
-    {
-      cv::Mat * img1C = AllImages->GetImage1C(i);
-      assert(NULL != img1C);
-      if (NULL == img1C) goto DecodeGrayCode_EXIT;
 
-      // Re-use preallocated storage.
-      img1C->convertTo(*tmp_buffer, CV_64FC1);
+//! Closed-form N-step numerator and denominator.
+/*!
+  Computes numerator and denominator of the relative phase for N-step phase shifting
+  directly from N gray rows. Only step counts that have specialization are valid;
+  the specializations use closed-form expressions where all weights that are 0 or +-1
+  are replaced by additions and subtractions.
+
+  Results are equal to sum_i I_i cos(2 pi i / N) and -sum_i I_i sin(2 pi i / N)
+  up to rounding.
+
+  \param g      Array of N pointers to gray rows.
+  \param num    Pointer to numerator output.
+  \param den    Pointer to denominator output.
+  \param n      Number of elements.
+*/
+template <int N>
+inline
+void
+RelativePhaseNumDen_inline(
+                           double const * const * const g,
+                           double * const num,
+                           double * const den,
+                           int const n
+                           );
 
-      for (int y = 0; y < rows; ++y)
-        {
-          // Get row addresses.
-          double const * const row_threshold = (double *)( (BYTE *)(threshold->data) + threshold->step[0] * y );
-          double const * const row_gray = (double *)( (BYTE *)(tmp_buffer->data) + tmp_buffer->step[0] * y );
-          double       * const row_code = (double *)( (BYTE *)(code->data) + code->step[0] * y );
 
-          // Unrolled for loop with step 4.
-          int x = 0;
-          int const max_x = cols - 3;
-          for (; x < max_x; x += 4)
-            {
-              row_code[x    ] *= 2.0;
-              row_code[x + 1] *= 2.0;
-              row_code[x + 2] *= 2.0;
-              row_code[x + 3] *= 2.0;
 
-              if (row_gray[x    ] > row_threshold[x    ]) row_code[x    ] += 1.0;
-              if (row_gray[x + 1] > row_threshold[x + 1]) row_code[x + 1] += 1.0;
-              if (row_gray[x + 2] > row_threshold[x + 2]) row_code[x + 2] += 1.0;
-              if (row_gray[x + 3] > row_threshold[x + 3]) row_code[x + 3] += 1.0;
-            }
-          /* for */
+//! Closed-form 3-step numerator and denominator.
+template <>
+inline
+void
+RelativePhaseNumDen_inline<3>(
+                              double const * const * const g,
+                              double * const num,
+                              double * const den,
+                              int const n
+                              )
+{
+  double const s = 0.866025403784438646763723170752936183471402626905190314; // sqrt(3)/2
 
-          // Complete to end.
-          for (; x < cols; ++x)
-            {
-              row_code[x] *= 2.0;
-              if (row_gray[x] > row_threshold[x]) row_code[x] += 1.0;
-            }
-          /* for */
-        }
-      /* for */
+  double const * const I0 = g[0];
+  double const * const I1 = g[1];
+  double const * const I2 = g[2];
 
-      SAFE_DELETE(img1C);
+  for (int x = 0; x < n; ++x)
+    {
+      num[x] = I0[x] - 0.5 * (I1[x] + I2[x]);
+      den[x] = s * (I2[x] - I1[x]);
     }
   /* for */
+}
+/* RelativePhaseNumDen_inline<3> */
 
-  // Normalize code.
-  for (int y = 0; y < rows; ++y)
-    {
-      // Get row addresses.
-      double * const row_code = (double *)( (BYTE *)(code->data) + code->step[0] * y );
 
-      for (int x = 0; x < cols; ++x)
-        {
-          assert( (0 <= row_code[x]) && (row_code[x] < total) );
-          row_code[x] = weight[ (int)(row_code[x]) ];
-        }
-      /* for */
+
+//! Closed-form 4-step numerator and denominator.
+template <>
+inline
+void
+RelativePhaseNumDen_inline<4>(
+                              double const * const * const g,
+                              double * const num,
+                              double * const den,
+                              int const n
+                              )
+{
+  double const * const I0 = g[0];
+  double const * const I1 = g[1];
+  double const * const I2 = g[2];
+  double const * const I3 = g[3];
+
+  for (int x = 0; x < n; ++x)
+    {
+      num[x] = I0[x] - I2[x];
+      den[x] = I3[x] - I1[x];
     }
   /* for */
+}
+/* RelativePhaseNumDen_inline<4> */
 
- DecodeGrayCode_EXIT:
 
-  SAFE_DELETE(tmp_buffer);
-  DeleteGrayCodeWeights(weight);
 
-  return code;
+//! Closed-form 6-step numerator and denominator.
+template <>
+inline
+void
+RelativePhaseNumDen_inline<6>(
+                              double const * const * const g,
+                              double * const num,
+                              double * const den,
+                              int const n
+                              )
+{
+  double const s = 0.866025403784438646763723170752936183471402626905190314; // sqrt(3)/2
+
+  double const * const I0 = g[0];
+  double const * const I1 = g[1];
+  double const * const I2 = g[2];
+  double const * const I3 = g[3];
+  double const * const I4 = g[4];
+  double const * const I5 = g[5];
+
+  for (int x = 0; x < n; ++x)
+    {
+      num[x] = (I0[x] - I3[x]) + 0.5 * ( (I1[x] + I5[x]) - (I2[x] + I4[x]) );
+      den[x] = s * ( (I4[x] + I5[x]) - (I1[x] + I2[x]) );
+    }
+  /* for */
 }
-/* DecodeGrayCode */
+/* RelativePhaseNumDen_inline<6> */
 
 
 
-/****** ABSOLUTE PHASE ESTIMATION USING GC+PS ******/
+//! Closed-form 8-step numerator and denominator.
+template <>
+inline
+void
+RelativePhaseNumDen_inline<8>(
+                              double const * const * const g,
+                              double * const num,
+                              double * const den,
+                              int const n
+                              )
+{
+  double const c = 0.707106781186547524400844362104849039284835937688474036; // sqrt(2)/2
+
+  double const * const I0 = g[0];
+  double const * const I1 = g[1];
+  double const * const I2 = g[2];
+  double const * const I3 = g[3];
+  double const * const I4 = g[4];
+  double const * const I5 = g[5];
+  double const * const I6 = g[6];
+  double const * const I7 = g[7];
+
+  for (int x = 0; x < n; ++x)
+    {
+      double const d17 = I1[x] - I5[x]; // I1 and I5 have opposite weights.
+      double const d37 = I7[x] - I3[x]; // I3 and I7 have opposite weights.
+      num[x] = (I0[x] - I4[x]) + c * (d17 + d37);
+      den[x] = (I6[x] - I2[x]) + c * (d37 - d17);
+    }
+  /* for */
+}
+/* RelativePhaseNumDen_inline<8> */
 
 
-//! Unwraps phase using Gray code.
-/*!
-  Function unwraps phase using Gray code.
 
-  \param AllImages
-  \param n1     First image of the normal Gray code set.
-  \param n2     Last image of the normal Gray code set.
-  \param m1     First image of the shifted Gray code set.
-  \param m2     Last iamge of the shifted Gray code set.
-  \param b  Index of the black image.
-  \param w  Index of the white image.
-  \param rel_phase      Pointer to wrapped phase image. Must be of type.
-  \param gray_code_1_out    Pointer to address where decoded normal Gray code will be stored. May be NULL.
-  \param gray_code_2_out    Pointer to address where decoded second Gray code will be stored. May be NULL.
-  \return Function returns pointer to unwrapped phase image or NULL if unsuccessfull.
-*/
-cv::Mat *
-UnwrapPhasePSAndGC(
-                   ImageSet * const AllImages,
-                   int const n1,
-                   int const n2,
-                   int const m1,
-                   int const m2,
-                   int const b,
-                   int const w,
-                   cv::Mat * const rel_phase,
-                   cv::Mat * * const gray_code_1_out,
-                   cv::Mat * * const gray_code_2_out
-                   )
-{
-  cv::Mat * abs_phase = NULL; // Unwrapped (or absolute) phase.
+//! Function pointer to specialized N-step phase kernel.
+typedef void (*RelativePhaseNumDenKernel)(double const * const * const, double * const, double * const, int const);
 
-  // Check inputs.
-  assert( (0 <= b) && (b < AllImages->num_images) );
-  if ( (b < 0) || (AllImages->num_images <= b) ) return abs_phase;
+//! Largest step count that has a specialized kernel.
+#define RELATIVE_PHASE_MAX_SPECIALIZED_STEPS 8
 
-  assert( (0 <= w) && (w < AllImages->num_images) );
-  if ( (w < 0) || (AllImages->num_images <= w) ) return abs_phase;
+//! Dispatch table of specialized N-step phase kernels indexed by the step count.
+static RelativePhaseNumDenKernel const gRelativePhaseNumDenKernels[RELATIVE_PHASE_MAX_SPECIALIZED_STEPS + 1] =
+  {
+    NULL, // 0
+    NULL, // 1
+    NULL, // 2
+    &RelativePhaseNumDen_inline<3>,
+    &RelativePhaseNumDen_inline<4>,
+    NULL, // 5
+    &RelativePhaseNumDen_inline<6>,
+    NULL, // 7
+    &RelativePhaseNumDen_inline<8>
+  };
 
-  assert( NULL != rel_phase );
-  if (NULL == rel_phase) return abs_phase;
 
-  assert( NULL != rel_phase->data );
-  if (NULL == rel_phase->data) return abs_phase;
 
-  // Fetch input image size.
-  int const cols = AllImages->width;
-  int const rows = AllImages->height;
+//! Gets specialized N-step phase kernel.
+/*!
+  Returns specialized kernel for the given step count.
 
-  assert( cols <= rel_phase->cols );
-  assert( rows <= rel_phase->rows );
-  if ( (cols > rel_phase->cols) || (rows > rel_phase->rows) ) return abs_phase;
+  \param num_images     Number of phase shifted images.
+  \return Returns pointer to kernel or NULL if there is no specialized kernel.
+*/
+inline
+RelativePhaseNumDenKernel
+GetRelativePhaseNumDenKernel_inline(
+                                    int const num_images
+                                    )
+{
+  if ( (num_images < 0) || (RELATIVE_PHASE_MAX_SPECIALIZED_STEPS < num_images) ) return NULL;
+  return gRelativePhaseNumDenKernels[num_images];
+}
+/* GetRelativePhaseNumDenKernel_inline */
 
-  assert( (CV_MAT_DEPTH(rel_phase->type()) == CV_64F) && (CV_MAT_CN(rel_phase->type()) == 1) );
-  if ( (CV_MAT_DEPTH(rel_phase->type()) != CV_64F) || (CV_MAT_CN(rel_phase->type()) != 1) ) return abs_phase;
 
-  // Preallocate storage.
-  cv::Mat * black = AllImages->GetImage1C(b);
-  assert(NULL != black);
 
-  cv::Mat * white = AllImages->GetImage1C(w);
-  assert(NULL != white);
+//! Tile statistics outputs of the fused relative phase estimator.
+/*!
+  Describes where the dynamic range and the texture computed from the tiles of
+  one phase shift group are stored. Dynamic range is the difference between
+  the maximal and the minimal gray value; if merging is requested the lower
+  of the stored and of the new value is kept. Texture is the scaled sum of all
+  images; if merging is requested it is added to the stored texture.
+  For multi-channel pixel formats texture is computed from BGR images.
+*/
+typedef
+struct TileStatisticsOutput_
+{
+  cv::Mat * dynamic_range; //!< Output dynamic range (CV_32FC1); may be NULL.
+  bool merge_dynamic_range; //!< Flag to indicate output dynamic range is merged with the new one.
+  cv::Mat * texture; //!< Output texture (CV_32FC1 or CV_32FC3); may be NULL.
+  bool merge_texture; //!< Flag to indicate new texture is added to the output texture.
+  float texture_scale; //!< Scaling factor of the texture.
+  std::vector<cv::Mat *> texture_images; //!< BGR image headers; empty if texture is computed from gray values.
+
+  //! Constructor.
+  TileStatisticsOutput_()
+  {
+    this->dynamic_range = NULL;
+    this->merge_dynamic_range = false;
+    this->texture = NULL;
+    this->merge_texture = false;
+    this->texture_scale = 1.0f;
+  }
 
-  cv::Mat * gray_code_1 = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
-  assert(NULL != gray_code_1);
+  //! Destructor.
+  ~TileStatisticsOutput_()
+  {
+    for (size_t i = 0; i < this->texture_images.size(); ++i) SAFE_DELETE( this->texture_images[i] );
+    this->texture_images.clear();
+  }
 
-  cv::Mat * gray_code_2 = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
-  assert(NULL != gray_code_2);
+} TileStatisticsOutput;
 
-  cv::Mat * threshold = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
-  assert(NULL != threshold);
 
-  if ( (NULL == black) ||
-       (NULL == white) ||
-       (NULL == gray_code_1) ||
-       (NULL == gray_code_2) ||
-       (NULL == threshold)
-       )
+
+//! Updates tile statistics.
+/*!
+  Updates running minimum, maximum, and sum of gray values of one tile row.
+
+  \param gray   Pointer to gray values.
+  \param i      Index of the image in the phase shift group; statistics are initialized for i = 0.
+  \param tile_min       Pointer to running minimum. May be NULL.
+  \param tile_max       Pointer to running maximum. May be NULL.
+  \param tile_sum       Pointer to running sum. May be NULL.
+  \param n      Number of elements.
+*/
+inline
+void
+UpdateTileStatistics_inline(
+                            double const * const gray,
+                            int const i,
+                            double * const tile_min,
+                            double * const tile_max,
+                            double * const tile_sum,
+                            int const n
+                            )
+{
+  if ( (NULL != tile_min) && (NULL != tile_max) )
     {
-      goto UnwrapPhasePSAndGC_EXIT;
+      if (0 == i)
+        {
+          memcpy(tile_min, gray, sizeof(double) * n);
+          memcpy(tile_max, gray, sizeof(double) * n);
+        }
+      else
+        {
+          for (int x = 0; x < n; ++x)
+            {
+              if (gray[x] < tile_min[x]) tile_min[x] = gray[x];
+              if (gray[x] > tile_max[x]) tile_max[x] = gray[x];
+            }
+          /* for */
+        }
+      /* if */
     }
   /* if */
 
-  // Compute threshold; we use gray_code_? as temporary buffers.
-  black->convertTo(*gray_code_1, CV_64FC1);
-  white->convertTo(*gray_code_2, CV_64FC1);
-
-  for (int y = 0; y < rows; ++y)
+  if (NULL != tile_sum)
     {
-      // Get row addresses.
-      double const * const row_gray_code_1 = (double *)( (BYTE *)(gray_code_1->data) + gray_code_1->step[0] * y );
-      double const * const row_gray_code_2 = (double *)( (BYTE *)(gray_code_2->data) + gray_code_2->step[0] * y );
-      double       * const row_threshold = (double *)( (BYTE *)(threshold->data) + threshold->step[0] * y );
-
-      // Unrolled for loop with step 8.
-      int x = 0;
-      int const max_x = cols - 7;
-      for (; x < max_x; x += 8)
+      if (0 == i)
         {
-          row_threshold[x    ] = 0.5 * ( row_gray_code_1[x    ] + row_gray_code_2[x    ] );
-          row_threshold[x + 1] = 0.5 * ( row_gray_code_1[x + 1] + row_gray_code_2[x + 1] );
-          row_threshold[x + 2] = 0.5 * ( row_gray_code_1[x + 2] + row_gray_code_2[x + 2] );
-          row_threshold[x + 3] = 0.5 * ( row_gray_code_1[x + 3] + row_gray_code_2[x + 3] );
-
-          row_threshold[x + 4] = 0.5 * ( row_gray_code_1[x + 4] + row_gray_code_2[x + 4] );
-          row_threshold[x + 5] = 0.5 * ( row_gray_code_1[x + 5] + row_gray_code_2[x + 5] );
-          row_threshold[x + 6] = 0.5 * ( row_gray_code_1[x + 6] + row_gray_code_2[x + 6] );
-          row_threshold[x + 7] = 0.5 * ( row_gray_code_1[x + 7] + row_gray_code_2[x + 7] );
+          memcpy(tile_sum, gray, sizeof(double) * n);
         }
-      /* for */
-
-      // Complete to end.
-      for (; x < cols; ++x)
+      else
         {
-          row_threshold[x] = 0.5 * ( row_gray_code_1[x] + row_gray_code_2[x] );
+          for (int x = 0; x < n; ++x) tile_sum[x] += gray[x];
         }
-      /* for */
+      /* if */
     }
-  /* for */
-
-  SAFE_DELETE( gray_code_1 );
-  SAFE_DELETE( gray_code_2 );
-
-  // Decode normal Gray code.
-  gray_code_1 = DecodeGrayCode(AllImages, threshold, n1, n2);
-  assert(NULL != gray_code_1);
-  if (NULL == gray_code_1) goto UnwrapPhasePSAndGC_EXIT;
-
-  // Decode shifted Gray code (may not be present).
-  gray_code_2 = DecodeGrayCode(AllImages, threshold, m1, m2);
+  /* if */
+}
+/* UpdateTileStatistics_inline */
 
-  // Reuse preallocated space for the output buffer.
-  abs_phase = threshold;
-  threshold = NULL;
 
-  // Define pi.
-  double const pi = 3.141592653589793238462643383279502884197169399375;
 
-  // Decode wrapped phase.
-  if (NULL == gray_code_2)
+//! Stores tile statistics.
+/*!
+  Stores dynamic range and texture of one tile row. If texture is computed
+  from BGR images then the BGR tile rows are fetched and summed here.
+
+  \param out    Pointer to tile statistics outputs.
+  \param y      Row index.
+  \param x0     Index of the first column of the tile.
+  \param n      Tile width.
+  \param tile_min       Minimal gray value of each pixel.
+  \param tile_max       Maximal gray value of each pixel.
+  \param tile_sum       Sum of gray values of each pixel; unused if texture is computed from BGR images.
+  \param bgr    Scratch buffer for 3 * RELATIVE_PHASE_TILE_WIDTH values.
+  \param bgr_sum        Scratch buffer for 3 * RELATIVE_PHASE_TILE_WIDTH values.
+*/
+inline
+void
+StoreTileStatistics_inline(
+                           TileStatisticsOutput const * const out,
+                           int const y,
+                           int const x0,
+                           int const n,
+                           double const * const tile_min,
+                           double const * const tile_max,
+                           double const * const tile_sum,
+                           double * const bgr,
+                           double * const bgr_sum
+                           )
+{
+  if (NULL != out->dynamic_range)
     {
-      // Decode using only the normal Gray code set. This type of decoding
-      // may produce errors on code boundaries.
-      double const total = (double)( 1 << (n2 - n1 + 1) );
-      double const c = 0.5 / (total * pi);
-
-      for (int y = 0; y < rows; ++y)
+      float * const dst = (float *)( (BYTE *)(out->dynamic_range->data) + out->dynamic_range->step[0] * y ) + x0;
+      if (true == out->merge_dynamic_range)
         {
-          // Get row addresses.
-          double const * const row_gray_code_1 = (double *)( (BYTE *)(gray_code_1->data) + gray_code_1->step[0] * y );
-          double const * const row_rel_phase = (double *)( (BYTE *)(rel_phase->data) + rel_phase->step[0] * y );
-          double       * const row_abs_phase = (double *)( (BYTE *)(abs_phase->data) + abs_phase->step[0] * y );
-
-          // Unrolled for loop with step 8.
-          int x = 0;
-          int const max_x = cols - 7;
-          for (; x < max_x; x += 8)
+          for (int x = 0; x < n; ++x)
             {
-              row_abs_phase[x    ] = row_gray_code_1[x    ] + c * row_rel_phase[x    ];
-              row_abs_phase[x + 1] = row_gray_code_1[x + 1] + c * row_rel_phase[x + 1];
-              row_abs_phase[x + 2] = row_gray_code_1[x + 2] + c * row_rel_phase[x + 2];
-              row_abs_phase[x + 3] = row_gray_code_1[x + 3] + c * row_rel_phase[x + 3];
-
-              row_abs_phase[x + 4] = row_gray_code_1[x + 4] + c * row_rel_phase[x + 4];
-              row_abs_phase[x + 5] = row_gray_code_1[x + 5] + c * row_rel_phase[x + 5];
-              row_abs_phase[x + 6] = row_gray_code_1[x + 6] + c * row_rel_phase[x + 6];
-              row_abs_phase[x + 7] = row_gray_code_1[x + 7] + c * row_rel_phase[x + 7];
-
+              float const value = (float)( tile_max[x] ) - (float)( tile_min[x] );
+              dst[x] = (dst[x] < value)? dst[x] : value;
             }
           /* for */
+        }
+      else
+        {
+          for (int x = 0; x < n; ++x) dst[x] = (float)( tile_max[x] ) - (float)( tile_min[x] );
+        }
+      /* if */
+    }
+  /* if */
 
-          // Complete to end.
-          for (; x < cols; ++x)
+  if (NULL != out->texture)
+    {
+      float const scl = out->texture_scale;
+      int const cn = out->texture->channels();
+      float * const dst = (float *)( (BYTE *)(out->texture->data) + out->texture->step[0] * y ) + cn * x0;
+
+      double const * src = tile_sum;
+      int const num_texture_images = (int)( out->texture_images.size() );
+      if (0 < num_texture_images)
+        {
+          for (int i = 0; i < num_texture_images; ++i)
             {
-              row_abs_phase[x] = row_gray_code_1[x] + c * row_rel_phase[x];
+              bool const fetched = FetchTileRowAsDouble_inline(out->texture_images[i], y, cn * x0, cn * n, bgr);
+              assert(true == fetched);
+              UpdateTileStatistics_inline(bgr, i, NULL, NULL, bgr_sum, cn * n);
             }
           /* for */
+          src = bgr_sum;
+        }
+      /* if */
 
+      int const end_x = cn * n;
+      if (true == out->merge_texture)
+        {
+          for (int x = 0; x < end_x; ++x) dst[x] += scl * (float)( src[x] );
         }
-      /* for */
-    }
-  else
-    {
-      double const total1 = (double)( 1 << (n2 - n1 + 1) );
-      double const total2 = (double)( 1 << (m2 - m1 + 1) );
-      assert(total1 == total2);
-
-      double const c = 0.5 / pi;
-      double const c1 = 1.0 / total1;
-      double const c2 = 1.0 / total2;
-
-      for (int y = 0; y < rows; ++y)
-        {
-          // Get row addresses.
-          double const * const row_gray_code_1 = (double *)( (BYTE *)(gray_code_1->data) + gray_code_1->step[0] * y );
-          double const * const row_gray_code_2 = (double *)( (BYTE *)(gray_code_2->data) + gray_code_2->step[0] * y );
-          double const * const row_rel_phase = (double *)( (BYTE *)(rel_phase->data) + rel_phase->step[0] * y );
-          double       * const row_abs_phase = (double *)( (BYTE *)(abs_phase->data) + abs_phase->step[0] * y );
-
-          // Unwrap phase.
-          int x = 0;
-          for (; x < cols; ++x)
-            {
-              double const WP_norm = c * row_rel_phase[x];
-
-              if ( (0.25 <= WP_norm) && (WP_norm < 0.75) )
-                {
-                  row_abs_phase[x] = row_gray_code_1[x] + c1 * WP_norm;
-                }
-              else
-                {
-                  if ( 0 != row_gray_code_1[x] )
-                    {
-                      double const WP_norm_shifted = WP_norm + ( (WP_norm < 0.5)? 0.5 : -0.5 );
-                      row_abs_phase[x] = (row_gray_code_2[x] + c2 * 0.5) + c2 * WP_norm_shifted;
-                    }
-                  else
-                    {
-                      row_abs_phase[x] = c1 * WP_norm;
-                    }
-                  /* if */
-                }
-              /* if */
-            }
-          /* for */
-        }
-      /* for */
-
+      else
+        {
+          for (int x = 0; x < end_x; ++x) dst[x] = scl * (float)( src[x] );
+        }
+      /* if */
     }
   /* if */
-
-
-  SAFE_ASSIGN_PTR( gray_code_1, gray_code_1_out );
-  SAFE_ASSIGN_PTR( gray_code_2, gray_code_2_out );
-
- UnwrapPhasePSAndGC_EXIT:
-
-  SAFE_DELETE( black );
-  SAFE_DELETE( white );
-  SAFE_DELETE( threshold );
-  SAFE_DELETE( gray_code_1 );
-  SAFE_DELETE( gray_code_2 );
-
-  return abs_phase;
 }
-/* UnwrapPSAndGC */
-
+/* StoreTileStatistics_inline */
 
 
 
-/****** ABSOLUTE PHASE ESTIMATION USING MPS ******/
-
-//! Test in all numbers are whole numbers.
+//! Prepares tile statistics outputs.
 /*!
-  Function tests is all numbers in std::vector are whole.
+  Validates and, if required, allocates dynamic range and texture images
+  and fetches BGR image headers for multi-channel pixel formats.
+  Inputs follow the conventions of UpdateDynamicRangeAndTexture.
 
-  \param numbers_in     Reference to std::vector of double precision numbers.
-  \return Function returns true if all elements in std::vector are whole numbers and false otherwise.
-  If the vector is empty then true is returned.
+  \param AllImages      Pointer to class containing all acquired images.
+  \param first  Index of the first image.
+  \param last   Index of the last image (inclusive).
+  \param dynamic_range_in_out   Address of a pointer to dynamic range image. May be NULL.
+  \param texture_in_out Address of a pointer to texture image. May be NULL.
+  \param out    Pointer to tile statistics outputs which will be filled.
+  \return Returns true if successfull, false otherwise.
 */
 inline
 bool
-mps_all_whole_inline(
-                     std::vector<double> const & numbers_in
-                     )
+PrepareTileStatistics_inline(
+                             ImageSet * const AllImages,
+                             int const first,
+                             int const last,
+                             cv::Mat * * const dynamic_range_in_out,
+                             cv::Mat * * const texture_in_out,
+                             TileStatisticsOutput * const out
+                             )
 {
-  bool all_whole = true;
+  int const cols = AllImages->width;
+  int const rows = AllImages->height;
+  int const num_images = last - first + 1;
 
-  int const i_max = (int)( numbers_in.size() );
-  for (int i = 0; i < i_max; ++i)
+  if (NULL != dynamic_range_in_out)
     {
-      __int64 const x = (__int64)( numbers_in[i] + 0.5 );
-      bool const x_is_whole = ( (double)x == numbers_in[i] );
-      all_whole = all_whole && x_is_whole;
-    }
-  /* for */
-
-  return all_whole;
-}
-/* mps_all_whole_inline */
-
-
+      out->merge_dynamic_range = (NULL != *dynamic_range_in_out);
+      if (true == out->merge_dynamic_range)
+        {
+          cv::Mat * const dynamic_range = *dynamic_range_in_out;
+          assert( (NULL != dynamic_range->data) && (CV_32F == dynamic_range->depth()) && (1 == dynamic_range->channels()) );
+          if ( (NULL == dynamic_range->data) || (CV_32F != dynamic_range->depth()) || (1 != dynamic_range->channels()) ) return false;
 
-//! Compute greatest common divisor of two numbers.
-/*!
-  Function computes greatest common divisor of two numbers
-  using Euclidean algorithm.
+          assert( (cols == dynamic_range->cols) && (rows == dynamic_range->rows) );
+          if ( (cols != dynamic_range->cols) || (rows != dynamic_range->rows) ) return false;
 
-  \param a      First number. Input must be whole number.
-  \param b      Second number. Input must be whole number different than zero.
-  \return Function returns greatest common divisor if successfull or NaN if unsuccessfull.
-*/
-double
-mps_gcd(
-        double const a,
-        double const b
-        )
-{
-  // Test if input numbers are whole numbers.
-  __int64 const A = (__int64)( a + 0.5 );
-  __int64 const B = (__int64)( b + 0.5 );
-  bool const a_is_whole = ( (double)A == a );
-  bool const b_is_whole = ( (double)B == b );
-  assert( (true == a_is_whole) && (true == b_is_whole) );
-  if ( (false == a_is_whole) || (false == b_is_whole) )
-    {
-      Debugfwprintf(stderr, gDbgGCDInputsAreNotWholeNumbers);
+          out->dynamic_range = dynamic_range;
+        }
+      else
+        {
+          out->dynamic_range = new cv::Mat(rows, cols, CV_32FC1);
+          assert( (NULL != out->dynamic_range) && (NULL != out->dynamic_range->data) );
+          if ( (NULL == out->dynamic_range) || (NULL == out->dynamic_range->data) ) return false;
+        }
+      /* if */
     }
   /* if */
 
-  // Test if input numbers have all digits.
-  double const limit = pow(2.0, 53);
-  assert( (a < limit) && (b < limit) );
-  if ( (a >= limit) || (b >= limit) )
+  if (NULL != texture_in_out)
     {
-      Debugfwprintf(stderr, gDbgGCDInputsHaveOverflow);
-    }
-  /* if */
+      bool const is_1_channel = ImageDataTypeIs1C_inline(AllImages->PixelFormat);
+      int const cn = (true == is_1_channel)? 1 : 3;
 
-  // Assume failure.
-  double gcd = std::numeric_limits<double>::quiet_NaN();
+      out->texture_scale = (float)( 2.0 / (double)(num_images) );
+      out->merge_texture = (NULL != *texture_in_out);
+      if (true == out->merge_texture)
+        {
+          cv::Mat * const texture = *texture_in_out;
+          assert( (NULL != texture->data) && (CV_32F == texture->depth()) && (cn == texture->channels()) );
+          if ( (NULL == texture->data) || (CV_32F != texture->depth()) || (cn != texture->channels()) ) return false;
 
-  // The second input must be non-zero to avoid an infinite loop.
-  // Note that the first input may be zero in which case the while loop terminates after first iteration.
-  if (0 != B)
-    {
-      __int64 r0 = A;
-      __int64 r1 = B;
-      __int64 r = 1;
+          assert( (cols == texture->cols) && (rows == texture->rows) );
+          if ( (cols != texture->cols) || (rows != texture->rows) ) return false;
 
-      while (0 != r)
+          out->texture = texture;
+        }
+      else
         {
-          r = r0 % r1;
-          r0 = r1;
-          r1 = r;
+          out->texture = new cv::Mat(rows, cols, CV_MAKETYPE(CV_32F, cn));
+          assert( (NULL != out->texture) && (NULL != out->texture->data) );
+          if ( (NULL == out->texture) || (NULL == out->texture->data) ) return false;
         }
-      /* while */
-
-      gcd = (double)( r0 );
-
-      __int64 const GCD = (__int64)(gcd + 0.5);
-      assert( (double)GCD == gcd );
-    }
-  /* if */
-
-  return gcd;
-}
-/* mps_gcd */
-
-
+      /* if */
 
-//! Compute greatest common divisor of many numbers.
-/*!
-  Function computes greatest common divisor of arbitrary many numbers in
-  sequential manner using associativity property of the greatest common divisor.
+      if (false == is_1_channel)
+        {
+          out->texture_images.reserve(num_images);
+          for (int i = first; i <= last; ++i)
+            {
+              cv::Mat * img3C = AllImages->GetImageBGR(i);
+              assert(NULL != img3C);
+              if (NULL == img3C) return false;
 
-  \param vec    Reference to a vector of numbers.
-  \return Function returns greatest common divisor if successfull or NaN if unsuccessfull.
-*/
-double
-mps_gcd(
-        std::vector<double> const & vec
-        )
-{
-  // Assume failure.
-  double gcd = std::numeric_limits<double>::quiet_NaN();
+              out->texture_images.push_back(img3C);
 
-  if ( (false == vec.empty()) && (true == mps_all_whole_inline(vec)) )
-    {
-      gcd = vec.front();
-      for (size_t i = 1; i < vec.size(); ++i)
-        {
-          gcd = mps_gcd(gcd, vec.at(i));
+              assert( (3 == img3C->channels()) && (cols <= img3C->cols) && (rows <= img3C->rows) );
+              if ( (3 != img3C->channels()) || (cols > img3C->cols) || (rows > img3C->rows) ) return false;
+            }
+          /* for */
         }
-      /* for */
+      /* if */
     }
   /* if */
 
-  return gcd;
+  return true;
 }
-/* mps_gcd */
+/* PrepareTileStatistics_inline */
 
 
 
-//! Compute least common multiple of two numbers.
+//! Finishes tile statistics outputs.
 /*!
-  Function computes least common multiple of two numbers
-  using mps_gcd function.
+  Assigns newly allocated dynamic range and texture images to outputs if the
+  computation was successfull and deletes them otherwise.
 
-  \param a      First number. Input must be whole number.
-  \param b      Second number. Input must be whole number different than zero.
-  \return Function returns least common multiple if successfull or NaN if unsuccessfull.
+  \param out    Pointer to tile statistics outputs.
+  \param success        Flag to indicate the computation was successfull.
+  \param dynamic_range_in_out   Address of a pointer to dynamic range image. May be NULL.
+  \param texture_in_out Address of a pointer to texture image. May be NULL.
 */
-double
-mps_lcm(
-        double const a,
-        double const b
-        )
+inline
+void
+FinishTileStatistics_inline(
+                            TileStatisticsOutput * const out,
+                            bool const success,
+                            cv::Mat * * const dynamic_range_in_out,
+                            cv::Mat * * const texture_in_out
+                            )
 {
-  // Test if input numbers are whole numbers.
-  __int64 const A = (__int64)( a + 0.5 );
-  __int64 const B = (__int64)( b + 0.5 );
-  bool const a_is_whole = ( (double)A == a );
-  bool const b_is_whole = ( (double)B == b );
-  assert( (true == a_is_whole) && (true == b_is_whole) );
-  if ( (false == a_is_whole) || (false == b_is_whole) )
+  if (false == out->merge_dynamic_range)
     {
-      Debugfwprintf(stderr, gDbgLCMInputsAreNotWholeNumbers);
+      if (true == success) SAFE_ASSIGN_PTR( out->dynamic_range, dynamic_range_in_out );
+      SAFE_DELETE( out->dynamic_range );
     }
   /* if */
+  out->dynamic_range = NULL;
 
-  // Test if input numbers have all digits and if product overflows.
-  double const limit = pow(2.0, 53);
-  assert( (a < limit) && (b < limit) && (a * b <= limit) );
-  if ( (a >= limit) || (b >= limit) || (a * b > limit) )
+  if (false == out->merge_texture)
     {
-      Debugfwprintf(stderr, gDbgLCMInputsHaveOverflow);
+      if (true == success) SAFE_ASSIGN_PTR( out->texture, texture_in_out );
+      SAFE_DELETE( out->texture );
     }
   /* if */
-
-  double const gcd = mps_gcd(a, b);
-  double const lcm = fabs(a * b) / gcd;
-
-  return lcm;
+  out->texture = NULL;
 }
-/* mps_lcm */
+/* FinishTileStatistics_inline */
 
 
 
-//! Compute least common multiple of many numbers.
+//! Computes relative phase for one tile row.
 /*!
-  Function computes least common multiple of arbitrary many numbers
-  in sequentiall manner using associativity property of the least common multiple.
-
-  \param vec    Reference to a vector of numbers.
-  \return Function returns least common multiple is successfull or NaN if unsuccessfull.
+  Fetches tile row of all images of a phase shift group, computes numerator
+  and denominator using either the specialized or the generic kernel,
+  and stores the relative phase. Minimum, maximum, and sum of the fetched
+  gray values may be computed at the same time.
+
+  \param images Pointer to vector of single channel images of one phase shift group.
+  \param weight_num     Numerator weights; used only by the generic kernel.
+  \param weight_den     Denominator weights; used only by the generic kernel.
+  \param kernel Specialized N-step kernel or NULL for generic accumulation.
+  \param atan2_method   Arctangent computation method.
+  \param y      Row index.
+  \param x0     Index of the first column of the tile.
+  \param n      Tile width.
+  \param gray   Scratch buffer for RELATIVE_PHASE_MAX_SPECIALIZED_STEPS tile rows.
+  \param acc_num        Scratch buffer for numerator.
+  \param acc_den        Scratch buffer for denominator.
+  \param dst    Pointer to output relative phase.
+  \param tile_min       Pointer to output minimal gray values. May be NULL.
+  \param tile_max       Pointer to output maximal gray values. May be NULL.
+  \param tile_sum       Pointer to output sum of gray values. May be NULL.
 */
-double
-mps_lcm(
-        std::vector<double> const & vec
-        )
+inline
+void
+RelativePhaseTileRow_inline(
+                            std::vector<cv::Mat *> const * const images,
+                            double const * const weight_num,
+                            double const * const weight_den,
+                            RelativePhaseNumDenKernel const kernel,
+                            PhaseAtan2Method const atan2_method,
+                            int const y,
+                            int const x0,
+                            int const n,
+                            double (* const gray)[RELATIVE_PHASE_TILE_WIDTH],
+                            double * const acc_num,
+                            double * const acc_den,
+                            double * const dst,
+                            double * const tile_min,
+                            double * const tile_max,
+                            double * const tile_sum
+                            )
 {
-  // Assume failure.
-  double lcm = std::numeric_limits<double>::quiet_NaN();
+  double const pi = 3.141592653589793238462643383279502884197169399375;
 
-  if ( (false == vec.empty()) && (true == mps_all_whole_inline(vec)) )
+  int const num_images = (int)( images->size() );
+
+  if (NULL != kernel)
     {
-      lcm = vec.front();
-      for (size_t i = 1; i < vec.size(); ++i)
+      assert(num_images <= RELATIVE_PHASE_MAX_SPECIALIZED_STEPS);
+
+      double const * gray_rows[RELATIVE_PHASE_MAX_SPECIALIZED_STEPS];
+
+      // Fetch all tile rows and compute numerator and denominator in closed form.
+      for (int i = 0; i < num_images; ++i)
         {
-          lcm = mps_lcm(lcm, vec.at(i));
+          bool const fetched = FetchTileRowAsDouble_inline((*images)[i], y, x0, n, gray[i]);
+          assert(true == fetched);
+          gray_rows[i] = gray[i];
+          UpdateTileStatistics_inline(gray[i], i, tile_min, tile_max, tile_sum, n);
+        }
+      /* for */
+
+      kernel(gray_rows, acc_num, acc_den, n);
+    }
+  else
+    {
+      memset(acc_num, 0, sizeof(double) * n);
+      memset(acc_den, 0, sizeof(double) * n);
+
+      // Accumulate numerator and denominator.
+      for (int i = 0; i < num_images; ++i)
+        {
+          bool const fetched = FetchTileRowAsDouble_inline((*images)[i], y, x0, n, gray[0]);
+          assert(true == fetched);
+          AccumulateWeightedRow_inline(gray[0], weight_num[i], weight_den[i], acc_num, acc_den, n);
+          UpdateTileStatistics_inline(gray[0], i, tile_min, tile_max, tile_sum, n);
         }
       /* for */
     }
   /* if */
 
-  return lcm;
+  // Compute relative phase.
+  Atan2Array(acc_num, acc_den, dst, n, pi, atan2_method);
 }
-/* mps_lcm */
+/* RelativePhaseTileRow_inline */
 
 
 
-//! Return periods from fringe counts.
+//! Parallel body of the fused relative phase estimator.
 /*!
-  Function returns a vector of period (wavelengts) which corresponds to given fringe counts.
-
-  \param counts_in      Reference to a vector of fringe counts.
-  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automatically computed from fringe counts.
-  \param lambda_out     Address where the pointer to a vector of periods will be stored.
-  \param width_out      Address where used maximal width will be stored.
-  \return Function returns true if successfull, false otherwise.
+  Each invocation processes a band of rows. Every row is split into tiles of
+  RELATIVE_PHASE_TILE_WIDTH pixels; for each tile all images of the phase shift
+  group are read once and accumulated into numerator and denominator buffers
+  which stay in the L1 cache. Relative phase is computed as soon as the tile
+  accumulation is complete.
+
+  If a specialized N-step kernel is set then all N tile rows are fetched first
+  and the numerator and denominator are computed in closed form; otherwise
+  the generic weighted accumulation is used.
+
+  If the output has more than one channel then the relative phase is written
+  into the selected channel of the interleaved output. Output may be single
+  precision in which case the relative phase is converted when stored.
+
+  Dynamic range and texture are optionally computed from the same tile rows
+  so every image is read only once.
 */
-bool
-mps_periods_from_fringe_counts(
-                               std::vector<double> const & counts_in,
-                               double const width_in,
-                               std::vector<double> * * const lambda_out,
-                               double * const width_out
-                               )
+struct EstimateRelativePhaseTiledParallel_ : public cv::ParallelLoopBody
 {
-  assert( true == mps_all_whole_inline(counts_in) );
+  std::vector<cv::Mat *> const * images; //!< Single channel images of one phase shift group.
+  double const * weight_num; //!< Numerator weights.
+  double const * weight_den; //!< Denominator weights.
+  RelativePhaseNumDenKernel kernel; //!< Specialized N-step kernel or NULL for generic accumulation.
+  PhaseAtan2Method atan2_method; //!< Arctangent computation method.
+  cv::Mat * rel_phase; //!< Output relative phase (CV_64FC1 or interleaved CV_64FC(D) or CV_32FC(D)).
+  int channel; //!< Output channel.
+  TileStatisticsOutput const * stats; //!< Dynamic range and texture outputs; may be NULL.
+
+  //! Constructor.
+  EstimateRelativePhaseTiledParallel_(
+                                      std::vector<cv::Mat *> const * const images_in,
+                                      double const * const weight_num_in,
+                                      double const * const weight_den_in,
+                                      RelativePhaseNumDenKernel const kernel_in,
+                                      PhaseAtan2Method const atan2_method_in,
+                                      cv::Mat * const rel_phase_in,
+                                      int const channel_in,
+                                      TileStatisticsOutput const * const stats_in
+                                      )
+  {
+    this->images = images_in;
+    this->weight_num = weight_num_in;
+    this->weight_den = weight_den_in;
+    this->kernel = kernel_in;
+    this->atan2_method = atan2_method_in;
+    this->rel_phase = rel_phase_in;
+    this->channel = channel_in;
+    this->stats = stats_in;
+  }
 
-  // Set default width.
-  double width = width_in;
-  double const lcm_counts = mps_lcm(counts_in);
-  double const gcd_counts = mps_gcd(counts_in);
-  if ( 0 != _isnan(width_in) )
-    {
-      width = lcm_counts / gcd_counts;
-      assert( 0 == _isnan(width) );
-    }
-  /* if */
-  assert( (0 <= width) && (width <= lcm_counts) );
-
-  bool result = false; // Assume failure.
-
-  std::vector<double> * lambda = new std::vector<double>( counts_in.size() );
-  assert(NULL != lambda);
-  if (NULL != lambda)
-    {      
-      int const i_max = (int)( counts_in.size() );
-      if (1.0 < gcd_counts)
-        {
-          Debugfwprintf(stderr, gDbgFringeCountsAreNotWholeNumbers);
-          for (int i = 0; i < i_max; ++i) (*lambda)[i] = ( width * gcd_counts ) / counts_in[i];
-        }
-      else
-        {
-          assert(1.0 == gcd_counts);
-          for (int i = 0; i < i_max; ++i) (*lambda)[i] = width / counts_in[i];
-        }
-      /* if */
-      
-      double const gcd_lambda = mps_gcd(*lambda);
-      if (1.0 < gcd_lambda)
-        {
-          Debugfwprintf(stderr, gDbgPeriodsAreNotRelativelyPrime);
-          double const scl = 1.0 / gcd_lambda;
-          for (int i = 0; i < i_max; ++i) (*lambda)[i] = (*lambda)[i] * scl;
-        }
-      else
-        {
-          assert(1.0 == gcd_lambda);
-        }
-      /* if */
+  //! Processes a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    __declspec(align(16)) double gray[RELATIVE_PHASE_MAX_SPECIALIZED_STEPS][RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double acc_num[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double acc_den[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double phase[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double tile_min[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double tile_max[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double tile_sum[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double bgr[3 * RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double bgr_sum[3 * RELATIVE_PHASE_TILE_WIDTH];
+
+    int const cols = this->rel_phase->cols;
+    int const cn = this->rel_phase->channels();
+    int const c = this->channel;
+    bool const is_double = (CV_64F == this->rel_phase->depth());
+
+    bool const have_range = (NULL != this->stats) && (NULL != this->stats->dynamic_range);
+    bool const have_gray_texture = (NULL != this->stats) && (NULL != this->stats->texture) && (true == this->stats->texture_images.empty());
+    double * const ptr_min = (true == have_range)? tile_min : NULL;
+    double * const ptr_max = (true == have_range)? tile_max : NULL;
+    double * const ptr_sum = (true == have_gray_texture)? tile_sum : NULL;
+
+    for (int y = r.start; y < r.end; ++y)
+      {
+        BYTE * const row_data = (BYTE *)(this->rel_phase->data) + this->rel_phase->step[0] * y;
+        double * const row_rel_phase = (double *)( row_data );
+        float * const row_rel_phase_single = (float *)( row_data );
 
-      result = true;
-    }
-  /* if */
+        for (int x0 = 0; x0 < cols; x0 += RELATIVE_PHASE_TILE_WIDTH)
+          {
+            int const n = (RELATIVE_PHASE_TILE_WIDTH < cols - x0)? RELATIVE_PHASE_TILE_WIDTH : cols - x0;
 
-  SAFE_ASSIGN_PTR( lambda, lambda_out );
-  if (NULL != width_out) *width_out = width;
+            if ( (1 == cn) && (true == is_double) )
+              {
+                RelativePhaseTileRow_inline(
+                                            this->images, this->weight_num, this->weight_den, this->kernel, this->atan2_method,
+                                            y, x0, n,
+                                            gray, acc_num, acc_den,
+                                            row_rel_phase + x0,
+                                            ptr_min, ptr_max, ptr_sum
+                                            );
+              }
+            else
+              {
+                RelativePhaseTileRow_inline(
+                                            this->images, this->weight_num, this->weight_den, this->kernel, this->atan2_method,
+                                            y, x0, n,
+                                            gray, acc_num, acc_den,
+                                            phase,
+                                            ptr_min, ptr_max, ptr_sum
+                                            );
+
+                // Scatter the tile into the selected channel.
+                if (true == is_double)
+                  {
+                    double * const dst = row_rel_phase + cn * x0 + c;
+                    for (int x = 0; x < n; ++x) dst[cn * x] = phase[x];
+                  }
+                else
+                  {
+                    float * const dst = row_rel_phase_single + cn * x0 + c;
+                    for (int x = 0; x < n; ++x) dst[cn * x] = (float)( phase[x] );
+                  }
+                /* if */
+              }
+            /* if */
 
-  SAFE_DELETE( lambda );
+            if (NULL != this->stats)
+              {
+                StoreTileStatistics_inline(this->stats, y, x0, n, tile_min, tile_max, tile_sum, bgr, bgr_sum);
+              }
+            /* if */
+          }
+        /* for */
+      }
+    /* for */
+  }
 
-  return result;
-}
-/* mps_periods_from_fringe_counts */
+};
+/* EstimateRelativePhaseTiledParallel_ */
 
 
 
-//! Computes all valid period tuples.
+//! Fused relative phase, dynamic range, and texture estimation (double precision).
 /*!
-  Function returns all valid period tuples k for input periods lambda.
+  Function computes relative phase using the selected image span and stores it
+  into one channel of a preallocated output matrix. Dynamic range and texture
+  are computed in the same pass so every image of the span is read only once;
+  their outputs follow the conventions of UpdateDynamicRangeAndTexture function
+  and agree with it up to rounding of the texture sum. The output may be a single
+  channel matrix or an interleaved (pixel-major) matrix of type CV_64FC(D) which
+  holds D relative phases per pixel; this is the layout expected by mps_unwrap_phase.
+  Output of type CV_32FC(D) is also accepted in which case relative phases are
+  computed in double precision and rounded to single precision when stored.
+  The computation is the same as in EstimateRelativePhaseTiled function.
 
-  \param lambda_in      Pointer to wavelengths.
-  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
-  \param k_out          Address where pointer to cv::Mat which stores all period tuples will be placed. May be NULL.
-  \param width_out      Address where used maximal width will be stored.
-  \param w_min_out      Address where pointer to cv::Mat which stores starting boundaries of each segment will be placed. May be NULL.
-  \param w_max_out      Address where pointer to cv::Mat which stores ending boundaries of each segment will be placed. May be NULL.
+  Function assumes images are consecutively stored in AllImages starting
+  from index first and ending with index last (inclusive).
+
+  \param AllImages      Pointer to class containing all acquired images.
+  \param first  Index of the first image.
+  \param last   Index of the last image (inclusive).
+  \param specialized    Flag to indicate specialized N-step kernel should be used if one exists.
+  \param atan2_method   Arctangent computation method.
+  \param rel_phase      Pointer to output matrix of type CV_64FC(D) or CV_32FC(D) having the same size as input images.
+  \param channel        Output channel; must be between 0 and D-1.
+  \param dynamic_range_in_out   Address where a pointer to cv::Mat which holds dynamic range image is stored.
+  Image data must be of CV_32FC1 type. Pointer may be NULL in which case the image will be created. May be NULL.
+  \param texture_in_out Address where a pointer to cv::Mat which holds texture image is stored.
+  Image data must be of CV_32FC1 or CV_32FC3 type. Pointer may be NULL in which case the image will be created. May be NULL.
   \return Function returns true if successfull, false otherwise.
 */
 bool
-mps_get_period_tuples(
-                      std::vector<double> const & lambda_in,
-                      double const width_in,
-                      cv::Mat * * const k_out,
-                      double * const width_out,
-                      cv::Mat * * const w_min_out,
-                      cv::Mat * * const w_max_out
-                      )
+EstimateRelativePhaseDynamicRangeAndTextureTiled(
+                                                 ImageSet * const AllImages,
+                                                 int const first,
+                                                 int const last,
+                                                 bool const specialized,
+                                                 PhaseAtan2Method const atan2_method,
+                                                 cv::Mat * const rel_phase,
+                                                 int const channel,
+                                                 cv::Mat * * const dynamic_range_in_out,
+                                                 cv::Mat * * const texture_in_out
+                                                 )
 {
-  // Set default width.
-  double width = width_in;
-  if ( 0 != _isnan(width_in) )
-    {
-      double const lcm = mps_lcm(lambda_in);
-      double const gcd = mps_gcd(lambda_in);
-      width = lcm / gcd;
-      assert( 0 == _isnan(width) );
-    }
-  /* if */
+  bool result = false;
+  std::vector<cv::Mat *> images; // Image headers.
+  TileStatisticsOutput stats; // Dynamic range and texture outputs.
 
-  if ( 0 != _isnan(width) ) return false;
+  double * weight_num = NULL;
+  double * weight_den = NULL;
 
-  bool result = true; // Assume success.
+  bool const inputs_valid = ValidateInputs_inline(AllImages, first, last);
+  if (false == inputs_valid) return result;
 
-  // Allocate storage on stack.
-  int const i_max = (int)( lambda_in.size() );
+  int const num_images = last - first + 1;
+  assert(0 < num_images);
 
-  int j = 1;
-  int const j_step = 100;
+  int const cols = AllImages->width;
+  int const rows = AllImages->height;
 
-  std::vector<double> next_boundary(lambda_in);
-  std::vector<int> inc(lambda_in.size(), 0);
+  assert( (NULL != rel_phase) && (NULL != rel_phase->data) );
+  if ( (NULL == rel_phase) || (NULL == rel_phase->data) ) return result;
 
-  // Find first minimal boundary.
-  double x = *std::min_element(next_boundary.begin(), next_boundary.end());
-  for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+  assert( ((CV_64F == rel_phase->depth()) || (CV_32F == rel_phase->depth())) && (cols == rel_phase->cols) && (rows == rel_phase->rows) );
+  if ( ((CV_64F != rel_phase->depth()) && (CV_32F != rel_phase->depth())) || (cols != rel_phase->cols) || (rows != rel_phase->rows) ) return result;
 
-  // Allocate storage on heap.
-  cv::Mat * k = new cv::Mat(j_step, i_max, CV_32SC1, cv::Scalar(0));
-  assert( (NULL != k) && (NULL != k->data) );
+  assert( (0 <= channel) && (channel < rel_phase->channels()) );
+  if ( (0 > channel) || (channel >= rel_phase->channels()) ) return result;
 
-  // Storage for borders will be allocated later.
-  cv::Mat * w_min = NULL;
-  cv::Mat * w_max = NULL;
+  // Compute weight factors for numerator and denominator.
+  weight_num = new double[num_images];
+  weight_den = new double[num_images];
+  assert(NULL != weight_num);
+  assert(NULL != weight_den);
 
-  // Bail-out if allocation failed.
-  if ( (NULL == k) || (NULL == k->data) )
+  if ( (NULL == weight_num) || (NULL == weight_den) ) goto EstimateRelativePhaseDynamicRangeAndTextureTiled_EXIT;
+
+  double const pi = 3.141592653589793238462643383279502884197169399375;
+  double const k = 2.0 * pi / (double)( num_images );
+
+  for (int i = 0; i < num_images; ++i)
     {
-      result = false;
-      goto mps_get_period_tuples_EXIT;
+      double const phi = k * (double)(i);
+      weight_num[i] = cos( phi );
+      weight_den[i] = -sin( phi );
     }
-  /* if */
+  /* for */
 
-  // Create valid tuples.
-  while ( (x < width) &&
-          (0 < *std::max_element(inc.begin(), inc.end()))
-          )
+  // Fetch image headers; most pixel formats are shallow copies.
+  images.reserve(num_images);
+  for (int i = first; i <= last; ++i)
     {
-      // Get next boundary.
-      for (int i = 0; i < i_max; ++i)
-        {
-          if (0 < inc[i]) next_boundary[i] += lambda_in[i];
-        }
-      /* for */
-
-      // Increase storage if necessary.
-      if (j >= k->rows) k->resize(k->rows + j_step, cv::Scalar(0));
-
-      // Set next period-order tuple.
-      int const j_prev = j - 1;
-      for (int i = 0; i < i_max; ++i)
-        {
-          k->at<int>(j, i) = k->at<int>(j_prev, i) + inc[i];
-        }
-      /* for */
-      j = j + 1;
+      cv::Mat * img1C = AllImages->GetImage1C(i);
+      assert(NULL != img1C);
+      if (NULL == img1C) goto EstimateRelativePhaseDynamicRangeAndTextureTiled_EXIT;
 
-      // Find next minimal boundary.
-      x = *std::min_element(next_boundary.begin(), next_boundary.end());
-      for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
-    }
-  /* while */
+      images.push_back(img1C);
 
-  // Efficiently create new cv::Mat header for the output buffer.
-  int const N = j;
-  if (N != k->rows)
-    {
-      cv::Range r[2] = {cv::Range(0, N), cv::Range::all()};
+      int const depth = img1C->depth();
+      bool const supported = (CV_8U == depth) || (CV_8S == depth) || (CV_16U == depth) || (CV_16S == depth) ||
+        (CV_32S == depth) || (CV_32F == depth) || (CV_64F == depth);
+      assert(true == supported);
+      if (false == supported) goto EstimateRelativePhaseDynamicRangeAndTextureTiled_EXIT;
 
-      cv::Mat * k_tmp = new cv::Mat(*k, r);
-      assert(NULL != k_tmp);
-      if (NULL != k_tmp)
-        {
-          SAFE_DELETE( k );
-          k = k_tmp;
-          k_tmp = NULL;
-        }
-      /* if */
+      assert( (1 == img1C->channels()) && (cols <= img1C->cols) && (rows <= img1C->rows) );
+      if ( (1 != img1C->channels()) || (cols > img1C->cols) || (rows > img1C->rows) ) goto EstimateRelativePhaseDynamicRangeAndTextureTiled_EXIT;
     }
-  /* if */
-
-  // Compute interval boundaries if requested.
-  if ( (NULL != w_min_out) || (NULL != w_max_out) )
-    {
-      w_min = new cv::Mat(N, 1, CV_64FC1, 0.0);
-      assert( (NULL != w_min) && (NULL != w_min->data) );
+  /* for */
 
-      w_max = new cv::Mat(N, 1, CV_64FC1, 0.0);
-      assert( (NULL != w_max) && (NULL != w_max->data) );
+  // Prepare dynamic range and texture outputs.
+  {
+    bool const prepared = PrepareTileStatistics_inline(AllImages, first, last, dynamic_range_in_out, texture_in_out, &stats);
+    assert(true == prepared);
+    if (false == prepared) goto EstimateRelativePhaseDynamicRangeAndTextureTiled_EXIT;
+  }
 
-      if ( (NULL == w_min) || (NULL == w_min->data) ||
-           (NULL == w_max) || (NULL == w_max->data)
-           )
-        {
-          result = false;
-          goto mps_get_period_tuples_EXIT;
-        }
-      /* if */
+  // Process bands of rows in parallel.
+  {
+    bool const have_stats = (NULL != stats.dynamic_range) || (NULL != stats.texture);
+    RelativePhaseNumDenKernel const kernel = (true == specialized)? GetRelativePhaseNumDenKernel_inline(num_images) : NULL;
+    EstimateRelativePhaseTiledParallel_ body(
+                                             &images, weight_num, weight_den, kernel, atan2_method, rel_phase, channel,
+                                             (true == have_stats)? &stats : NULL
+                                             );
+    cv::parallel_for_( cv::Range(0, rows), body, (double)(rows) / (double)(RELATIVE_PHASE_BAND_HEIGHT) );
+  }
 
-      // Compute interval boundaries.
-      double stop_max = -std::numeric_limits<double>::infinity();
-      for (int j = 0; j < N; ++j)
-        {
-          stop_max = -std::numeric_limits<double>::infinity();
-          for (int i = 0; i < i_max; ++i)
-            {
-              double const stop = (double)( k->at<int>(j, i) ) * lambda_in[i];
-              if (stop > stop_max) stop_max = stop;
-            }
-          /* for */
+  result = true;
 
-          w_min->at<double>(j, 0) = stop_max;
-          if (0 < j) w_max->at<double>(j - 1, 0) = stop_max;
-        }
-      /* for */
-      if (0 < N) w_max->at<double>(N - 1, 0) = width;
-    }
-  /* if */
 
+ EstimateRelativePhaseDynamicRangeAndTextureTiled_EXIT:
 
-  SAFE_ASSIGN_PTR( k, k_out );
-  if (NULL != width_out) *width_out = width;
-  SAFE_ASSIGN_PTR( w_min, w_min_out );
-  SAFE_ASSIGN_PTR( w_max, w_max_out );
+  FinishTileStatistics_inline(&stats, result, dynamic_range_in_out, texture_in_out);
 
- mps_get_period_tuples_EXIT:
+  for (size_t i = 0; i < images.size(); ++i) SAFE_DELETE( images[i] );
+  images.clear();
 
-  SAFE_DELETE( k );
-  SAFE_DELETE( w_min );
-  SAFE_DELETE( w_max );
+  SAFE_DELETE_ARRAY( weight_num );
+  SAFE_DELETE_ARRAY( weight_den );
 
   return result;
 }
-/* mps_get_period_tuples */
+/* EstimateRelativePhaseDynamicRangeAndTextureTiled */
 
 
 
-//! Return line equations for chosen set of wavelengths.
+//! Fused relative phase estimation into interleaved output (double precision).
 /*!
-  Function computes line equations for a chosen set of wavelengths.
-  Line equations are defined by line direction vector V and particular points X0 on each line.
-  Line direction V is stored as row vector.
-  Particular points X0 are stored as one point per row.
+  Function computes relative phase using the selected image span and stores it
+  into one channel of a preallocated output matrix. See
+  EstimateRelativePhaseDynamicRangeAndTextureTiled for details.
 
-  \param lambda_in      Pointer to wavelengths.
-  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
-  \param V_out          Address where pointer to cv::Mat which stores line direction vector will be placed. May be NULL.
-  \param X0_out         Address where pointer to cv::Mat which stores line points will be placed. May be NULL.
-  \param k_out          Address where pointer to cv::Mat which stores all period tuples will be placed. May be NULL.
-  \param width_out      Address where used maximal width will be stored.
-  \param w_min          Address where pointer to cv::Mat which stores starting boundaries of each segment will be placed. May be NULL.
-  \param w_max          Address where pointer to cv::Mat which stores ending boundaries of each segment will be placed. May be NULL.
+  \param AllImages      Pointer to class containing all acquired images.
+  \param first  Index of the first image.
+  \param last   Index of the last image (inclusive).
+  \param specialized    Flag to indicate specialized N-step kernel should be used if one exists.
+  \param atan2_method   Arctangent computation method.
+  \param rel_phase      Pointer to output matrix of type CV_64FC(D) or CV_32FC(D) having the same size as input images.
+  \param channel        Output channel; must be between 0 and D-1.
   \return Function returns true if successfull, false otherwise.
 */
 bool
-mps_get_lines(
-              std::vector<double> const & lambda_in,
-              double const width_in,
-              cv::Mat * * const V_out,
-              cv::Mat * * const X0_out,
-              cv::Mat * * const k_out,
-              double * const width_out,
-              cv::Mat * * const w_min,
-              cv::Mat * * const w_max
-              )
+EstimateRelativePhaseTiledInterleaved(
+                                      ImageSet * const AllImages,
+                                      int const first,
+                                      int const last,
+                                      bool const specialized,
+                                      PhaseAtan2Method const atan2_method,
+                                      cv::Mat * const rel_phase,
+                                      int const channel
+                                      )
 {
-  double width = width_in;
+  return EstimateRelativePhaseDynamicRangeAndTextureTiled(AllImages, first, last, specialized, atan2_method, rel_phase, channel, NULL, NULL);
+}
+/* EstimateRelativePhaseTiledInterleaved */
 
-  cv::Mat * V = NULL;
-  cv::Mat * X0 = NULL;
-  cv::Mat * k = NULL;
 
-  // Get period tuples.
-  bool result = mps_get_period_tuples(lambda_in, width_in, &k, &width, w_min, w_max);
-  assert( (NULL != k) && (NULL != k->data) && (true == result) );
 
-  // Return immediately if unsuccessfull.
-  if ( (NULL == k) || (NULL == k->data) || (false == result) )
+//! Fused relative phase estimation (double precision).
+/*!
+  Function computes relative phase using the selected image span.
+  The result is identical to the result of EstimateRelativePhase function;
+  however, instead of making one pass over the whole frame for each image
+  the function reads all images of the phase shift group tile-by-tile in a single pass.
+  Numerator and denominator accumulators are kept in small per-thread buffers
+  and bands of rows are processed in parallel.
+
+  For 3, 4, 6, and 8 step phase shifting specialized closed-form kernels
+  may be used instead of the generic weighted accumulation; results
+  of specialized kernels differ from generic results only due to rounding.
+
+  Function assumes images are consecutively stored in AllImages starting
+  from index first and ending with index last (inclusive).
+
+  \param AllImages      Pointer to class containing all acquired images.
+  \param first  Index of the first image.
+  \param last   Index of the last image (inclusive).
+  \param specialized    Flag to indicate specialized N-step kernel should be used if one exists.
+  \param atan2_method   Arctangent computation method.
+  \return Function returns a pointer to valid cv::Mat or NULL if unsuccessfull.
+*/
+cv::Mat *
+EstimateRelativePhaseTiled(
+                           ImageSet * const AllImages,
+                           int const first,
+                           int const last,
+                           bool const specialized,
+                           PhaseAtan2Method const atan2_method
+                           )
+{
+  cv::Mat * rel_phase = NULL; // Relative phase.
+
+  bool const inputs_valid = ValidateInputs_inline(AllImages, first, last);
+  if (false == inputs_valid) return rel_phase;
+
+  rel_phase = new cv::Mat(AllImages->height, AllImages->width, CV_64FC1);
+  assert( (NULL != rel_phase) && (NULL != rel_phase->data) );
+  if ( (NULL == rel_phase) || (NULL == rel_phase->data) )
     {
-      result = false;
-      goto mps_get_lines_EXIT;
+      SAFE_DELETE( rel_phase );
+      return rel_phase;
     }
   /* if */
 
-  // Fetch period-tuple sizes.
-  int const N = k->rows;
-  int const M = k->cols;
-  assert( M == (int)( lambda_in.size() ) );
+  bool const estimate = EstimateRelativePhaseTiledInterleaved(AllImages, first, last, specialized, atan2_method, rel_phase, 0);
+  if (false == estimate) SAFE_DELETE( rel_phase );
+
+  return rel_phase;
+}
+/* EstimateRelativePhaseTiled */
+
+
+
+//! Benchmarks relative phase estimation kernels.
+/*!
+  Function measures the execution time of generic and of specialized
+  relative phase estimation for 3, 4, 6, and 8 step phase shifting and
+  of specialized estimation which uses the fast arctangent.
+  Speedups are printed together with the largest phase differences
+  with respect to the generic result. First N images of the image set
+  are used as the input for the N-step estimation; their content is
+  irrelevant for timing.
+
+  Before timing, the fast arctangent is validated against the C runtime
+  atan2 and the measured error bound is printed.
+
+  \param AllImages      Pointer to class containing all acquired images.
+  \param repeats        Number of repetitions for each kernel.
+  \return Function returns true if successfull.
+*/
+bool
+BenchmarkRelativePhaseEstimation(
+                                 ImageSet * const AllImages,
+                                 int const repeats
+                                 )
+{
+  assert(NULL != AllImages);
+  if (NULL == AllImages) return false;
+
+  assert(0 < repeats);
+  if (0 >= repeats) return false;
 
+  LARGE_INTEGER frequency;
+  BOOL const qpf = QueryPerformanceFrequency( &frequency );
+  assert(TRUE == qpf);
+  if ( (TRUE != qpf) || (0 >= frequency.QuadPart) ) return false;
+
+  double const ms_per_tick = 1000.0 / (double)( frequency.QuadPart );
   double const pi = 3.141592653589793238462643383279502884197169399375;
-  double const tau = 2.0 * pi;
 
-  // Allocate storage on heap.
-  V = new cv::Mat(1, M, CV_64FC1);
-  assert( (NULL != V) && (NULL != V->data) );
+  bool result = true;
 
-  X0 = new cv::Mat(N, M, CV_64FC1);
-  assert( (NULL != X0) && (NULL != X0->data) );
+  // Validate fast arctangent.
+  {
+    int const num_angles = 1000003;
+    double max_error = 0.0;
+    bool const valid = ValidateFastAtan2(num_angles, &max_error);
+    wprintf(gMsgBenchmarkFastAtan2Error, max_error, FAST_ATAN2_ERROR_BOUND, (true == valid)? L"PASSED" : L"FAILED");
+    if (false == valid) result = false;
+  }
 
-  if ( (NULL == V) || (NULL == V->data) ||
-       (NULL == X0) || (NULL == X0->data)
-       )
-    {
-      result = false;
-      goto mps_get_lines_EXIT;
-    }
-  /* if */
+  int const steps[] = {3, 4, 6, 8};
+  int const num_steps = sizeof(steps) / sizeof(steps[0]);
 
-  // Compute points on lines.
-  for (int j = 0; j < N; ++j)
+  // Tested variants are generic, specialized, and specialized with fast arctangent.
+  int const num_variants = 3;
+  bool const variant_specialized[num_variants] = {false, true, true};
+  PhaseAtan2Method const variant_atan2[num_variants] = {PHASE_ATAN2_LIBM, PHASE_ATAN2_LIBM, PHASE_ATAN2_FAST};
+
+  for (int j = 0; j < num_steps; ++j)
     {
-      int const * const srcrow = (int *)( (BYTE *)(k->data) + k->step[0] * j );
-      double * const dstrow = (double *)( (BYTE *)(X0->data) + X0->step[0] * j );
-      for (int i = 0; i < M; ++i)
+      int const N = steps[j];
+      if (AllImages->num_images < N)
         {
-          dstrow[i] = -tau * srcrow[i];
+          wprintf(gMsgBenchmarkRelativePhaseEstimationSkipped, N);
+          continue;
+        }
+      /* if */
+
+      double duration[num_variants] = {0.0, 0.0, 0.0};
+      double max_difference[num_variants] = {0.0, 0.0, 0.0};
+      cv::Mat * rel_phase[num_variants] = {NULL, NULL, NULL};
+
+      for (int k = 0; k < num_variants; ++k)
+        {
+          for (int r = 0; r < repeats; ++r)
+            {
+              LARGE_INTEGER start, stop;
+              QueryPerformanceCounter( &start );
+              cv::Mat * const phase = EstimateRelativePhaseTiled(AllImages, 0, N - 1, variant_specialized[k], variant_atan2[k]);
+              QueryPerformanceCounter( &stop );
+
+              assert(NULL != phase);
+              if (NULL == phase) result = false;
+
+              duration[k] += (double)(stop.QuadPart - start.QuadPart) * ms_per_tick;
+
+              SAFE_DELETE( rel_phase[k] );
+              rel_phase[k] = phase;
+            }
+          /* for */
+
+          duration[k] /= (double)( repeats );
         }
       /* for */
-    }
-  /* for */
 
-  // Compute line direction vector.
-  {
-    double * const dstrow = (double *)( (BYTE *)(V->data) );
-    for (int i = 0; i < M; ++i)
-      {
-        dstrow[i] = tau / lambda_in[i];
-      }
-    /* for */
-  }
+      // Compare results to the generic result; phase difference is wrapped to [0, pi].
+      for (int k = 1; k < num_variants; ++k)
+        {
+          if ( (NULL == rel_phase[0]) || (NULL == rel_phase[k]) ) continue;
 
+          for (int y = 0; y < rel_phase[0]->rows; ++y)
+            {
+              double const * const row_generic = (double *)( (BYTE *)(rel_phase[0]->data) + rel_phase[0]->step[0] * y );
+              double const * const row_variant = (double *)( (BYTE *)(rel_phase[k]->data) + rel_phase[k]->step[0] * y );
 
-  SAFE_ASSIGN_PTR( V, V_out );
-  SAFE_ASSIGN_PTR( X0, X0_out );
-  SAFE_ASSIGN_PTR( k, k_out );
+              for (int x = 0; x < rel_phase[0]->cols; ++x)
+                {
+                  double difference = fabs(row_generic[x] - row_variant[x]);
+                  if (pi < difference) difference = 2.0 * pi - difference;
+                  if (max_difference[k] < difference) max_difference[k] = difference;
+                }
+              /* for */
+            }
+          /* for */
+        }
+      /* for */
 
- mps_get_lines_EXIT:
+      double const speedup_specialized = (0.0 < duration[1])? duration[0] / duration[1] : 0.0;
+      double const speedup_fast = (0.0 < duration[2])? duration[0] / duration[2] : 0.0;
+      wprintf(gMsgBenchmarkRelativePhaseEstimation, N, duration[0], duration[1], speedup_specialized, max_difference[1]);
+      wprintf(gMsgBenchmarkRelativePhaseEstimationFastAtan2, N, duration[2], speedup_fast, max_difference[2]);
 
-  SAFE_DELETE( V );
-  SAFE_DELETE( X0 );
-  SAFE_DELETE( k );
+      for (int k = 0; k < num_variants; ++k) SAFE_DELETE( rel_phase[k] );
+    }
+  /* for */
 
   return result;
 }
-/* mps_get_lines */
+/* BenchmarkRelativePhaseEstimation */
 
 
 
-//! Return wrapped tupples.
+/****** GRAY CODE DECODING ******/
+
+
+//! Computes Gray code weights (double precision).
 /*!
-  Function computes all wrapped period tuples.
+  Function computes weights required to decode Gray code into projector column or row index.
 
-  \param lambda_in      Pointer to wavelengths.
-  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
-  \param k_out          Address where pointer to cv::Mat which stores all wrapped period tuples will be placed. May be NULL.
-  \param width_out      Address where used maximal width will be stored.
-  \param idx_out        Address where pointer to cv::Mat which stores indices into list of all unwrapped period tuples.
-  \return Function returns true if successfull, false otherwise.
+  \param N      Number of bits reserved for the Gray code.
+  \return Function returns a pointer to an array of doubles that has 2^N elements or NULL if unsuccessfull.
 */
-bool
-mps_get_wrapped_tuples(
-                       std::vector<double> const & lambda_in,
-                       double const width_in,
-                       cv::Mat * * const k_out,
-                       double * const width_out,
-                       cv::Mat * * const idx_out
-                       )
+double *
+CreateGrayCodeWeights(
+                      int const N
+                      )
 {
-  // Set default width.
-  double width = width_in;
-  if ( 0 != _isnan(width_in) )
-    {
-      double const lcm = mps_lcm(lambda_in);
-      double const gcd = mps_gcd(lambda_in);
-      width = lcm / gcd;
-      assert( 0 == _isnan(width) );
-    }
-  /* if */
+  assert(0 < N);
+  if (0 >= N) return NULL;
 
-  bool result = true; // Assume success.
+  /* Pre-allocate storage. */
+  int * const idx = (int *)malloc( sizeof(int) * N );
+  assert(NULL != idx);
 
-  // Allocate storage on stack.
-  int const i_max = (int)( lambda_in.size() );
+  int const total = 1 << N;
 
-  int j = 0;
-  int j_tmp = 0;
-  int const j_step = 100;
+  int * const code = (int *)malloc( sizeof(int) * total );
+  assert(NULL != code);
 
-  // Allocate storage on heap.
-  cv::Mat * k = new cv::Mat(j_step, i_max, CV_32SC1, cv::Scalar(0));
-  assert( (NULL != k) && (NULL != k->data) );
+  double * const weight = (double *)malloc( sizeof(double) * total );
+  assert(NULL != weight);
 
-  cv::Mat * k_tmp = new cv::Mat(j_step, i_max, CV_32SC1, cv::Scalar(0));
-  assert( (NULL != k_tmp) && (NULL != k_tmp->data) );
+  if ( (NULL == idx) || (NULL == code) || (NULL == weight) )
+    {
+      if (NULL != idx) free(idx);
+      if (NULL != code) free(code);
+      if (NULL != weight) free(weight);
+      return NULL;
+    }
+  /* if */
 
-  cv::Mat * idx = new cv::Mat(j_step, 1, CV_32SC1, cv::Scalar(0));
-  assert( (NULL != idx) && (NULL != idx->data) );
+  /* Compute code. */
+  for (int i = 0; i < N; ++i) idx[i] = 1 << i;
 
-  if ( (NULL == k) || (NULL == k->data) ||
-       (NULL == k_tmp) || (NULL == k_tmp->data) ||
-       (NULL == idx) || (NULL == idx->data)
-       )
+  code[0] = 0;
+  for (int i = 0; i < N; ++i)
     {
-      result = false;
-      goto mps_get_wrapped_tuples_EXIT;
+      for (int j = idx[i]; j < 2 * idx[i]; ++j)
+        {
+          assert( (0 <= j) && (j < total) );
+          int const k = j - 2 * (j - idx[i] + 1) + 1;
+          assert( (0 <= k) && (k < total) );
+          code[j] = code[k] + idx[i];
+        }
+      /* for */
     }
-  /* if */
+  /* for */
 
-  // Generate first wrapped tuple. The first wrapped tuple covers all
-  // corners of a hyper-cube except ones whose all coordinates are 0 or 2*pi.
-  {
-    assert(i_max < 32);
-    int b = 1;
-    double const b_max_dbl = ldexp(1.0, i_max) - 1.0;
-    assert( b_max_dbl < INT_MAX );
-    int const b_max = (int)( b_max_dbl );
-    while (b < b_max)
-      {
-        // Increase storage if necessary.
-        if (j >= k->rows) k->resize(k->rows + j_step, cv::Scalar(0));
-        if (j >= idx->rows) idx->resize(idx->rows +j_step, cv::Scalar(0));
+  double const total_inv = 1.0 / (double)(total);
+  for (int i = 0; i < total; ++i)
+    {
+      int const j = code[i];
+      assert( (0 <= j) && (j < total) );
+      weight[j] = double(i) * total_inv;
+    }
+  /* for */
 
-        // Copy starting tupple and starting index.
-        for (int i = 0; i < i_max; ++i)
-          {
-            k->at<int>(j, i) = k_tmp->at<int>(1, i);
-          }
-        /* for */
-        idx->at<int>(j, 0) = 0;
+  /* Deallocate temporary storage. */
+  free(idx);
+  free(code);
 
-        // Adjust tupple to obtain wrapped tuple.
-        for (int i = 0; i < i_max; ++i)
-          {
-            int const bitmask = (1 << i);
-            if ( 0 != (b & bitmask) )
-              {
-                k->at<int>(j, i) = k->at<int>(j, i) - 1;
-              }
-            /* if */
-          }
-        /* for */
+  return weight;
+}
+/* CreateGrayCodeWeights */
+
+
+
+//! Deletes Gray code weights (double precision).
+/*!
+  Function deletes Gray code weights.
+
+  \param weight Pointer to Gray code weights.
+*/
+void
+DeleteGrayCodeWeights(
+                      double * const weight
+                      )
+{
+  if (NULL != weight) free( weight );
+}
+/* DeleteGrayCodeWeights */
+
+
+
+//! Decodes Gray code (double precision).
+/*!
+  Decodes Gray code and returns normalized projector coordinate.
+  Function assumes images are consecutively stored in AllImages starting
+  from index first and ending with index last (inclusive).
+
+  \param AllImages      Pointer to class containing all acquired images.
+  \param threshold      Pointer to threshold image. Must be of CV_64FC1 type.
+  \param first  Index of the first Gray code image.
+  \param last   Index of the last Gray code image.
+  \return Function returns a pointer to valid cv::Mat or NULL if unsuccesffull.
+*/
+cv::Mat *
+DecodeGrayCode(
+               ImageSet * const AllImages,
+               cv::Mat * threshold,
+               int const first,
+               int const last
+               )
+{
+  cv::Mat * code = NULL; // Decoded Gray code.
+
+  bool const inputs_valid = ValidateInputs_inline(AllImages, first, last);
+  if (false == inputs_valid) return code;
+
+  assert(NULL != threshold);
+  if (NULL == threshold) return code;
+
+  int const num_images = last - first + 1;
+  assert(0 < num_images);
+
+  // Fetch input image size.
+  int const cols = AllImages->width;
+  int const rows = AllImages->height;
+
+  // Check size and type of the threshold image.
+  assert( cols <= threshold->cols );
+  assert( rows <= threshold->rows );
+  if ( (cols > threshold->cols) || (rows > threshold->rows) ) return code;
+
+  assert( (CV_MAT_DEPTH(threshold->type()) == CV_64F) && (CV_MAT_CN(threshold->type()) == 1) );
+  if ( (CV_MAT_DEPTH(threshold->type()) != CV_64F) || (CV_MAT_CN(threshold->type()) != 1) ) return code;
+
+  // Allocate data storage for temporray buffers and end result.
+  code = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
+  assert(NULL != code);
+
+  cv::Mat * tmp_buffer = new cv::Mat(rows, cols, CV_64FC1, 0.0f);
+  assert(NULL != tmp_buffer);
+
+  double * const weight = CreateGrayCodeWeights(num_images);
+  assert(NULL != weight);
+
+  int const total = 1 << num_images;
+
+  if ( (NULL == code) || (NULL == tmp_buffer) || (NULL == weight) ) goto DecodeGrayCode_EXIT;
+
+  // Decode Gray code.
+  for (int i = first; i <= last; ++i)
+    {
+      cv::Mat * img1C = AllImages->GetImage1C(i);
+      assert(NULL != img1C);
+      if (NULL == img1C) goto DecodeGrayCode_EXIT;
+
+      // Re-use preallocated storage.
+      img1C->convertTo(*tmp_buffer, CV_64FC1);
+
+      for (int y = 0; y < rows; ++y)
+        {
+          // Get row addresses.
+          double const * const row_threshold = (double *)( (BYTE *)(threshold->data) + threshold->step[0] * y );
+          double const * const row_gray = (double *)( (BYTE *)(tmp_buffer->data) + tmp_buffer->step[0] * y );
+          double       * const row_code = (double *)( (BYTE *)(code->data) + code->step[0] * y );
+
+          // Unrolled for loop with step 4.
+          int x = 0;
+          int const max_x = cols - 3;
+          for (; x < max_x; x += 4)
+            {
+              row_code[x    ] *= 2.0;
+              row_code[x + 1] *= 2.0;
+              row_code[x + 2] *= 2.0;
+              row_code[x + 3] *= 2.0;
+
+              if (row_gray[x    ] > row_threshold[x    ]) row_code[x    ] += 1.0;
+              if (row_gray[x + 1] > row_threshold[x + 1]) row_code[x + 1] += 1.0;
+              if (row_gray[x + 2] > row_threshold[x + 2]) row_code[x + 2] += 1.0;
+              if (row_gray[x + 3] > row_threshold[x + 3]) row_code[x + 3] += 1.0;
+            }
+          /* for */
+
+          // Complete to end.
+          for (; x < cols; ++x)
+            {
+              row_code[x] *= 2.0;
+              if (row_gray[x] > row_threshold[x]) row_code[x] += 1.0;
+            }
+          /* for */
+        }
+      /* for */
+
+      SAFE_DELETE(img1C);
+    }
+  /* for */
+
+  // Normalize code.
+  for (int y = 0; y < rows; ++y)
+    {
+      // Get row addresses.
+      double * const row_code = (double *)( (BYTE *)(code->data) + code->step[0] * y );
+
+      for (int x = 0; x < cols; ++x)
+        {
+          assert( (0 <= row_code[x]) && (row_code[x] < total) );
+          row_code[x] = weight[ (int)(row_code[x]) ];
+        }
+      /* for */
+    }
+  /* for */
+
+ DecodeGrayCode_EXIT:
+
+  SAFE_DELETE(tmp_buffer);
+  DeleteGrayCodeWeights(weight);
+
+  return code;
+}
+/* DecodeGrayCode */
+
+
+
+//! Largest number of Gray code bits supported by the tiled decoder.
+#define GRAY_CODE_MAX_BITS 16
+
+//! Tile width (in pixels) of the tiled Gray code decoder.
+#define GRAY_CODE_TILE_WIDTH 256
+
+//! Band height (in rows) of one parallel work unit of the tiled Gray code decoder.
+#define GRAY_CODE_BAND_HEIGHT 16
+
+
+
+//! Converts Gray code to binary.
+/*!
+  Converts reflected binary Gray code to binary number using prefix XOR.
+  Number of shifts is fixed at compile time by the number of bits.
+
+  \param g      Gray code word.
+  \return Returns binary number.
+*/
+template <int BITS>
+inline
+unsigned int
+GrayToBinary_inline(
+                    unsigned int const g
+                    )
+{
+  unsigned int b = g;
+  for (int s = 1; s < BITS; s <<= 1) b ^= b >> s;
+  return b;
+}
+/* GrayToBinary_inline */
+
+
+
+//! Converts packed Gray code words to normalized projector coordinate.
+/*!
+  Converts n packed Gray code words to normalized projector coordinates.
+  Normalization weight 2^-BITS is a compile-time constant so the result is
+  identical to the result of Gray code weights from CreateGrayCodeWeights.
+
+  \param code   Pointer to packed Gray code words; first image is the most significant bit.
+  \param dst    Pointer to output array.
+  \param n      Number of elements.
+*/
+template <int BITS>
+inline
+void
+GrayCodeWordsToCoordinate_inline(
+                                 unsigned int const * const code,
+                                 double * const dst,
+                                 int const n
+                                 )
+{
+  static_assert( (0 < BITS) && (BITS <= GRAY_CODE_MAX_BITS), "Unsupported number of Gray code bits." );
+  double const weight = 1.0 / (double)(1 << BITS);
+
+  // Unrolled for loop with step 4.
+  int x = 0;
+  int const max_x = n - 3;
+  for (; x < max_x; x += 4)
+    {
+      dst[x    ] = weight * (double)( GrayToBinary_inline<BITS>(code[x    ]) );
+      dst[x + 1] = weight * (double)( GrayToBinary_inline<BITS>(code[x + 1]) );
+      dst[x + 2] = weight * (double)( GrayToBinary_inline<BITS>(code[x + 2]) );
+      dst[x + 3] = weight * (double)( GrayToBinary_inline<BITS>(code[x + 3]) );
+    }
+  /* for */
+
+  // Complete to end.
+  for (; x < n; ++x) dst[x] = weight * (double)( GrayToBinary_inline<BITS>(code[x]) );
+}
+/* GrayCodeWordsToCoordinate_inline */
+
+
+
+//! Function pointer to Gray code word converter.
+typedef void (*GrayCodeWordsToCoordinateKernel)(unsigned int const * const, double * const, int const);
+
+//! Dispatch table of Gray code word converters indexed by the number of bits.
+static GrayCodeWordsToCoordinateKernel const gGrayCodeWordsToCoordinateKernels[GRAY_CODE_MAX_BITS + 1] =
+  {
+    NULL,
+    &GrayCodeWordsToCoordinate_inline<1>,
+    &GrayCodeWordsToCoordinate_inline<2>,
+    &GrayCodeWordsToCoordinate_inline<3>,
+    &GrayCodeWordsToCoordinate_inline<4>,
+    &GrayCodeWordsToCoordinate_inline<5>,
+    &GrayCodeWordsToCoordinate_inline<6>,
+    &GrayCodeWordsToCoordinate_inline<7>,
+    &GrayCodeWordsToCoordinate_inline<8>,
+    &GrayCodeWordsToCoordinate_inline<9>,
+    &GrayCodeWordsToCoordinate_inline<10>,
+    &GrayCodeWordsToCoordinate_inline<11>,
+    &GrayCodeWordsToCoordinate_inline<12>,
+    &GrayCodeWordsToCoordinate_inline<13>,
+    &GrayCodeWordsToCoordinate_inline<14>,
+    &GrayCodeWordsToCoordinate_inline<15>,
+    &GrayCodeWordsToCoordinate_inline<16>
+  };
+
+
+
+//! Computes tile row of the black/white threshold.
+/*!
+  Computes threshold as the mean of black and white images using SSE2.
+  All buffers must be 16 byte aligned.
+
+  \param black  Pointer to black image values.
+  \param white  Pointer to white image values.
+  \param threshold      Pointer to threshold output.
+  \param n      Number of elements.
+*/
+inline
+void
+ThresholdRow_inline(
+                    double const * const black,
+                    double const * const white,
+                    double * const threshold,
+                    int const n
+                    )
+{
+  __m128d const half = _mm_set1_pd(0.5);
+
+  // Unrolled for loop with step 4.
+  int x = 0;
+  int const max_x = n - 3;
+  for (; x < max_x; x += 4)
+    {
+      _mm_store_pd(threshold + x    , _mm_mul_pd( half, _mm_add_pd( _mm_load_pd(black + x    ), _mm_load_pd(white + x    ) ) ));
+      _mm_store_pd(threshold + x + 2, _mm_mul_pd( half, _mm_add_pd( _mm_load_pd(black + x + 2), _mm_load_pd(white + x + 2) ) ));
+    }
+  /* for */
+
+  // Complete to end.
+  for (; x < n; ++x) threshold[x] = 0.5 * ( black[x] + white[x] );
+}
+/* ThresholdRow_inline */
+
+
+
+//! Appends one Gray code bit-plane to packed code words.
+/*!
+  Thresholds gray values and shifts the resulting bits into packed code words.
+
+  \param gray   Pointer to gray values.
+  \param threshold      Pointer to threshold values.
+  \param code   Pointer to packed Gray code words.
+  \param n      Number of elements.
+*/
+inline
+void
+AppendGrayCodeBitPlane_inline(
+                              double const * const gray,
+                              double const * const threshold,
+                              unsigned int * const code,
+                              int const n
+                              )
+{
+  // Unrolled for loop with step 4.
+  int x = 0;
+  int const max_x = n - 3;
+  for (; x < max_x; x += 4)
+    {
+      code[x    ] = (code[x    ] << 1) | (unsigned int)( gray[x    ] > threshold[x    ] );
+      code[x + 1] = (code[x + 1] << 1) | (unsigned int)( gray[x + 1] > threshold[x + 1] );
+      code[x + 2] = (code[x + 2] << 1) | (unsigned int)( gray[x + 2] > threshold[x + 2] );
+      code[x + 3] = (code[x + 3] << 1) | (unsigned int)( gray[x + 3] > threshold[x + 3] );
+    }
+  /* for */
+
+  // Complete to end.
+  for (; x < n; ++x) code[x] = (code[x] << 1) | (unsigned int)( gray[x] > threshold[x] );
+}
+/* AppendGrayCodeBitPlane_inline */
+
+
+
+//! Decodes Gray code for one tile row.
+/*!
+  Thresholds tile row of all Gray code images into packed code words and
+  converts them to normalized projector coordinate.
+
+  \param images Pointer to vector of single channel Gray code images; first image is the most significant bit.
+  \param threshold      Pointer to threshold values of the tile row.
+  \param kernel Code word converter for the number of bits.
+  \param y      Row index.
+  \param x0     Index of the first column of the tile.
+  \param n      Tile width.
+  \param gray   Scratch buffer for one tile row.
+  \param words  Scratch buffer for packed code words.
+  \param dst    Pointer to output normalized code.
+*/
+inline
+void
+GrayCodeTileRow_inline(
+                       std::vector<cv::Mat *> const * const images,
+                       double const * const threshold,
+                       GrayCodeWordsToCoordinateKernel const kernel,
+                       int const y,
+                       int const x0,
+                       int const n,
+                       double * const gray,
+                       unsigned int * const words,
+                       double * const dst
+                       )
+{
+  int const num_images = (int)( images->size() );
+
+  // Pack all bit-planes.
+  memset(words, 0, sizeof(unsigned int) * n);
+  for (int i = 0; i < num_images; ++i)
+    {
+      bool const fetched = FetchTileRowAsDouble_inline((*images)[i], y, x0, n, gray);
+      assert(true == fetched);
+      AppendGrayCodeBitPlane_inline(gray, threshold, words, n);
+    }
+  /* for */
+
+  // Convert to normalized coordinate.
+  kernel(words, dst, n);
+}
+/* GrayCodeTileRow_inline */
+
+
+
+//! Parallel body of the tiled Gray code decoder.
+/*!
+  Each invocation processes a band of rows. Every row is split into tiles of
+  GRAY_CODE_TILE_WIDTH pixels. For each tile the threshold is computed from
+  the black and white images, all Gray code images are thresholded into
+  packed code words, and the code words are converted to binary and normalized.
+  No full-frame intermediate buffers are used.
+*/
+struct DecodeGrayCodeTiledParallel_ : public cv::ParallelLoopBody
+{
+  std::vector<cv::Mat *> const * images; //!< Single channel Gray code images; first image is the most significant bit.
+  cv::Mat const * black; //!< Black image.
+  cv::Mat const * white; //!< White image.
+  GrayCodeWordsToCoordinateKernel kernel; //!< Code word converter for the number of bits.
+  cv::Mat * code; //!< Output normalized code (CV_64FC1).
+
+  //! Constructor.
+  DecodeGrayCodeTiledParallel_(
+                               std::vector<cv::Mat *> const * const images_in,
+                               cv::Mat const * const black_in,
+                               cv::Mat const * const white_in,
+                               GrayCodeWordsToCoordinateKernel const kernel_in,
+                               cv::Mat * const code_in
+                               )
+  {
+    this->images = images_in;
+    this->black = black_in;
+    this->white = white_in;
+    this->kernel = kernel_in;
+    this->code = code_in;
+  }
+
+  //! Processes a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    __declspec(align(16)) double gray[GRAY_CODE_TILE_WIDTH];
+    __declspec(align(16)) double white_row[GRAY_CODE_TILE_WIDTH];
+    __declspec(align(16)) double threshold[GRAY_CODE_TILE_WIDTH];
+    __declspec(align(16)) unsigned int words[GRAY_CODE_TILE_WIDTH];
+
+    int const cols = this->code->cols;
+
+    for (int y = r.start; y < r.end; ++y)
+      {
+        double * const row_code = (double *)( (BYTE *)(this->code->data) + this->code->step[0] * y );
+
+        for (int x0 = 0; x0 < cols; x0 += GRAY_CODE_TILE_WIDTH)
+          {
+            int const n = (GRAY_CODE_TILE_WIDTH < cols - x0)? GRAY_CODE_TILE_WIDTH : cols - x0;
+
+            // Compute threshold.
+            bool const fetched_black = FetchTileRowAsDouble_inline(this->black, y, x0, n, gray);
+            bool const fetched_white = FetchTileRowAsDouble_inline(this->white, y, x0, n, white_row);
+            assert( (true == fetched_black) && (true == fetched_white) );
+            ThresholdRow_inline(gray, white_row, threshold, n);
+
+            // Decode Gray code.
+            GrayCodeTileRow_inline(this->images, threshold, this->kernel, y, x0, n, gray, words, row_code + x0);
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+};
+/* DecodeGrayCodeTiledParallel_ */
+
+
+
+//! Checks if image may be used by tiled decoders.
+/*!
+  Checks if image is single channel, has supported depth, and is large enough.
+
+  \param img    Pointer to image.
+  \param cols   Required number of columns.
+  \param rows   Required number of rows.
+  \return Returns true if image may be used.
+*/
+inline
+bool
+IsValidTileSource_inline(
+                         cv::Mat const * const img,
+                         int const cols,
+                         int const rows
+                         )
+{
+  if (NULL == img) return false;
+
+  int const depth = img->depth();
+  bool const supported = (CV_8U == depth) || (CV_8S == depth) || (CV_16U == depth) || (CV_16S == depth) ||
+    (CV_32S == depth) || (CV_32F == depth) || (CV_64F == depth);
+
+  return (true == supported) && (1 == img->channels()) && (cols <= img->cols) && (rows <= img->rows);
+}
+/* IsValidTileSource_inline */
+
+
+
+//! Decodes Gray code using packed bit-planes (double precision).
+/*!
+  Decodes Gray code and returns normalized projector coordinate.
+  The result is identical to thresholding with 0.5 * (black + white) followed by
+  DecodeGrayCode; however, all images are read tile-by-tile in a single pass,
+  each thresholded image contributes one bit to a packed per-pixel code word,
+  and the code word is converted from Gray to binary code using XOR shifts
+  with normalization weight fixed at compile time. Bands of rows are processed
+  in parallel.
+
+  Function assumes images are consecutively stored in AllImages starting
+  from index first and ending with index last (inclusive).
+
+  \param AllImages      Pointer to class containing all acquired images.
+  \param b      Index of the black image.
+  \param w      Index of the white image.
+  \param first  Index of the first Gray code image.
+  \param last   Index of the last Gray code image.
+  \return Function returns a pointer to valid cv::Mat or NULL if unsuccesffull.
+*/
+cv::Mat *
+DecodeGrayCodeTiled(
+                    ImageSet * const AllImages,
+                    int const b,
+                    int const w,
+                    int const first,
+                    int const last
+                    )
+{
+  cv::Mat * code = NULL; // Decoded Gray code.
+  cv::Mat * black = NULL; // Black image.
+  cv::Mat * white = NULL; // White image.
+  std::vector<cv::Mat *> images; // Image headers.
+
+  bool const inputs_valid = ValidateInputs_inline(AllImages, first, last);
+  if (false == inputs_valid) return code;
+
+  assert( (0 <= b) && (b < AllImages->num_images) );
+  if ( (b < 0) || (AllImages->num_images <= b) ) return code;
+
+  assert( (0 <= w) && (w < AllImages->num_images) );
+  if ( (w < 0) || (AllImages->num_images <= w) ) return code;
+
+  int const num_images = last - first + 1;
+  assert( (0 < num_images) && (num_images <= GRAY_CODE_MAX_BITS) );
+  if ( (0 >= num_images) || (GRAY_CODE_MAX_BITS < num_images) ) return code;
+
+  // Fetch input image size.
+  int const cols = AllImages->width;
+  int const rows = AllImages->height;
+
+  // Fetch image headers; most pixel formats are shallow copies.
+  black = AllImages->GetImage1C(b);
+  white = AllImages->GetImage1C(w);
+  assert( true == IsValidTileSource_inline(black, cols, rows) );
+  assert( true == IsValidTileSource_inline(white, cols, rows) );
+  if ( (false == IsValidTileSource_inline(black, cols, rows)) ||
+       (false == IsValidTileSource_inline(white, cols, rows))
+       )
+    {
+      goto DecodeGrayCodeTiled_EXIT;
+    }
+  /* if */
+
+  images.reserve(num_images);
+  for (int i = first; i <= last; ++i)
+    {
+      cv::Mat * img1C = AllImages->GetImage1C(i);
+      assert(NULL != img1C);
+      if (NULL == img1C) goto DecodeGrayCodeTiled_EXIT;
+
+      images.push_back(img1C);
+
+      bool const valid = IsValidTileSource_inline(img1C, cols, rows);
+      assert(true == valid);
+      if (false == valid) goto DecodeGrayCodeTiled_EXIT;
+    }
+  /* for */
+
+  // Allocate output and process bands of rows in parallel.
+  code = new cv::Mat(rows, cols, CV_64FC1);
+  assert(NULL != code);
+  if (NULL == code) goto DecodeGrayCodeTiled_EXIT;
+
+  {
+    DecodeGrayCodeTiledParallel_ body(&images, black, white, gGrayCodeWordsToCoordinateKernels[num_images], code);
+    cv::parallel_for_( cv::Range(0, rows), body, (double)(rows) / (double)(GRAY_CODE_BAND_HEIGHT) );
+  }
+
+
+ DecodeGrayCodeTiled_EXIT:
+
+  for (size_t i = 0; i < images.size(); ++i) SAFE_DELETE( images[i] );
+  images.clear();
+
+  SAFE_DELETE( black );
+  SAFE_DELETE( white );
+
+  return code;
+}
+/* DecodeGrayCodeTiled */
+
+
+
+/****** ABSOLUTE PHASE ESTIMATION USING GC+PS ******/
+
+
+//! Unwraps one row of relative phase using Gray code.
+/*!
+  Unwraps n values of relative phase using decoded normal and shifted Gray code.
+  If shifted Gray code is not available then only normal Gray code is used;
+  this type of decoding may produce errors on code boundaries.
+
+  \param gray_code_1    Pointer to normalized normal Gray code.
+  \param gray_code_2    Pointer to normalized shifted Gray code. May be NULL.
+  \param rel_phase      Pointer to relative phase in [0, 2pi] range.
+  \param abs_phase      Pointer to output absolute phase.
+  \param n      Number of elements.
+  \param total1 Number of codewords of the normal Gray code.
+  \param total2 Number of codewords of the shifted Gray code.
+*/
+inline
+void
+UnwrapPhasePSAndGCRow_inline(
+                             double const * const gray_code_1,
+                             double const * const gray_code_2,
+                             double const * const rel_phase,
+                             double * const abs_phase,
+                             int const n,
+                             double const total1,
+                             double const total2
+                             )
+{
+  // Define pi.
+  double const pi = 3.141592653589793238462643383279502884197169399375;
+
+  if (NULL == gray_code_2)
+    {
+      double const c = 0.5 / (total1 * pi);
+
+      // Unrolled for loop with step 8.
+      int x = 0;
+      int const max_x = n - 7;
+      for (; x < max_x; x += 8)
+        {
+          abs_phase[x    ] = gray_code_1[x    ] + c * rel_phase[x    ];
+          abs_phase[x + 1] = gray_code_1[x + 1] + c * rel_phase[x + 1];
+          abs_phase[x + 2] = gray_code_1[x + 2] + c * rel_phase[x + 2];
+          abs_phase[x + 3] = gray_code_1[x + 3] + c * rel_phase[x + 3];
+
+          abs_phase[x + 4] = gray_code_1[x + 4] + c * rel_phase[x + 4];
+          abs_phase[x + 5] = gray_code_1[x + 5] + c * rel_phase[x + 5];
+          abs_phase[x + 6] = gray_code_1[x + 6] + c * rel_phase[x + 6];
+          abs_phase[x + 7] = gray_code_1[x + 7] + c * rel_phase[x + 7];
+        }
+      /* for */
+
+      // Complete to end.
+      for (; x < n; ++x)
+        {
+          abs_phase[x] = gray_code_1[x] + c * rel_phase[x];
+        }
+      /* for */
+    }
+  else
+    {
+      double const c = 0.5 / pi;
+      double const c1 = 1.0 / total1;
+      double const c2 = 1.0 / total2;
+
+      // Unwrap phase.
+      for (int x = 0; x < n; ++x)
+        {
+          double const WP_norm = c * rel_phase[x];
+
+          if ( (0.25 <= WP_norm) && (WP_norm < 0.75) )
+            {
+              abs_phase[x] = gray_code_1[x] + c1 * WP_norm;
+            }
+          else
+            {
+              if ( 0 != gray_code_1[x] )
+                {
+                  double const WP_norm_shifted = WP_norm + ( (WP_norm < 0.5)? 0.5 : -0.5 );
+                  abs_phase[x] = (gray_code_2[x] + c2 * 0.5) + c2 * WP_norm_shifted;
+                }
+              else
+                {
+                  abs_phase[x] = c1 * WP_norm;
+                }
+              /* if */
+            }
+          /* if */
+        }
+      /* for */
+    }
+  /* if */
+}
+/* UnwrapPhasePSAndGCRow_inline */
+
+
+
+//! Unwraps phase using Gray code.
+/*!
+  Function unwraps phase using Gray code.
+
+  \param AllImages
+  \param n1     First image of the normal Gray code set.
+  \param n2     Last image of the normal Gray code set.
+  \param m1     First image of the shifted Gray code set.
+  \param m2     Last iamge of the shifted Gray code set.
+  \param b  Index of the black image.
+  \param w  Index of the white image.
+  \param rel_phase      Pointer to wrapped phase image. Must be of type.
+  \param gray_code_1_out    Pointer to address where decoded normal Gray code will be stored. May be NULL.
+  \param gray_code_2_out    Pointer to address where decoded second Gray code will be stored. May be NULL.
+  \return Function returns pointer to unwrapped phase image or NULL if unsuccessfull.
+*/
+cv::Mat *
+UnwrapPhasePSAndGC(
+                   ImageSet * const AllImages,
+                   int const n1,
+                   int const n2,
+                   int const m1,
+                   int const m2,
+                   int const b,
+                   int const w,
+                   cv::Mat * const rel_phase,
+                   cv::Mat * * const gray_code_1_out,
+                   cv::Mat * * const gray_code_2_out
+                   )
+{
+  cv::Mat * abs_phase = NULL; // Unwrapped (or absolute) phase.
+
+  // Check inputs.
+  assert( (0 <= b) && (b < AllImages->num_images) );
+  if ( (b < 0) || (AllImages->num_images <= b) ) return abs_phase;
+
+  assert( (0 <= w) && (w < AllImages->num_images) );
+  if ( (w < 0) || (AllImages->num_images <= w) ) return abs_phase;
+
+  assert( NULL != rel_phase );
+  if (NULL == rel_phase) return abs_phase;
+
+  assert( NULL != rel_phase->data );
+  if (NULL == rel_phase->data) return abs_phase;
+
+  // Fetch input image size.
+  int const cols = AllImages->width;
+  int const rows = AllImages->height;
+
+  assert( cols <= rel_phase->cols );
+  assert( rows <= rel_phase->rows );
+  if ( (cols > rel_phase->cols) || (rows > rel_phase->rows) ) return abs_phase;
+
+  assert( (CV_MAT_DEPTH(rel_phase->type()) == CV_64F) && (CV_MAT_CN(rel_phase->type()) == 1) );
+  if ( (CV_MAT_DEPTH(rel_phase->type()) != CV_64F) || (CV_MAT_CN(rel_phase->type()) != 1) ) return abs_phase;
+
+  cv::Mat * gray_code_1 = NULL;
+  cv::Mat * gray_code_2 = NULL;
+
+  // Decode normal Gray code; threshold is the mean of black and white images.
+  gray_code_1 = DecodeGrayCodeTiled(AllImages, b, w, n1, n2);
+  assert(NULL != gray_code_1);
+  if (NULL == gray_code_1) goto UnwrapPhasePSAndGC_EXIT;
+
+  // Decode shifted Gray code (may not be present).
+  gray_code_2 = DecodeGrayCodeTiled(AllImages, b, w, m1, m2);
+
+  // Allocate output buffer.
+  abs_phase = new cv::Mat(rows, cols, CV_64FC1);
+  assert(NULL != abs_phase);
+  if (NULL == abs_phase) goto UnwrapPhasePSAndGC_EXIT;
+
+  // Decode wrapped phase.
+  {
+    double const total1 = (double)( 1 << (n2 - n1 + 1) );
+    double const total2 = (NULL != gray_code_2)? (double)( 1 << (m2 - m1 + 1) ) : total1;
+    assert(total1 == total2);
+
+    for (int y = 0; y < rows; ++y)
+      {
+        // Get row addresses.
+        double const * const row_gray_code_1 = (double *)( (BYTE *)(gray_code_1->data) + gray_code_1->step[0] * y );
+        double const * const row_gray_code_2 =
+          (NULL != gray_code_2)? (double *)( (BYTE *)(gray_code_2->data) + gray_code_2->step[0] * y ) : NULL;
+        double const * const row_rel_phase = (double *)( (BYTE *)(rel_phase->data) + rel_phase->step[0] * y );
+        double       * const row_abs_phase = (double *)( (BYTE *)(abs_phase->data) + abs_phase->step[0] * y );
+
+        UnwrapPhasePSAndGCRow_inline(row_gray_code_1, row_gray_code_2, row_rel_phase, row_abs_phase, cols, total1, total2);
+      }
+    /* for */
+  }
+
+
+  SAFE_ASSIGN_PTR( gray_code_1, gray_code_1_out );
+  SAFE_ASSIGN_PTR( gray_code_2, gray_code_2_out );
+
+ UnwrapPhasePSAndGC_EXIT:
+
+  SAFE_DELETE( gray_code_1 );
+  SAFE_DELETE( gray_code_2 );
+
+  return abs_phase;
+}
+/* UnwrapPSAndGC */
+
+
+
+//! Parallel body of the streaming PS+GC unwrapper.
+/*!
+  Each invocation processes a band of rows. For every tile of RELATIVE_PHASE_TILE_WIDTH
+  pixels the relative phase, the black/white threshold and validity, both Gray codes,
+  and the absolute phase are computed using only per-thread tile buffers.
+  Dynamic range and texture of phase shifted images are optionally computed
+  from the same tile rows.
+*/
+struct UnwrapPhasePSAndGCStreamingParallel_ : public cv::ParallelLoopBody
+{
+  std::vector<cv::Mat *> const * ps_images; //!< Phase shifted images.
+  double const * weight_num; //!< Numerator weights.
+  double const * weight_den; //!< Denominator weights.
+  RelativePhaseNumDenKernel ps_kernel; //!< Specialized N-step kernel or NULL for generic accumulation.
+  PhaseAtan2Method atan2_method; //!< Arctangent computation method.
+
+  std::vector<cv::Mat *> const * gc1_images; //!< Normal Gray code images.
+  std::vector<cv::Mat *> const * gc2_images; //!< Shifted Gray code images; may be empty.
+  GrayCodeWordsToCoordinateKernel gc1_kernel; //!< Code word converter for normal Gray code.
+  GrayCodeWordsToCoordinateKernel gc2_kernel; //!< Code word converter for shifted Gray code.
+  double total1; //!< Number of codewords of normal Gray code.
+  double total2; //!< Number of codewords of shifted Gray code.
+
+  cv::Mat const * black; //!< Black image.
+  cv::Mat const * white; //!< White image.
+  double contrast_thr; //!< Minimal difference between white and black image for valid pixels.
+
+  cv::Mat * abs_phase; //!< Output absolute phase (CV_64FC1).
+  cv::Mat * valid; //!< Output validity mask (CV_8UC1); may be NULL.
+  TileStatisticsOutput const * stats; //!< Dynamic range and texture outputs of phase shifted images; may be NULL.
+
+  //! Constructor.
+  UnwrapPhasePSAndGCStreamingParallel_()
+  {
+    this->ps_images = NULL;
+    this->weight_num = NULL;
+    this->weight_den = NULL;
+    this->ps_kernel = NULL;
+    this->atan2_method = PHASE_ATAN2_LIBM;
+    this->gc1_images = NULL;
+    this->gc2_images = NULL;
+    this->gc1_kernel = NULL;
+    this->gc2_kernel = NULL;
+    this->total1 = 0.0;
+    this->total2 = 0.0;
+    this->black = NULL;
+    this->white = NULL;
+    this->contrast_thr = 0.0;
+    this->abs_phase = NULL;
+    this->valid = NULL;
+    this->stats = NULL;
+  }
+
+  //! Processes a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    __declspec(align(16)) double gray[RELATIVE_PHASE_MAX_SPECIALIZED_STEPS][RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double acc_num[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double acc_den[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double rel_phase[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double black_row[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double white_row[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double threshold[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double gray_code_1[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double gray_code_2[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) unsigned int words[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double tile_min[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double tile_max[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double tile_sum[RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double bgr[3 * RELATIVE_PHASE_TILE_WIDTH];
+    __declspec(align(16)) double bgr_sum[3 * RELATIVE_PHASE_TILE_WIDTH];
+
+    bool const have_gc2 = (NULL != this->gc2_kernel);
+    bool const have_range = (NULL != this->stats) && (NULL != this->stats->dynamic_range);
+    bool const have_gray_texture = (NULL != this->stats) && (NULL != this->stats->texture) && (true == this->stats->texture_images.empty());
+    int const cols = this->abs_phase->cols;
+
+    for (int y = r.start; y < r.end; ++y)
+      {
+        double * const row_abs_phase = (double *)( (BYTE *)(this->abs_phase->data) + this->abs_phase->step[0] * y );
+        unsigned char * const row_valid =
+          (NULL != this->valid)? (unsigned char *)( (BYTE *)(this->valid->data) + this->valid->step[0] * y ) : NULL;
+
+        for (int x0 = 0; x0 < cols; x0 += RELATIVE_PHASE_TILE_WIDTH)
+          {
+            int const n = (RELATIVE_PHASE_TILE_WIDTH < cols - x0)? RELATIVE_PHASE_TILE_WIDTH : cols - x0;
+
+            // Compute relative phase, dynamic range, and texture.
+            RelativePhaseTileRow_inline(
+                                        this->ps_images, this->weight_num, this->weight_den, this->ps_kernel, this->atan2_method,
+                                        y, x0, n,
+                                        gray, acc_num, acc_den,
+                                        rel_phase,
+                                        (true == have_range)? tile_min : NULL,
+                                        (true == have_range)? tile_max : NULL,
+                                        (true == have_gray_texture)? tile_sum : NULL
+                                        );
+
+            if (NULL != this->stats)
+              {
+                StoreTileStatistics_inline(this->stats, y, x0, n, tile_min, tile_max, tile_sum, bgr, bgr_sum);
+              }
+            /* if */
+
+            // Compute threshold and validity.
+            bool const fetched_black = FetchTileRowAsDouble_inline(this->black, y, x0, n, black_row);
+            bool const fetched_white = FetchTileRowAsDouble_inline(this->white, y, x0, n, white_row);
+            assert( (true == fetched_black) && (true == fetched_white) );
+            ThresholdRow_inline(black_row, white_row, threshold, n);
+
+            if (NULL != row_valid)
+              {
+                unsigned char * const dst = row_valid + x0;
+                for (int x = 0; x < n; ++x) dst[x] = (white_row[x] - black_row[x] > this->contrast_thr)? 255 : 0;
+              }
+            /* if */
+
+            // Decode Gray codes.
+            GrayCodeTileRow_inline(this->gc1_images, threshold, this->gc1_kernel, y, x0, n, gray[0], words, gray_code_1);
+            if (true == have_gc2)
+              {
+                GrayCodeTileRow_inline(this->gc2_images, threshold, this->gc2_kernel, y, x0, n, gray[0], words, gray_code_2);
+              }
+            /* if */
+
+            // Unwrap phase.
+            UnwrapPhasePSAndGCRow_inline(
+                                         gray_code_1, (true == have_gc2)? gray_code_2 : NULL, rel_phase,
+                                         row_abs_phase + x0, n,
+                                         this->total1, this->total2
+                                         );
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+};
+/* UnwrapPhasePSAndGCStreamingParallel_ */
+
+
+
+//! Unwraps phase using Gray code in a single streaming pass.
+/*!
+  Function computes the relative phase, decodes normal and shifted Gray code,
+  tests black/white validity, and unwraps the phase tile-by-tile in a single
+  pass over all images. Unlike the combination of EstimateRelativePhaseTiled
+  and UnwrapPhasePSAndGC no full-frame relative phase, threshold, or Gray code
+  images are allocated; only the absolute phase and, optionally, the validity
+  mask are written. Results are identical to the results of that combination.
+
+  \param AllImages      Pointer to class containing all acquired images.
+  \param ps1    First image of the phase shifted set.
+  \param ps2    Last image of the phase shifted set.
+  \param n1     First image of the normal Gray code set.
+  \param n2     Last image of the normal Gray code set.
+  \param m1     First image of the shifted Gray code set.
+  \param m2     Last image of the shifted Gray code set. If the set is empty (m2 < m1) then only normal Gray code is used.
+  \param b      Index of the black image.
+  \param w      Index of the white image.
+  \param specialized    Flag to indicate specialized N-step kernel should be used if one exists.
+  \param atan2_method   Arctangent computation method.
+  \param contrast_thr   Minimal difference between white and black image for the pixel to be valid.
+  \param valid_out      Address where validity mask (CV_8UC1) will be stored. May be NULL.
+  \param dynamic_range_in_out   Address where a pointer to cv::Mat which holds dynamic range of phase shifted images is stored.
+  Follows the conventions of UpdateDynamicRangeAndTexture function. May be NULL.
+  \param texture_in_out Address where a pointer to cv::Mat which holds texture of phase shifted images is stored.
+  Follows the conventions of UpdateDynamicRangeAndTexture function. May be NULL.
+  \return Function returns pointer to unwrapped phase image (CV_64FC1) or NULL if unsuccessfull.
+*/
+cv::Mat *
+UnwrapPhasePSAndGCStreaming(
+                            ImageSet * const AllImages,
+                            int const ps1,
+                            int const ps2,
+                            int const n1,
+                            int const n2,
+                            int const m1,
+                            int const m2,
+                            int const b,
+                            int const w,
+                            bool const specialized,
+                            PhaseAtan2Method const atan2_method,
+                            double const contrast_thr,
+                            cv::Mat * * const valid_out,
+                            cv::Mat * * const dynamic_range_in_out,
+                            cv::Mat * * const texture_in_out
+                            )
+{
+  TileStatisticsOutput stats; // Dynamic range and texture outputs.
+
+  cv::Mat * abs_phase = NULL; // Unwrapped (or absolute) phase.
+  cv::Mat * valid = NULL; // Validity mask.
+  cv::Mat * black = NULL; // Black image.
+  cv::Mat * white = NULL; // White image.
+
+  std::vector<cv::Mat *> ps_images; // Phase shifted image headers.
+  std::vector<cv::Mat *> gc1_images; // Normal Gray code image headers.
+  std::vector<cv::Mat *> gc2_images; // Shifted Gray code image headers.
+
+  double * weight_num = NULL;
+  double * weight_den = NULL;
+
+  // Check inputs.
+  bool const ps_valid = ValidateInputs_inline(AllImages, ps1, ps2);
+  if (false == ps_valid) return abs_phase;
+
+  bool const gc1_valid = ValidateInputs_inline(AllImages, n1, n2);
+  if (false == gc1_valid) return abs_phase;
+
+  bool const have_gc2 = (m1 <= m2);
+  if (true == have_gc2)
+    {
+      bool const gc2_valid = ValidateInputs_inline(AllImages, m1, m2);
+      if (false == gc2_valid) return abs_phase;
+    }
+  /* if */
+
+  assert( (0 <= b) && (b < AllImages->num_images) );
+  if ( (b < 0) || (AllImages->num_images <= b) ) return abs_phase;
+
+  assert( (0 <= w) && (w < AllImages->num_images) );
+  if ( (w < 0) || (AllImages->num_images <= w) ) return abs_phase;
+
+  int const num_ps = ps2 - ps1 + 1;
+  int const num_gc1 = n2 - n1 + 1;
+  int const num_gc2 = (true == have_gc2)? m2 - m1 + 1 : num_gc1;
+
+  assert( (num_gc1 <= GRAY_CODE_MAX_BITS) && (num_gc2 <= GRAY_CODE_MAX_BITS) );
+  if ( (GRAY_CODE_MAX_BITS < num_gc1) || (GRAY_CODE_MAX_BITS < num_gc2) ) return abs_phase;
+
+  assert(num_gc1 == num_gc2);
+
+  // Fetch input image size.
+  int const cols = AllImages->width;
+  int const rows = AllImages->height;
+
+  // Compute weight factors for numerator and denominator.
+  weight_num = new double[num_ps];
+  weight_den = new double[num_ps];
+  assert(NULL != weight_num);
+  assert(NULL != weight_den);
+
+  if ( (NULL == weight_num) || (NULL == weight_den) ) goto UnwrapPhasePSAndGCStreaming_EXIT;
+
+  {
+    double const pi = 3.141592653589793238462643383279502884197169399375;
+    double const k = 2.0 * pi / (double)( num_ps );
+
+    for (int i = 0; i < num_ps; ++i)
+      {
+        double const phi = k * (double)(i);
+        weight_num[i] = cos( phi );
+        weight_den[i] = -sin( phi );
+      }
+    /* for */
+  }
+
+  // Fetch image headers; most pixel formats are shallow copies.
+  black = AllImages->GetImage1C(b);
+  white = AllImages->GetImage1C(w);
+  assert( true == IsValidTileSource_inline(black, cols, rows) );
+  assert( true == IsValidTileSource_inline(white, cols, rows) );
+  if ( (false == IsValidTileSource_inline(black, cols, rows)) ||
+       (false == IsValidTileSource_inline(white, cols, rows))
+       )
+    {
+      goto UnwrapPhasePSAndGCStreaming_EXIT;
+    }
+  /* if */
+
+  {
+    int const first[3] = {ps1, n1, m1};
+    int const last[3] = {ps2, n2, (true == have_gc2)? m2 : m1 - 1};
+    std::vector<cv::Mat *> * const images[3] = {&ps_images, &gc1_images, &gc2_images};
+
+    for (int j = 0; j < 3; ++j)
+      {
+        for (int i = first[j]; i <= last[j]; ++i)
+          {
+            cv::Mat * img1C = AllImages->GetImage1C(i);
+            assert(NULL != img1C);
+            if (NULL == img1C) goto UnwrapPhasePSAndGCStreaming_EXIT;
+
+            images[j]->push_back(img1C);
+
+            bool const valid_source = IsValidTileSource_inline(img1C, cols, rows);
+            assert(true == valid_source);
+            if (false == valid_source) goto UnwrapPhasePSAndGCStreaming_EXIT;
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+  // Prepare dynamic range and texture outputs.
+  {
+    bool const prepared = PrepareTileStatistics_inline(AllImages, ps1, ps2, dynamic_range_in_out, texture_in_out, &stats);
+    assert(true == prepared);
+    if (false == prepared) goto UnwrapPhasePSAndGCStreaming_EXIT;
+  }
+
+  // Allocate outputs.
+  abs_phase = new cv::Mat(rows, cols, CV_64FC1);
+  assert(NULL != abs_phase);
+  if (NULL == abs_phase) goto UnwrapPhasePSAndGCStreaming_EXIT;
+
+  if (NULL != valid_out)
+    {
+      valid = new cv::Mat(rows, cols, CV_8UC1);
+      assert(NULL != valid);
+      if (NULL == valid)
+        {
+          SAFE_DELETE( abs_phase );
+          goto UnwrapPhasePSAndGCStreaming_EXIT;
+        }
+      /* if */
+    }
+  /* if */
+
+  // Process bands of rows in parallel.
+  {
+    UnwrapPhasePSAndGCStreamingParallel_ body;
+
+    body.ps_images = &ps_images;
+    body.weight_num = weight_num;
+    body.weight_den = weight_den;
+    body.ps_kernel = (true == specialized)? GetRelativePhaseNumDenKernel_inline(num_ps) : NULL;
+    body.atan2_method = atan2_method;
+
+    body.gc1_images = &gc1_images;
+    body.gc2_images = &gc2_images;
+    body.gc1_kernel = gGrayCodeWordsToCoordinateKernels[num_gc1];
+    body.gc2_kernel = (true == have_gc2)? gGrayCodeWordsToCoordinateKernels[num_gc2] : NULL;
+    body.total1 = (double)( 1 << num_gc1 );
+    body.total2 = (double)( 1 << num_gc2 );
+
+    body.black = black;
+    body.white = white;
+    body.contrast_thr = contrast_thr;
+
+    body.abs_phase = abs_phase;
+    body.valid = valid;
+    body.stats = ( (NULL != stats.dynamic_range) || (NULL != stats.texture) )? &stats : NULL;
+
+    cv::parallel_for_( cv::Range(0, rows), body, (double)(rows) / (double)(RELATIVE_PHASE_BAND_HEIGHT) );
+  }
+
+  SAFE_ASSIGN_PTR( valid, valid_out );
+
+
+ UnwrapPhasePSAndGCStreaming_EXIT:
+
+  FinishTileStatistics_inline(&stats, NULL != abs_phase, dynamic_range_in_out, texture_in_out);
+
+  for (size_t i = 0; i < ps_images.size(); ++i) SAFE_DELETE( ps_images[i] );
+  for (size_t i = 0; i < gc1_images.size(); ++i) SAFE_DELETE( gc1_images[i] );
+  for (size_t i = 0; i < gc2_images.size(); ++i) SAFE_DELETE( gc2_images[i] );
+
+  SAFE_DELETE( black );
+  SAFE_DELETE( white );
+  SAFE_DELETE( valid );
+
+  SAFE_DELETE_ARRAY( weight_num );
+  SAFE_DELETE_ARRAY( weight_den );
+
+  return abs_phase;
+}
+/* UnwrapPhasePSAndGCStreaming */
+
+
+
+
+/****** ABSOLUTE PHASE ESTIMATION USING MPS ******/
+
+//! Test in all numbers are whole numbers.
+/*!
+  Function tests is all numbers in std::vector are whole.
+
+  \param numbers_in     Reference to std::vector of double precision numbers.
+  \return Function returns true if all elements in std::vector are whole numbers and false otherwise.
+  If the vector is empty then true is returned.
+*/
+inline
+bool
+mps_all_whole_inline(
+                     std::vector<double> const & numbers_in
+                     )
+{
+  bool all_whole = true;
+
+  int const i_max = (int)( numbers_in.size() );
+  for (int i = 0; i < i_max; ++i)
+    {
+      __int64 const x = (__int64)( numbers_in[i] + 0.5 );
+      bool const x_is_whole = ( (double)x == numbers_in[i] );
+      all_whole = all_whole && x_is_whole;
+    }
+  /* for */
+
+  return all_whole;
+}
+/* mps_all_whole_inline */
+
+
+
+//! Compute greatest common divisor of two numbers.
+/*!
+  Function computes greatest common divisor of two numbers
+  using Euclidean algorithm.
+
+  \param a      First number. Input must be whole number.
+  \param b      Second number. Input must be whole number different than zero.
+  \return Function returns greatest common divisor if successfull or NaN if unsuccessfull.
+*/
+double
+mps_gcd(
+        double const a,
+        double const b
+        )
+{
+  // Test if input numbers are whole numbers.
+  __int64 const A = (__int64)( a + 0.5 );
+  __int64 const B = (__int64)( b + 0.5 );
+  bool const a_is_whole = ( (double)A == a );
+  bool const b_is_whole = ( (double)B == b );
+  assert( (true == a_is_whole) && (true == b_is_whole) );
+  if ( (false == a_is_whole) || (false == b_is_whole) )
+    {
+      Debugfwprintf(stderr, gDbgGCDInputsAreNotWholeNumbers);
+    }
+  /* if */
+
+  // Test if input numbers have all digits.
+  double const limit = pow(2.0, 53);
+  assert( (a < limit) && (b < limit) );
+  if ( (a >= limit) || (b >= limit) )
+    {
+      Debugfwprintf(stderr, gDbgGCDInputsHaveOverflow);
+    }
+  /* if */
+
+  // Assume failure.
+  double gcd = std::numeric_limits<double>::quiet_NaN();
+
+  // The second input must be non-zero to avoid an infinite loop.
+  // Note that the first input may be zero in which case the while loop terminates after first iteration.
+  if (0 != B)
+    {
+      __int64 r0 = A;
+      __int64 r1 = B;
+      __int64 r = 1;
+
+      while (0 != r)
+        {
+          r = r0 % r1;
+          r0 = r1;
+          r1 = r;
+        }
+      /* while */
+
+      gcd = (double)( r0 );
+
+      __int64 const GCD = (__int64)(gcd + 0.5);
+      assert( (double)GCD == gcd );
+    }
+  /* if */
+
+  return gcd;
+}
+/* mps_gcd */
+
+
+
+//! Compute greatest common divisor of many numbers.
+/*!
+  Function computes greatest common divisor of arbitrary many numbers in
+  sequential manner using associativity property of the greatest common divisor.
+
+  \param vec    Reference to a vector of numbers.
+  \return Function returns greatest common divisor if successfull or NaN if unsuccessfull.
+*/
+double
+mps_gcd(
+        std::vector<double> const & vec
+        )
+{
+  // Assume failure.
+  double gcd = std::numeric_limits<double>::quiet_NaN();
+
+  if ( (false == vec.empty()) && (true == mps_all_whole_inline(vec)) )
+    {
+      gcd = vec.front();
+      for (size_t i = 1; i < vec.size(); ++i)
+        {
+          gcd = mps_gcd(gcd, vec.at(i));
+        }
+      /* for */
+    }
+  /* if */
+
+  return gcd;
+}
+/* mps_gcd */
+
+
+
+//! Compute least common multiple of two numbers.
+/*!
+  Function computes least common multiple of two numbers
+  using mps_gcd function.
+
+  \param a      First number. Input must be whole number.
+  \param b      Second number. Input must be whole number different than zero.
+  \return Function returns least common multiple if successfull or NaN if unsuccessfull.
+*/
+double
+mps_lcm(
+        double const a,
+        double const b
+        )
+{
+  // Test if input numbers are whole numbers.
+  __int64 const A = (__int64)( a + 0.5 );
+  __int64 const B = (__int64)( b + 0.5 );
+  bool const a_is_whole = ( (double)A == a );
+  bool const b_is_whole = ( (double)B == b );
+  assert( (true == a_is_whole) && (true == b_is_whole) );
+  if ( (false == a_is_whole) || (false == b_is_whole) )
+    {
+      Debugfwprintf(stderr, gDbgLCMInputsAreNotWholeNumbers);
+    }
+  /* if */
+
+  // Test if input numbers have all digits and if product overflows.
+  double const limit = pow(2.0, 53);
+  assert( (a < limit) && (b < limit) && (a * b <= limit) );
+  if ( (a >= limit) || (b >= limit) || (a * b > limit) )
+    {
+      Debugfwprintf(stderr, gDbgLCMInputsHaveOverflow);
+    }
+  /* if */
+
+  double const gcd = mps_gcd(a, b);
+  double const lcm = fabs(a * b) / gcd;
+
+  return lcm;
+}
+/* mps_lcm */
+
+
+
+//! Compute least common multiple of many numbers.
+/*!
+  Function computes least common multiple of arbitrary many numbers
+  in sequentiall manner using associativity property of the least common multiple.
+
+  \param vec    Reference to a vector of numbers.
+  \return Function returns least common multiple is successfull or NaN if unsuccessfull.
+*/
+double
+mps_lcm(
+        std::vector<double> const & vec
+        )
+{
+  // Assume failure.
+  double lcm = std::numeric_limits<double>::quiet_NaN();
+
+  if ( (false == vec.empty()) && (true == mps_all_whole_inline(vec)) )
+    {
+      lcm = vec.front();
+      for (size_t i = 1; i < vec.size(); ++i)
+        {
+          lcm = mps_lcm(lcm, vec.at(i));
+        }
+      /* for */
+    }
+  /* if */
+
+  return lcm;
+}
+/* mps_lcm */
+
+
+
+//! Return periods from fringe counts.
+/*!
+  Function returns a vector of period (wavelengts) which corresponds to given fringe counts.
+
+  \param counts_in      Reference to a vector of fringe counts.
+  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automatically computed from fringe counts.
+  \param lambda_out     Address where the pointer to a vector of periods will be stored.
+  \param width_out      Address where used maximal width will be stored.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+mps_periods_from_fringe_counts(
+                               std::vector<double> const & counts_in,
+                               double const width_in,
+                               std::vector<double> * * const lambda_out,
+                               double * const width_out
+                               )
+{
+  assert( true == mps_all_whole_inline(counts_in) );
+
+  // Set default width.
+  double width = width_in;
+  double const lcm_counts = mps_lcm(counts_in);
+  double const gcd_counts = mps_gcd(counts_in);
+  if ( 0 != _isnan(width_in) )
+    {
+      width = lcm_counts / gcd_counts;
+      assert( 0 == _isnan(width) );
+    }
+  /* if */
+  assert( (0 <= width) && (width <= lcm_counts) );
+
+  bool result = false; // Assume failure.
+
+  std::vector<double> * lambda = new std::vector<double>( counts_in.size() );
+  assert(NULL != lambda);
+  if (NULL != lambda)
+    {      
+      int const i_max = (int)( counts_in.size() );
+      if (1.0 < gcd_counts)
+        {
+          Debugfwprintf(stderr, gDbgFringeCountsAreNotWholeNumbers);
+          for (int i = 0; i < i_max; ++i) (*lambda)[i] = ( width * gcd_counts ) / counts_in[i];
+        }
+      else
+        {
+          assert(1.0 == gcd_counts);
+          for (int i = 0; i < i_max; ++i) (*lambda)[i] = width / counts_in[i];
+        }
+      /* if */
+      
+      double const gcd_lambda = mps_gcd(*lambda);
+      if (1.0 < gcd_lambda)
+        {
+          Debugfwprintf(stderr, gDbgPeriodsAreNotRelativelyPrime);
+          double const scl = 1.0 / gcd_lambda;
+          for (int i = 0; i < i_max; ++i) (*lambda)[i] = (*lambda)[i] * scl;
+        }
+      else
+        {
+          assert(1.0 == gcd_lambda);
+        }
+      /* if */
+
+      result = true;
+    }
+  /* if */
+
+  SAFE_ASSIGN_PTR( lambda, lambda_out );
+  if (NULL != width_out) *width_out = width;
+
+  SAFE_DELETE( lambda );
+
+  return result;
+}
+/* mps_periods_from_fringe_counts */
+
+
+
+//! Computes all valid period tuples.
+/*!
+  Function returns all valid period tuples k for input periods lambda.
+
+  \param lambda_in      Pointer to wavelengths.
+  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
+  \param k_out          Address where pointer to cv::Mat which stores all period tuples will be placed. May be NULL.
+  \param width_out      Address where used maximal width will be stored.
+  \param w_min_out      Address where pointer to cv::Mat which stores starting boundaries of each segment will be placed. May be NULL.
+  \param w_max_out      Address where pointer to cv::Mat which stores ending boundaries of each segment will be placed. May be NULL.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+mps_get_period_tuples(
+                      std::vector<double> const & lambda_in,
+                      double const width_in,
+                      cv::Mat * * const k_out,
+                      double * const width_out,
+                      cv::Mat * * const w_min_out,
+                      cv::Mat * * const w_max_out
+                      )
+{
+  // Set default width.
+  double width = width_in;
+  if ( 0 != _isnan(width_in) )
+    {
+      double const lcm = mps_lcm(lambda_in);
+      double const gcd = mps_gcd(lambda_in);
+      width = lcm / gcd;
+      assert( 0 == _isnan(width) );
+    }
+  /* if */
+
+  if ( 0 != _isnan(width) ) return false;
+
+  bool result = true; // Assume success.
+
+  // Allocate storage on stack.
+  int const i_max = (int)( lambda_in.size() );
+
+  int j = 1;
+  int const j_step = 100;
+
+  std::vector<double> next_boundary(lambda_in);
+  std::vector<int> inc(lambda_in.size(), 0);
+
+  // Find first minimal boundary.
+  double x = *std::min_element(next_boundary.begin(), next_boundary.end());
+  for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+
+  // Allocate storage on heap.
+  cv::Mat * k = new cv::Mat(j_step, i_max, CV_32SC1, cv::Scalar(0));
+  assert( (NULL != k) && (NULL != k->data) );
+
+  // Storage for borders will be allocated later.
+  cv::Mat * w_min = NULL;
+  cv::Mat * w_max = NULL;
+
+  // Bail-out if allocation failed.
+  if ( (NULL == k) || (NULL == k->data) )
+    {
+      result = false;
+      goto mps_get_period_tuples_EXIT;
+    }
+  /* if */
+
+  // Create valid tuples.
+  while ( (x < width) &&
+          (0 < *std::max_element(inc.begin(), inc.end()))
+          )
+    {
+      // Get next boundary.
+      for (int i = 0; i < i_max; ++i)
+        {
+          if (0 < inc[i]) next_boundary[i] += lambda_in[i];
+        }
+      /* for */
+
+      // Increase storage if necessary.
+      if (j >= k->rows) k->resize(k->rows + j_step, cv::Scalar(0));
+
+      // Set next period-order tuple.
+      int const j_prev = j - 1;
+      for (int i = 0; i < i_max; ++i)
+        {
+          k->at<int>(j, i) = k->at<int>(j_prev, i) + inc[i];
+        }
+      /* for */
+      j = j + 1;
+
+      // Find next minimal boundary.
+      x = *std::min_element(next_boundary.begin(), next_boundary.end());
+      for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+    }
+  /* while */
+
+  // Efficiently create new cv::Mat header for the output buffer.
+  int const N = j;
+  if (N != k->rows)
+    {
+      cv::Range r[2] = {cv::Range(0, N), cv::Range::all()};
+
+      cv::Mat * k_tmp = new cv::Mat(*k, r);
+      assert(NULL != k_tmp);
+      if (NULL != k_tmp)
+        {
+          SAFE_DELETE( k );
+          k = k_tmp;
+          k_tmp = NULL;
+        }
+      /* if */
+    }
+  /* if */
+
+  // Compute interval boundaries if requested.
+  if ( (NULL != w_min_out) || (NULL != w_max_out) )
+    {
+      w_min = new cv::Mat(N, 1, CV_64FC1, 0.0);
+      assert( (NULL != w_min) && (NULL != w_min->data) );
+
+      w_max = new cv::Mat(N, 1, CV_64FC1, 0.0);
+      assert( (NULL != w_max) && (NULL != w_max->data) );
+
+      if ( (NULL == w_min) || (NULL == w_min->data) ||
+           (NULL == w_max) || (NULL == w_max->data)
+           )
+        {
+          result = false;
+          goto mps_get_period_tuples_EXIT;
+        }
+      /* if */
+
+      // Compute interval boundaries.
+      double stop_max = -std::numeric_limits<double>::infinity();
+      for (int j = 0; j < N; ++j)
+        {
+          stop_max = -std::numeric_limits<double>::infinity();
+          for (int i = 0; i < i_max; ++i)
+            {
+              double const stop = (double)( k->at<int>(j, i) ) * lambda_in[i];
+              if (stop > stop_max) stop_max = stop;
+            }
+          /* for */
+
+          w_min->at<double>(j, 0) = stop_max;
+          if (0 < j) w_max->at<double>(j - 1, 0) = stop_max;
+        }
+      /* for */
+      if (0 < N) w_max->at<double>(N - 1, 0) = width;
+    }
+  /* if */
+
+
+  SAFE_ASSIGN_PTR( k, k_out );
+  if (NULL != width_out) *width_out = width;
+  SAFE_ASSIGN_PTR( w_min, w_min_out );
+  SAFE_ASSIGN_PTR( w_max, w_max_out );
+
+ mps_get_period_tuples_EXIT:
+
+  SAFE_DELETE( k );
+  SAFE_DELETE( w_min );
+  SAFE_DELETE( w_max );
+
+  return result;
+}
+/* mps_get_period_tuples */
+
+
+
+//! Return line equations for chosen set of wavelengths.
+/*!
+  Function computes line equations for a chosen set of wavelengths.
+  Line equations are defined by line direction vector V and particular points X0 on each line.
+  Line direction V is stored as row vector.
+  Particular points X0 are stored as one point per row.
+
+  \param lambda_in      Pointer to wavelengths.
+  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
+  \param V_out          Address where pointer to cv::Mat which stores line direction vector will be placed. May be NULL.
+  \param X0_out         Address where pointer to cv::Mat which stores line points will be placed. May be NULL.
+  \param k_out          Address where pointer to cv::Mat which stores all period tuples will be placed. May be NULL.
+  \param width_out      Address where used maximal width will be stored.
+  \param w_min          Address where pointer to cv::Mat which stores starting boundaries of each segment will be placed. May be NULL.
+  \param w_max          Address where pointer to cv::Mat which stores ending boundaries of each segment will be placed. May be NULL.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+mps_get_lines(
+              std::vector<double> const & lambda_in,
+              double const width_in,
+              cv::Mat * * const V_out,
+              cv::Mat * * const X0_out,
+              cv::Mat * * const k_out,
+              double * const width_out,
+              cv::Mat * * const w_min,
+              cv::Mat * * const w_max
+              )
+{
+  double width = width_in;
+
+  cv::Mat * V = NULL;
+  cv::Mat * X0 = NULL;
+  cv::Mat * k = NULL;
+
+  // Get period tuples.
+  bool result = mps_get_period_tuples(lambda_in, width_in, &k, &width, w_min, w_max);
+  assert( (NULL != k) && (NULL != k->data) && (true == result) );
+
+  // Return immediately if unsuccessfull.
+  if ( (NULL == k) || (NULL == k->data) || (false == result) )
+    {
+      result = false;
+      goto mps_get_lines_EXIT;
+    }
+  /* if */
+
+  // Fetch period-tuple sizes.
+  int const N = k->rows;
+  int const M = k->cols;
+  assert( M == (int)( lambda_in.size() ) );
+
+  double const pi = 3.141592653589793238462643383279502884197169399375;
+  double const tau = 2.0 * pi;
+
+  // Allocate storage on heap.
+  V = new cv::Mat(1, M, CV_64FC1);
+  assert( (NULL != V) && (NULL != V->data) );
+
+  X0 = new cv::Mat(N, M, CV_64FC1);
+  assert( (NULL != X0) && (NULL != X0->data) );
+
+  if ( (NULL == V) || (NULL == V->data) ||
+       (NULL == X0) || (NULL == X0->data)
+       )
+    {
+      result = false;
+      goto mps_get_lines_EXIT;
+    }
+  /* if */
+
+  // Compute points on lines.
+  for (int j = 0; j < N; ++j)
+    {
+      int const * const srcrow = (int *)( (BYTE *)(k->data) + k->step[0] * j );
+      double * const dstrow = (double *)( (BYTE *)(X0->data) + X0->step[0] * j );
+      for (int i = 0; i < M; ++i)
+        {
+          dstrow[i] = -tau * srcrow[i];
+        }
+      /* for */
+    }
+  /* for */
+
+  // Compute line direction vector.
+  {
+    double * const dstrow = (double *)( (BYTE *)(V->data) );
+    for (int i = 0; i < M; ++i)
+      {
+        dstrow[i] = tau / lambda_in[i];
+      }
+    /* for */
+  }
+
+
+  SAFE_ASSIGN_PTR( V, V_out );
+  SAFE_ASSIGN_PTR( X0, X0_out );
+  SAFE_ASSIGN_PTR( k, k_out );
+
+ mps_get_lines_EXIT:
+
+  SAFE_DELETE( V );
+  SAFE_DELETE( X0 );
+  SAFE_DELETE( k );
+
+  return result;
+}
+/* mps_get_lines */
+
+
+
+//! Return wrapped tupples.
+/*!
+  Function computes all wrapped period tuples.
+
+  \param lambda_in      Pointer to wavelengths.
+  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
+  \param k_out          Address where pointer to cv::Mat which stores all wrapped period tuples will be placed. May be NULL.
+  \param width_out      Address where used maximal width will be stored.
+  \param idx_out        Address where pointer to cv::Mat which stores indices into list of all unwrapped period tuples.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+mps_get_wrapped_tuples(
+                       std::vector<double> const & lambda_in,
+                       double const width_in,
+                       cv::Mat * * const k_out,
+                       double * const width_out,
+                       cv::Mat * * const idx_out
+                       )
+{
+  // Set default width.
+  double width = width_in;
+  if ( 0 != _isnan(width_in) )
+    {
+      double const lcm = mps_lcm(lambda_in);
+      double const gcd = mps_gcd(lambda_in);
+      width = lcm / gcd;
+      assert( 0 == _isnan(width) );
+    }
+  /* if */
+
+  bool result = true; // Assume success.
+
+  // Allocate storage on stack.
+  int const i_max = (int)( lambda_in.size() );
+
+  int j = 0;
+  int j_tmp = 0;
+  int const j_step = 100;
+
+  // Allocate storage on heap.
+  cv::Mat * k = new cv::Mat(j_step, i_max, CV_32SC1, cv::Scalar(0));
+  assert( (NULL != k) && (NULL != k->data) );
+
+  cv::Mat * k_tmp = new cv::Mat(j_step, i_max, CV_32SC1, cv::Scalar(0));
+  assert( (NULL != k_tmp) && (NULL != k_tmp->data) );
+
+  cv::Mat * idx = new cv::Mat(j_step, 1, CV_32SC1, cv::Scalar(0));
+  assert( (NULL != idx) && (NULL != idx->data) );
+
+  if ( (NULL == k) || (NULL == k->data) ||
+       (NULL == k_tmp) || (NULL == k_tmp->data) ||
+       (NULL == idx) || (NULL == idx->data)
+       )
+    {
+      result = false;
+      goto mps_get_wrapped_tuples_EXIT;
+    }
+  /* if */
+
+  // Generate first wrapped tuple. The first wrapped tuple covers all
+  // corners of a hyper-cube except ones whose all coordinates are 0 or 2*pi.
+  {
+    assert(i_max < 32);
+    int b = 1;
+    double const b_max_dbl = ldexp(1.0, i_max) - 1.0;
+    assert( b_max_dbl < INT_MAX );
+    int const b_max = (int)( b_max_dbl );
+    while (b < b_max)
+      {
+        // Increase storage if necessary.
+        if (j >= k->rows) k->resize(k->rows + j_step, cv::Scalar(0));
+        if (j >= idx->rows) idx->resize(idx->rows +j_step, cv::Scalar(0));
+
+        // Copy starting tupple and starting index.
+        for (int i = 0; i < i_max; ++i)
+          {
+            k->at<int>(j, i) = k_tmp->at<int>(1, i);
+          }
+        /* for */
+        idx->at<int>(j, 0) = 0;
+
+        // Adjust tupple to obtain wrapped tuple.
+        for (int i = 0; i < i_max; ++i)
+          {
+            int const bitmask = (1 << i);
+            if ( 0 != (b & bitmask) )
+              {
+                k->at<int>(j, i) = k->at<int>(j, i) - 1;
+              }
+            /* if */
+          }
+        /* for */
 
         // Go to next wrapped tuple.
         j = j + 1;
         b = b + 1;
       }
-    /* while */
+    /* while */
+  }
+
+  // Create remainin wrapped tuples.
+  // Note that we first generate regular tuples in k_tmp.
+  {
+    j_tmp = j_tmp + 1;
+
+    std::vector<double> next_boundary(lambda_in);
+    std::vector<int> inc(lambda_in.size(), 0);
+    std::vector<int> I(lambda_in.size(), 0);
+
+    double x = *std::min_element(next_boundary.begin(), next_boundary.end());
+    for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+
+    while ( (x < width) &&
+            (0 < *std::max_element(inc.begin(), inc.end()))
+            )
+      {
+        // Increase storage if necessary.
+        if (j_tmp >= k_tmp->rows) k_tmp->resize(k_tmp->rows + j_step, cv::Scalar(0));
+
+        // Fetch next regular tuple.
+        int const j_tmp_prev = j_tmp - 1;
+        for (int i = 0; i < i_max; ++i)
+          {
+            k_tmp->at<int>(j_tmp, i) = k_tmp->at<int>(j_tmp_prev, i) + inc[i];
+          }
+        /* for */
+
+        // Get next boundary.
+        int s = 0;
+        I.clear();
+        for (int i = 0; i < i_max; ++i)
+          {
+            if (0 < inc[i])
+              {
+                next_boundary[i] += lambda_in[i];
+                ++s;
+                I.push_back(i);
+              }
+            /* if */
+          }
+        /* for */
+
+        // Generate wrapped tuple if boundary jump is at more than one axis.
+        if (1 < s)
+          {
+            assert(s < 32);
+            int b = 1;
+            double const b_max_dbl = ldexp(1.0, s) - 1.0;
+            assert( b_max_dbl < INT_MAX );
+            int const b_max = (int)( b_max_dbl );
+            while (b < b_max)
+              {
+                // Increase storage if necessary.
+                if (j >= k->rows) k->resize(k->rows + j_step, cv::Scalar(0));
+                if (j >= idx->rows) idx->resize(idx->rows +j_step, cv::Scalar(0));
+
+                // Copy starting tupple and starting index.
+                for (int i = 0; i < i_max; ++i)
+                  {
+                    k->at<int>(j, i) = k_tmp->at<int>(j_tmp, i);
+                  }
+                /* for */
+                idx->at<int>(j, 0) = j_tmp;
+
+                // Adjust tupple to obtain wrapped tuple.
+                for (int i = 0; i < s; ++i)
+                  {
+                    int const bitmask = (1 << i);
+                    if ( 0 != (b & bitmask) )
+                      {
+                        int const col = I[i];
+                        k->at<int>(j, col) = k->at<int>(j, col) - 1;
+                      }
+                    /* if */
+                  }
+                /* for */
+
+                // Go to next wrapped tuple.
+                j = j + 1;
+                b = b + 1;
+              }
+            /* while */
+          }
+        /* if */
+
+        // Go to next regular tuple.
+        j_tmp = j_tmp + 1;
+        x = *std::min_element(next_boundary.begin(), next_boundary.end());
+        for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+      }
+    /* while */
+  }
+
+  // Efficiently create new cv::Mat headers for output buffers.
+  int const N = j;
+  if (N != k->rows)
+    {
+      cv::Range r[2] = {cv::Range(0, N), cv::Range::all()};
+
+      cv::Mat * ptr = new cv::Mat(*k, r);
+      assert(NULL != ptr);
+      if (NULL != ptr)
+        {
+          SAFE_DELETE( k );
+          k = ptr;
+          ptr = NULL;
+        }
+      /* if */
+    }
+  /* if */
+
+  int const N_tmp = j_tmp;
+  if (N_tmp != k_tmp->rows)
+    {
+      cv::Range r[2] = {cv::Range(0, N_tmp), cv::Range::all()};
+
+      cv::Mat * ptr = new cv::Mat(*k_tmp, r);
+      assert(NULL != ptr);
+      if (NULL != ptr)
+        {
+          SAFE_DELETE( k_tmp );
+          k_tmp = ptr;
+          ptr = NULL;
+        }
+      /* if */
+    }
+  /* if */
+
+
+  SAFE_ASSIGN_PTR( k, k_out );
+  if (NULL != width_out) *width_out = width;
+  SAFE_ASSIGN_PTR( idx, idx_out);
+
+ mps_get_wrapped_tuples_EXIT:
+
+  SAFE_DELETE( k );
+  SAFE_DELETE( k_tmp );
+  SAFE_DELETE( idx );
+
+  return result;
+}
+/* mps_get_wrapped_tuples */
+
+
+
+//! Returns ortographic projection matrix and projected tuple center points.
+/*!
+  Function computes orthographic projection matrix O, tuple center points Xk,
+  wrapped period-order t.
+
+  \param lambda_in      Pointer to wavelengths.
+  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
+  \param O_out          Address where pointer to cv::Mat which stores orthographic projection matrix will be stored. May be NULL.
+  \param Xk_out         Address where pointer to cv::Mat which stores all period-order tuples center points will be stored. May be NULL.
+  \param kk_out         Address where pointer to cv::Mat which stores all period tuples will be placed. May be NULL.
+  \param Xw_out         Address where pointer to cv::Mat which stores all wrapped period-order tuples center points will be stored. May be NULL.
+  \param kw_out         Address where pointer to cv::Mat which stores all wrapped period tuples will be placed. May be NULL.
+  \param idxw_out       Address where pointer to cv::Mat which stores indices into list of all unwrapped period tuples for each wrapped period tuple. May be NULL.
+  \param width_out      Address where used maximal width will be stored.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+mps_get_projection_matrix_and_centers(
+                                      std::vector<double> const & lambda_in,
+                                      double const width_in,
+                                      cv::Mat * * const O_out,
+                                      cv::Mat * * const Xk_out,
+                                      cv::Mat * * const kk_out,
+                                      cv::Mat * * const Xw_out,
+                                      cv::Mat * * const kw_out,
+                                      cv::Mat * * const idx_out,
+                                      double * const width_out
+                                      )
+{
+  double width = width_in;
+
+  cv::Mat * O = NULL;
+  cv::Mat * Xk = NULL;
+  cv::Mat * kk = NULL;
+  cv::Mat * Xw = NULL;
+  cv::Mat * kw = NULL;
+  cv::Mat * idx = NULL;
+
+  cv::Mat * V = NULL;
+  cv::Mat * X0 = NULL;
+  cv::Mat * X1 = NULL;
+
+  bool result = true; // Assume success.
+
+  // Get lines.
+  bool const get_lines = mps_get_lines(lambda_in, width, &V, &X0, &kk, &width, NULL, NULL);
+  assert(true == get_lines);
+  result = result & get_lines;
+
+  if ( (false == get_lines) ||
+       (NULL == V) || (NULL == V->data) ||
+       (NULL == X0) || (NULL == X0->data) ||
+       (NULL == kk) || (NULL == kk->data)
+       )
+    {
+      result = false;
+      goto mps_get_projection_matrix_and_centers_EXIT;
+    }
+  /* if */
+
+  // Get wrapped-around phase vectors.
+  bool const get_wrapped_tuples = mps_get_wrapped_tuples(lambda_in, width, &kw, &width, &idx);
+  result = result & get_wrapped_tuples;
+
+  if ( (false == get_wrapped_tuples) ||
+       (NULL == kw) || (NULL == kw->data) ||
+       (NULL == idx) || (NULL == idx->data)
+       )
+    {
+      result = false;
+      goto mps_get_projection_matrix_and_centers_EXIT;
+    }
+  /* if */
+
+  int const N0 = kk->rows;
+  int const N1 = kw->rows;
+  int const D = kk->cols;
+  assert( D == kw->cols );
+  assert( D == (int)( lambda_in.size() ) );
+
+  // Allocate space for orthographic projection matrix.
+  O = new cv::Mat(D-1, D, CV_64FC1);
+  assert( (NULL != O) && (NULL != O->data) );
+  if ( (NULL == O) || (NULL == O->data) )
+    {
+      result = false;
+      goto mps_get_projection_matrix_and_centers_EXIT;
+    }
+  /* if */
+
+  // Get projection matrix.
+  {
+    cv::Mat w, u, vt;
+    cv::SVD::compute(*V, w, u, vt, cv::SVD::FULL_UV);
+
+    double const s = w.at<double>(0,0);
+    double const tol = (double)(V->cols) * s * DBL_EPSILON;
+    int const r = ( (s > tol)? 1 : 0 );
+
+    for (int j = 0; j < D - 1; ++j)
+      {
+        assert(j + r < vt.rows);
+        double const * const srcrow = (double *)( (BYTE *)vt.data + vt.step[0] * (j + r) );
+        double * const dstrow = (double *)( (BYTE *)O->data + O->step[0] * j );
+        for (int i = 0; i < D; ++i)
+          {
+            dstrow[i] = srcrow[i];
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+  // Allocate space for projected lines.
+  Xk = new cv::Mat(N0, D - 1, CV_64FC1);
+  assert( (NULL != Xk) && (NULL != Xk->data) );
+  if ( (NULL == Xk) || (NULL == Xk->data) )
+    {
+      result = false;
+      goto mps_get_projection_matrix_and_centers_EXIT;
+    }
+  /* if */
+
+  // Project lines.
+  *Xk = (*X0) * O->t();
+
+  // Allocate space for wrapped lines and their projection.
+  X1 = new cv::Mat(N1, D, CV_64FC1);
+  assert( (NULL != X1) && (NULL != X1->data) );
+
+  Xw = new cv::Mat(N1, D-1, CV_64FC1);
+  assert( (NULL != Xw) && (NULL != Xw->data) );
+
+  if ( (NULL == X1) || (NULL == X1->data) ||
+       (NULL == Xw) || (NULL == Xw->data)
+       )
+    {
+      result = false;
+      goto mps_get_projection_matrix_and_centers_EXIT;
+    }
+  /* if */
+
+  // Compute points on wrapped lines.
+  {
+    double const pi = 3.141592653589793238462643383279502884197169399375;
+    double const tau = 2.0 * pi;
+
+    for (int j = 0; j < N1; ++j)
+      {
+        int const * const srcrow = (int *)( (BYTE *)(kw->data) + kw->step[0] * j );
+        double * const dstrow = (double *)( (BYTE *)(X1->data) + X1->step[0] * j );
+        for (int i = 0; i < D; ++i)
+          {
+            dstrow[i] = -tau * (double)( srcrow[i] );
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+  // Project wrapped lines.
+  *Xw = (*X1) * O->t();
+
+
+  SAFE_ASSIGN_PTR( O, O_out );
+  SAFE_ASSIGN_PTR( Xk, Xk_out );
+  SAFE_ASSIGN_PTR( kk, kk_out );
+  SAFE_ASSIGN_PTR( Xw, Xw_out );
+  SAFE_ASSIGN_PTR( kw, kw_out );
+  SAFE_ASSIGN_PTR( idx, idx_out );
+  if (NULL != width_out) *width_out = width;
+
+ mps_get_projection_matrix_and_centers_EXIT:
+
+  SAFE_DELETE( O );
+  SAFE_DELETE( Xk );
+  SAFE_DELETE( kk );
+  SAFE_DELETE( Xw );
+  SAFE_DELETE( kw );
+  SAFE_DELETE( idx );
+  SAFE_DELETE( V );
+  SAFE_DELETE( X0 );
+  SAFE_DELETE( X1 );
+
+  return result;
+}
+/* mps_get_projection_matrix_and_centers */
+
+
+
+//! Construct KD tree.
+/*!
+  Function consolidates regular and wrapped points and constructs KD tree over them.
+
+  \param kk_in  Pointer to regular period-order vectors.
+  \param Xk_in  Pointer to regular projected constellation lines.
+  \param kw_in  Pointer to wrapped period-order vectors.
+  \param Xw_in  Pointer to wrapped projected constellation lines.
+  \param X_out  Address where the pointer to cv::Mat which holds all constellation points will be stored.
+  \param k_out  Address where the pointer to cv::Mat which holds all period-order vectors will be stored.
+  \param k_max_out  Address where the pointer to vector which holds maximal number of fringes for each wavelength will be stored.
+  \param kd_tree_out    Address where the pointer to KD tree will be stored.
+  May be NULL in which case only constellation points are consolidated.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_get_kd_tree(
+                cv::Mat * const Xk_in,
+                cv::Mat * const kk_in,
+                cv::Mat * const Xw_in,
+                cv::Mat * const kw_in,
+                cv::Mat * * const X_out,
+                cv::Mat * * const k_out,
+                std::vector<int> * * const k_max_out,
+                KDTreeRoot_ * * const kd_tree_out
+                )
+{
+  bool result = true; // Assume success.
+
+  cv::Mat * X = NULL;
+  cv::Mat * k = NULL;
+  std::vector<int> * k_max = NULL;
+  KDTreeRoot * kd_tree = NULL;
+
+  assert( (NULL != Xk_in) && (NULL != Xk_in->data) &&
+          (NULL != kk_in) && (NULL != kk_in->data) &&
+          (NULL != Xw_in) && (NULL != Xw_in->data) &&
+          (NULL != kw_in) && (NULL != kw_in->data)
+          );
+  if ( (NULL == Xk_in) || (NULL == Xk_in->data) ||
+       (NULL == kk_in) || (NULL == kk_in->data) ||
+       (NULL == Xw_in) || (NULL == Xw_in->data) ||
+       (NULL == kw_in) || (NULL == kw_in->data)
+       )
+    {
+      result = false;
+      goto mps_get_kd_tree_EXIT;
+    }
+  /* if */
+
+  int const D = kk_in->cols;
+  assert( D == kw_in->cols );
+  assert( D - 1 == Xk_in->cols );
+  assert( D - 1 == Xw_in->cols );
+  int const Nk = Xk_in->rows;
+  assert( Nk == kk_in->rows );
+  int const Nw = Xw_in->rows;
+  assert( Nw == kw_in->rows );
+  int const N = Nk + Nw;
+
+  // Allocate storage on heap.
+  X = new cv::Mat(N, D - 1, CV_64FC1);
+  assert( (NULL != X) && (NULL != X->data) );
+
+  k = new cv::Mat(N, D, CV_32SC1);
+  assert( (NULL != k) && (NULL != k->data) );
+
+  k_max = new std::vector<int>();
+  assert(NULL != k_max);
+
+  if (NULL != kd_tree_out)
+    {
+      kd_tree = new KDTreeRoot();
+      assert(NULL != kd_tree);
+    }
+  /* if */
+
+  if ( (NULL == X) || (NULL == X->data) ||
+       (NULL == k) || (NULL == k->data) ||
+       (NULL == k_max) || ((NULL != kd_tree_out) && (NULL == kd_tree))
+       )
+    {
+      result = false;
+      goto mps_get_kd_tree_EXIT;
+    }
+  /* if */
+
+  // Consolidate regular and wrapped constellation points.
+  int j = 0;
+  for (; j < Nk; ++j)
+    {
+      double const * const Xk_row = (double *)( (BYTE *)Xk_in->data + Xk_in->step[0] * j );
+      double * const X_row = (double *)( (BYTE *)X->data + X->step[0] * j );
+      for (int i = 0; i < D - 1; ++i) X_row[i] = Xk_row[i];
+    }
+  /* for */
+
+  for (; j < N; ++j)
+    {
+      int const jw = j - Nk;
+      assert( (0 <= jw) && (jw < Xw_in->rows) );
+      double const * const Xw_row = (double *)( (BYTE *)Xw_in->data + Xw_in->step[0] * jw );
+      double * const X_row = (double *)( (BYTE *)X->data + X->step[0] * j );
+      for (int i = 0; i < D - 1; ++i) X_row[i] = Xw_row[i];
+    }
+  /* for */
+
+  if (0 < Nk)
+    {
+      k_max->reserve( (size_t)D );
+      int const * const kk_row = (int *)( (BYTE *)kk_in->data );
+      for (int i = 0; i < D; ++i)
+        {
+          k_max->push_back( kk_row[i] );
+        }
+      /* for */
+      assert( D == (int)( k_max->size() ) );
+    }
+  /* if */
+
+  for (j = 0; j < Nk; ++j)
+    {
+      int const * const kk_row = (int *)( (BYTE *)kk_in->data + kk_in->step[0] * j );
+      int * const k_row = (int *)( (BYTE *)k->data +k->step[0] * j );
+      for (int i = 0; i < D; ++i)
+        {
+          k_row[i] = kk_row[i];
+          if (kk_row[i] > (*k_max)[i])
+            {
+              (*k_max)[i] = kk_row[i];
+            }
+          /* if */
+        }
+      /* for */
+    }
+  /* for */
+
+  for (; j < N; ++j)
+    {
+      int const jw = j - Nk;
+      assert( (0 <= jw) && (jw < kw_in->rows) );
+      int const * const kw_row = (int *)( (BYTE *)kw_in->data + kw_in->step[0] * jw );
+      int * const k_row = (int *)( (BYTE *)k->data + k->step[0] * j );
+      for (int i = 0; i < D; ++i) k_row[i] = kw_row[i];
+    }
+  /* for */
+
+  // Construct KD tree.
+  if (NULL != kd_tree)
+    {
+      double const * const data = (double *)( X->data );
+      bool const construct = kd_tree->ConstructTree(data, D-1, N, (int)(X->step[0]));
+      assert(true == construct);
+      result = result && construct;
+    }
+  /* if */
+
+
+  SAFE_ASSIGN_PTR( X, X_out );
+  SAFE_ASSIGN_PTR( k, k_out );
+  SAFE_ASSIGN_PTR( k_max, k_max_out );
+  SAFE_ASSIGN_PTR( kd_tree, kd_tree_out );
+
+ mps_get_kd_tree_EXIT:
+
+  SAFE_DELETE( X );
+  SAFE_DELETE( k );
+  SAFE_DELETE( k_max );
+  SAFE_DELETE( kd_tree );
+
+  return result;
+}
+/* mps_get_kd_tree */
+
+
+
+/****** MPS GRID LOOKUP TABLE ******/
+
+//! Constructor.
+/*!
+  Creates empty grid lookup table.
+*/
+MPSGridLUT_::MPSGridLUT_()
+{
+  this->Blank();
+}
+/* MPSGridLUT_::MPSGridLUT_ */
+
+
+
+//! Destructor.
+/*!
+  Deletes grid lookup table.
+*/
+MPSGridLUT_::~MPSGridLUT_()
+{
+  SAFE_DELETE_ARRAY( this->points );
+  SAFE_DELETE_ARRAY( this->cell_begin );
+  SAFE_DELETE_ARRAY( this->labels );
+  this->Blank();
+}
+/* MPSGridLUT_::~MPSGridLUT_ */
+
+
+
+//! Blank class variables.
+/*!
+  Initializes all class variables.
+*/
+void
+MPSGridLUT_::Blank(
+                   void
+                   )
+{
+  this->n_dim = 0;
+  this->n_bins[0] = 0;
+  this->n_bins[1] = 0;
+  this->origin[0] = 0.0;
+  this->origin[1] = 0.0;
+  this->inv_cell = 0.0;
+
+  this->n_pts = 0;
+  this->points = NULL;
+
+  this->cell_begin = NULL;
+  this->labels = NULL;
+}
+/* MPSGridLUT_::Blank */
+
+
+
+//! Finds closest constellation point.
+/*!
+  Returns index of the constellation point closest to the query point.
+  Only the Voronoi labels of the cell which contains the query point are tested;
+  as labels of a cell include all points which may be closest to any point inside
+  the cell the result is exact. Query points outside of the grid are clamped
+  to the nearest border cell; such points may only be produced by non-finite
+  wrapped phases. 1D grids have only one row of cells so the second
+  coordinate is always clamped to zero and the same code handles both cases.
+
+  \param lut    Pointer to grid lookup table.
+  \param query  Pointer to query point.
+  \param dst2_out       Address where the squared distance to the closest point will be stored.
+  \return Returns index of the closest constellation point.
+*/
+inline
+int
+mps_grid_lut_lookup_inline(
+                           MPSGridLUT const * const lut,
+                           double const * const query,
+                           double * const dst2_out
+                           )
+{
+  assert(NULL != lut);
+  assert(NULL != query);
+  assert(NULL != dst2_out);
+
+  double const max_x = (double)( lut->n_bins[0] - 1 );
+  double const max_y = (double)( lut->n_bins[1] - 1 );
+
+  double const qx = query[0];
+  double const qy = (2 == lut->n_dim)? query[1] : 0.0;
+
+  double fx = (qx - lut->origin[0]) * lut->inv_cell;
+  double fy = (qy - lut->origin[1]) * lut->inv_cell;
+
+  // Clamp to grid; compiles to min/max instructions.
+  fx = (fx > 0.0)? fx : 0.0;
+  fy = (fy > 0.0)? fy : 0.0;
+  fx = (fx < max_x)? fx : max_x;
+  fy = (fy < max_y)? fy : max_y;
+
+  int const cell = (int)( fy ) * lut->n_bins[0] + (int)( fx );
+  int const k_begin = lut->cell_begin[cell];
+  int const k_end = lut->cell_begin[cell + 1];
+  assert(k_begin < k_end);
+
+  // Test all labels of the cell; most cells have exactly one label.
+  int best_idx = lut->labels[k_begin];
+  double best_dst2 = std::numeric_limits<double>::infinity();
+  for (int k = k_begin; k < k_end; ++k)
+    {
+      int const idx = lut->labels[k];
+      double const dx = qx - lut->points[2 * idx];
+      double const dy = qy - lut->points[2 * idx + 1];
+      double const dst2 = dx * dx + dy * dy;
+      best_idx = (dst2 < best_dst2)? idx : best_idx;
+      best_dst2 = (dst2 < best_dst2)? dst2 : best_dst2;
+    }
+  /* for */
+
+  *dst2_out = best_dst2;
+
+  return best_idx;
+}
+/* mps_grid_lut_lookup_inline */
+
+
+
+//! Construct grid lookup table.
+/*!
+  Function constructs uniform grid over the bounded domain of projected wrapped phases.
+  The domain is the projection of the hypercube [0, 2pi]^D extended to include all
+  constellation points. Cell size is chosen so half of the cell diagonal h equals
+  one half of the minimal half-distance between constellation points.
+
+  For each cell the distance d from the cell center to the closest constellation
+  point is computed and all constellation points not farther than d + 2h from the
+  cell center are stored as Voronoi labels of the cell. By the triangle inequality
+  the closest constellation point of any query inside the cell is among the labels,
+  so lookups are exact and no KD tree is required. Labels are computed by exhaustive
+  search; this is done once per plan.
+
+  Grid is only constructed for 1D and 2D constellations and only if the number of cells
+  does not exceed MPS_GRID_LUT_MAX_CELLS. Otherwise the function succeeds but no
+  lookup table is returned and the KD tree should be used instead.
+
+  \param O_in   Pointer to orthographic projection matrix.
+  \param X_in   Pointer to points in constellation.
+  \param lut_out        Address where the pointer to grid lookup table will be stored.
+  If the grid is not used then the stored value is not changed.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_get_grid_lut(
+                 cv::Mat * const O_in,
+                 cv::Mat * const X_in,
+                 MPSGridLUT_ * * const lut_out
+                 )
+{
+  bool result = true; // Assume success.
+
+  MPSGridLUT * lut = NULL;
+  std::vector<int> labels;
+
+  double lo[2] = {0.0, 0.0}; // Lower corner of the domain.
+  double hi[2] = {0.0, 0.0}; // Upper corner of the domain.
+
+  assert( (NULL != O_in) && (NULL != O_in->data) &&
+          (NULL != X_in) && (NULL != X_in->data)
+          );
+  if ( (NULL == O_in) || (NULL == O_in->data) ||
+       (NULL == X_in) || (NULL == X_in->data)
+       )
+    {
+      result = false;
+      goto mps_get_grid_lut_EXIT;
+    }
+  /* if */
+
+  int const n_dim = O_in->rows;
+  int const D = O_in->cols;
+  int const N = X_in->rows;
+  assert( n_dim == X_in->cols );
+
+  // Use grid only for low-dimensional constellations.
+  if ( (1 != n_dim) && (2 != n_dim) ) goto mps_get_grid_lut_EXIT;
+  if (1 > N) goto mps_get_grid_lut_EXIT;
+
+  lut = new MPSGridLUT();
+  assert(NULL != lut);
+  if (NULL == lut)
+    {
+      result = false;
+      goto mps_get_grid_lut_EXIT;
+    }
+  /* if */
+
+  lut->n_dim = n_dim;
+  lut->n_pts = N;
+  lut->points = new double[2 * N];
+  assert(NULL != lut->points);
+  if (NULL == lut->points)
+    {
+      result = false;
+      goto mps_get_grid_lut_EXIT;
+    }
+  /* if */
+
+  // Copy constellation points.
+  for (int j = 0; j < N; ++j)
+    {
+      double const * const X_row = (double *)( (BYTE *)X_in->data + X_in->step[0] * j );
+      lut->points[2 * j] = X_row[0];
+      lut->points[2 * j + 1] = (2 == n_dim)? X_row[1] : 0.0;
+    }
+  /* for */
+
+  // Find minimal half-distance between constellation points.
+  double min_dst2 = std::numeric_limits<double>::infinity();
+  for (int j = 0; j < N; ++j)
+    {
+      for (int i = j + 1; i < N; ++i)
+        {
+          double const dx = lut->points[2 * j] - lut->points[2 * i];
+          double const dy = lut->points[2 * j + 1] - lut->points[2 * i + 1];
+          double const dst2 = dx * dx + dy * dy;
+          if (dst2 < min_dst2) min_dst2 = dst2;
+        }
+      /* for */
+    }
+  /* for */
+
+  double const min_half_dst = 0.5 * sqrt(min_dst2);
+  if ( !(0.0 < min_half_dst) || !(min_half_dst < std::numeric_limits<double>::infinity()) ) goto mps_get_grid_lut_EXIT;
+
+  double const cell = min_half_dst / sqrt( (double)(n_dim) );
+  double const half_diagonal = 0.5 * cell * sqrt( (double)(n_dim) );
+
+  // Find bounding box of the domain.
+  {
+    double const pi = 3.141592653589793238462643383279502884197169399375;
+
+    for (int r = 0; r < n_dim; ++r)
+      {
+        double const * const O_row = (double *)( (BYTE *)O_in->data + O_in->step[0] * r );
+        for (int d = 0; d < D; ++d)
+          {
+            double const v = 2.0 * pi * O_row[d];
+            if (v < 0.0) lo[r] += v;
+            if (v > 0.0) hi[r] += v;
+          }
+        /* for */
+      }
+    /* for */
+
+    for (int j = 0; j < N; ++j)
+      {
+        for (int r = 0; r < n_dim; ++r)
+          {
+            double const v = lut->points[2 * j + r];
+            if (v < lo[r]) lo[r] = v;
+            if (v > hi[r]) hi[r] = v;
+          }
+        /* for */
+      }
+    /* for */
   }
 
-  // Create remainin wrapped tuples.
-  // Note that we first generate regular tuples in k_tmp.
+  // Compute grid size.
   {
-    j_tmp = j_tmp + 1;
+    double n_cells = 1.0;
+    int n_bins[2] = {1, 1};
+    for (int r = 0; r < n_dim; ++r)
+      {
+        lo[r] -= cell;
+        hi[r] += cell;
+        double const n_bins_r = ceil( (hi[r] - lo[r]) / cell );
+        n_cells *= n_bins_r;
+        if ( (double)(MPS_GRID_LUT_MAX_CELLS) < n_cells ) goto mps_get_grid_lut_EXIT;
+        n_bins[r] = (int)( n_bins_r );
+      }
+    /* for */
 
-    std::vector<double> next_boundary(lambda_in);
-    std::vector<int> inc(lambda_in.size(), 0);
-    std::vector<int> I(lambda_in.size(), 0);
+    lut->n_bins[0] = n_bins[0];
+    lut->n_bins[1] = n_bins[1];
+    lut->origin[0] = lo[0];
+    lut->origin[1] = (2 == n_dim)? lo[1] : 0.0;
+    lut->inv_cell = 1.0 / cell;
+
+    lut->cell_begin = new int[ n_bins[0] * n_bins[1] + 1 ];
+    assert(NULL != lut->cell_begin);
+    if (NULL == lut->cell_begin)
+      {
+        result = false;
+        goto mps_get_grid_lut_EXIT;
+      }
+    /* if */
+  }
+
+  // Find Voronoi labels of each cell.
+  {
+    labels.reserve( (size_t)( lut->n_bins[0] ) * (size_t)( lut->n_bins[1] ) );
+
+    for (int y = 0; y < lut->n_bins[1]; ++y)
+      {
+        int * const cell_row = lut->cell_begin + y * lut->n_bins[0];
+        double const cy = (2 == n_dim)? lut->origin[1] + cell * ( (double)(y) + 0.5 ) : 0.0;
+
+        for (int x = 0; x < lut->n_bins[0]; ++x)
+          {
+            double const cx = lut->origin[0] + cell * ( (double)(x) + 0.5 );
+
+            // Find the closest and the second closest constellation point.
+            int idx1 = 0;
+            double d1_2 = std::numeric_limits<double>::infinity();
+            double d2_2 = std::numeric_limits<double>::infinity();
+            for (int j = 0; j < N; ++j)
+              {
+                double const dx = cx - lut->points[2 * j];
+                double const dy = cy - lut->points[2 * j + 1];
+                double const dst2 = dx * dx + dy * dy;
+                if (dst2 < d1_2)
+                  {
+                    d2_2 = d1_2;
+                    d1_2 = dst2;
+                    idx1 = j;
+                  }
+                else if (dst2 < d2_2)
+                  {
+                    d2_2 = dst2;
+                  }
+                /* if */
+              }
+            /* for */
+
+            // Slightly enlarge the search radius so rounding errors cannot drop a label.
+            double const radius = ( sqrt(d1_2) + 2.0 * half_diagonal ) * (1.0 + 1.0e-9);
+            double const radius2 = radius * radius;
+
+            cell_row[x] = (int)( labels.size() );
+            if (d2_2 > radius2)
+              {
+                // Cell lies inside one Voronoi region.
+                labels.push_back(idx1);
+              }
+            else
+              {
+                for (int j = 0; j < N; ++j)
+                  {
+                    double const dx = cx - lut->points[2 * j];
+                    double const dy = cy - lut->points[2 * j + 1];
+                    double const dst2 = dx * dx + dy * dy;
+                    if (dst2 <= radius2) labels.push_back(j);
+                  }
+                /* for */
+              }
+            /* if */
+            assert( cell_row[x] < (int)( labels.size() ) );
+          }
+        /* for */
+      }
+    /* for */
+
+    lut->cell_begin[ lut->n_bins[0] * lut->n_bins[1] ] = (int)( labels.size() );
+
+    lut->labels = new int[ labels.size() ];
+    assert(NULL != lut->labels);
+    if (NULL == lut->labels)
+      {
+        result = false;
+        goto mps_get_grid_lut_EXIT;
+      }
+    /* if */
+
+    std::copy(labels.begin(), labels.end(), lut->labels);
+  }
+
+  if (true == result) SAFE_ASSIGN_PTR( lut, lut_out );
+
+ mps_get_grid_lut_EXIT:
+
+  SAFE_DELETE( lut );
+
+  return result;
+}
+/* mps_get_grid_lut */
+
+
+
+//! Return standard weights.
+/*!
+  Returns standard weights for MPS unwrapping.
+
+  \param lambda_in      Vector of used wavelengths.
+  \param wgt_out     Address where pointer to computed weights will be stored.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_get_weights(
+                std::vector<double> const & lambda_in,
+                std::vector<double> * * const wgt_out
+                )
+{
+  bool result = false; // Assume failure.
+
+  std::vector<double> * wgt = new std::vector<double>(lambda_in.size());
+  assert(NULL != wgt);
+  if (NULL != wgt)
+    {
+      int const i_max = (int)( lambda_in.size() );
+      for (int i = 0; i < i_max; ++i)
+        {
+          (*wgt)[i] = 1.0 / ( lambda_in[i] * lambda_in[i] );
+        }
+      /* for */
+
+      result = true;
+    }
+  /* if */
+
+  SAFE_ASSIGN_PTR( wgt, wgt_out );
+  SAFE_DELETE( wgt );
+
+  return result;
+}
+/* mps_get_weights */
+
+
+
+//! Band height (in rows) of one parallel work unit of the MPS nearest-constellation search.
+#define MPS_KD_SEARCH_BAND_HEIGHT 8
+
+//! Number of query points processed in one batch of the MPS nearest-constellation search.
+#define MPS_KD_SEARCH_BATCH_SIZE 256
+
+
+
+//! Parallel body of the fused MPS phase unwrapping.
+/*!
+  Each invocation processes a band of rows of the interleaved wrapped phase
+  image. Every row is split into batches of MPS_KD_SEARCH_BATCH_SIZE pixels
+  and each batch is processed in three steps:
+  the orthographic projection of wrapped phases is computed into a small
+  per-thread buffer, the closest constellation point is found for every query
+  in pixel order, and finally the wrapped phases are unwrapped and combined
+  into the absolute phase.
+  Each thread uses its own KDTreeClosestPoint.
+
+  If grid lookup table is given then the second step is a grid lookup
+  which is exact so the KD tree is not used at all.
+
+  Otherwise every query first checks the closest point of the previous query
+  (hit or traversal alike) and traverses the KD tree only if that check fails.
+  A warm-start match is accepted only if it is closer than the half of
+  the minimal distance between constellation points; such match is unique so
+  the result does not depend on the processing order and is identical to the
+  result of the serial search.
+
+  Template parameter sets the precision of wrapped phases, of the projection,
+  and of the phase combination; KD tree queries are always in double precision.
+*/
+template <typename T>
+struct mps_unwrap_phase_parallel_ : public cv::ParallelLoopBody
+{
+  KDTreeRoot * kd_tree; //!< KD tree constructed over the constellation; may be NULL if grid lookup table is given.
+  MPSGridLUT const * lut; //!< Grid lookup table; may be NULL.
+  cv::Mat * WP; //!< Interleaved wrapped phases (CV_64FC(D) or CV_32FC(D)).
+  T const * O; //!< Orthographic projection matrix; (D-1) x D, row-major.
+  T const * kpi; //!< Phase offsets for each period-order vector; K x D, row-major.
+  T const * scl; //!< Scaling factors used to combine unwrapped phases.
+  cv::Mat * idx; //!< Output indices into period-order vectors.
+  cv::Mat * dst; //!< Output distances to the closest constellation point.
+  cv::Mat * abs_phase; //!< Output unwrapped phase.
+
+  //! Constructor.
+  mps_unwrap_phase_parallel_(
+                             KDTreeRoot * const kd_tree_in,
+                             MPSGridLUT const * const lut_in,
+                             cv::Mat * const WP_in,
+                             T const * const O_in,
+                             T const * const kpi_in,
+                             T const * const scl_in,
+                             cv::Mat * const idx_in,
+                             cv::Mat * const dst_in,
+                             cv::Mat * const abs_phase_in
+                             )
+  {
+    this->kd_tree = kd_tree_in;
+    this->lut = lut_in;
+    this->WP = WP_in;
+    this->O = O_in;
+    this->kpi = kpi_in;
+    this->scl = scl_in;
+    this->idx = idx_in;
+    this->dst = dst_in;
+    this->abs_phase = abs_phase_in;
+  }
 
-    double x = *std::min_element(next_boundary.begin(), next_boundary.end());
-    for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+  //! Processes a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    KDTreeClosestPoint best;
+    double query[MPS_KD_SEARCH_BATCH_SIZE * (MPS_MAX_WAVELENGTHS - 1)];
 
-    while ( (x < width) &&
-            (0 < *std::max_element(inc.begin(), inc.end()))
-            )
+    int const n_cols = this->idx->cols;
+    int const D = this->WP->channels();
+    int const M = D - 1;
+
+    for (int j = r.start; j < r.end; ++j)
       {
-        // Increase storage if necessary.
-        if (j_tmp >= k_tmp->rows) k_tmp->resize(k_tmp->rows + j_step, cv::Scalar(0));
+        T const * const wp_row = (T *)( (BYTE *)this->WP->data + this->WP->step[0] * j );
+        int * const idx_row = (int *)( (BYTE *)this->idx->data + this->idx->step[0] * j );
+        float * const dst_row = (float *)( (BYTE *)this->dst->data + this->dst->step[0] * j );
+        double * const abs_phase_row = (double *)( (BYTE *)this->abs_phase->data + this->abs_phase->step[0] * j );
 
-        // Fetch next regular tuple.
-        int const j_tmp_prev = j_tmp - 1;
-        for (int i = 0; i < i_max; ++i)
+        for (int i0 = 0; i0 < n_cols; i0 += MPS_KD_SEARCH_BATCH_SIZE)
           {
-            k_tmp->at<int>(j_tmp, i) = k_tmp->at<int>(j_tmp_prev, i) + inc[i];
-          }
-        /* for */
+            int const i1 = (MPS_KD_SEARCH_BATCH_SIZE < n_cols - i0)? i0 + MPS_KD_SEARCH_BATCH_SIZE : n_cols;
 
-        // Get next boundary.
-        int s = 0;
-        I.clear();
-        for (int i = 0; i < i_max; ++i)
-          {
-            if (0 < inc[i])
+            // Apply orthographic projection.
+            for (int i = i0; i < i1; ++i)
               {
-                next_boundary[i] += lambda_in[i];
-                ++s;
-                I.push_back(i);
+                T const * const wrapped_phase = wp_row + D * i;
+                double * const q = query + M * (i - i0);
+                for (int m = 0; m < M; ++m)
+                  {
+                    T const * const O_row = this->O + D * m;
+                    T sum = 0;
+                    for (int d = 0; d < D; ++d) sum += O_row[d] * wrapped_phase[d];
+                    q[m] = (double)( sum );
+                  }
+                /* for */
               }
-            /* if */
-          }
-        /* for */
+            /* for */
 
-        // Generate wrapped tuple if boundary jump is at more than one axis.
-        if (1 < s)
-          {
-            assert(s < 32);
-            int b = 1;
-            double const b_max_dbl = ldexp(1.0, s) - 1.0;
-            assert( b_max_dbl < INT_MAX );
-            int const b_max = (int)( b_max_dbl );
-            while (b < b_max)
+            if (NULL != this->lut)
               {
-                // Increase storage if necessary.
-                if (j >= k->rows) k->resize(k->rows + j_step, cv::Scalar(0));
-                if (j >= idx->rows) idx->resize(idx->rows +j_step, cv::Scalar(0));
-
-                // Copy starting tupple and starting index.
-                for (int i = 0; i < i_max; ++i)
+                // Find closest points using the grid lookup table.
+                for (int i = i0; i < i1; ++i)
                   {
-                    k->at<int>(j, i) = k_tmp->at<int>(j_tmp, i);
+                    double dst2 = 0.0;
+                    idx_row[i] = mps_grid_lut_lookup_inline(this->lut, query + M * (i - i0), &dst2);
+                    dst_row[i] = (float)( sqrt( dst2 ) );
                   }
                 /* for */
-                idx->at<int>(j, 0) = j_tmp;
-
-                // Adjust tupple to obtain wrapped tuple.
-                for (int i = 0; i < s; ++i)
+              }
+            else
+              {
+                // Find closest points; Find1NN first checks the closest point of the previous query.
+                for (int i = i0; i < i1; ++i)
                   {
-                    int const bitmask = (1 << i);
-                    if ( 0 != (b & bitmask) )
-                      {
-                        int const col = I[i];
-                        k->at<int>(j, col) = k->at<int>(j, col) - 1;
-                      }
-                    /* if */
+                    best.query = query + M * (i - i0);
+
+                    bool const find = this->kd_tree->Find1NN(best);
+                    assert(true == find);
+
+                    idx_row[i] = best.idx;
+                    dst_row[i] = (float)( sqrt( best.dst2 ) );
                   }
                 /* for */
+              }
+            /* if */
 
-                // Go to next wrapped tuple.
-                j = j + 1;
-                b = b + 1;
+            // Unwrap phase. Note that we combine all unwrapped phases using given weights.
+            for (int i = i0; i < i1; ++i)
+              {
+                T const * const wrapped_phase = wp_row + D * i;
+                T const * const phase_offset = this->kpi + D * idx_row[i];
+                T sum = 0;
+                for (int d = 0; d < D; ++d) sum += this->scl[d] * ( wrapped_phase[d] + phase_offset[d] );
+                abs_phase_row[i] = (double)( sum );
               }
-            /* while */
+            /* for */
           }
-        /* if */
-
-        // Go to next regular tuple.
-        j_tmp = j_tmp + 1;
-        x = *std::min_element(next_boundary.begin(), next_boundary.end());
-        for (int i = 0; i < i_max; ++i) inc[i] = (next_boundary[i] <= x)? 1 : 0;
+        /* for */
       }
-    /* while */
+    /* for */
   }
 
-  // Efficiently create new cv::Mat headers for output buffers.
-  int const N = j;
-  if (N != k->rows)
+};
+/* mps_unwrap_phase_parallel_ */
+
+
+
+//! Unwraps phase using orthographic projection.
+/*!
+  Function unwraps wrapped phases using orthographic projection.
+
+  Wrapped phases are given as one interleaved (pixel-major) image of type CV_64FC(D)
+  where D is the number of wavelengths; such image is produced by calling
+  EstimateRelativePhaseTiledInterleaved function once for each wavelength.
+  Orthographic projection, nearest-constellation search, and combination of
+  unwrapped phases are fused into one parallel pass so no temporary
+  arrays of the image size are allocated.
+
+  If wrapped phases are of type CV_32FC(D) then projection and combination of
+  unwrapped phases are computed in single precision. This halves the memory
+  traffic; the accuracy loss may be measured using ValidateMPSSinglePrecision.
+  The absolute phase is always returned in double precision.
+
+  \param WP_in  Interleaved wrapped phases of type CV_64FC(D) or CV_32FC(D); channel order must correspond to
+  wavelength order used to construct the orthographic projection matrix O_in, constellation X_in, and KD tree kd_tree_in.
+  \param O_in   Pointer to orthographic projection matrix.
+  \param X_in   Pointer to points in constellation.
+  \param k_in   Pointer to period-order numbers.
+  \param kd_tree_in     Pointer to KD tree constructed over the constellation X_in. May be NULL if lut_in is given.
+  \param lut_in Pointer to grid lookup table constructed over the constellation X_in. May be NULL in which case KD tree is used.
+  \param n      Vector of maximal frige counts for each wavelength.
+  \param wgt    Vector of weights used to combine wrapped phases into absolute phase.
+  \param idx    Address where cv::Mat holding indices into period-order vectors will be stored. May be NULL.
+  \param dst    Address where cv::Mat holding distance to closest constellation point will be stored. May be NULL.
+  \param abs_phase_out  Address where cv::Mat holding unwrapped phase will be stored. May be NULL.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_unwrap_phase(
+                 cv::Mat * const WP_in,
+                 cv::Mat * const O_in,
+                 cv::Mat * const X_in,
+                 cv::Mat * const k_in,
+                 KDTreeRoot * const kd_tree_in,
+                 MPSGridLUT const * const lut_in,
+                 std::vector<double> const & n_in,
+                 std::vector<double> const & wgt_in,
+                 cv::Mat * * const idx_out,
+                 cv::Mat * * const dst_out,
+                 cv::Mat * * const abs_phase_out
+                 )
+{
+  bool result = true; // Assume success.
+
+  cv::Mat * idx = NULL;
+  cv::Mat * dst = NULL;
+  cv::Mat * abs_phase = NULL;
+
+  assert( (NULL != WP_in) && (NULL != WP_in->data) &&
+          (NULL != O_in) && (NULL != O_in->data) &&
+          (NULL != X_in) && (NULL != X_in->data) &&
+          (NULL != k_in) && (NULL != k_in->data) &&
+          ( (NULL != lut_in) || ((NULL != kd_tree_in) && (NULL != kd_tree_in->data)) )
+          );
+  if ( (NULL == WP_in) || (NULL == WP_in->data) ||
+       (NULL == O_in) || (NULL == O_in->data) ||
+       (NULL == X_in) || (NULL == X_in->data) ||
+       (NULL == k_in) || (NULL == k_in->data) ||
+       ( (NULL == lut_in) && ((NULL == kd_tree_in) || (NULL == kd_tree_in->data)) )
+       )
     {
-      cv::Range r[2] = {cv::Range(0, N), cv::Range::all()};
+      result = false;
+      goto mps_unwrap_phase_EXIT;
+    }
+  /* if */
 
-      cv::Mat * ptr = new cv::Mat(*k, r);
-      assert(NULL != ptr);
-      if (NULL != ptr)
-        {
-          SAFE_DELETE( k );
-          k = ptr;
-          ptr = NULL;
-        }
-      /* if */
+  int const D = WP_in->channels();
+  int const n_rows = WP_in->rows;
+  int const n_cols = WP_in->cols;
+  assert( D == O_in->cols );
+  assert( D - 1 == O_in->rows );
+  assert( D - 1 == X_in->cols );
+  assert( D == k_in->cols );
+  assert( X_in->rows == k_in->rows );
+  assert( (NULL == kd_tree_in) || (D - 1 == kd_tree_in->n_dim) );
+  assert( (NULL == kd_tree_in) || (X_in->rows == kd_tree_in->n_pts) );
+  assert( (NULL == kd_tree_in) || ((void *)kd_tree_in->data == (void *)X_in->data) );
+  assert( D == (int)( n_in.size() ) );
+  assert( D == (int)( wgt_in.size() ) );
+  assert( (NULL == lut_in) || ((D - 1 == lut_in->n_dim) && (X_in->rows == lut_in->n_pts)) );
+
+  // Validate input wrapped phases.
+  assert( ((CV_64F == WP_in->depth()) || (CV_32F == WP_in->depth())) && (2 <= D) && (D <= MPS_MAX_WAVELENGTHS) );
+  if ( ((CV_64F != WP_in->depth()) && (CV_32F != WP_in->depth())) || (2 > D) || (D > MPS_MAX_WAVELENGTHS) )
+    {
+      result = false;
+      goto mps_unwrap_phase_EXIT;
     }
   /* if */
 
-  int const N_tmp = j_tmp;
-  if (N_tmp != k_tmp->rows)
+  assert( (D == O_in->cols) && (D - 1 == O_in->rows) && (D == k_in->cols) );
+  if ( (D != O_in->cols) || (D - 1 != O_in->rows) || (D != k_in->cols) )
     {
-      cv::Range r[2] = {cv::Range(0, N_tmp), cv::Range::all()};
+      result = false;
+      goto mps_unwrap_phase_EXIT;
+    }
+  /* if */
+
+  // Allocate required space.
+  idx = new cv::Mat(n_rows, n_cols, CV_32SC1);
+  assert( (NULL != idx) && (NULL != idx->data) );
+
+  dst = new cv::Mat(n_rows, n_cols, CV_32FC1);
+  assert( (NULL != dst) && (NULL != dst->data) );
+
+  abs_phase = new cv::Mat(n_rows, n_cols, CV_64FC1);
+  assert( (NULL != abs_phase) && (NULL != abs_phase->data) );
+
+  if ( (NULL == idx) || (NULL == idx->data) ||
+       (NULL == dst) || (NULL == dst->data) ||
+       (NULL == abs_phase) || (NULL == abs_phase->data)
+       )
+    {
+      result = false;
+      goto mps_unwrap_phase_EXIT;
+    }
+  /* if */
+
+  // Project, find period-order number, and unwrap phase for each point; bands of rows are processed in parallel.
+  {
+    // Copy orthographic projection matrix into a contiguous array.
+    double O[(MPS_MAX_WAVELENGTHS - 1) * MPS_MAX_WAVELENGTHS];
+    for (int j = 0; j < D - 1; ++j)
+      {
+        double const * const srcrow = (double *)( (BYTE *)O_in->data + O_in->step[0] * j );
+        for (int i = 0; i < D; ++i) O[D * j + i] = srcrow[i];
+      }
+    /* for */
+
+    // Precompute required phase-offsets for each period-order vector.
+    double const pi = 3.141592653589793238462643383279502884197169399375;
+    cv::Mat kpi(k_in->rows, k_in->cols, CV_64FC1);
+    for (int j = 0; j < k_in->rows; ++j)
+      {
+        int const * const srcrow = (int *)( (BYTE *)k_in->data + k_in->step[0] * j );
+        double * const dstrow = (double *)( (BYTE *)kpi.data + kpi.step[0] * j );
+        for (int i = 0; i < k_in->cols; ++i)
+          {
+            dstrow[i] = (2.0 * pi) * (double)( srcrow[i] );
+          }
+        /* for */
+      }
+    /* for */
+    assert( sizeof(double) * D == kpi.step[0] );
+
+    // Precompute scaling factors used to combine multiple unwrapped phases.
+    double scl[MPS_MAX_WAVELENGTHS];
+    double const wgt_sum = std::accumulate(wgt_in.begin(), wgt_in.end(), 0.0);
+    for (int d = 0; d < D; ++d)
+      {
+        scl[d] = wgt_in[d] / (2.0 * pi * wgt_sum * n_in[d]);
+      }
+    /* for */
+
+    if (CV_64F == WP_in->depth())
+      {
+        mps_unwrap_phase_parallel_<double> body(kd_tree_in, lut_in, WP_in, O, (double *)( kpi.data ), scl, idx, dst, abs_phase);
+        cv::parallel_for_( cv::Range(0, n_rows), body, (double)(n_rows) / (double)(MPS_KD_SEARCH_BAND_HEIGHT) );
+      }
+    else
+      {
+        // Convert all parameters to single precision.
+        float O_single[(MPS_MAX_WAVELENGTHS - 1) * MPS_MAX_WAVELENGTHS];
+        for (int i = 0; i < (D - 1) * D; ++i) O_single[i] = (float)( O[i] );
+
+        float scl_single[MPS_MAX_WAVELENGTHS];
+        for (int d = 0; d < D; ++d) scl_single[d] = (float)( scl[d] );
+
+        cv::Mat kpi_single;
+        kpi.convertTo(kpi_single, CV_32F);
+        assert( sizeof(float) * D == kpi_single.step[0] );
+
+        mps_unwrap_phase_parallel_<float> body(kd_tree_in, lut_in, WP_in, O_single, (float *)( kpi_single.data ), scl_single, idx, dst, abs_phase);
+        cv::parallel_for_( cv::Range(0, n_rows), body, (double)(n_rows) / (double)(MPS_KD_SEARCH_BAND_HEIGHT) );
+      }
+    /* if */
+  }
+
+
+  SAFE_ASSIGN_PTR( idx, idx_out );
+  SAFE_ASSIGN_PTR( dst, dst_out );
+  SAFE_ASSIGN_PTR( abs_phase, abs_phase_out );
+
+ mps_unwrap_phase_EXIT:
+
+  SAFE_DELETE( idx );
+  SAFE_DELETE( dst );
+  SAFE_DELETE( abs_phase );
+
+  return result;
+}
+/* mps_unwrap_phase */
+
+
+
+/****** MPS UNWRAPPING PLAN ******/
+
+//! Identifier of the MPS plan file ("MPSP").
+#define MPS_PLAN_FILE_MAGIC 0x5053504D
+
+//! Version of the MPS plan file format.
+#define MPS_PLAN_FILE_VERSION 2
+
+//! Size of the buffer used to hash the geometry XML file.
+#define MPS_PLAN_HASH_BUFFER_SIZE 4096
+
+
+
+//! Cache of MPS unwrapping plans.
+static std::vector<MPSPlan *> gMPSPlanCache;
+
+//! Slim Reader/Writer lock for MPS plan cache.
+static SRWLOCK gMPSPlanCacheLock = SRWLOCK_INIT;
+
+//! Slim Reader/Writer lock which serializes construction of MPS plans so concurrent reconstructions do not build or write the same plan twice.
+static SRWLOCK gMPSPlanBuildLock = SRWLOCK_INIT;
+
+
+
+//! Constructor.
+/*!
+  Creates empty MPS unwrapping plan.
+*/
+MPSPlan_::MPSPlan_()
+{
+  this->Blank();
+}
+/* MPSPlan_::MPSPlan_ */
+
+
+
+//! Destructor.
+/*!
+  Deletes all data of the MPS unwrapping plan.
+*/
+MPSPlan_::~MPSPlan_()
+{
+  SAFE_DELETE( this->lut );
+  SAFE_DELETE( this->tree );
+
+  SAFE_DELETE( this->O );
+  SAFE_DELETE( this->X );
+  SAFE_DELETE( this->K );
+
+  SAFE_DELETE( this->lambda );
+  SAFE_DELETE( this->wgt );
+  SAFE_DELETE( this->k_max );
+  SAFE_DELETE( this->n );
 
-      cv::Mat * ptr = new cv::Mat(*k_tmp, r);
-      assert(NULL != ptr);
-      if (NULL != ptr)
-        {
-          SAFE_DELETE( k_tmp );
-          k_tmp = ptr;
-          ptr = NULL;
-        }
-      /* if */
-    }
-  /* if */
+  this->Blank();
+}
+/* MPSPlan_::~MPSPlan_ */
 
 
-  SAFE_ASSIGN_PTR( k, k_out );
-  if (NULL != width_out) *width_out = width;
-  SAFE_ASSIGN_PTR( idx, idx_out);
 
- mps_get_wrapped_tuples_EXIT:
+//! Blank class variables.
+/*!
+  Initializes all class variables.
+*/
+void
+MPSPlan_::Blank(
+                void
+                )
+{
+  this->counts.clear();
+  this->width = std::numeric_limits<double>::quiet_NaN();
 
-  SAFE_DELETE( k );
-  SAFE_DELETE( k_tmp );
-  SAFE_DELETE( idx );
+  this->lambda = NULL;
+  this->wgt = NULL;
+  this->k_max = NULL;
+  this->n = NULL;
 
-  return result;
+  this->O = NULL;
+  this->X = NULL;
+  this->K = NULL;
+
+  this->tree = NULL;
+  this->lut = NULL;
 }
-/* mps_get_wrapped_tuples */
+/* MPSPlan_::Blank */
 
 
 
-//! Returns ortographic projection matrix and projected tuple center points.
+//! Construct search indices.
 /*!
-  Function computes orthographic projection matrix O, tuple center points Xk,
-  wrapped period-order t.
+  Constructs grid lookup table over constellation points; if the grid cannot be used
+  then KD tree is constructed instead. Also computes maximal fringe counts from
+  maximal period-order numbers.
+  Both search indices are derived from X so they are not stored in plan files.
 
-  \param lambda_in      Pointer to wavelengths.
-  \param width_in       Maximal unwrapped phase width; may be set to NaN in which case it is automaticall computed from wavelengths lambda.
-  \param O_out          Address where pointer to cv::Mat which stores orthographic projection matrix will be stored. May be NULL.
-  \param Xk_out         Address where pointer to cv::Mat which stores all period-order tuples center points will be stored. May be NULL.
-  \param kk_out         Address where pointer to cv::Mat which stores all period tuples will be placed. May be NULL.
-  \param Xw_out         Address where pointer to cv::Mat which stores all wrapped period-order tuples center points will be stored. May be NULL.
-  \param kw_out         Address where pointer to cv::Mat which stores all wrapped period tuples will be placed. May be NULL.
-  \param idxw_out       Address where pointer to cv::Mat which stores indices into list of all unwrapped period tuples for each wrapped period tuple. May be NULL.
-  \param width_out      Address where used maximal width will be stored.
-  \return Function returns true if successfull, false otherwise.
+  \param plan   Pointer to MPS unwrapping plan with valid O, X, and k_max.
+  \return Returns true if successfull, false otherwise.
 */
+inline
 bool
-mps_get_projection_matrix_and_centers(
-                                      std::vector<double> const & lambda_in,
-                                      double const width_in,
-                                      cv::Mat * * const O_out,
-                                      cv::Mat * * const Xk_out,
-                                      cv::Mat * * const kk_out,
-                                      cv::Mat * * const Xw_out,
-                                      cv::Mat * * const kw_out,
-                                      cv::Mat * * const idx_out,
-                                      double * const width_out
-                                      )
+mps_plan_construct_indices_inline(
+                                  MPSPlan * const plan
+                                  )
 {
-  double width = width_in;
-
-  cv::Mat * O = NULL;
-  cv::Mat * Xk = NULL;
-  cv::Mat * kk = NULL;
-  cv::Mat * Xw = NULL;
-  cv::Mat * kw = NULL;
-  cv::Mat * idx = NULL;
-
-  cv::Mat * V = NULL;
-  cv::Mat * X0 = NULL;
-  cv::Mat * X1 = NULL;
+  assert( (NULL != plan) && (NULL != plan->O) && (NULL != plan->X) && (NULL != plan->k_max) );
+  if ( (NULL == plan) || (NULL == plan->O) || (NULL == plan->X) || (NULL == plan->k_max) ) return false;
 
-  bool result = true; // Assume success.
+  assert( (NULL == plan->lut) && (NULL == plan->tree) && (NULL == plan->n) );
 
-  // Get lines.
-  bool const get_lines = mps_get_lines(lambda_in, width, &V, &X0, &kk, &width, NULL, NULL);
-  assert(true == get_lines);
-  result = result & get_lines;
+  bool const get = mps_get_grid_lut(plan->O, plan->X, &(plan->lut));
+  assert(true == get);
+  if (false == get) return false;
 
-  if ( (false == get_lines) ||
-       (NULL == V) || (NULL == V->data) ||
-       (NULL == X0) || (NULL == X0->data) ||
-       (NULL == kk) || (NULL == kk->data)
-       )
+  // Grid lookup is exact so KD tree is only needed if there is no grid.
+  if (NULL == plan->lut)
     {
-      result = false;
-      goto mps_get_projection_matrix_and_centers_EXIT;
+      plan->tree = new KDTreeRoot();
+      assert(NULL != plan->tree);
+      if (NULL == plan->tree) return false;
+
+      double const * const data = (double *)( plan->X->data );
+      bool const construct = plan->tree->ConstructTree(data, plan->X->cols, plan->X->rows, (int)(plan->X->step[0]));
+      assert(true == construct);
+      if (false == construct) return false;
     }
   /* if */
 
-  // Get wrapped-around phase vectors.
-  bool const get_wrapped_tuples = mps_get_wrapped_tuples(lambda_in, width, &kw, &width, &idx);
-  result = result & get_wrapped_tuples;
+  plan->n = new std::vector<double>();
+  assert(NULL != plan->n);
+  if (NULL == plan->n) return false;
 
-  if ( (false == get_wrapped_tuples) ||
-       (NULL == kw) || (NULL == kw->data) ||
-       (NULL == idx) || (NULL == idx->data)
-       )
-    {
-      result = false;
-      goto mps_get_projection_matrix_and_centers_EXIT;
-    }
-  /* if */
+  int const i_max = (int)( plan->k_max->size() );
+  plan->n->reserve( (size_t)i_max );
+  for (int i = 0; i < i_max; ++i) plan->n->push_back( (double)( (*plan->k_max)[i] + 1 ) );
 
-  int const N0 = kk->rows;
-  int const N1 = kw->rows;
-  int const D = kk->cols;
-  assert( D == kw->cols );
-  assert( D == (int)( lambda_in.size() ) );
+  return true;
+}
+/* mps_plan_construct_indices_inline */
 
-  // Allocate space for orthographic projection matrix.
-  O = new cv::Mat(D-1, D, CV_64FC1);
-  assert( (NULL != O) && (NULL != O->data) );
-  if ( (NULL == O) || (NULL == O->data) )
-    {
-      result = false;
-      goto mps_get_projection_matrix_and_centers_EXIT;
-    }
-  /* if */
 
-  // Get projection matrix.
-  {
-    cv::Mat w, u, vt;
-    cv::SVD::compute(*V, w, u, vt, cv::SVD::FULL_UV);
 
-    double const s = w.at<double>(0,0);
-    double const tol = (double)(V->cols) * s * DBL_EPSILON;
-    int const r = ( (s > tol)? 1 : 0 );
+//! Construct MPS unwrapping plan.
+/*!
+  Constructs all data required to unwrap phase using multiple phase shifting
+  for the given fringe counts.
 
-    for (int j = 0; j < D - 1; ++j)
-      {
-        assert(j + r < vt.rows);
-        double const * const srcrow = (double *)( (BYTE *)vt.data + vt.step[0] * (j + r) );
-        double * const dstrow = (double *)( (BYTE *)O->data + O->step[0] * j );
-        for (int i = 0; i < D; ++i)
-          {
-            dstrow[i] = srcrow[i];
-          }
-        /* for */
-      }
-    /* for */
-  }
+  \param counts_in      Number of periods per screen for each frequency.
+  \param plan_out       Address where the pointer to the plan will be stored.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_get_plan(
+             std::vector<double> const & counts_in,
+             MPSPlan_ * * const plan_out
+             )
+{
+  bool result = false; // Assume failure.
 
-  // Allocate space for projected lines.
-  Xk = new cv::Mat(N0, D - 1, CV_64FC1);
-  assert( (NULL != Xk) && (NULL != Xk->data) );
-  if ( (NULL == Xk) || (NULL == Xk->data) )
-    {
-      result = false;
-      goto mps_get_projection_matrix_and_centers_EXIT;
-    }
-  /* if */
+  MPSPlan * plan = NULL;
 
-  // Project lines.
-  *Xk = (*X0) * O->t();
+  cv::Mat * Xk = NULL; // Regular constellation points.
+  cv::Mat * kk = NULL; // Regular period-order vectors.
+  cv::Mat * Xw = NULL; // Wrapped constellation points.
+  cv::Mat * kw = NULL; // Wrapped period-order vectors.
 
-  // Allocate space for wrapped lines and their projection.
-  X1 = new cv::Mat(N1, D, CV_64FC1);
-  assert( (NULL != X1) && (NULL != X1->data) );
+  assert(1 < counts_in.size());
+  if (1 >= counts_in.size()) goto mps_get_plan_EXIT;
 
-  Xw = new cv::Mat(N1, D-1, CV_64FC1);
-  assert( (NULL != Xw) && (NULL != Xw->data) );
+  plan = new MPSPlan();
+  assert(NULL != plan);
+  if (NULL == plan) goto mps_get_plan_EXIT;
 
-  if ( (NULL == X1) || (NULL == X1->data) ||
-       (NULL == Xw) || (NULL == Xw->data)
-       )
-    {
-      result = false;
-      goto mps_get_projection_matrix_and_centers_EXIT;
-    }
-  /* if */
+  plan->counts = counts_in;
 
-  // Compute points on wrapped lines.
+  // Get wavelengths and width from period counts.
   {
-    double const pi = 3.141592653589793238462643383279502884197169399375;
-    double const tau = 2.0 * pi;
+    bool const get = mps_periods_from_fringe_counts(counts_in, plan->width, &(plan->lambda), &(plan->width));
+    assert( (true == get) && (NULL != plan->lambda) );
+    if ( (false == get) || (NULL == plan->lambda) ) goto mps_get_plan_EXIT;
+  }
 
-    for (int j = 0; j < N1; ++j)
-      {
-        int const * const srcrow = (int *)( (BYTE *)(kw->data) + kw->step[0] * j );
-        double * const dstrow = (double *)( (BYTE *)(X1->data) + X1->step[0] * j );
-        for (int i = 0; i < D; ++i)
-          {
-            dstrow[i] = -tau * (double)( srcrow[i] );
-          }
-        /* for */
-      }
-    /* for */
+  // Get orthographic projection matrix and centers.
+  {
+    bool const get = mps_get_projection_matrix_and_centers(*(plan->lambda), plan->width, &(plan->O), &Xk, &kk, &Xw, &kw, NULL, &(plan->width));
+    assert(true == get);
+    if (false == get) goto mps_get_plan_EXIT;
   }
 
-  // Project wrapped lines.
-  *Xw = (*X1) * O->t();
+  // Consolidate constellation points; search indices are constructed later.
+  {
+    bool const get = mps_get_kd_tree(Xk, kk, Xw, kw, &(plan->X), &(plan->K), &(plan->k_max), NULL);
+    assert(true == get);
+    if (false == get) goto mps_get_plan_EXIT;
+  }
 
+  // Get standard weights.
+  {
+    bool const get = mps_get_weights(*(plan->lambda), &(plan->wgt));
+    assert(true == get);
+    if (false == get) goto mps_get_plan_EXIT;
+  }
 
-  SAFE_ASSIGN_PTR( O, O_out );
-  SAFE_ASSIGN_PTR( Xk, Xk_out );
-  SAFE_ASSIGN_PTR( kk, kk_out );
-  SAFE_ASSIGN_PTR( Xw, Xw_out );
-  SAFE_ASSIGN_PTR( kw, kw_out );
-  SAFE_ASSIGN_PTR( idx, idx_out );
-  if (NULL != width_out) *width_out = width;
+  result = mps_plan_construct_indices_inline(plan);
+  assert(true == result);
 
- mps_get_projection_matrix_and_centers_EXIT:
+  if (true == result) SAFE_ASSIGN_PTR( plan, plan_out );
+
+ mps_get_plan_EXIT:
+
+  SAFE_DELETE( plan );
 
-  SAFE_DELETE( O );
   SAFE_DELETE( Xk );
   SAFE_DELETE( kk );
   SAFE_DELETE( Xw );
   SAFE_DELETE( kw );
-  SAFE_DELETE( idx );
-  SAFE_DELETE( V );
-  SAFE_DELETE( X0 );
-  SAFE_DELETE( X1 );
 
   return result;
 }
-/* mps_get_projection_matrix_and_centers */
+/* mps_get_plan */
 
 
 
-//! Construct KD tree.
+//! Writes matrix rows.
 /*!
-  Function consolidates regular and wrapped points and constructs KD tree over them.
+  Writes all rows of a matrix to an open file.
 
-  \param kk_in  Pointer to regular period-order vectors.
-  \param Xk_in  Pointer to regular projected constellation lines.
-  \param kw_in  Pointer to wrapped period-order vectors.
-  \param Xw_in  Pointer to wrapped projected constellation lines.
-  \param X_out  Address where the pointer to cv::Mat which holds all constellation points will be stored.
-  \param k_out  Address where the pointer to cv::Mat which holds all period-order vectors will be stored.
-  \param k_max_out  Address where the pointer to vector which holds maximal number of fringes for each wavelength will be stored.
-  \param kd_tree_out    Address where the pointer to KD tree will be stored.
+  \param fid    File pointer.
+  \param mat    Pointer to matrix.
   \return Returns true if successfull, false otherwise.
 */
+inline
 bool
-mps_get_kd_tree(
-                cv::Mat * const Xk_in,
-                cv::Mat * const kk_in,
-                cv::Mat * const Xw_in,
-                cv::Mat * const kw_in,
-                cv::Mat * * const X_out,
-                cv::Mat * * const k_out,
-                std::vector<int> * * const k_max_out,
-                KDTreeRoot_ * * const kd_tree_out
-                )
+mps_plan_write_rows_inline(
+                           FILE * const fid,
+                           cv::Mat const * const mat
+                           )
+{
+  size_t const row_size = mat->elemSize() * mat->cols;
+  for (int j = 0; j < mat->rows; ++j)
+    {
+      size_t const write_row = fwrite(mat->data + j * mat->step[0], row_size, 1, fid);
+      if (1 != write_row) return false;
+    }
+  /* for */
+  return true;
+}
+/* mps_plan_write_rows_inline */
+
+
+
+//! Reads matrix rows.
+/*!
+  Reads all rows of a preallocated matrix from an open file.
+
+  \param fid    File pointer.
+  \param mat    Pointer to matrix.
+  \return Returns true if successfull, false otherwise.
+*/
+inline
+bool
+mps_plan_read_rows_inline(
+                          FILE * const fid,
+                          cv::Mat * const mat
+                          )
+{
+  size_t const row_size = mat->elemSize() * mat->cols;
+  for (int j = 0; j < mat->rows; ++j)
+    {
+      size_t const read_row = fread(mat->data + j * mat->step[0], row_size, 1, fid);
+      if (1 != read_row) return false;
+    }
+  /* for */
+  return true;
+}
+/* mps_plan_read_rows_inline */
+
+
+
+//! Updates FNV-1a hash.
+/*!
+  Updates 64-bit FNV-1a hash with given bytes.
+
+  \param hash   Current hash value.
+  \param data   Pointer to data.
+  \param size   Data size in bytes.
+  \return Returns updated hash value.
+*/
+inline
+unsigned __int64
+mps_plan_hash_update_inline(
+                            unsigned __int64 hash,
+                            void const * const data,
+                            size_t const size
+                            )
+{
+  assert( (NULL != data) || (0 == size) );
+  BYTE const * const bytes = (BYTE const *)( data );
+  for (size_t i = 0; i < size; ++i)
+    {
+      hash ^= (unsigned __int64)( bytes[i] );
+      hash *= 0x00000100000001B3ULL;
+    }
+  /* for */
+  return hash;
+}
+/* mps_plan_hash_update_inline */
+
+
+
+//! Computes MPS unwrapping plan hash.
+/*!
+  Computes 64-bit FNV-1a hash of all inputs of the MPS unwrapping plan:
+  the method descriptor, fringe counts, wavelengths and screen width derived
+  from fringe counts, and the contents of the geometry XML file.
+  The hash is stored in the plan file so a plan file written for different
+  inputs is never reused.
+
+  \param method MPS method descriptor.
+  \param counts_in      Number of periods per screen for each frequency.
+  \param fname_geometry Filename of the geometry XML file.
+  \param hash_out       Address where the hash will be stored.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_plan_hash(
+              wchar_t const * const method,
+              std::vector<double> const & counts_in,
+              wchar_t const * const fname_geometry,
+              unsigned __int64 * const hash_out
+              )
 {
-  bool result = true; // Assume success.
+  bool result = false; // Assume failure.
 
-  cv::Mat * X = NULL;
-  cv::Mat * k = NULL;
-  std::vector<int> * k_max = NULL;
-  KDTreeRoot * kd_tree = NULL;
+  std::vector<double> * lambda = NULL;
+  double width = std::numeric_limits<double>::quiet_NaN();
+  FILE * fid = NULL;
 
-  assert( (NULL != Xk_in) && (NULL != Xk_in->data) &&
-          (NULL != kk_in) && (NULL != kk_in->data) &&
-          (NULL != Xw_in) && (NULL != Xw_in->data) &&
-          (NULL != kw_in) && (NULL != kw_in->data)
-          );
-  if ( (NULL == Xk_in) || (NULL == Xk_in->data) ||
-       (NULL == kk_in) || (NULL == kk_in->data) ||
-       (NULL == Xw_in) || (NULL == Xw_in->data) ||
-       (NULL == kw_in) || (NULL == kw_in->data)
-       )
-    {
-      result = false;
-      goto mps_get_kd_tree_EXIT;
-    }
-  /* if */
+  assert( (NULL != method) && (NULL != fname_geometry) && (NULL != hash_out) );
+  if ( (NULL == method) || (NULL == fname_geometry) || (NULL == hash_out) ) goto mps_plan_hash_EXIT;
 
-  int const D = kk_in->cols;
-  assert( D == kw_in->cols );
-  assert( D - 1 == Xk_in->cols );
-  assert( D - 1 == Xw_in->cols );
-  int const Nk = Xk_in->rows;
-  assert( Nk == kk_in->rows );
-  int const Nw = Xw_in->rows;
-  assert( Nw == kw_in->rows );
-  int const N = Nk + Nw;
+  assert(1 < counts_in.size());
+  if (1 >= counts_in.size()) goto mps_plan_hash_EXIT;
 
-  // Allocate storage on heap.
-  X = new cv::Mat(N, D - 1, CV_64FC1);
-  assert( (NULL != X) && (NULL != X->data) );
+  {
+    bool const get = mps_periods_from_fringe_counts(counts_in, width, &lambda, &width);
+    if ( (false == get) || (NULL == lambda) ) goto mps_plan_hash_EXIT;
+  }
 
-  k = new cv::Mat(N, D, CV_32SC1);
-  assert( (NULL != k) && (NULL != k->data) );
+  {
+    errno_t const open = _wfopen_s(&fid, fname_geometry, L"rb");
+    if ( (0 != open) || (NULL == fid) ) goto mps_plan_hash_EXIT;
+  }
 
-  k_max = new std::vector<int>();
-  assert(NULL != k_max);
+  {
+    unsigned __int64 hash = 0xCBF29CE484222325ULL;
+
+    int const D = (int)( counts_in.size() );
+    hash = mps_plan_hash_update_inline(hash, method, sizeof(wchar_t) * wcslen(method));
+    hash = mps_plan_hash_update_inline(hash, &D, sizeof(D));
+    hash = mps_plan_hash_update_inline(hash, &(counts_in[0]), sizeof(double) * D);
+    hash = mps_plan_hash_update_inline(hash, &((*lambda)[0]), sizeof(double) * lambda->size());
+    hash = mps_plan_hash_update_inline(hash, &width, sizeof(width));
+
+    BYTE buffer[MPS_PLAN_HASH_BUFFER_SIZE];
+    size_t n_read = 0;
+    do
+      {
+        n_read = fread(buffer, 1, MPS_PLAN_HASH_BUFFER_SIZE, fid);
+        hash = mps_plan_hash_update_inline(hash, buffer, n_read);
+      }
+    while (MPS_PLAN_HASH_BUFFER_SIZE == n_read);
 
-  kd_tree = new KDTreeRoot();
-  assert(NULL != kd_tree);
+    if (0 != ferror(fid)) goto mps_plan_hash_EXIT;
 
-  if ( (NULL == X) || (NULL == X->data) ||
-       (NULL == k) || (NULL == k->data) ||
-       (NULL == k_max) || (NULL == kd_tree)
-       )
+    *hash_out = hash;
+  }
+
+  result = true;
+
+ mps_plan_hash_EXIT:
+
+  if (NULL != fid)
     {
-      result = false;
-      goto mps_get_kd_tree_EXIT;
+      int const closed = fclose(fid);
+      assert(0 == closed);
+      if (0 == closed) fid = NULL;
     }
   /* if */
 
-  // Consolidate regular and wrapped constellation points.
-  int j = 0;
-  for (; j < Nk; ++j)
-    {
-      double const * const Xk_row = (double *)( (BYTE *)Xk_in->data + Xk_in->step[0] * j );
-      double * const X_row = (double *)( (BYTE *)X->data + X->step[0] * j );
-      for (int i = 0; i < D - 1; ++i) X_row[i] = Xk_row[i];
-    }
-  /* for */
+  SAFE_DELETE( lambda );
 
-  for (; j < N; ++j)
-    {
-      int const jw = j - Nk;
-      assert( (0 <= jw) && (jw < Xw_in->rows) );
-      double const * const Xw_row = (double *)( (BYTE *)Xw_in->data + Xw_in->step[0] * jw );
-      double * const X_row = (double *)( (BYTE *)X->data + X->step[0] * j );
-      for (int i = 0; i < D - 1; ++i) X_row[i] = Xw_row[i];
-    }
-  /* for */
+  return result;
+}
+/* mps_plan_hash */
 
-  if (0 < Nk)
+
+
+//! Writes MPS unwrapping plan.
+/*!
+  Writes MPS unwrapping plan to a binary file.
+  File starts with four integers: magic number, version, number of frequencies D,
+  and number of constellation points N, followed by the 64-bit plan hash computed
+  by mps_plan_hash. The header is followed by D fringe counts,
+  D wavelengths, width, D weights (all doubles), D maximal period-order numbers (ints),
+  (D-1) x D orthographic projection matrix O, N x (D-1) constellation points X (doubles),
+  and N x D period-order vectors K (ints).
+
+  \param filename       Output filename.
+  \param hash   Plan hash.
+  \param plan   Pointer to MPS unwrapping plan.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+mps_write_plan(
+               wchar_t const * const filename,
+               unsigned __int64 const hash,
+               MPSPlan_ const * const plan
+               )
+{
+  bool result = false; // Assume failure.
+
+  assert(NULL != filename);
+  if (NULL == filename) return result;
+
+  assert( (NULL != plan) && (NULL != plan->lambda) && (NULL != plan->wgt) && (NULL != plan->k_max) &&
+          (NULL != plan->O) && (NULL != plan->X) && (NULL != plan->K)
+          );
+  if ( (NULL == plan) || (NULL == plan->lambda) || (NULL == plan->wgt) || (NULL == plan->k_max) ||
+       (NULL == plan->O) || (NULL == plan->X) || (NULL == plan->K)
+       )
     {
-      k_max->reserve( (size_t)D );
-      int const * const kk_row = (int *)( (BYTE *)kk_in->data );
-      for (int i = 0; i < D; ++i)
-        {
-          k_max->push_back( kk_row[i] );
-        }
-      /* for */
-      assert( D == (int)( k_max->size() ) );
+      return result;
     }
   /* if */
 
-  for (j = 0; j < Nk; ++j)
-    {
-      int const * const kk_row = (int *)( (BYTE *)kk_in->data + kk_in->step[0] * j );
-      int * const k_row = (int *)( (BYTE *)k->data +k->step[0] * j );
-      for (int i = 0; i < D; ++i)
-        {
-          k_row[i] = kk_row[i];
-          if (kk_row[i] > (*k_max)[i])
-            {
-              (*k_max)[i] = kk_row[i];
-            }
-          /* if */
-        }
-      /* for */
-    }
-  /* for */
+  int const D = (int)( plan->counts.size() );
+  int const N = plan->X->rows;
 
-  for (; j < N; ++j)
-    {
-      int const jw = j - Nk;
-      assert( (0 <= jw) && (jw < kw_in->rows) );
-      int const * const kw_row = (int *)( (BYTE *)kw_in->data + kw_in->step[0] * jw );
-      int * const k_row = (int *)( (BYTE *)k->data + k->step[0] * j );
-      for (int i = 0; i < D; ++i) k_row[i] = kw_row[i];
-    }
-  /* for */
+  FILE * fid = NULL;
+  errno_t const open = _wfopen_s(&fid, filename, L"wb");
+  if ( (0 != open) || (NULL == fid) ) return result;
 
-  // Construct KD tree.
   {
-    double const * const data = (double *)( X->data );
-    bool const construct = kd_tree->ConstructTree(data, D-1, N, (int)(X->step[0]));
-    assert(true == construct);
-    result = result && construct;
+    int const header[4] = {MPS_PLAN_FILE_MAGIC, MPS_PLAN_FILE_VERSION, D, N};
+    if (1 != fwrite(header, sizeof(header), 1, fid)) goto mps_write_plan_EXIT;
+    if (1 != fwrite(&hash, sizeof(hash), 1, fid)) goto mps_write_plan_EXIT;
+
+    if (1 != fwrite(&(plan->counts[0]), sizeof(double) * D, 1, fid)) goto mps_write_plan_EXIT;
+    if (1 != fwrite(&((*plan->lambda)[0]), sizeof(double) * D, 1, fid)) goto mps_write_plan_EXIT;
+    if (1 != fwrite(&(plan->width), sizeof(double), 1, fid)) goto mps_write_plan_EXIT;
+    if (1 != fwrite(&((*plan->wgt)[0]), sizeof(double) * D, 1, fid)) goto mps_write_plan_EXIT;
+    if (1 != fwrite(&((*plan->k_max)[0]), sizeof(int) * D, 1, fid)) goto mps_write_plan_EXIT;
+
+    if (false == mps_plan_write_rows_inline(fid, plan->O)) goto mps_write_plan_EXIT;
+    if (false == mps_plan_write_rows_inline(fid, plan->X)) goto mps_write_plan_EXIT;
+    if (false == mps_plan_write_rows_inline(fid, plan->K)) goto mps_write_plan_EXIT;
   }
 
+  result = true;
 
-  SAFE_ASSIGN_PTR( X, X_out );
-  SAFE_ASSIGN_PTR( k, k_out );
-  SAFE_ASSIGN_PTR( k_max, k_max_out );
-  SAFE_ASSIGN_PTR( kd_tree, kd_tree_out );
-
- mps_get_kd_tree_EXIT:
+ mps_write_plan_EXIT:
 
-  SAFE_DELETE( X );
-  SAFE_DELETE( k );
-  SAFE_DELETE( k_max );
-  SAFE_DELETE( kd_tree );
+  int const closed = fclose(fid);
+  assert(0 == closed);
+  if (0 == closed) fid = NULL;
 
   return result;
 }
-/* mps_get_kd_tree */
+/* mps_write_plan */
 
 
 
-//! Return standard weights.
+//! Reads MPS unwrapping plan.
 /*!
-  Returns standard weights for MPS unwrapping.
-
-  \param lambda_in      Vector of used wavelengths.
-  \param wgt_out     Address where pointer to computed weights will be stored.
+  Reads MPS unwrapping plan from a binary file written by mps_write_plan
+  and reconstructs the search indices. The plan is accepted only if stored
+  hash and fringe counts are the same as the requested ones.
+
+  \param filename       Input filename.
+  \param counts_in      Number of periods per screen for each frequency.
+  \param hash   Expected plan hash.
+  \param plan_out       Address where the pointer to the plan will be stored.
   \return Returns true if successfull, false otherwise.
 */
 bool
-mps_get_weights(
-                std::vector<double> const & lambda_in,
-                std::vector<double> * * const wgt_out
-                )
+mps_read_plan(
+              wchar_t const * const filename,
+              std::vector<double> const & counts_in,
+              unsigned __int64 const hash,
+              MPSPlan_ * * const plan_out
+              )
 {
   bool result = false; // Assume failure.
 
-  std::vector<double> * wgt = new std::vector<double>(lambda_in.size());
-  assert(NULL != wgt);
-  if (NULL != wgt)
+  MPSPlan * plan = NULL;
+
+  assert(NULL != filename);
+  if (NULL == filename) return result;
+
+  FILE * fid = NULL;
+  errno_t const open = _wfopen_s(&fid, filename, L"rb");
+  if ( (0 != open) || (NULL == fid) ) return result;
+
+  int header[4] = {0, 0, 0, 0};
+  if (1 != fread(header, sizeof(header), 1, fid)) goto mps_read_plan_EXIT;
+  if ( (MPS_PLAN_FILE_MAGIC != header[0]) || (MPS_PLAN_FILE_VERSION != header[1]) ) goto mps_read_plan_EXIT;
+
+  unsigned __int64 hash_stored = 0;
+  if (1 != fread(&hash_stored, sizeof(hash_stored), 1, fid)) goto mps_read_plan_EXIT;
+  if (hash != hash_stored)
     {
-      int const i_max = (int)( lambda_in.size() );
-      for (int i = 0; i < i_max; ++i)
-        {
-          (*wgt)[i] = 1.0 / ( lambda_in[i] * lambda_in[i] );
-        }
-      /* for */
+      Debugfwprintf(stderr, gDbgMPSPlanStale, filename);
+      goto mps_read_plan_EXIT;
+    }
+  /* if */
 
-      result = true;
+  int const D = header[2];
+  int const N = header[3];
+  if ( (D != (int)( counts_in.size() )) || (2 > D) || (0 >= N) ) goto mps_read_plan_EXIT;
+
+  plan = new MPSPlan();
+  assert(NULL != plan);
+  if (NULL == plan) goto mps_read_plan_EXIT;
+
+  plan->counts.resize( (size_t)D );
+  plan->lambda = new std::vector<double>( (size_t)D );
+  plan->wgt = new std::vector<double>( (size_t)D );
+  plan->k_max = new std::vector<int>( (size_t)D );
+  plan->O = new cv::Mat(D - 1, D, CV_64FC1);
+  plan->X = new cv::Mat(N, D - 1, CV_64FC1);
+  plan->K = new cv::Mat(N, D, CV_32SC1);
+  if ( (NULL == plan->lambda) || (NULL == plan->wgt) || (NULL == plan->k_max) ||
+       (NULL == plan->O) || (NULL == plan->O->data) ||
+       (NULL == plan->X) || (NULL == plan->X->data) ||
+       (NULL == plan->K) || (NULL == plan->K->data)
+       )
+    {
+      goto mps_read_plan_EXIT;
     }
   /* if */
 
-  SAFE_ASSIGN_PTR( wgt, wgt_out );
-  SAFE_DELETE( wgt );
+  if (1 != fread(&(plan->counts[0]), sizeof(double) * D, 1, fid)) goto mps_read_plan_EXIT;
+  if (plan->counts != counts_in) goto mps_read_plan_EXIT;
+
+  if (1 != fread(&((*plan->lambda)[0]), sizeof(double) * D, 1, fid)) goto mps_read_plan_EXIT;
+  if (1 != fread(&(plan->width), sizeof(double), 1, fid)) goto mps_read_plan_EXIT;
+  if (1 != fread(&((*plan->wgt)[0]), sizeof(double) * D, 1, fid)) goto mps_read_plan_EXIT;
+  if (1 != fread(&((*plan->k_max)[0]), sizeof(int) * D, 1, fid)) goto mps_read_plan_EXIT;
+
+  if (false == mps_plan_read_rows_inline(fid, plan->O)) goto mps_read_plan_EXIT;
+  if (false == mps_plan_read_rows_inline(fid, plan->X)) goto mps_read_plan_EXIT;
+  if (false == mps_plan_read_rows_inline(fid, plan->K)) goto mps_read_plan_EXIT;
+
+  result = mps_plan_construct_indices_inline(plan);
+
+  if (true == result) SAFE_ASSIGN_PTR( plan, plan_out );
+
+ mps_read_plan_EXIT:
+
+  int const closed = fclose(fid);
+  assert(0 == closed);
+  if (0 == closed) fid = NULL;
+
+  SAFE_DELETE( plan );
 
   return result;
 }
-/* mps_get_weights */
+/* mps_read_plan */
 
 
 
-//! Unwraps phase using orthographic projection.
+//! Get plan filename.
 /*!
-  Function unwraps wrapped phases using orthographic projection.
+  Returns filename of the MPS plan file which is stored in the same directory
+  as the geometry XML file, e.g. MPS_plan_n15_n19.bin for fringe counts 15 and 19.
 
-  \param WP_in  Vector of at least two wrapped phase images. The order of wrapped phase images must correspond to
-  wavelength order used to construct the orthographic projection matrix O_in, constellation X_in, and KD tree kd_tree_in.
-  \param O_in   Pointer to orthographic projection matrix.
-  \param X_in   Pointer to points in constellation.
-  \param k_in   Pointer to period-order numbers.
-  \param kd_tree_in     Pointer to KD tree constructed over the constellation X_in.
-  \param n      Vector of maximal frige counts for each wavelength.
-  \param wgt    Vector of weights used to combine wrapped phases into absolute phase.
-  \param idx    Address where cv::Mat holding indices into period-order vectors will be stored. May be NULL.
-  \param dst    Address where cv::Mat holding distance to closest constellation point will be stored. May be NULL.
-  \param abs_phase_out  Address where cv::Mat holding unwrapped phase will be stored. May be NULL.
-  \return Returns true if successfull, false otherwise.
+  \param fname_geometry Filename of the geometry XML file.
+  \param counts_in      Number of periods per screen for each frequency.
+  \return Returns plan filename.
 */
-bool
-mps_unwrap_phase(
-                 std::vector<cv::Mat *> const & WP_in,
-                 cv::Mat * const O_in,
-                 cv::Mat * const X_in,
-                 cv::Mat * const k_in,
-                 KDTreeRoot * const kd_tree_in,
-                 std::vector<double> const & n_in,
-                 std::vector<double> const & wgt_in,
-                 cv::Mat * * const idx_out,
-                 cv::Mat * * const dst_out,
-                 cv::Mat * * const abs_phase_out
-                 )
+inline
+std::wstring
+mps_plan_filename_inline(
+                         wchar_t const * const fname_geometry,
+                         std::vector<double> const & counts_in
+                         )
 {
-  bool result = true; // Assume success.
+  std::wstring filename(fname_geometry);
 
-  cv::Mat * idx = NULL;
-  cv::Mat * dst = NULL;
-  cv::Mat * abs_phase = NULL;
-  cv::Mat * WP = NULL;
-  cv::Mat * WPO = NULL;
+  size_t const separator = filename.find_last_of(L"\\/");
+  if (std::wstring::npos != separator)
+    {
+      filename.erase(separator + 1);
+    }
+  else
+    {
+      filename.clear();
+    }
+  /* if */
 
-  int n_rows = 0;
-  int n_cols = 0;
+  filename += L"MPS_plan";
 
-  assert( (NULL != O_in) && (NULL != O_in->data) &&
-          (NULL != X_in) && (NULL != X_in->data) &&
-          (NULL != k_in) && (NULL != k_in->data) &&
-          (NULL != kd_tree_in) && (NULL != kd_tree_in->data)
-          );
-  if ( (NULL == O_in) || (NULL == O_in->data) ||
-       (NULL == X_in) || (NULL == X_in->data) ||
-       (NULL == k_in) || (NULL == k_in->data) ||
-       (NULL == kd_tree_in) || (NULL == kd_tree_in->data)
-       )
+  wchar_t buffer[32];
+  int const i_max = (int)( counts_in.size() );
+  for (int i = 0; i < i_max; ++i)
     {
-      result = false;
-      goto mps_unwrap_phase_EXIT;
+      int const cnt = swprintf_s(buffer, 32, L"_n%.0f", counts_in[i]);
+      assert(0 < cnt);
+      if (0 < cnt) filename += buffer;
     }
-  /* if */
+  /* for */
 
-  int const D = (int)( WP_in.size() );
-  assert( D == O_in->cols );
-  assert( D - 1 == O_in->rows );
-  assert( D - 1 == X_in->cols );
-  assert( D == k_in->cols );
-  assert( X_in->rows == k_in->rows );
-  assert( D - 1 == kd_tree_in->n_dim );
-  assert( X_in->rows = kd_tree_in->n_pts );
-  assert( (void *)kd_tree_in->data == (void *)X_in->data );
-  assert( D == (int)( n_in.size() ) );
-  assert( D == (int)( wgt_in.size() ) );
+  filename += L".bin";
 
-  // Validate input wrapped phases; all inputs must have same size and type.
-  {
-    cv::Mat * WP_tmp = NULL;
-    for (int i = 0; i < D; ++i)
-      {
-        if ( (NULL == WP_tmp) && (NULL != WP_in[0]) )
-          {
-            n_cols = WP_in[0]->cols;
-            n_rows = WP_in[0]->rows;
-          }
-        /* if */
+  return filename;
+}
+/* mps_plan_filename_inline */
 
-        WP_tmp = WP_in[i];
-        if (NULL != WP_tmp)
-          {
-            assert( (NULL != WP_tmp) && (NULL != WP_tmp->data) );
-            if ( (NULL == WP_tmp) || (NULL == WP_tmp->data) )
-              {
-                result = false;
-                goto mps_unwrap_phase_EXIT;
-              }
-            /* if */
 
-            assert( (CV_MAT_DEPTH(WP_tmp->type()) == CV_64F) &&
-                    (CV_MAT_CN(WP_tmp->type()) == 1) ||
-                    (n_cols == WP_tmp->cols) &&
-                    (n_rows == WP_tmp->rows)
-                    );
-            if ( (CV_MAT_DEPTH(WP_tmp->type()) != CV_64F) ||
-                 (CV_MAT_CN(WP_tmp->type()) != 1) ||
-                 (n_cols != WP_tmp->cols) ||
-                 (n_rows != WP_tmp->rows)
-                 )
-              {
-                result = false;
-                goto mps_unwrap_phase_EXIT;
-              }
-            /* if */
-          }
-        /* if */
-      }
-    /* for */
-  }
 
-  int const N = n_rows * n_cols;
+//! Find cached plan.
+/*!
+  Searches the plan cache for a plan with given fringe counts.
+  Cache lock must be held by the caller.
+
+  \param counts_in      Number of periods per screen for each frequency.
+  \return Returns pointer to the plan or NULL if there is no such plan.
+*/
+inline
+MPSPlan *
+mps_plan_cache_find_inline(
+                           std::vector<double> const & counts_in
+                           )
+{
+  int const i_max = (int)( gMPSPlanCache.size() );
+  for (int i = 0; i < i_max; ++i)
+    {
+      MPSPlan * const plan = gMPSPlanCache[i];
+      if ( (NULL != plan) && (plan->counts == counts_in) ) return plan;
+    }
+  /* for */
+  return NULL;
+}
+/* mps_plan_cache_find_inline */
+
 
-  // Allocate required space.
-  idx = new cv::Mat(n_rows, n_cols, CV_32SC1);
-  assert( (NULL != idx) && (NULL != idx->data) );
 
-  dst = new cv::Mat(n_rows, n_cols, CV_32FC1);
-  assert( (NULL != dst) && (NULL != dst->data) );
+//! Get cached MPS unwrapping plan.
+/*!
+  Returns MPS unwrapping plan for the given fringe counts.
+  The plan is first searched for in memory. If it is not found and USE_MPS_PLAN_FILES
+  is defined then the plan is read from the plan file stored next to the geometry XML file;
+  if there is no such file or if its hash does not match then the plan is constructed
+  and the plan file is written. Otherwise the plan is constructed and only cached in memory.
+
+  Returned plan is owned by the cache and must not be modified or deleted.
+  Plans remain valid until mps_plan_cache_clear is called.
+
+  \param counts_in      Number of periods per screen for each frequency.
+  \param method MPS method descriptor. May be NULL in which case the plan is only cached in memory.
+  \param fname_geometry Filename of the geometry XML file. May be NULL in which case the plan is only cached in memory.
+  \return Returns pointer to the plan or NULL if unsuccessfull.
+*/
+MPSPlan_ *
+mps_plan_cache_get(
+                   std::vector<double> const & counts_in,
+                   wchar_t const * const method,
+                   wchar_t const * const fname_geometry
+                   )
+{
+  MPSPlan * plan = NULL;
 
-  abs_phase = new cv::Mat(n_rows, n_cols, CV_64FC1, cv::Scalar(0.0));
-  assert( (NULL != abs_phase) && (NULL != abs_phase->data) );
+  // Check in-memory cache.
+  AcquireSRWLockShared( &gMPSPlanCacheLock );
+  plan = mps_plan_cache_find_inline(counts_in);
+  ReleaseSRWLockShared( &gMPSPlanCacheLock );
 
-  WP = new cv::Mat(N, D, CV_64FC1);
-  assert( (NULL != WP) && (NULL != WP->data) );
+  if (NULL != plan) return plan;
 
-  WPO = new cv::Mat(N, D - 1, CV_64FC1);
-  assert( (NULL != WPO) && (NULL != WPO->data) );
+  // Only one thread reads or constructs plans; others wait and then find the plan in the cache.
+  AcquireSRWLockExclusive( &gMPSPlanBuildLock );
 
-  if ( (NULL == idx) || (NULL == idx->data) ||
-       (NULL == dst) || (NULL == dst->data) ||
-       (NULL == abs_phase) || (NULL == abs_phase->data) ||
-       (NULL == WP) || (NULL == WP->data) ||
-       (NULL == WPO) || (NULL == WPO->data)
-       )
+  AcquireSRWLockShared( &gMPSPlanCacheLock );
+  plan = mps_plan_cache_find_inline(counts_in);
+  ReleaseSRWLockShared( &gMPSPlanCacheLock );
+
+  if (NULL != plan)
     {
-      result = false;
-      goto mps_unwrap_phase_EXIT;
+      ReleaseSRWLockExclusive( &gMPSPlanBuildLock );
+      return plan;
     }
   /* if */
 
-  // Copy wrapped phase data from input images into one array.
-  for (int j = 0; j < n_rows; ++j)
+  // Read or construct a new plan.
+  MPSPlan * new_plan = NULL;
+  bool have_plan = false;
+
+  std::wstring filename;
+  unsigned __int64 hash = 0;
+
+#ifdef USE_MPS_PLAN_FILES
+  if ( (NULL != method) && (NULL != fname_geometry) && (true == mps_plan_hash(method, counts_in, fname_geometry, &hash)) )
     {
-      int const offset = j * n_cols;
-      for (int i = 0; i < n_cols; ++i)
-        {
-          double * const dstrow = (double *)( (BYTE *)WP->data + WP->step[0] * (offset + i) );
-          for (int d = 0; d < D; ++d)
-            {
-              cv::Mat * const WP_tmp = WP_in[d];
-              double const * const srcrow = (double *)( (BYTE *)WP_tmp->data + WP_tmp->step[0] * j );
-              dstrow[d] = srcrow[i];
-            }
-          /* for */
-        }
-      /* for */
+      filename = mps_plan_filename_inline(fname_geometry, counts_in);
     }
-  /* for */
-
-  // Apply orthographic projection.
-  *WPO = (*WP) * O_in->t();
+  /* if */
+#endif /* USE_MPS_PLAN_FILES */
 
-  // Find period-order number for each point.
-  {
-    KDTreeClosestPoint best;
+  if (false == filename.empty())
+    {
+      have_plan = mps_read_plan(filename.c_str(), counts_in, hash, &new_plan);
+    }
+  /* if */
 
-    for (int j = 0; j < n_rows; ++j)
-      {
-        int const offset = j * n_cols;
-        int * const idx_row = (int *)( (BYTE *)idx->data + idx->step[0] * j );
-        float * const dst_row = (float *)( (BYTE *)dst->data + dst->step[0] * j );
+  if (false == have_plan)
+    {
+      have_plan = mps_get_plan(counts_in, &new_plan);
+      assert(true == have_plan);
 
-        for (int i = 0; i < n_cols; ++i)
-          {
-            double * const query = (double *)( (BYTE *)WPO->data + WPO->step[0] * (offset + i) );
-            best.query = query;
+      if ( (true == have_plan) && (false == filename.empty()) )
+        {
+          bool const write = mps_write_plan(filename.c_str(), hash, new_plan);
+          if (false == write) Debugfwprintf(stderr, gDbgMPSPlanNotWritten, filename.c_str());
+        }
+      /* if */
+    }
+  /* if */
 
-            bool const find = kd_tree_in->Find1NN(best);
-            assert(true == find);
+  if (false == have_plan)
+    {
+      ReleaseSRWLockExclusive( &gMPSPlanBuildLock );
+      return NULL;
+    }
+  /* if */
 
-            idx_row[i] = best.idx;
-            dst_row[i] = (float)( sqrt( best.dst2 ) );
-          }
-        /* for */
-      }
-    /* for */
-  }
+  // Store the plan; another thread may have stored the same plan in the meantime.
+  AcquireSRWLockExclusive( &gMPSPlanCacheLock );
 
-  // Unwrap phase. Note that we combine all unwrapped phases using given weights.
-  {
-    // Precompute required phase-offsets for each period-order vector.
-    double const pi = 3.141592653589793238462643383279502884197169399375;
-    cv::Mat kpi(k_in->rows, k_in->cols, CV_64FC1);
-    for (int j = 0; j < k_in->rows; ++j)
-      {
-        int const * const srcrow = (int *)( (BYTE *)k_in->data + k_in->step[0] * j );
-        double * const dstrow = (double *)( (BYTE *)kpi.data + kpi.step[0] * j );
-        for (int i = 0; i < k_in->cols; ++i)
-          {
-            dstrow[i] = (2.0 * pi) * (double)( srcrow[i] );
-          }
-        /* for */
-      }
-    /* for */
+  plan = mps_plan_cache_find_inline(counts_in);
+  if (NULL == plan)
+    {
+      gMPSPlanCache.push_back(new_plan);
+      SWAP_ONE_VALID_PTR( plan, new_plan );
+    }
+  /* if */
 
-    // Precompute scaling factors used to combine multiple unwrapped phases.
-    std::vector<double> scl;
-    scl.reserve( D );
-    double const wgt_sum = std::accumulate(wgt_in.begin(), wgt_in.end(), 0.0);
-    for (int d = 0; d < D; ++d)
-      {
-        double const scl_tmp = wgt_in[d] / (2.0 * pi * wgt_sum * n_in[d]);
-        scl.push_back(scl_tmp);
-      }
-    /* for */
+  ReleaseSRWLockExclusive( &gMPSPlanCacheLock );
 
-    // Fetch data pointer to phase offsets.
-    double const * const kpi_ptr = (double *)( kpi.data );
-    assert( sizeof(double) * D == kpi.step[0] );
+  ReleaseSRWLockExclusive( &gMPSPlanBuildLock );
 
-    // Compute unwrapped phase.
-    for (int j = 0; j < n_rows; ++j)
-      {
-        int const offset = j * n_cols;
-        int const * const idx_row = (int *)( (BYTE *)idx->data + idx->step[0] * j );
-        double * const abs_phase_row = (double *)( (BYTE *)abs_phase->data + abs_phase->step[0] * j );
+  SAFE_DELETE( new_plan );
 
-        for (int i = 0; i < n_cols; ++i)
-          {
-            double * const wrapped_phase = (double *)( (BYTE *)WP->data + WP->step[0] * (offset + i) );
-            int const phase_idx = idx_row[i];
-            for (int d = 0; d < D; ++d)
-              {
-                double const phase_offset = kpi_ptr[D * phase_idx + d];
-                abs_phase_row[i] += scl[d] * ( wrapped_phase[d] + phase_offset );
-              }
-            /* for */
-          }
-        /* for */
-      }
-    /* for */
-  }
+  return plan;
+}
+/* mps_plan_cache_get */
 
 
-  SAFE_ASSIGN_PTR( idx, idx_out );
-  SAFE_ASSIGN_PTR( dst, dst_out );
-  SAFE_ASSIGN_PTR( abs_phase, abs_phase_out );
 
- mps_unwrap_phase_EXIT:
+//! Clear MPS plan cache.
+/*!
+  Deletes all cached MPS unwrapping plans. Plan files are not deleted.
+  Function must not be called while any reconstruction is in progress.
+*/
+void
+mps_plan_cache_clear(
+                     void
+                     )
+{
+  AcquireSRWLockExclusive( &gMPSPlanCacheLock );
 
-  SAFE_DELETE( idx );
-  SAFE_DELETE( abs_phase );
-  SAFE_DELETE( WP );
-  SAFE_DELETE( WPO );
+  int const i_max = (int)( gMPSPlanCache.size() );
+  for (int i = 0; i < i_max; ++i) SAFE_DELETE( gMPSPlanCache[i] );
+  gMPSPlanCache.clear();
 
-  return result;
+  ReleaseSRWLockExclusive( &gMPSPlanCacheLock );
 }
-/* mps_unwrap_phase */
+/* mps_plan_cache_clear */
 
 
 
@@ -2624,4 +6362,342 @@ CombinePhaseDeviationOrDistance(
 
 
 
+//! Band height (in rows) of one parallel work unit of the sliding window phase statistics.
+#define PHASE_STATISTICS_BAND_HEIGHT 64
+
+
+
+//! Compensated summation.
+/*!
+  Adds value to the sum using Neumaier's variant of Kahan summation.
+  The compensated sum is sum + c.
+
+  \param sum    Pointer to the running sum.
+  \param c      Pointer to the running compensation.
+  \param value  Value to add.
+*/
+inline
+void
+CompensatedAdd_inline(
+                      double * const sum,
+                      double * const c,
+                      double const value
+                      )
+{
+  double const s = *sum;
+  double const t = s + value;
+  if ( fabs(s) >= fabs(value) )
+    {
+      *c += (s - t) + value;
+    }
+  else
+    {
+      *c += (value - t) + s;
+    }
+  /* if */
+  *sum = t;
+}
+/* CompensatedAdd_inline */
+
+
+
+//! Parallel body of the sliding window phase statistics.
+/*!
+  Each invocation processes a band of rows. For every column the band keeps
+  the sum and the sum of squares of the ny input values which lie in the
+  sliding window; when moving to the next row the leaving row is subtracted
+  and the entering row is added. Window sums are then obtained by sliding
+  the same way along the columns. This is the separable form of the
+  summed-area table so the cost per pixel does not depend on the window size.
+
+  All sums are kept in compensated double precision and values are shifted
+  by the first value of the band to reduce cancellation when computing
+  the variance from the sum of squares.
+
+  If two absolute phase images are given then the per-pixel maximums of
+  their phase orders and phase deviations are stored.
+*/
+struct GetAbsolutePhaseOrderAndDeviationParallel_ : public cv::ParallelLoopBody
+{
+  cv::Mat * abs_phase[2]; //!< Absolute phase images; second may be NULL.
+  int nx; //!< Sliding window size along x dimension.
+  int ny; //!< Sliding window size along y dimension.
+  cv::Mat * abs_phase_order; //!< Output phase order (CV_32FC1).
+  cv::Mat * abs_phase_deviation; //!< Output phase deviation (CV_32FC1).
+
+  //! Constructor.
+  GetAbsolutePhaseOrderAndDeviationParallel_(
+                                             cv::Mat * const abs_phase_1_in,
+                                             cv::Mat * const abs_phase_2_in,
+                                             int const nx_in,
+                                             int const ny_in,
+                                             cv::Mat * const abs_phase_order_in,
+                                             cv::Mat * const abs_phase_deviation_in
+                                             )
+  {
+    this->abs_phase[0] = abs_phase_1_in;
+    this->abs_phase[1] = abs_phase_2_in;
+    this->nx = nx_in;
+    this->ny = ny_in;
+    this->abs_phase_order = abs_phase_order_in;
+    this->abs_phase_deviation = abs_phase_deviation_in;
+  }
+
+  //! Processes a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const cols = this->abs_phase_order->cols;
+    int const rows = this->abs_phase_order->rows;
+
+    int const cx = (this->nx - 1) / 2;
+    int const cy = (this->ny - 1) / 2;
+
+    int const maxx = cols - this->nx + cx + 1;
+    int const maxy = rows - this->ny + cy + 1;
+
+    double const n = (double)( this->nx * this->ny );
+    double const inv_n = 1.0 / n;
+    double const scl_M2 = 1.0 / (n - 1.0);
+
+    int const num_phases = (NULL != this->abs_phase[1])? 2 : 1;
+
+    // Column sums and sums of squares with compensations for each phase image.
+    std::vector<double> buffer( (size_t)(8 * cols) );
+    double * const col_sum[2] = { &( buffer[0] ), &( buffer[4 * cols] ) };
+    double * const col_sum_c[2] = { col_sum[0] + cols, col_sum[1] + cols };
+    double * const col_sq[2] = { col_sum[0] + 2 * cols, col_sum[1] + 2 * cols };
+    double * const col_sq_c[2] = { col_sum[0] + 3 * cols, col_sum[1] + 3 * cols };
+
+    double shift[2] = { 0.0, 0.0 };
+
+    int const y_begin = (r.start > cy)? r.start : cy;
+    int const y_end = (r.end < maxy)? r.end : maxy;
+
+    // Initialize column sums for the first row of the band which has a completely valid ROI.
+    if (y_begin < y_end)
+      {
+        for (int k = 0; k < num_phases; ++k)
+          {
+            cv::Mat const * const src = this->abs_phase[k];
+            shift[k] = *( (double *)( (BYTE *)(src->data) + src->step[0] * (y_begin - cy) ) );
+
+            memset(col_sum[k], 0, sizeof(double) * 4 * cols);
+
+            for (int j = 0; j < this->ny; ++j)
+              {
+                double const * const src_row = (double *)( (BYTE *)(src->data) + src->step[0] * (y_begin - cy + j) );
+                for (int x = 0; x < cols; ++x)
+                  {
+                    double const value = src_row[x] - shift[k];
+                    CompensatedAdd_inline(col_sum[k] + x, col_sum_c[k] + x, value);
+                    CompensatedAdd_inline(col_sq[k] + x, col_sq_c[k] + x, value * value);
+                  }
+                /* for */
+              }
+            /* for */
+          }
+        /* for */
+      }
+    /* if */
+
+    for (int y = r.start; y < r.end; ++y)
+      {
+        float * const phase_order = (float *)( (BYTE *)(this->abs_phase_order->data) + this->abs_phase_order->step[0] * y );
+        float * const phase_deviation = (float *)( (BYTE *)(this->abs_phase_deviation->data) + this->abs_phase_deviation->step[0] * y );
+
+        // Set rows without a completely valid ROI to zero.
+        if ( (y < y_begin) || (y_end <= y) )
+          {
+            for (int x = 0; x < cols; ++x)
+              {
+                phase_order[x] = 0.0f;
+                phase_deviation[x] = 0.0f;
+              }
+            /* for */
+            continue;
+          }
+        /* if */
+
+        // Set borders to zero.
+        for (int x = 0; x < cx; ++x)
+          {
+            phase_order[x] = 0.0f;
+            phase_deviation[x] = 0.0f;
+          }
+        /* for */
+
+        for (int x = maxx; x < cols; ++x)
+          {
+            phase_order[x] = 0.0f;
+            phase_deviation[x] = 0.0f;
+          }
+        /* for */
+
+        for (int k = 0; k < num_phases; ++k)
+          {
+            cv::Mat const * const src = this->abs_phase[k];
+            double const * const src_row = (double *)( (BYTE *)(src->data) + src->step[0] * y );
+
+            // Slide column sums down by one row.
+            if (y_begin < y)
+              {
+                double const * const row_out = (double *)( (BYTE *)(src->data) + src->step[0] * (y - cy - 1) );
+                double const * const row_in = (double *)( (BYTE *)(src->data) + src->step[0] * (y - cy + this->ny - 1) );
+                for (int x = 0; x < cols; ++x)
+                  {
+                    double const value_out = row_out[x] - shift[k];
+                    double const value_in = row_in[x] - shift[k];
+                    CompensatedAdd_inline(col_sum[k] + x, col_sum_c[k] + x, -value_out);
+                    CompensatedAdd_inline(col_sum[k] + x, col_sum_c[k] + x, value_in);
+                    CompensatedAdd_inline(col_sq[k] + x, col_sq_c[k] + x, -value_out * value_out);
+                    CompensatedAdd_inline(col_sq[k] + x, col_sq_c[k] + x, value_in * value_in);
+                  }
+                /* for */
+              }
+            /* if */
+
+            // Compute window sums for the first valid pixel.
+            double sum = 0.0;
+            double sum_c = 0.0;
+            double sq = 0.0;
+            double sq_c = 0.0;
+            for (int i = 0; i < this->nx; ++i)
+              {
+                CompensatedAdd_inline(&sum, &sum_c, col_sum[k][i] + col_sum_c[k][i]);
+                CompensatedAdd_inline(&sq, &sq_c, col_sq[k][i] + col_sq_c[k][i]);
+              }
+            /* for */
+
+            // Slide window along the row.
+            for (int x = cx; x < maxx; ++x)
+              {
+                if (cx < x)
+                  {
+                    int const i_out = x - cx - 1;
+                    int const i_in = x - cx + this->nx - 1;
+                    CompensatedAdd_inline(&sum, &sum_c, -( col_sum[k][i_out] + col_sum_c[k][i_out] ));
+                    CompensatedAdd_inline(&sum, &sum_c, col_sum[k][i_in] + col_sum_c[k][i_in]);
+                    CompensatedAdd_inline(&sq, &sq_c, -( col_sq[k][i_out] + col_sq_c[k][i_out] ));
+                    CompensatedAdd_inline(&sq, &sq_c, col_sq[k][i_in] + col_sq_c[k][i_in]);
+                  }
+                /* if */
+
+                double const S = sum + sum_c;
+                double const mean = S * inv_n;
+                double const M2 = (sq + sq_c) - S * mean;
+                double const dev = (0.0 < M2)? sqrt( scl_M2 * M2 ) : 0.0;
+
+                float const order = (float)( fabs(mean + shift[k] - src_row[x]) );
+
+                if ( (0 == k) || (phase_order[x] < order) ) phase_order[x] = order;
+                if ( (0 == k) || (phase_deviation[x] < (float)(dev)) ) phase_deviation[x] = (float)(dev);
+              }
+            /* for */
+          }
+        /* for */
+      }
+    /* for */
+  }
+
+};
+/* GetAbsolutePhaseOrderAndDeviationParallel_ */
+
+
+
+//! Compute and combine statistics.
+/*!
+  Computes phase order and phase deviation for one or two absolute phase
+  images using a sliding window and combines them by keeping the highest
+  value (the worst case). Phase deviation is the same as when calling
+  GetAbsolutePhaseOrderAndDeviation for each image and combining the outputs
+  with CombinePhaseDeviationOrDistance up to rounding; however, cost per pixel
+  does not depend on the window size and bands of rows are processed in parallel.
+  Phase order is the absolute difference between the window mean and the
+  value of the central pixel of the window.
+
+  \param abs_phase_1    First absolute phase image. May be NULL.
+  \param abs_phase_2    Second absolute phase image. May be NULL.
+  \param nx     Sliding window size along x dimension (number of columns).
+  \param ny     Sliding window size along y dimension (number of rows).
+  \param abs_phase_order_out    Pointer where the combined order information will be stored.
+  \param abs_phase_deviation_out        Pointer where the combined deviation information will be stored.
+  \return Returns true if successfull, false otherwise.
+*/
+bool
+GetCombinedAbsolutePhaseOrderAndDeviation(
+                                          cv::Mat * const abs_phase_1,
+                                          cv::Mat * const abs_phase_2,
+                                          int const nx,
+                                          int const ny,
+                                          cv::Mat * * const abs_phase_order_out,
+                                          cv::Mat * * const abs_phase_deviation_out
+                                          )
+{
+  cv::Mat * const abs_phase_a = (NULL != abs_phase_1)? abs_phase_1 : abs_phase_2;
+  cv::Mat * const abs_phase_b = (NULL != abs_phase_1)? abs_phase_2 : NULL;
+
+  assert( (NULL != abs_phase_a) && (NULL != abs_phase_a->data) );
+  if ( (NULL == abs_phase_a) || (NULL == abs_phase_a->data) ) return false;
+
+  assert( (CV_MAT_DEPTH(abs_phase_a->type()) == CV_64F) && (CV_MAT_CN(abs_phase_a->type()) == 1) );
+  if ( (CV_MAT_DEPTH(abs_phase_a->type()) != CV_64F) || (CV_MAT_CN(abs_phase_a->type()) != 1) ) return false;
+
+  // Fetch input image size.
+  int const cols = abs_phase_a->cols;
+  int const rows = abs_phase_a->rows;
+
+  if (NULL != abs_phase_b)
+    {
+      assert( (NULL != abs_phase_b->data) && (CV_MAT_DEPTH(abs_phase_b->type()) == CV_64F) && (CV_MAT_CN(abs_phase_b->type()) == 1) );
+      if ( (NULL == abs_phase_b->data) || (CV_MAT_DEPTH(abs_phase_b->type()) != CV_64F) || (CV_MAT_CN(abs_phase_b->type()) != 1) ) return false;
+
+      assert( (cols == abs_phase_b->cols) && (rows == abs_phase_b->rows) );
+      if ( (cols != abs_phase_b->cols) || (rows != abs_phase_b->rows) ) return false;
+    }
+  /* if */
+
+  assert( (0 < nx) && (nx < cols) );
+  if ( (nx <= 0) || (cols <= nx) ) return false;
+
+  assert( (0 < ny) && (ny < rows) );
+  if ( (ny <= 0) || (rows <= ny) ) return false;
+
+  bool result = true; // Assume success.
+
+  cv::Mat * abs_phase_order = new cv::Mat(rows, cols, CV_32FC1);
+  assert( (NULL != abs_phase_order) && (NULL != abs_phase_order->data) );
+
+  cv::Mat * abs_phase_deviation = new cv::Mat(rows, cols, CV_32FC1);
+  assert( (NULL != abs_phase_deviation) && (NULL != abs_phase_deviation->data) );
+
+  if ( (NULL == abs_phase_order) || (NULL == abs_phase_order->data) ||
+       (NULL == abs_phase_deviation) || (NULL == abs_phase_deviation->data)
+       )
+    {
+      result = false;
+      goto GetCombinedAbsolutePhaseOrderAndDeviation_EXIT;
+    }
+  /* if */
+
+  // Compute mean and standard deviation; bands of rows are processed in parallel.
+  {
+    GetAbsolutePhaseOrderAndDeviationParallel_ body(abs_phase_a, abs_phase_b, nx, ny, abs_phase_order, abs_phase_deviation);
+    cv::parallel_for_( cv::Range(0, rows), body, (double)(rows) / (double)(PHASE_STATISTICS_BAND_HEIGHT) );
+  }
+
+
+  SAFE_ASSIGN_PTR( abs_phase_order, abs_phase_order_out );
+  SAFE_ASSIGN_PTR( abs_phase_deviation, abs_phase_deviation_out );
+
+ GetCombinedAbsolutePhaseOrderAndDeviation_EXIT:
+
+  SAFE_DELETE( abs_phase_order );
+  SAFE_DELETE( abs_phase_deviation );
+
+  return result;
+}
+/* GetCombinedAbsolutePhaseOrderAndDeviation */
+
+
+
 #endif /* !__BATCHACQUISITIONPROCESSINGPHASESHIFT_CPP */
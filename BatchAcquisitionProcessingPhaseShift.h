@@ -28,6 +28,18 @@
 #include "BatchAcquisitionProcessingKDTree.h"
 
 
+/****** FAST ARCTANGENT ******/
+
+//! Upper bound of the absolute error of the fast arctangent (in radians).
+#define FAST_ATAN2_ERROR_BOUND 2.0e-8
+
+//! Computes arctangent for an array.
+void Atan2Array(double const * const, double const * const, double * const, int const, double const, PhaseAtan2Method const);
+
+//! Validates fast arctangent.
+bool ValidateFastAtan2(int const, double * const);
+
+
 /****** RELATIVE PHASE ESTIMATION ******/
 
 //! Relative phase estimation (single precision).
@@ -36,6 +48,18 @@ cv::Mat * EstimateRelativePhaseSingle(ImageSet * const, int const, int const);
 //! Relative phase estimation (double precision).
 cv::Mat * EstimateRelativePhase(ImageSet * const, int const, int const);
 
+//! Fused tiled relative phase estimation (double precision).
+cv::Mat * EstimateRelativePhaseTiled(ImageSet * const, int const, int const, bool const, PhaseAtan2Method const);
+
+//! Fused tiled relative phase estimation into interleaved output (double precision).
+bool EstimateRelativePhaseTiledInterleaved(ImageSet * const, int const, int const, bool const, PhaseAtan2Method const, cv::Mat * const, int const);
+
+//! Fused tiled relative phase, dynamic range, and texture estimation (double precision).
+bool EstimateRelativePhaseDynamicRangeAndTextureTiled(ImageSet * const, int const, int const, bool const, PhaseAtan2Method const, cv::Mat * const, int const, cv::Mat * * const, cv::Mat * * const);
+
+//! Benchmarks relative phase estimation kernels.
+bool BenchmarkRelativePhaseEstimation(ImageSet * const, int const);
+
 
 /****** GRAY CODE DECODING ******/
 
@@ -46,7 +70,10 @@ double * CreateGrayCodeWeights(int const);
 void DeleteGrayCodeWeights(double * const);
 
 //! Decodes Gray code (double precision).
-cv::Mat * DecodeGrayCode(ImageSet * const, int const, int const);
+cv::Mat * DecodeGrayCode(ImageSet * const, cv::Mat *, int const, int const);
+
+//! Decodes Gray code using packed bit-planes (double precision).
+cv::Mat * DecodeGrayCodeTiled(ImageSet * const, int const, int const, int const, int const);
 
 
 /****** ABSOLUTE PHASE ESTIMATION USING GC+PS ******/
@@ -65,10 +92,114 @@ cv::Mat * UnwrapPhasePSAndGC(
                              cv::Mat * * const
                              );
 
+//! Unwraps phase using Gray code in a single streaming pass.
+cv::Mat * UnwrapPhasePSAndGCStreaming(
+                                      ImageSet * const,
+                                      int const,
+                                      int const,
+                                      int const,
+                                      int const,
+                                      int const,
+                                      int const,
+                                      int const,
+                                      int const,
+                                      bool const,
+                                      PhaseAtan2Method const,
+                                      double const,
+                                      cv::Mat * * const,
+                                      cv::Mat * * const,
+                                      cv::Mat * * const
+                                      );
+
 
 
 /****** ABSOLUTE PHASE ESTIMATION USING MPS ******/
 
+//! Maximal number of wavelengths (channels of the interleaved wrapped phase image) for MPS unwrapping.
+#define MPS_MAX_WAVELENGTHS 8
+
+//! Define to store MPS unwrapping plans in files next to the geometry XML file.
+/*!
+  If defined then mps_plan_cache_get reads plans from and writes plans to the directory
+  which holds the geometry XML file. Plan files are checked using a hash of their inputs
+  so a stale file is rebuilt instead of being reused.
+*/
+//#define USE_MPS_PLAN_FILES
+
+//! Maximal number of cells of the MPS nearest-center grid lookup table.
+#define MPS_GRID_LUT_MAX_CELLS (1 << 22)
+
+//! Grid lookup table for nearest-center search.
+/*!
+  Uniform grid over the bounded domain of projected wrapped phases.
+  Each cell stores its Voronoi labels, i.e. the list of all constellation points
+  which may be the closest point to any query inside the cell. Cells inside one
+  Voronoi region have exactly one label; cells crossing a Voronoi boundary have
+  a few. The lookup is exact so the KD tree is not needed when the grid exists.
+  The grid is used for 1D and 2D constellations only; higher dimensions use the KD tree.
+*/
+typedef
+struct MPSGridLUT_
+{
+  int n_dim; //!< Number of dimensions; 1 or 2.
+  int n_bins[2]; //!< Number of cells along each dimension.
+  double origin[2]; //!< Coordinates of the corner of the first cell.
+  double inv_cell; //!< Inverse of the cell size.
+
+  int n_pts; //!< Number of constellation points.
+  double * points; //!< Copy of constellation points; n_pts x 2, row-major, second coordinate is zero for 1D grids.
+
+  int * cell_begin; //!< Index of the first label of each cell; the last element marks the end of the last cell.
+  int * labels; //!< Voronoi labels (indices of constellation points) of all cells.
+
+  //! Constructor.
+  MPSGridLUT_();
+
+  //! Destructor.
+  ~MPSGridLUT_();
+
+  //! Blank class variables.
+  void Blank(void);
+
+} MPSGridLUT;
+
+
+//! MPS unwrapping plan.
+/*!
+  Structure holds all data required to unwrap phase using multiple phase shifting.
+  The plan depends only on fringe counts so it may be reused for all reconstructions
+  which use the same fringe counts.
+*/
+typedef
+struct MPSPlan_
+{
+  std::vector<double> counts; //!< Number of periods per screen for each frequency.
+  double width; //!< Screen width.
+
+  std::vector<double> * lambda; //!< Wavelengths.
+  std::vector<double> * wgt; //!< Weights used to combine unwrapped phases.
+  std::vector<int> * k_max; //!< Maximal period-order number for each wavelength.
+  std::vector<double> * n; //!< Maximal fringe count for each wavelength.
+
+  cv::Mat * O; //!< Orthographic projection matrix.
+  cv::Mat * X; //!< All constellation points.
+  cv::Mat * K; //!< All period-order vectors.
+
+  KDTreeRoot_ * tree; //!< KD tree over constellation points; NULL if grid lookup table is used.
+  MPSGridLUT_ * lut; //!< Grid lookup table over constellation points; may be NULL.
+
+  //! Constructor.
+  MPSPlan_();
+
+  //! Destructor.
+  ~MPSPlan_();
+
+  //! Blank class variables.
+  void Blank(void);
+
+} MPSPlan;
+
+
 //! Compute greatest common divisor of two numbers.
 double mps_gcd(double const, double const);
 
@@ -151,6 +282,14 @@ mps_get_kd_tree(
                 KDTreeRoot_ * * const
                 );
 
+//! Construct grid lookup table.
+bool
+mps_get_grid_lut(
+                 cv::Mat * const,
+                 cv::Mat * const,
+                 MPSGridLUT_ * * const
+                 );
+
 //! Return standard weights.
 bool
 mps_get_weights(
@@ -161,11 +300,12 @@ mps_get_weights(
 //! Unwraps phase using orthographic projection.
 bool
 mps_unwrap_phase(
-                 std::vector<cv::Mat *> const &,
+                 cv::Mat * const,
                  cv::Mat * const,
                  cv::Mat * const,
                  cv::Mat * const,
                  KDTreeRoot * const,
+                 MPSGridLUT const * const,
                  std::vector<double> const &,
                  std::vector<double> const &,
                  cv::Mat * * const,
@@ -173,6 +313,53 @@ mps_unwrap_phase(
                  cv::Mat * * const
                  );
 
+//! Construct MPS unwrapping plan.
+bool
+mps_get_plan(
+             std::vector<double> const &,
+             MPSPlan_ * * const
+             );
+
+//! Computes MPS unwrapping plan hash.
+bool
+mps_plan_hash(
+              wchar_t const * const,
+              std::vector<double> const &,
+              wchar_t const * const,
+              unsigned __int64 * const
+              );
+
+//! Writes MPS unwrapping plan.
+bool
+mps_write_plan(
+               wchar_t const * const,
+               unsigned __int64 const,
+               MPSPlan_ const * const
+               );
+
+//! Reads MPS unwrapping plan.
+bool
+mps_read_plan(
+              wchar_t const * const,
+              std::vector<double> const &,
+              unsigned __int64 const,
+              MPSPlan_ * * const
+              );
+
+//! Get cached MPS unwrapping plan.
+MPSPlan_ *
+mps_plan_cache_get(
+                   std::vector<double> const &,
+                   wchar_t const * const,
+                   wchar_t const * const
+                   );
+
+//! Clear MPS plan cache.
+void
+mps_plan_cache_clear(
+                     void
+                     );
+
 
 /****** PHASE STATISTICS ON SLIDING WINDOW ******/
 
@@ -193,6 +380,17 @@ CombinePhaseDeviationOrDistance(
                                 cv::Mat const * const
                                 );
 
+//! Compute and combine statistics.
+bool
+GetCombinedAbsolutePhaseOrderAndDeviation(
+                                          cv::Mat * const,
+                                          cv::Mat * const,
+                                          int const,
+                                          int const,
+                                          cv::Mat * * const,
+                                          cv::Mat * * const
+                                          );
+
 
 
 #endif /* !__BATCHACQUISITIONPROCESSINGPHASESHIFT_H */
@@ -69,11 +69,191 @@ GetAbsoluteThreshold(
 
 
 
+//! Number of rows in one band of valid pixel selection.
+#define VALID_PIXELS_BAND_HEIGHT 32
+
+
+
+//! Number of set bits in a 4-bit SSE comparison mask.
+static
+int const gValidPixelsMaskCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+
+
+//! Parallel count of valid pixels.
+/*!
+  Each invocation counts pixels whose dynamic range is above the threshold
+  for a band of rows. Counts are stored per row so the prefix sum and the
+  scatter do not depend on how rows are split between threads.
+  Four pixels are compared at once using SSE.
+*/
+struct CountValidPixelsParallel_ : public cv::ParallelLoopBody
+{
+  cv::Mat const * dynamic_range; //!< Dynamic range image (CV_32FC1).
+  float threshold; //!< Threshold.
+  int * row_count; //!< Output number of valid pixels in each row.
+
+  //! Constructor.
+  CountValidPixelsParallel_(
+                            cv::Mat const * const dynamic_range_in,
+                            float const threshold_in,
+                            int * const row_count_in
+                            )
+  {
+    this->dynamic_range = dynamic_range_in;
+    this->threshold = threshold_in;
+    this->row_count = row_count_in;
+  }
+
+  //! Counts valid pixels in a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const cols = this->dynamic_range->cols;
+    float const thr = this->threshold;
+    __m128 const thr4 = _mm_set1_ps(thr);
+
+    for (int y = r.start; y < r.end; ++y)
+      {
+        float const * const row_dynamic_range = (float *)( (BYTE *)(this->dynamic_range->data) + this->dynamic_range->step[0] * y );
+
+        int count = 0;
+
+        int x = 0;
+        int const max_x = cols - 3;
+        for (; x < max_x; x += 4)
+          {
+            int const mask = _mm_movemask_ps( _mm_cmplt_ps( thr4, _mm_loadu_ps(row_dynamic_range + x) ) );
+            count += gValidPixelsMaskCount[mask];
+          }
+        /* for */
+
+        // Complete to end.
+        for (; x < cols; ++x) if (thr < row_dynamic_range[x]) ++count;
+
+        this->row_count[y] = count;
+      }
+    /* for */
+  }
+};
+/* CountValidPixelsParallel_ */
+
+
+
+//! Parallel scatter of valid pixels.
+/*!
+  Each invocation writes coordinates and dynamic range of valid pixels
+  for a band of rows starting at row offsets computed by the prefix sum.
+  Groups of four pixels are compared using SSE; if all four are valid they
+  are stored at once and otherwise only valid pixels are stored.
+*/
+struct ScatterValidPixelsParallel_ : public cv::ParallelLoopBody
+{
+  cv::Mat const * dynamic_range; //!< Dynamic range image (CV_32FC1).
+  float threshold; //!< Threshold.
+  int const * row_offset; //!< Index of the first valid pixel of each row in the output.
+  int * crd_x; //!< Output x coordinates.
+  int * crd_y; //!< Output y coordinates.
+  float * range; //!< Output dynamic range values.
+
+  //! Constructor.
+  ScatterValidPixelsParallel_(
+                              cv::Mat const * const dynamic_range_in,
+                              float const threshold_in,
+                              int const * const row_offset_in,
+                              int * const crd_x_in,
+                              int * const crd_y_in,
+                              float * const range_in
+                              )
+  {
+    this->dynamic_range = dynamic_range_in;
+    this->threshold = threshold_in;
+    this->row_offset = row_offset_in;
+    this->crd_x = crd_x_in;
+    this->crd_y = crd_y_in;
+    this->range = range_in;
+  }
+
+  //! Scatters valid pixels of a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const cols = this->dynamic_range->cols;
+    float const thr = this->threshold;
+    __m128 const thr4 = _mm_set1_ps(thr);
+    __m128i const step4 = _mm_set_epi32(3, 2, 1, 0);
+
+    for (int y = r.start; y < r.end; ++y)
+      {
+        float const * const row_dynamic_range = (float *)( (BYTE *)(this->dynamic_range->data) + this->dynamic_range->step[0] * y );
+
+        int * const ptr_crd_x = this->crd_x;
+        int * const ptr_crd_y = this->crd_y;
+        float * const ptr_range = this->range;
+        int k = this->row_offset[y];
+
+        __m128i const y4 = _mm_set1_epi32(y);
+
+        int x = 0;
+        int const max_x = cols - 3;
+        for (; x < max_x; x += 4)
+          {
+            __m128 const value = _mm_loadu_ps(row_dynamic_range + x);
+            int const mask = _mm_movemask_ps( _mm_cmplt_ps(thr4, value) );
+            if (0xF == mask)
+              {
+                _mm_storeu_si128( (__m128i *)(ptr_crd_x + k), _mm_add_epi32(_mm_set1_epi32(x), step4) );
+                _mm_storeu_si128( (__m128i *)(ptr_crd_y + k), y4 );
+                _mm_storeu_ps( ptr_range + k, value );
+                k += 4;
+              }
+            else if (0 != mask)
+              {
+                for (int i = 0; i < 4; ++i)
+                  {
+                    if (0 == (mask & (1 << i))) continue;
+                    ptr_crd_x[k] = x + i;
+                    ptr_crd_y[k] = y;
+                    ptr_range[k] = row_dynamic_range[x + i];
+                    ++k;
+                  }
+                /* for */
+              }
+            /* if */
+          }
+        /* for */
+
+        // Complete to end.
+        for (; x < cols; ++x)
+          {
+            if (thr < row_dynamic_range[x])
+              {
+                ptr_crd_x[k] = x;
+                ptr_crd_y[k] = y;
+                ptr_range[k] = row_dynamic_range[x];
+                ++k;
+              }
+            /* if */
+          }
+        /* for */
+
+        assert(k == this->row_offset[y + 1]);
+      }
+    /* for */
+  }
+};
+/* ScatterValidPixelsParallel_ */
+
+
+
 //! Creates matrices holding pixel coordinates.
 /*!
   Function creates matrices holding pixel coordinates.
   Pixel coordinates follow C/C++ convention so first pixel has both coordinates 0.
 
+  Selection is done in three steps: valid pixels of each row are counted in parallel,
+  a prefix sum of row counts gives the output position of each row, and valid pixels
+  are then scattered in parallel to outputs which are allocated to the exact size.
+  Pixels are listed row-wise.
+
   \param dynamic_range  Pointer to dynamic range image.
   \param threshold      Threshold for the dynamic range image.
   \param crd_x_out      Address where a pointer to a matrix holding x (column) image coordinates will be stored.
@@ -108,13 +288,38 @@ GetValidPixelCoordinates(
 
   bool result = true; // Assume processing succeeded.
 
-  cv::Mat * crd_x = new cv::Mat(1, N, CV_32S, cv::Scalar(-1));
+  cv::Mat * crd_x = NULL;
+  cv::Mat * crd_y = NULL;
+  cv::Mat * range = NULL;
+
+  int k = 0; // Number of valid pixels.
+  double const nstripes = (double)(rows) / (double)(VALID_PIXELS_BAND_HEIGHT);
+
+  // Row counts are stored starting from the second element so they may be summed in place.
+  int * row_offset = new int[rows + 1];
+  assert(NULL != row_offset);
+  if (NULL == row_offset) return false;
+
+  // Count valid pixels of each row.
+  {
+    CountValidPixelsParallel_ body(dynamic_range, threshold, row_offset + 1);
+    cv::parallel_for_( cv::Range(0, rows), body, nstripes );
+  }
+
+  // Compute row offsets.
+  row_offset[0] = 0;
+  for (int y = 0; y < rows; ++y) row_offset[y + 1] += row_offset[y];
+  k = row_offset[rows];
+  assert( (0 <= k) && (k <= N) );
+
+  // Allocate outputs of the exact size.
+  crd_x = new cv::Mat(1, k, CV_32S);
   assert(NULL != crd_x);
 
-  cv::Mat * crd_y = new cv::Mat(1, N, CV_32S, cv::Scalar(-1));
+  crd_y = new cv::Mat(1, k, CV_32S);
   assert(NULL != crd_y);
 
-  cv::Mat * range = new cv::Mat(1, N, CV_32F, cv::Scalar(-1.0));
+  range = new cv::Mat(1, k, CV_32F);
   assert(NULL != range);
 
   if ( (NULL == crd_x) || (NULL == crd_y) || (NULL == range) )
@@ -124,93 +329,18 @@ GetValidPixelCoordinates(
     }
   /* if */
 
-  // Get row pointers.
-  int * const ptr_crd_x = (int *)( (BYTE *)(crd_x->data) + crd_x->step[0] * 0 );
-  int * const ptr_crd_y = (int *)( (BYTE *)(crd_y->data) + crd_y->step[0] * 0 );
-  float * const ptr_range = (float *)( (BYTE *)(range->data) + range->step[0] * 0 );
-  int k = 0;
-
   // Get coordinates of valid pixels.
-  for (int y = 0; y < rows; ++y)
-    {
-      // Get row addresses.
-      float const * const row_dynamic_range = (float *)( (BYTE *)(dynamic_range->data) + dynamic_range->step[0] * y );
-
-      // Assign coordinates sequentially..
-      for (int x = 0; x < cols; ++x)
-        {
-          if (threshold < row_dynamic_range[x])
-            {
-              ptr_crd_x[k] = x;
-              ptr_crd_y[k] = y;
-              ptr_range[k] = row_dynamic_range[x];
-              ++k;
-            }
-          /* if */
-        }
-      /* for */
-    }
-  /* for */
-
-  // Create new cv::Mat headers for output buffers. Note that we do not reallocate
-  // allocated storage; instead only header data of cv::Mat is changed to reflect
-  // the correct number of valid points.
-  cv::Range r[2] = {cv::Range::all(), cv::Range(0, k)};
-
   if (0 < k)
     {
-      cv::Mat * crd_x_tmp = new cv::Mat(*crd_x, r);
-      assert(NULL != crd_x_tmp);
-      if (NULL != crd_x_tmp)
-        {
-          SAFE_DELETE(crd_x);
-          crd_x = crd_x_tmp;
-          crd_x_tmp = NULL;
-        }
-      else
-        {
-          result = false;
-        }
-      /* if */
-
-      cv::Mat * crd_y_tmp = new cv::Mat(*crd_y, r);
-      assert(NULL != crd_y_tmp);
-      if (NULL != crd_y_tmp)
-        {
-          SAFE_DELETE(crd_y);
-          crd_y = crd_y_tmp;
-          crd_y_tmp = NULL;
-        }
-      else
-        {
-          result = false;
-        }
-      /* if */
-
-      cv::Mat * range_tmp = new cv::Mat(*range, r);
-      assert(NULL != range_tmp);
-      if (NULL != range_tmp)
-        {
-          SAFE_DELETE(range);
-          range = range_tmp;
-          range_tmp = NULL;
-        }
-      else
-        {
-          result = false;
-        }
-      /* if */
-    }
-  else
-    {
-      crd_x->create(1, 0, CV_32S);
-      crd_y->create(1, 0, CV_32S);
-      range->create(1, 0, CV_32F);
-      assert(true == result);
+      int * const ptr_crd_x = (int *)( (BYTE *)(crd_x->data) + crd_x->step[0] * 0 );
+      int * const ptr_crd_y = (int *)( (BYTE *)(crd_y->data) + crd_y->step[0] * 0 );
+      float * const ptr_range = (float *)( (BYTE *)(range->data) + range->step[0] * 0 );
+
+      ScatterValidPixelsParallel_ body(dynamic_range, threshold, row_offset, ptr_crd_x, ptr_crd_y, ptr_range);
+      cv::parallel_for_( cv::Range(0, rows), body, nstripes );
     }
   /* if */
 
-  
   SAFE_ASSIGN_PTR( crd_x, crd_x_out );
   SAFE_ASSIGN_PTR( crd_y, crd_y_out );
   SAFE_ASSIGN_PTR( range, range_out );
@@ -221,6 +351,8 @@ GetValidPixelCoordinates(
   SAFE_DELETE( crd_y );
   SAFE_DELETE( range );
 
+  SAFE_DELETE_ARRAY( row_offset );
+
   return result;
 }
 /* GetValidPixelCoordinates */
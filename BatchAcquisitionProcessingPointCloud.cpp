@@ -118,7 +118,8 @@ PointCloudCenterOfMass(
   Function computes median of a point cloud using Weiszfeld's algorithm.
   Note that median is not affected of the number of outliers in the data is limited.
 
-  \param points Pointer to array holding point coordinates.
+  \param points Pointer to array holding point coordinates. Array must be CV_64F;
+  CV_32F is accepted only for three-dimensional points.
   \param md_out Pointer where found median will be stored.
   \param cm_out Pointer where found center of mass will be stored.
   \param niter_stop Maximal number of iterations.
@@ -146,8 +147,8 @@ PointCloudWeiszfeld(
   assert( 1 == CV_MAT_CN(points_type) );
   if (1 != CV_MAT_CN(points_type) ) return false;
 
-  assert( CV_64F == points_depth );
-  if ( CV_64F != points_depth ) return false;
+  assert( (CV_64F == points_depth) || ( (CV_32F == points_depth) && (3 == points->cols) ) );
+  if ( (CV_64F != points_depth) && ( (CV_32F != points_depth) || (3 != points->cols) ) ) return false;
 
   bool result = true;
 
@@ -193,33 +194,72 @@ PointCloudWeiszfeld(
           double const my = md.at<double>(0, 1);
           double const mz = md.at<double>(0, 2);
 
-          for (int j = 0; j < N; ++j)
+          switch (points_depth)
             {
-              double const * const ptr_row_points = (double *)( ptr_points + j * step_points );
-
-              double const x = ptr_row_points[0];
-              double const y = ptr_row_points[1];
-              double const z = ptr_row_points[2];
-
-              double const dx = x - mx;
-              double const dy = y - my;
-              double const dz = z - mz;
-
-              double const sum2 = dx * dx + dy * dy + dz * dz;
-              double const d = sqrt(sum2);
-              double const d_inv = 1.0 / d;
-
-              if (FLT_EPSILON < d)
-                {
-                  acc += d_inv;
+            case CV_32F:
+              {
+                for (int j = 0; j < N; ++j)
+                  {
+                    float const * const ptr_row_points = (float *)( ptr_points + j * step_points );
+
+                    double const x = ptr_row_points[0];
+                    double const y = ptr_row_points[1];
+                    double const z = ptr_row_points[2];
+
+                    double const dx = x - mx;
+                    double const dy = y - my;
+                    double const dz = z - mz;
+
+                    double const sum2 = dx * dx + dy * dy + dz * dz;
+                    double const d = sqrt(sum2);
+                    double const d_inv = 1.0 / d;
+
+                    if (FLT_EPSILON < d)
+                      {
+                        acc += d_inv;
+
+                        acc_x += x * d_inv;
+                        acc_y += y * d_inv;
+                        acc_z += z * d_inv;
+                      }
+                    /* if */
+                  }
+                /* for */
+              }
+              break;
 
-                  acc_x += x * d_inv;
-                  acc_y += y * d_inv;
-                  acc_z += z * d_inv;
-                }
-              /* if */
+            default:
+              {
+                for (int j = 0; j < N; ++j)
+                  {
+                    double const * const ptr_row_points = (double *)( ptr_points + j * step_points );
+
+                    double const x = ptr_row_points[0];
+                    double const y = ptr_row_points[1];
+                    double const z = ptr_row_points[2];
+
+                    double const dx = x - mx;
+                    double const dy = y - my;
+                    double const dz = z - mz;
+
+                    double const sum2 = dx * dx + dy * dy + dz * dz;
+                    double const d = sqrt(sum2);
+                    double const d_inv = 1.0 / d;
+
+                    if (FLT_EPSILON < d)
+                      {
+                        acc += d_inv;
+
+                        acc_x += x * d_inv;
+                        acc_y += y * d_inv;
+                        acc_z += z * d_inv;
+                      }
+                    /* if */
+                  }
+                /* for */
+              }
             }
-          /* for */
+          /* switch */
 
           den.create(1, 1, CV_64FC1);
           den.at<double>(0, 0) = acc;
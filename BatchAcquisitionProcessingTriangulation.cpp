@@ -28,12 +28,53 @@
 #define __BATCHACQUISITIONPROCESSINGTRIANGULATION_CPP
 
 
+#include "BatchAcquisitionMessages.h"
 #include "BatchAcquisitionProcessingTriangulation.h"
 #include "BatchAcquisitionProcessingPixelSelector.h"
+#include "BatchAcquisitionProcessingDistortion.h"
+#include "BatchAcquisitionDebug.h"
+#include <immintrin.h>
 
 #pragma intrinsic(sqrt)
 
 
+
+//! Number of points processed as one chunk by the fused triangulation kernel.
+#define TRIANGULATION_CHUNK_SIZE 4096
+
+//! Height of the band of rows processed by one thread when filling the camera ray table.
+#define CAMERA_RAY_TABLE_BAND_HEIGHT 32
+
+//! Number of single precision coefficients of one pixel of the phase-to-XYZ model.
+#define PHASE_TO_XYZ_MODEL_COEFFICIENTS 12
+
+//! Height of the band of rows processed by one thread when fitting the phase-to-XYZ model.
+#define PHASE_TO_XYZ_MODEL_BAND_HEIGHT 8
+
+//! Number of projector pixels by which the phase-to-XYZ model extends past projector resolution.
+#define PHASE_TO_XYZ_MODEL_MARGIN 8
+
+
+
+//! Cache of camera ray tables; there is at most one table for each camera name.
+static std::vector<CameraRayTable *> gCameraRayTableCache;
+
+//! Slim Reader/Writer lock for camera ray table cache.
+static SRWLOCK gCameraRayTableCacheLock = SRWLOCK_INIT;
+
+//! Camera ray tables replaced in the cache while still in use; each is deleted by CameraRayTableCacheRelease when released by its last user.
+static std::vector<CameraRayTable *> gCameraRayTableRetired;
+
+//! Cache of phase-to-XYZ models; there is at most one model for each camera name, projector name, and projector coordinate.
+static std::vector<PhaseToXYZModel *> gPhaseToXYZModelCache;
+
+//! Slim Reader/Writer lock for phase-to-XYZ model cache.
+static SRWLOCK gPhaseToXYZModelCacheLock = SRWLOCK_INIT;
+
+//! Phase-to-XYZ models replaced in the cache while still in use; each is deleted by PhaseToXYZModelCacheRelease when released by its last user.
+static std::vector<PhaseToXYZModel *> gPhaseToXYZModelRetired;
+
+
 /****** INLINE HELPER FUNCTIONS ******/
 
 //! Validates row array.
@@ -555,6 +596,34 @@ RayRayIntersection(
 
 /****** RAY GENERATORS ******/
 
+//! Get pseudoinverse of the projection matrix.
+/*!
+  Computes pseudoinverse of the 3x4 projection matrix which backprojects
+  homogeneous image coordinates to homogeneous world coordinates.
+
+  \param PG     Pinhole camera geometry.
+  \param Pinv   Array of 12 elements where the 4x3 pseudoinverse will be stored in row-major order.
+*/
+inline
+void
+GetProjectionPseudoinverse_inline(
+                                  ProjectiveGeometry * const PG,
+                                  double * const Pinv
+                                  )
+{
+  assert( (NULL != PG) && (NULL != Pinv) );
+
+  cv::Mat P(3, 4, CV_64F, &(PG->projection[0][0]), 4 * sizeof(double));
+  cv::Mat PT = P.t();
+  cv::Mat PPT = P * PT;
+  cv::Mat PPinv = PT * PPT.inv(cv::DECOMP_SVD);
+
+  for (int i = 0; i < 12; ++i) Pinv[i] = PPinv.at<double>(i);
+}
+/* GetProjectionPseudoinverse_inline */
+
+
+
 //! Get camera planes.
 /*!
   Computes coefficients of all camera planes for input coordinates.
@@ -731,10 +800,8 @@ GetCameraRays(
   bool result = true; // Assume success.
 
   // Compute pseudoinverse of the projection matrix.
-  cv::Mat P(3, 4, CV_64F, &(PG->projection[0][0]), 4 * sizeof(double));
-  cv::Mat PT = P.t();
-  cv::Mat PPT = P * PT;
-  cv::Mat Pinv = PT * PPT.inv(cv::DECOMP_SVD);
+  double Pinv[12];
+  GetProjectionPseudoinverse_inline(PG, Pinv);
 
   // Preallocate outputs.
   int const N = x->cols;
@@ -766,10 +833,10 @@ GetCameraRays(
   double * const row_vz = (double *)( (BYTE *)(vz->data) + vz->step[0] * 0 );
 
   // Get values of the pseudoinverse projection matrix.
-  double const pxx = Pinv.at<double>(0);  double const pxy = Pinv.at<double>( 1);  double const pxh = Pinv.at<double>( 2);
-  double const pyx = Pinv.at<double>(3);  double const pyy = Pinv.at<double>( 4);  double const pyh = Pinv.at<double>( 5);
-  double const pzx = Pinv.at<double>(6);  double const pzy = Pinv.at<double>( 7);  double const pzh = Pinv.at<double>( 8);
-  double const phx = Pinv.at<double>(9);  double const phy = Pinv.at<double>(10);  double const phh = Pinv.at<double>(11);
+  double const pxx = Pinv[0];  double const pxy = Pinv[ 1];  double const pxh = Pinv[ 2];
+  double const pyx = Pinv[3];  double const pyy = Pinv[ 4];  double const pyh = Pinv[ 5];
+  double const pzx = Pinv[6];  double const pzy = Pinv[ 7];  double const pzh = Pinv[ 8];
+  double const phx = Pinv[9];  double const phy = Pinv[10];  double const phh = Pinv[11];
 
   // Get camera center.
   double const cx = PG->center[0];
@@ -820,12 +887,16 @@ GetCameraRays(
 
 /****** TRIANGULATION ******/
 
-//! Triangulates two views.
+//! Triangulates two views (reference implementation).
 /*!
   Function computes intersections of two views.
   Note that exactly one of x1, y2, x2, and y2 may be NULL; if so
   then dst2 will not be computed.
 
+  This is the reference implementation which first computes rays and planes
+  for all points and then intersects them in separate passes.
+  It is kept to validate the fused kernel used by TriangulateTwoViews.
+
   \param PG1    Projective geometry for the first view.
   \param x1     Undistorted image x coordinates for the first view.
   \param y1     Undistorted image y coordinates for the first view.
@@ -839,18 +910,18 @@ GetCameraRays(
   \return Function returns true if successfull, false otherwise.
 */
 bool
-TriangulateTwoViews(
-                    ProjectiveGeometry * const PG1,
-                    cv::Mat * const x1,
-                    cv::Mat * const y1,
-                    ProjectiveGeometry * const PG2,
-                    cv::Mat * const x2,
-                    cv::Mat * const y2,
-                    cv::Mat * * const x_out,
-                    cv::Mat * * const y_out,
-                    cv::Mat * * const z_out,
-                    cv::Mat * * const dst2_out
-                    )
+TriangulateTwoViewsReference(
+                             ProjectiveGeometry * const PG1,
+                             cv::Mat * const x1,
+                             cv::Mat * const y1,
+                             ProjectiveGeometry * const PG2,
+                             cv::Mat * const x2,
+                             cv::Mat * const y2,
+                             cv::Mat * * const x_out,
+                             cv::Mat * * const y_out,
+                             cv::Mat * * const z_out,
+                             cv::Mat * * const dst2_out
+                             )
 {
   int const E1 = ( (NULL == x1)? 1 : 0 ) + ( (NULL == y1)? 1 : 0 );
   int const E2 = ( (NULL == x2)? 1 : 0 ) + ( (NULL == y2)? 1 : 0 );
@@ -949,435 +1020,3492 @@ TriangulateTwoViews(
 
   return result;
 }
-/* TriangulateTwoViews */
+/* TriangulateTwoViewsReference */
 
 
 
-/****** PROJECTION ******/
+/****** FUSED TRIANGULATION ******/
 
-//! Projects points.
+//! Loads packed values.
 /*!
-  Function projects points in 3D to 2D using pinhole camera model.
+  Loads two consecutive values or one value if only one point remains.
 
-  \param PG     Pinhole camera geometry.
-  \param x_3D   X coordinates in 3D.
-  \param y_3D   Y coordinates in 3D.
-  \param z_3D   Z coordinates in 3D.
-  \param x_2D_out       Address where x coordinates in 2D will be stored.
-  \param y_2D_out       Address where y coordiantes in 2D will be stored.
-  \return Function returns true if successfull, false otherwise.
+  \param src    Pointer to the first value.
+  \param n      Number of values to load; must be 1 or 2.
+  \return Returns packed values.
 */
-bool
-ProjectPoints(
-              ProjectiveGeometry * const PG,
-              cv::Mat * const x_3D,
-              cv::Mat * const y_3D,
-              cv::Mat * const z_3D,
-              cv::Mat * * const x_2D_out,
-              cv::Mat * * const y_2D_out
-              )
+inline
+__m128d
+LoadPacked_inline(
+                  double const * const src,
+                  int const n
+                  )
 {
-  assert(NULL != PG);
-  if (NULL == PG) return false;
+  return (2 == n)? _mm_loadu_pd(src) : _mm_load_sd(src);
+}
+/* LoadPacked_inline */
 
-  int const num_3D = CheckRowArrays_inline(CV_64F, x_3D, y_3D, z_3D);
-  assert(3 == num_3D);
-  if (3 != num_3D) return false;
 
-  bool result = true; // Assume success.
 
-  int const N = x_3D->cols;
+//! Stores packed values.
+/*!
+  Stores two consecutive values or one value if only one point remains.
 
-  cv::Mat * x_2D = new cv::Mat(1, N, CV_64F);
-  assert(NULL != x_2D);
+  \param dst    Pointer to the first value.
+  \param v      Packed values.
+  \param n      Number of values to store; must be 1 or 2.
+*/
+inline
+void
+StorePacked_inline(
+                   double * const dst,
+                   __m128d const v,
+                   int const n
+                   )
+{
+  if (2 == n) _mm_storeu_pd(dst, v); else _mm_store_sd(dst, v);
+}
+/* StorePacked_inline */
 
-  cv::Mat * y_2D = new cv::Mat(1, N, CV_64F);
-  assert(NULL != y_2D);
 
-  if ( (NULL == x_2D) || (NULL == y_2D) )
-    {
-      result = false;
-      goto ProjectPoints_EXIT;
-    }
-  /* if */
 
-  // Get row pointers.
-  double const * const row_x_3D = (double *)( (BYTE *)(x_3D->data) + x_3D->step[0] * 0 );
-  double const * const row_y_3D = (double *)( (BYTE *)(y_3D->data) + y_3D->step[0] * 0 );
-  double const * const row_z_3D = (double *)( (BYTE *)(z_3D->data) + z_3D->step[0] * 0 );
-  double * const row_x_2D = (double *)( (BYTE *)(x_2D->data) + x_2D->step[0] * 0 );
-  double * const row_y_2D = (double *)( (BYTE *)(y_2D->data) + y_2D->step[0] * 0 );
+//! Computes camera rays for two points.
+/*!
+  Computes unit ray directions for two points using the same expressions
+  as GetCameraRays.
+
+  \param x      X coordinates in the image plane.
+  \param y      Y coordinates in the image plane.
+  \param Pinv   Pseudoinverse of the projection matrix (4x3, row-major).
+  \param center Camera center.
+  \param vx     Address where x ray direction coefficients will be stored.
+  \param vy     Address where y ray direction coefficients will be stored.
+  \param vz     Address where z ray direction coefficients will be stored.
+*/
+inline
+void
+GetCameraRaysPacked_inline(
+                           __m128d const x,
+                           __m128d const y,
+                           double const * const Pinv,
+                           double const * const center,
+                           __m128d * const vx,
+                           __m128d * const vy,
+                           __m128d * const vz
+                           )
+{
+  __m128d const one = _mm_set1_pd(1.0);
 
-  // Get projection matrix coefficients.
-  double const pxx = PG->projection[0][0];
-  double const pxy = PG->projection[0][1];
-  double const pxz = PG->projection[0][2];
-  double const pxh = PG->projection[0][3];
+  __m128d const x3 = _mm_add_pd( _mm_add_pd( _mm_mul_pd(_mm_set1_pd(Pinv[ 0]), x), _mm_mul_pd(_mm_set1_pd(Pinv[ 1]), y) ), _mm_set1_pd(Pinv[ 2]) );
+  __m128d const y3 = _mm_add_pd( _mm_add_pd( _mm_mul_pd(_mm_set1_pd(Pinv[ 3]), x), _mm_mul_pd(_mm_set1_pd(Pinv[ 4]), y) ), _mm_set1_pd(Pinv[ 5]) );
+  __m128d const z3 = _mm_add_pd( _mm_add_pd( _mm_mul_pd(_mm_set1_pd(Pinv[ 6]), x), _mm_mul_pd(_mm_set1_pd(Pinv[ 7]), y) ), _mm_set1_pd(Pinv[ 8]) );
+  __m128d const h3 = _mm_add_pd( _mm_add_pd( _mm_mul_pd(_mm_set1_pd(Pinv[ 9]), x), _mm_mul_pd(_mm_set1_pd(Pinv[10]), y) ), _mm_set1_pd(Pinv[11]) );
 
-  double const pyx = PG->projection[1][0];
-  double const pyy = PG->projection[1][1];
-  double const pyz = PG->projection[1][2];
-  double const pyh = PG->projection[1][3];
+  __m128d const h3_inv = _mm_div_pd(one, h3);
 
-  double const phx = PG->projection[2][0];
-  double const phy = PG->projection[2][1];
-  double const phz = PG->projection[2][2];
-  double const phh = PG->projection[2][3];
+  __m128d const val_vx = _mm_sub_pd( _mm_mul_pd(x3, h3_inv), _mm_set1_pd(center[0]) );
+  __m128d const val_vy = _mm_sub_pd( _mm_mul_pd(y3, h3_inv), _mm_set1_pd(center[1]) );
+  __m128d const val_vz = _mm_sub_pd( _mm_mul_pd(z3, h3_inv), _mm_set1_pd(center[2]) );
 
-  // Project points.
-  for (int i = 0; i < N; ++i)
-    {
-      double const x2 = pxx * row_x_3D[i] + pxy * row_y_3D[i] + pxz * row_z_3D[i] + pxh;
-      double const y2 = pyx * row_x_3D[i] + pyy * row_y_3D[i] + pyz * row_z_3D[i] + pyh;
-      double const h2 = phx * row_x_3D[i] + phy * row_y_3D[i] + phz * row_z_3D[i] + phh;
+  __m128d const v2 = _mm_add_pd( _mm_add_pd( _mm_mul_pd(val_vx, val_vx), _mm_mul_pd(val_vy, val_vy) ), _mm_mul_pd(val_vz, val_vz) );
+  __m128d const k = _mm_div_pd(one, _mm_sqrt_pd(v2));
 
-      double const h2_inv = 1.0 / h2;
+  *vx = _mm_mul_pd(k, val_vx);
+  *vy = _mm_mul_pd(k, val_vy);
+  *vz = _mm_mul_pd(k, val_vz);
+}
+/* GetCameraRaysPacked_inline */
 
-      row_x_2D[i] = x2 * h2_inv;
-      row_y_2D[i] = y2 * h2_inv;
-    }
-  /* for */
 
 
-  SAFE_ASSIGN_PTR( x_2D, x_2D_out );
-  SAFE_ASSIGN_PTR( y_2D, y_2D_out );
+//! Computes camera planes for two points.
+/*!
+  Computes normalized plane coefficients for two points using the same
+  expressions as GetCameraPlanes.
+
+  \param u      X or Y coordinates in the image plane.
+  \param P      Array of 8 elements holding the row of the projection matrix
+  which corresponds to coordinate u followed by the last row of the projection matrix.
+  \param A      Address where first plane coefficients will be stored.
+  \param B      Address where second plane coefficients will be stored.
+  \param C      Address where third plane coefficients will be stored.
+  \param D      Address where fourth plane coefficients will be stored.
+*/
+inline
+void
+GetCameraPlanesPacked_inline(
+                             __m128d const u,
+                             double const * const P,
+                             __m128d * const A,
+                             __m128d * const B,
+                             __m128d * const C,
+                             __m128d * const D
+                             )
+{
+  __m128d const val_A = _mm_sub_pd( _mm_mul_pd(_mm_set1_pd(P[4]), u), _mm_set1_pd(P[0]) );
+  __m128d const val_B = _mm_sub_pd( _mm_mul_pd(_mm_set1_pd(P[5]), u), _mm_set1_pd(P[1]) );
+  __m128d const val_C = _mm_sub_pd( _mm_mul_pd(_mm_set1_pd(P[6]), u), _mm_set1_pd(P[2]) );
+  __m128d const val_D = _mm_sub_pd( _mm_mul_pd(_mm_set1_pd(P[7]), u), _mm_set1_pd(P[3]) );
+
+  __m128d const v2 = _mm_add_pd( _mm_add_pd( _mm_mul_pd(val_A, val_A), _mm_mul_pd(val_B, val_B) ), _mm_mul_pd(val_C, val_C) );
+  __m128d const k = _mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(v2));
+
+  *A = _mm_mul_pd(k, val_A);
+  *B = _mm_mul_pd(k, val_B);
+  *C = _mm_mul_pd(k, val_C);
+  *D = _mm_mul_pd(k, val_D);
+}
+/* GetCameraPlanesPacked_inline */
 
- ProjectPoints_EXIT:
 
-  SAFE_DELETE( x_2D );
-  SAFE_DELETE( y_2D );
 
-  return result;
+//! Replaces invalid values with NaNs.
+/*!
+  \param v      Packed values.
+  \param valid  Mask which is set for valid values.
+  \return Returns v where valid is set and NaN elsewhere.
+*/
+inline
+__m128d
+SelectValidOrNaNPacked_inline(
+                              __m128d const v,
+                              __m128d const valid
+                              )
+{
+  return _mm_or_pd( _mm_and_pd(valid, v), _mm_andnot_pd(valid, _mm_set1_pd(BATCHACQUISITION_qNaN_dv)) );
 }
-/* ProjectPoints */
+/* SelectValidOrNaNPacked_inline */
 
 
 
-/****** AUXILIARY FUNCTIONS ******/
-
-//! Data assembly for VTK visualization.
+//! Computes camera ray for a pixel.
 /*!
-  Creates inputs required for VTK visualization.
-
-  \param x_3D   Array of x coordinates.
-  \param y_3D   Array of y coordinates.
-  \param z_3D   Array of z coordinates.
-  \param dst2_3D        Array of squared distances between rays. May be NULL.
-  \param dst2_thr       Threshold for the array of squared distances. Only points having distance lower than this threshold will be output.
-  \param x_img  Image x coordinate.
-  \param y_img  Image y coordinate.
-  \param range_img Dynamic range of selected points.
-  \param AllImages      Pointer to all captured images. If NULL then points will not have color information.
-  \param texture      Pointer to cv::Mat which stores texture image. Texture image must be either grayscale or BGR with 8 bits per pixel.
-  \param abs_phase_distance  Image storing distance to constellation of the absolute phase.
-  \param abs_phase_deviation  Image storing deviation of the absolute phase.
-  \param points_out     Address where selected 3D points will be stored.
-  \param colors_out     Address where texture information for 3D points will be stored.
-  \param data_out       Address where additional data for 3D points will be stored.
-  \return Returns true if successfull.
+  Undistorts pixel coordinates using the same expressions as
+  UndistortImageCoordinatesForRadialDistorsion and computes the unit ray
+  direction using the same expressions as GetCameraRays.
+
+  \param table  Pointer to camera ray table which holds camera parameters.
+  \param Pinv   Pseudoinverse of the projection matrix (4x3, row-major).
+  \param x      Column index of the pixel in the sensor.
+  \param y      Row index of the pixel in the sensor.
+  \param vx     Address where x ray direction coefficient will be stored.
+  \param vy     Address where y ray direction coefficient will be stored.
+  \param vz     Address where z ray direction coefficient will be stored.
 */
-bool
-SelectValidPointsAndAssembleDataForVTK(
-                                       cv::Mat * const x_3D,
-                                       cv::Mat * const y_3D,
-                                       cv::Mat * const z_3D,
-                                       cv::Mat * const dst2_3D,
-                                       double const dst2_thr,
-                                       cv::Mat * const x_img,
-                                       cv::Mat * const y_img,
-                                       cv::Mat * const range_img,
-                                       ImageSet * const AllImages,
-                                       cv::Mat * const texture,
-                                       cv::Mat * const abs_phase_distance,
-                                       cv::Mat * const abs_phase_deviation,
-                                       cv::Mat * * const points_out,
-                                       cv::Mat * * const colors_out,
-                                       cv::Mat * * const data_out
-                                       )
+inline
+void
+GetCameraRayForPixel_inline(
+                            CameraRayTable const * const table,
+                            double const * const Pinv,
+                            int const x,
+                            int const y,
+                            double * const vx,
+                            double * const vy,
+                            double * const vz
+                            )
 {
-  int const num_3D = CheckRowArrays_inline(CV_64F, x_3D, y_3D, z_3D, dst2_3D);
-  assert( 3 <= num_3D );
-  if (3 > num_3D) return false;
+  assert( (NULL != table) && (NULL != Pinv) );
 
-  int const N = x_3D->cols;
+  // Undistort pixel coordinates.
+  double const xn = ( (double)( x + table->shift_x ) - table->cx ) * ( 1.0 / table->fx );
+  double const yn = ( (double)( y + table->shift_y ) - table->cy ) * ( 1.0 / table->fy );
 
-  cv::Mat * points = NULL;
-  cv::Mat * colors = NULL;
-  //cv::Mat * img = NULL;
-  cv::Mat * data = NULL;
+  double const r2 = xn*xn + yn*yn;
+  double const L_inv = 1.0 / ( 1.0 + (table->k0 + table->k1 * r2) * r2 );
 
-  bool const prune = (NULL != dst2_thr);
-  bool const is_grayscale = (NULL != AllImages) && (true == AllImages->IsGrayscale());
-  bool const have_texture = (NULL != texture) && (NULL != texture->data);
-  bool const have_range = (NULL != range_img) && (NULL != range_img->data);
-  bool const have_phase_distance = (NULL != abs_phase_distance) && (NULL != abs_phase_distance->data);
-  bool const have_phase_deviation = (NULL != abs_phase_deviation) && (NULL != abs_phase_deviation->data);
+  double const x_un = table->cx + table->fx * xn * L_inv;
+  double const y_un = table->cy + table->fy * yn * L_inv;
 
-  bool const have_data = (true == have_texture) || (true == have_range) || (true == have_phase_distance) || (true == have_phase_deviation);
-  if ( true == have_data )
-    {
-      int const num_2D = CheckRowArrays_inline(CV_32S, x_img, y_img);
-      assert(2 == num_2D);
-      if (2 != num_2D) return false;
+  // Backproject undistorted coordinates.
+  double const x3 = Pinv[0] * x_un + Pinv[ 1] * y_un + Pinv[ 2];
+  double const y3 = Pinv[3] * x_un + Pinv[ 4] * y_un + Pinv[ 5];
+  double const z3 = Pinv[6] * x_un + Pinv[ 7] * y_un + Pinv[ 8];
+  double const h3 = Pinv[9] * x_un + Pinv[10] * y_un + Pinv[11];
 
-      assert(N == x_img->cols);
-      if (N != x_img->cols) return false;
+  double const h3_inv = 1.0 / h3;
 
-      if (true == have_texture)
-        {
-          assert( (CV_MAT_DEPTH(texture->type()) == CV_8U) &&
-                  ( (true == is_grayscale) ?
-                    (CV_MAT_CN(texture->type()) == 1) :
-                    (CV_MAT_CN(texture->type()) == 3)
-                    )
-                  );
-          if ( (CV_MAT_DEPTH(texture->type()) != CV_8U) ||
-               ( (true == is_grayscale) ?
-                 (CV_MAT_CN(texture->type()) != 1) :
-                 (CV_MAT_CN(texture->type()) != 3)
-                 )
-               )
-            {
-              return false;
-            }
-          /* if */
-        }
-      /* if */
+  double const val_vx = x3 * h3_inv - table->center[0];
+  double const val_vy = y3 * h3_inv - table->center[1];
+  double const val_vz = z3 * h3_inv - table->center[2];
 
-      if (true == have_range)
-        {
-          bool const range_valid = CheckRowArray_inline(CV_32F, range_img);
-          assert(true == range_valid);
-          if (true != range_valid) return false;
+  double const v2 = val_vx * val_vx + val_vy * val_vy + val_vz * val_vz;
+  double const v = sqrt(v2);
+  double const k = 1.0 / v;
 
-          assert(N == range_img->cols);
-          if (N != range_img->cols) return false;
-        }
-      /* if */
-    }
-  /* if */
+  *vx = k * val_vx;
+  *vy = k * val_vy;
+  *vz = k * val_vz;
+}
+/* GetCameraRayForPixel_inline */
 
-  bool result = true; // Assume success.
 
-  // Allocate storage for point coordinates.
-  points = new cv::Mat(N, 3, CV_64F);
-  assert(NULL != points);
-  if (NULL == points)
+
+//! Fused two-view triangulation.
+/*!
+  Computes intersections of two views directly from undistorted image
+  coordinates. Rays and planes are computed in registers and are immediately
+  intersected so no intermediate arrays are allocated. Two points are
+  processed at once using SSE2 and the point arrays are split into chunks of
+  TRIANGULATION_CHUNK_SIZE points which are processed in parallel.
+
+  First view always has both coordinates defined. If the second view has both
+  coordinates defined then ray-ray intersection is computed; otherwise the
+  plane of the second view is intersected with the ray of the first view.
+
+  If camera ray table is given then coordinates of the first view are
+  integer pixel indices and rays of the first view are fetched from the table.
+
+  If refinement iterations are requested for plane-ray intersection then the
+  coordinate of the second view is treated as distorted. The missing coordinate
+  is estimated by projecting the point to the second view, both coordinates
+  are undistorted, and the ray-ray intersection is computed; this is repeated
+  for the requested number of iterations without leaving registers.
+*/
+struct TriangulateTwoViewsParallel_ : public cv::ParallelLoopBody
+{
+  int N; //!< Number of points.
+  bool ray_ray; //!< Flag to indicate ray-ray intersection.
+  int iterations; //!< Number of refinement iterations for plane-ray intersection.
+
+  double const * row_x1; //!< X coordinates of the first view; unused if ray table is given.
+  double const * row_y1; //!< Y coordinates of the first view; unused if ray table is given.
+  int const * row_i1; //!< Column indices of the first view; used only if ray table is given.
+  int const * row_j1; //!< Row indices of the first view; used only if ray table is given.
+  double const * row_x2; //!< X coordinates of the second view.
+  double const * row_y2; //!< Y coordinates of the second view; unused for plane-ray intersection.
+
+  double * row_x; //!< Output x coordinates.
+  double * row_y; //!< Output y coordinates.
+  double * row_z; //!< Output z coordinates.
+  double * row_dst2; //!< Output squared distances; unused for plane-ray intersection.
+
+  double Pinv1[12]; //!< Pseudoinverse of the first projection matrix.
+  double center1[3]; //!< First camera center.
+  double Pinv2[12]; //!< Pseudoinverse of the second projection matrix.
+  double center2[3]; //!< Second camera center.
+  double plane2[8]; //!< Projection matrix rows which define planes of the second view.
+  double other2[4]; //!< Projection matrix row of the missing coordinate of the second view.
+  int row2; //!< Known coordinate of the second view for plane-ray intersection; 0 for columns and 1 for rows.
+  double F; //!< Squared distance between camera centers.
+
+  double f_u2; //!< Focal length of the second view for the known coordinate.
+  double c_u2; //!< Principal point of the second view for the known coordinate.
+  double f_o2; //!< Focal length of the second view for the missing coordinate.
+  double c_o2; //!< Principal point of the second view for the missing coordinate.
+  double k0_2; //!< First radial distortion coefficient of the second view.
+  double k1_2; //!< Second radial distortion coefficient of the second view.
+
+  CameraRayTable const * table; //!< Ray table of the first view; may be NULL.
+  int offset_x; //!< Column of the first pixel of the first view in the sensor.
+  int offset_y; //!< Row of the first pixel of the first view in the sensor.
+
+  //! Constructor.
+  TriangulateTwoViewsParallel_(
+                               ProjectiveGeometry * const PG1_in,
+                               cv::Mat * const x1_in,
+                               cv::Mat * const y1_in,
+                               ProjectiveGeometry * const PG2_in,
+                               cv::Mat * const x2_in,
+                               cv::Mat * const y2_in,
+                               cv::Mat * const x_in,
+                               cv::Mat * const y_in,
+                               cv::Mat * const z_in,
+                               cv::Mat * const dst2_in,
+                               CameraRayTable const * const table_in,
+                               int const offset_x_in,
+                               int const offset_y_in,
+                               int const iterations_in
+                               )
+  {
+    assert( (NULL != PG1_in) && (NULL != x1_in) && (NULL != y1_in) && (NULL != PG2_in) );
+    assert( (NULL != x2_in) || (NULL != y2_in) );
+
+    this->N = x1_in->cols;
+    this->ray_ray = ( (NULL != x2_in) && (NULL != y2_in) );
+    this->iterations = (false == this->ray_ray)? iterations_in : 0;
+
+    this->table = table_in;
+    this->offset_x = offset_x_in;
+    this->offset_y = offset_y_in;
+
+    this->row_x1 = NULL;
+    this->row_y1 = NULL;
+    this->row_i1 = NULL;
+    this->row_j1 = NULL;
+    if (NULL == this->table)
+      {
+        this->row_x1 = (double *)( (BYTE *)(x1_in->data) + x1_in->step[0] * 0 );
+        this->row_y1 = (double *)( (BYTE *)(y1_in->data) + y1_in->step[0] * 0 );
+      }
+    else
+      {
+        this->row_i1 = (int *)( (BYTE *)(x1_in->data) + x1_in->step[0] * 0 );
+        this->row_j1 = (int *)( (BYTE *)(y1_in->data) + y1_in->step[0] * 0 );
+      }
+    /* if */
+    this->row_x2 = NULL;
+    this->row_y2 = NULL;
+
+    this->row_x = (double *)( (BYTE *)(x_in->data) + x_in->step[0] * 0 );
+    this->row_y = (double *)( (BYTE *)(y_in->data) + y_in->step[0] * 0 );
+    this->row_z = (double *)( (BYTE *)(z_in->data) + z_in->step[0] * 0 );
+    this->row_dst2 = NULL;
+
+    GetProjectionPseudoinverse_inline(PG1_in, this->Pinv1);
+    for (int i = 0; i < 3; ++i) this->center1[i] = PG1_in->center[i];
+
+    for (int i = 0; i < 12; ++i) this->Pinv2[i] = BATCHACQUISITION_qNaN_dv;
+    for (int i = 0; i < 3; ++i) this->center2[i] = PG2_in->center[i];
+    for (int i = 0; i < 8; ++i) this->plane2[i] = BATCHACQUISITION_qNaN_dv;
+    for (int i = 0; i < 4; ++i) this->other2[i] = BATCHACQUISITION_qNaN_dv;
+    this->row2 = 0;
+
+    this->f_u2 = BATCHACQUISITION_qNaN_dv;
+    this->c_u2 = BATCHACQUISITION_qNaN_dv;
+    this->f_o2 = BATCHACQUISITION_qNaN_dv;
+    this->c_o2 = BATCHACQUISITION_qNaN_dv;
+    this->k0_2 = BATCHACQUISITION_qNaN_dv;
+    this->k1_2 = BATCHACQUISITION_qNaN_dv;
+
+    if (true == this->ray_ray)
+      {
+        assert( NULL != dst2_in );
+        this->row_x2 = (double *)( (BYTE *)(x2_in->data) + x2_in->step[0] * 0 );
+        this->row_y2 = (double *)( (BYTE *)(y2_in->data) + y2_in->step[0] * 0 );
+        this->row_dst2 = (double *)( (BYTE *)(dst2_in->data) + dst2_in->step[0] * 0 );
+        GetProjectionPseudoinverse_inline(PG2_in, this->Pinv2);
+      }
+    else
+      {
+        // Column planes use the first and row planes use the second row of the projection matrix.
+        cv::Mat * const u = (NULL != x2_in)? x2_in : y2_in;
+        int const row = (NULL != x2_in)? 0 : 1;
+        this->row_x2 = (double *)( (BYTE *)(u->data) + u->step[0] * 0 );
+        for (int i = 0; i < 4; ++i) this->plane2[i] = PG2_in->projection[row][i];
+        for (int i = 0; i < 4; ++i) this->plane2[4 + i] = PG2_in->projection[2][i];
+        this->row2 = row;
+
+        if (0 < this->iterations)
+          {
+            assert( NULL != dst2_in );
+            this->row_dst2 = (double *)( (BYTE *)(dst2_in->data) + dst2_in->step[0] * 0 );
+            GetProjectionPseudoinverse_inline(PG2_in, this->Pinv2);
+            for (int i = 0; i < 4; ++i) this->other2[i] = PG2_in->projection[1 - row][i];
+
+            this->f_u2 = (0 == row)? PG2_in->fx : PG2_in->fy;
+            this->c_u2 = (0 == row)? PG2_in->cx : PG2_in->cy;
+            this->f_o2 = (0 == row)? PG2_in->fy : PG2_in->fx;
+            this->c_o2 = (0 == row)? PG2_in->cy : PG2_in->cx;
+            this->k0_2 = PG2_in->k0;
+            this->k1_2 = PG2_in->k1;
+          }
+        /* if */
+      }
+    /* if */
+
+    double const dx = this->center1[0] - this->center2[0];
+    double const dy = this->center1[1] - this->center2[1];
+    double const dz = this->center1[2] - this->center2[2];
+    this->F = dx * dx + dy * dy + dz * dz;
+  }
+
+  //! Gets rays of the first view for one or two points.
+  inline void GetRays1(int const i, int const n, __m128d * const vx1, __m128d * const vy1, __m128d * const vz1) const
+  {
+    if (NULL == this->table)
+      {
+        GetCameraRaysPacked_inline(LoadPacked_inline(this->row_x1 + i, n), LoadPacked_inline(this->row_y1 + i, n), this->Pinv1, this->center1, vx1, vy1, vz1);
+        return;
+      }
+    /* if */
+
+    double vx[2] = {0.0, 0.0};
+    double vy[2] = {0.0, 0.0};
+    double vz[2] = {0.0, 0.0};
+    for (int k = 0; k < n; ++k)
+      {
+        int const x = this->row_i1[i + k] + this->offset_x;
+        int const y = this->row_j1[i + k] + this->offset_y;
+
+        if ( (0 <= x) && (x < this->table->width) && (0 <= y) && (y < this->table->height) )
+          {
+            vx[k] = ( (float *)( (BYTE *)(this->table->vx->data) + this->table->vx->step[0] * y ) )[x];
+            vy[k] = ( (float *)( (BYTE *)(this->table->vy->data) + this->table->vy->step[0] * y ) )[x];
+            vz[k] = ( (float *)( (BYTE *)(this->table->vz->data) + this->table->vz->step[0] * y ) )[x];
+          }
+        else
+          {
+            GetCameraRayForPixel_inline(this->table, this->Pinv1, x, y, vx + k, vy + k, vz + k);
+          }
+        /* if */
+      }
+    /* for */
+
+    *vx1 = _mm_loadu_pd(vx);
+    *vy1 = _mm_loadu_pd(vy);
+    *vz1 = _mm_loadu_pd(vz);
+  }
+
+  //! Intersects rays of both views for one or two points.
+  /*!
+    Computes the midpoint of the shortest segment between rays, the squared length of that segment,
+    and the distance along the first ray to the closest point. Returns mask which is set for points
+    where rays are not parallel.
+  */
+  inline __m128d IntersectRays(
+                               __m128d const vx1, __m128d const vy1, __m128d const vz1,
+                               __m128d const vx2, __m128d const vy2, __m128d const vz2,
+                               __m128d * const x, __m128d * const y, __m128d * const z, __m128d * const dst2_out,
+                               __m128d * const t1_out
+                               ) const
+  {
+    __m128d const eps = _mm_set1_pd(FLT_EPSILON);
+    __m128d const neg_eps = _mm_set1_pd(-FLT_EPSILON);
+
+    __m128d const cx1 = _mm_set1_pd(this->center1[0]);
+    __m128d const cy1 = _mm_set1_pd(this->center1[1]);
+    __m128d const cz1 = _mm_set1_pd(this->center1[2]);
+
+    __m128d const cx2 = _mm_set1_pd(this->center2[0]);
+    __m128d const cy2 = _mm_set1_pd(this->center2[1]);
+    __m128d const cz2 = _mm_set1_pd(this->center2[2]);
+
+    __m128d const dx = _mm_sub_pd(cx1, cx2);
+    __m128d const dy = _mm_sub_pd(cy1, cy2);
+    __m128d const dz = _mm_sub_pd(cz1, cz2);
+
+    __m128d const two = _mm_set1_pd(2.0);
+
+    __m128d const A = _mm_add_pd( _mm_add_pd( _mm_mul_pd(vx1, vx1), _mm_mul_pd(vy1, vy1) ), _mm_mul_pd(vz1, vz1) );
+    __m128d const C = _mm_mul_pd( two, _mm_add_pd( _mm_add_pd( _mm_mul_pd(vx1, vx2), _mm_mul_pd(vy1, vy2) ), _mm_mul_pd(vz1, vz2) ) );
+    __m128d const E = _mm_add_pd( _mm_add_pd( _mm_mul_pd(vx2, vx2), _mm_mul_pd(vy2, vy2) ), _mm_mul_pd(vz2, vz2) );
+
+    __m128d const det = _mm_sub_pd( _mm_mul_pd(C, C), _mm_mul_pd( _mm_mul_pd(_mm_set1_pd(4.0), A), E ) );
+    __m128d const valid = _mm_or_pd( _mm_cmpgt_pd(det, eps), _mm_cmplt_pd(det, neg_eps) );
+
+    __m128d const B = _mm_mul_pd( two, _mm_add_pd( _mm_add_pd( _mm_mul_pd(dx, vx1), _mm_mul_pd(dy, vy1) ), _mm_mul_pd(dz, vz1) ) );
+    __m128d const D = _mm_mul_pd( _mm_set1_pd(-2.0), _mm_add_pd( _mm_add_pd( _mm_mul_pd(dx, vx2), _mm_mul_pd(dy, vy2) ), _mm_mul_pd(dz, vz2) ) );
+
+    __m128d const det_inv = _mm_div_pd(_mm_set1_pd(1.0), det);
+
+    __m128d const t1 = _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_mul_pd(two, B), E ), _mm_mul_pd(C, D) ), det_inv );
+    __m128d const t2 = _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_mul_pd(two, A), D ), _mm_mul_pd(B, C) ), det_inv );
+
+    __m128d dst2 = _mm_add_pd( _mm_mul_pd( _mm_mul_pd(A, t1), t1 ), _mm_mul_pd(B, t1) );
+    dst2 = _mm_sub_pd( dst2, _mm_mul_pd( _mm_mul_pd(C, t1), t2 ) );
+    dst2 = _mm_add_pd( dst2, _mm_mul_pd(D, t2) );
+    dst2 = _mm_add_pd( dst2, _mm_mul_pd( _mm_mul_pd(E, t2), t2 ) );
+    dst2 = _mm_add_pd( dst2, _mm_set1_pd(this->F) );
+
+    __m128d const x1 = _mm_add_pd( cx1, _mm_mul_pd(vx1, t1) );
+    __m128d const y1 = _mm_add_pd( cy1, _mm_mul_pd(vy1, t1) );
+    __m128d const z1 = _mm_add_pd( cz1, _mm_mul_pd(vz1, t1) );
+
+    __m128d const x2 = _mm_add_pd( cx2, _mm_mul_pd(vx2, t2) );
+    __m128d const y2 = _mm_add_pd( cy2, _mm_mul_pd(vy2, t2) );
+    __m128d const z2 = _mm_add_pd( cz2, _mm_mul_pd(vz2, t2) );
+
+    __m128d const half = _mm_set1_pd(0.5);
+
+    *x = _mm_mul_pd(half, _mm_add_pd(x1, x2));
+    *y = _mm_mul_pd(half, _mm_add_pd(y1, y2));
+    *z = _mm_mul_pd(half, _mm_add_pd(z1, z2));
+    *dst2_out = dst2;
+    *t1_out = t1;
+
+    return valid;
+  }
+
+  //! Refines plane-ray intersection for one or two points.
+  /*!
+    Known coordinate of the second view is distorted. In each iteration the
+    point is projected to the second view to estimate the missing coordinate,
+    the estimate is distorted using the distortion of the previous iteration,
+    both coordinates are undistorted, and rays are intersected. Next iteration
+    projects the closest point on the camera ray, not the midpoint, so the
+    estimate is not biased towards the previous projector ray. The first
+    iteration uses the undistorted estimate of the missing coordinate which
+    gives the same result as projecting points using ProjectPoints,
+    undistorting coordinates using UndistortImageCoordinatesForRadialDistorsion,
+    and re-triangulating views.
+  */
+  inline void Refine(
+                     int const i, int const n,
+                     __m128d const vx1, __m128d const vy1, __m128d const vz1, __m128d const t,
+                     __m128d * const x, __m128d * const y, __m128d * const z, __m128d * const valid
+                     ) const
+  {
+    __m128d const cx1 = _mm_set1_pd(this->center1[0]);
+    __m128d const cy1 = _mm_set1_pd(this->center1[1]);
+    __m128d const cz1 = _mm_set1_pd(this->center1[2]);
+
+    __m128d const one = _mm_set1_pd(1.0);
+    __m128d const k0 = _mm_set1_pd(this->k0_2);
+    __m128d const k1 = _mm_set1_pd(this->k1_2);
+
+    __m128d const f_u = _mm_set1_pd(this->f_u2);
+    __m128d const c_u = _mm_set1_pd(this->c_u2);
+    __m128d const f_o = _mm_set1_pd(this->f_o2);
+    __m128d const c_o = _mm_set1_pd(this->c_o2);
+    __m128d const f_o_inv = _mm_set1_pd(1.0 / this->f_o2);
+
+    // Normalized distorted known coordinate does not change.
+    __m128d const u_n = _mm_mul_pd( _mm_sub_pd( LoadPacked_inline(this->row_x2 + i, n), c_u ), _mm_set1_pd(1.0 / this->f_u2) );
+
+    __m128d dst2 = _mm_set1_pd(BATCHACQUISITION_qNaN_dv);
+    __m128d t1 = t;
+    __m128d L = one;
+    for (int k = 0; k < this->iterations; ++k)
+      {
+        // Project point on the camera ray to the second view to estimate the missing coordinate.
+        __m128d const px = _mm_add_pd( cx1, _mm_mul_pd(t1, vx1) );
+        __m128d const py = _mm_add_pd( cy1, _mm_mul_pd(t1, vy1) );
+        __m128d const pz = _mm_add_pd( cz1, _mm_mul_pd(t1, vz1) );
+
+        __m128d const w = _mm_add_pd(
+                                     _mm_add_pd( _mm_mul_pd(_mm_set1_pd(this->plane2[4]), px), _mm_mul_pd(_mm_set1_pd(this->plane2[5]), py) ),
+                                     _mm_add_pd( _mm_mul_pd(_mm_set1_pd(this->plane2[6]), pz), _mm_set1_pd(this->plane2[7]) )
+                                     );
+        __m128d const p = _mm_add_pd(
+                                     _mm_add_pd( _mm_mul_pd(_mm_set1_pd(this->other2[0]), px), _mm_mul_pd(_mm_set1_pd(this->other2[1]), py) ),
+                                     _mm_add_pd( _mm_mul_pd(_mm_set1_pd(this->other2[2]), pz), _mm_set1_pd(this->other2[3]) )
+                                     );
+        __m128d const o = _mm_mul_pd( p, _mm_div_pd(one, w) );
+
+        // Distort the estimate and undistort both coordinates.
+        __m128d const o_n = _mm_mul_pd( _mm_mul_pd( _mm_sub_pd(o, c_o), f_o_inv ), L );
+        __m128d const r2 = _mm_add_pd( _mm_mul_pd(u_n, u_n), _mm_mul_pd(o_n, o_n) );
+        L = _mm_add_pd( one, _mm_mul_pd( _mm_add_pd( k0, _mm_mul_pd(k1, r2) ), r2 ) );
+        __m128d const L_inv = _mm_div_pd(one, L);
+
+        __m128d const u_un = _mm_add_pd( c_u, _mm_mul_pd( _mm_mul_pd(f_u, u_n), L_inv ) );
+        __m128d const o_un = _mm_add_pd( c_o, _mm_mul_pd( _mm_mul_pd(f_o, o_n), L_inv ) );
+
+        // Intersect camera ray with the ray of the second view.
+        __m128d vx2, vy2, vz2;
+        if (0 == this->row2)
+          {
+            GetCameraRaysPacked_inline(u_un, o_un, this->Pinv2, this->center2, &vx2, &vy2, &vz2);
+          }
+        else
+          {
+            GetCameraRaysPacked_inline(o_un, u_un, this->Pinv2, this->center2, &vx2, &vy2, &vz2);
+          }
+        /* if */
+
+        __m128d const valid_k = this->IntersectRays(vx1, vy1, vz1, vx2, vy2, vz2, x, y, z, &dst2, &t1);
+        *valid = _mm_and_pd(*valid, valid_k);
+      }
+    /* for */
+
+    StorePacked_inline(this->row_dst2 + i, SelectValidOrNaNPacked_inline(dst2, *valid), n);
+  }
+
+  //! Triangulates one or two points.
+  inline void Triangulate(int const i, int const n) const
+  {
+    __m128d vx1, vy1, vz1;
+    this->GetRays1(i, n, &vx1, &vy1, &vz1);
+
+    if (true == this->ray_ray)
+      {
+        __m128d vx2, vy2, vz2;
+        GetCameraRaysPacked_inline(LoadPacked_inline(this->row_x2 + i, n), LoadPacked_inline(this->row_y2 + i, n), this->Pinv2, this->center2, &vx2, &vy2, &vz2);
+
+        __m128d x, y, z, dst2, t1;
+        __m128d const valid = this->IntersectRays(vx1, vy1, vz1, vx2, vy2, vz2, &x, &y, &z, &dst2, &t1);
+
+        StorePacked_inline(this->row_x + i, SelectValidOrNaNPacked_inline(x, valid), n);
+        StorePacked_inline(this->row_y + i, SelectValidOrNaNPacked_inline(y, valid), n);
+        StorePacked_inline(this->row_z + i, SelectValidOrNaNPacked_inline(z, valid), n);
+        StorePacked_inline(this->row_dst2 + i, SelectValidOrNaNPacked_inline(dst2, valid), n);
+      }
+    else
+      {
+        __m128d const eps = _mm_set1_pd(FLT_EPSILON);
+        __m128d const neg_eps = _mm_set1_pd(-FLT_EPSILON);
+
+        __m128d const cx1 = _mm_set1_pd(this->center1[0]);
+        __m128d const cy1 = _mm_set1_pd(this->center1[1]);
+        __m128d const cz1 = _mm_set1_pd(this->center1[2]);
+
+        __m128d A, B, C, D;
+        GetCameraPlanesPacked_inline(LoadPacked_inline(this->row_x2 + i, n), this->plane2, &A, &B, &C, &D);
+
+        __m128d const det = _mm_add_pd( _mm_add_pd( _mm_mul_pd(A, vx1), _mm_mul_pd(B, vy1) ), _mm_mul_pd(C, vz1) );
+        __m128d valid = _mm_or_pd( _mm_cmpgt_pd(det, eps), _mm_cmplt_pd(det, neg_eps) );
+
+        __m128d const num = _mm_add_pd( _mm_add_pd( _mm_add_pd( _mm_mul_pd(A, cx1), _mm_mul_pd(B, cy1) ), _mm_mul_pd(C, cz1) ), D );
+        __m128d const t = _mm_div_pd( _mm_xor_pd(num, _mm_set1_pd(-0.0)), det );
+
+        __m128d x = _mm_add_pd( cx1, _mm_mul_pd(t, vx1) );
+        __m128d y = _mm_add_pd( cy1, _mm_mul_pd(t, vy1) );
+        __m128d z = _mm_add_pd( cz1, _mm_mul_pd(t, vz1) );
+
+        if (0 < this->iterations) this->Refine(i, n, vx1, vy1, vz1, t, &x, &y, &z, &valid);
+
+        StorePacked_inline(this->row_x + i, SelectValidOrNaNPacked_inline(x, valid), n);
+        StorePacked_inline(this->row_y + i, SelectValidOrNaNPacked_inline(y, valid), n);
+        StorePacked_inline(this->row_z + i, SelectValidOrNaNPacked_inline(z, valid), n);
+      }
+    /* if */
+  }
+
+  //! Triangulates a range of chunks.
+  virtual void operator()(const cv::Range & r) const
+  {
+    for (int j = r.start; j < r.end; ++j)
+      {
+        int const start = j * TRIANGULATION_CHUNK_SIZE;
+        int const end = (start + TRIANGULATION_CHUNK_SIZE < this->N)? start + TRIANGULATION_CHUNK_SIZE : this->N;
+
+        int i = start;
+        int const max_i = end - 1;
+        for (; i < max_i; i += 2) this->Triangulate(i, 2);
+
+        // Complete to end.
+        if (i < end) this->Triangulate(i, 1);
+      }
+    /* for */
+  }
+};
+/* TriangulateTwoViewsParallel_ */
+
+
+
+//! Maximal relative difference.
+/*!
+  Computes maximal relative difference between two row arrays.
+  Relative difference is computed w.r.t. to the absolute value of the reference
+  value if it is larger than one and is absolute otherwise.
+  NaNs must be at the same positions in both arrays.
+
+  \param a      Tested array.
+  \param b      Reference array.
+  \return Returns maximal relative difference or infinity if arrays do not match.
+*/
+inline
+double
+MaxRelativeDifference_inline(
+                             cv::Mat * const a,
+                             cv::Mat * const b
+                             )
+{
+  if ( (NULL == a) && (NULL == b) ) return 0.0;
+  if ( (NULL == a) || (NULL == b) || (a->cols != b->cols) ) return std::numeric_limits<double>::infinity();
+
+  double const * const row_a = (double *)( (BYTE *)(a->data) + a->step[0] * 0 );
+  double const * const row_b = (double *)( (BYTE *)(b->data) + b->step[0] * 0 );
+
+  double max_diff = 0.0;
+  for (int i = 0; i < a->cols; ++i)
     {
-      result = false;
-      goto SelectValidPointsAndAssembleDataForVTK_EXIT;
+      bool const nan_a = ( row_a[i] != row_a[i] );
+      bool const nan_b = ( row_b[i] != row_b[i] );
+      if (nan_a != nan_b) return std::numeric_limits<double>::infinity();
+      if (true == nan_a) continue;
+
+      double const abs_b = fabs(row_b[i]);
+      double const diff = fabs(row_a[i] - row_b[i]) / ( (1.0 < abs_b)? abs_b : 1.0 );
+      if (diff > max_diff) max_diff = diff;
     }
-  /* if */
+  /* for */
 
-  // Create row indices into images.
-  int y_prev_tex = -1;
-  int y_prev_phase_distance = -1;
-  int y_prev_phase_deviation = -1;
+  return max_diff;
+}
+/* MaxRelativeDifference_inline */
 
-  UINT8 const * row_tex = NULL;
-  float const * row_phase_distance = NULL;
-  float const * row_phase_deviation = NULL;
 
-  // Allocate storage for additional data.
-  if ( true == have_data )
-    {
-      data = new cv::Mat(N, 4, CV_32F, cv::Scalar(0.0f));
-      assert( (NULL != data) && (NULL != data->data) );
-      if ( (NULL == data) || (NULL == data->data) )
-        {
-          result = false;
-          goto SelectValidPointsAndAssembleDataForVTK_EXIT;
+
+//! Triangulates two views.
+/*!
+  Function computes intersections of two views.
+  Note that exactly one of x1, y2, x2, and y2 may be NULL; if so
+  then dst2 will not be computed.
+
+  Triangulation is computed using a fused kernel which computes rays or planes
+  and their intersection for each point in registers, so no intermediate
+  arrays are allocated. The kernel evaluates the same expressions in the same
+  order as TriangulateTwoViewsReference, so results are normally bitwise
+  identical; as compilers may contract multiplications and additions of the
+  scalar reference differently the outputs are only guaranteed to agree within
+  TRIANGULATION_FUSED_TOLERANCE relative difference. In debug builds every
+  result is checked against the reference implementation.
+
+  \param PG1    Projective geometry for the first view.
+  \param x1     Undistorted image x coordinates for the first view.
+  \param y1     Undistorted image y coordinates for the first view.
+  \param PG2    Projective geometry for the second view.
+  \param x2     Undistorted image x coordinates for the second view.
+  \param y2     Undistorted image y coordinates for the second view.
+  \param x_out  Address where x coordinates of intersection points will be stored.
+  \param y_out  Address where y coordinates of intersection points will be stored.
+  \param z_out  Address where z coordinates of intersection points will be stored.
+  \param dst2_out Squared length of the shortest line segment that connects two rays.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+TriangulateTwoViews(
+                    ProjectiveGeometry * const PG1,
+                    cv::Mat * const x1,
+                    cv::Mat * const y1,
+                    ProjectiveGeometry * const PG2,
+                    cv::Mat * const x2,
+                    cv::Mat * const y2,
+                    cv::Mat * * const x_out,
+                    cv::Mat * * const y_out,
+                    cv::Mat * * const z_out,
+                    cv::Mat * * const dst2_out
+                    )
+{
+  int const E1 = ( (NULL == x1)? 1 : 0 ) + ( (NULL == y1)? 1 : 0 );
+  int const E2 = ( (NULL == x2)? 1 : 0 ) + ( (NULL == y2)? 1 : 0 );
+  assert( 1 >= E1 + E2 );
+  if (1 < E1 + E2) return false;
+
+  int const num_valid = (0 == E1)? CheckRowArrays_inline(CV_64F, x1, y1, x2, y2) : CheckRowArrays_inline(CV_64F, x2, y2, x1, y1);
+  assert( 3 <= num_valid );
+  if (3 > num_valid) return false;
+
+  assert( (NULL != PG1) && (NULL != PG2) );
+  if ( (NULL == PG1) || (NULL == PG2) ) return false;
+
+  bool result = true; // Assume success.
+
+  int const N = (0 == E1)? x1->cols : x2->cols;
+  bool const ray_ray = (0 == E1 + E2);
+
+  // Allocate outputs.
+  cv::Mat * x = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x);
+
+  cv::Mat * y = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y);
+
+  cv::Mat * z = new cv::Mat(1, N, CV_64F);
+  assert(NULL != z);
+
+  cv::Mat * dst2 = (true == ray_ray)? new cv::Mat(1, N, CV_64F) : NULL;
+  assert( (NULL != dst2) || (false == ray_ray) );
+
+  if ( (NULL == x) || (NULL == y) || (NULL == z) || ( (NULL == dst2) && (true == ray_ray) ) )
+    {
+      result = false;
+      goto TriangulateTwoViews_EXIT;
+    }
+  /* if */
+
+  // Triangulate views; the view with both coordinates defined is always passed first.
+  if (0 < N)
+    {
+      int const num_chunks = (N + TRIANGULATION_CHUNK_SIZE - 1) / TRIANGULATION_CHUNK_SIZE;
+      if (0 == E1)
+        {
+          TriangulateTwoViewsParallel_ body(PG1, x1, y1, PG2, x2, y2, x, y, z, dst2, NULL, 0, 0, 0);
+          cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
+        }
+      else
+        {
+          TriangulateTwoViewsParallel_ body(PG2, x2, y2, PG1, x1, y1, x, y, z, dst2, NULL, 0, 0, 0);
+          cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
+        }
+      /* if */
+    }
+  /* if */
+
+#ifdef _DEBUG
+  // Compare the fused kernel to the reference implementation.
+  {
+    cv::Mat * x_ref = NULL;  cv::Mat * y_ref = NULL;  cv::Mat * z_ref = NULL;
+    cv::Mat * dst2_ref = NULL;
+
+    bool const result_ref = TriangulateTwoViewsReference(PG1, x1, y1, PG2, x2, y2, &x_ref, &y_ref, &z_ref, &dst2_ref);
+    assert(true == result_ref);
+    if (true == result_ref)
+      {
+        double const diff_x = MaxRelativeDifference_inline(x, x_ref);
+        double const diff_y = MaxRelativeDifference_inline(y, y_ref);
+        double const diff_z = MaxRelativeDifference_inline(z, z_ref);
+        double const diff_dst2 = MaxRelativeDifference_inline(dst2, dst2_ref);
+        assert( TRIANGULATION_FUSED_TOLERANCE >= diff_x );
+        assert( TRIANGULATION_FUSED_TOLERANCE >= diff_y );
+        assert( TRIANGULATION_FUSED_TOLERANCE >= diff_z );
+        assert( TRIANGULATION_FUSED_TOLERANCE >= diff_dst2 );
+      }
+    /* if */
+
+    SAFE_DELETE( x_ref );  SAFE_DELETE( y_ref );  SAFE_DELETE( z_ref );
+    SAFE_DELETE( dst2_ref );
+  }
+#endif /* _DEBUG */
+
+  SAFE_ASSIGN_PTR( x, x_out );
+  SAFE_ASSIGN_PTR( y, y_out );
+  SAFE_ASSIGN_PTR( z, z_out );
+  SAFE_ASSIGN_PTR( dst2, dst2_out );
+
+ TriangulateTwoViews_EXIT:
+
+  SAFE_DELETE( x );
+  SAFE_DELETE( y );
+  SAFE_DELETE( z );
+  SAFE_DELETE( dst2 );
+
+  return result;
+}
+/* TriangulateTwoViews */
+
+
+
+
+/****** CAMERA RAY TABLES ******/
+
+//! Constructor.
+/*!
+  Blanks class variables.
+*/
+CameraRayTable_::CameraRayTable_()
+{
+  this->Blank();
+}
+/* CameraRayTable_::CameraRayTable_ */
+
+
+
+//! Destructor.
+/*!
+  Deletes ray direction arrays.
+*/
+CameraRayTable_::~CameraRayTable_()
+{
+  SAFE_DELETE( this->vx );
+  SAFE_DELETE( this->vy );
+  SAFE_DELETE( this->vz );
+
+  this->Blank();
+}
+/* CameraRayTable_::~CameraRayTable_ */
+
+
+
+//! Blank class variables.
+/*!
+  Initializes all class variables.
+*/
+void
+CameraRayTable_::Blank(
+                       void
+                       )
+{
+  this->name.clear();
+
+  this->fx = BATCHACQUISITION_qNaN_dv;
+  this->fy = BATCHACQUISITION_qNaN_dv;
+  this->cx = BATCHACQUISITION_qNaN_dv;
+  this->cy = BATCHACQUISITION_qNaN_dv;
+  this->k0 = BATCHACQUISITION_qNaN_dv;
+  this->k1 = BATCHACQUISITION_qNaN_dv;
+
+  for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 4; ++j) this->projection[i][j] = BATCHACQUISITION_qNaN_dv;
+      this->center[i] = BATCHACQUISITION_qNaN_dv;
+    }
+  /* for */
+
+  this->shift_x = 0;
+  this->shift_y = 0;
+  this->width = 0;
+  this->height = 0;
+
+  this->vx = NULL;
+  this->vy = NULL;
+  this->vz = NULL;
+
+  this->refcount = 0;
+}
+/* CameraRayTable_::Blank */
+
+
+
+//! Check if table matches geometry.
+/*!
+  Checks if the ray table was computed for the given camera geometry and sensor size.
+  Parameters must match exactly as they are always read from the same geometry file.
+
+  \param geometry       Pointer to camera geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices.
+  \param shift_y        Row shift applied to pixel indices.
+  \return Returns true if table is valid for the given geometry.
+*/
+bool
+CameraRayTable_::IsValidFor(
+                            ProjectiveGeometry_ const * const geometry,
+                            int const width,
+                            int const height,
+                            int const shift_x,
+                            int const shift_y
+                            ) const
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return false;
+
+  bool const valid =
+    (NULL != this->vx) && (NULL != this->vy) && (NULL != this->vz) &&
+    (this->width == width) && (this->height == height) &&
+    (this->shift_x == shift_x) && (this->shift_y == shift_y) &&
+    (this->fx == geometry->fx) && (this->fy == geometry->fy) &&
+    (this->cx == geometry->cx) && (this->cy == geometry->cy) &&
+    (this->k0 == geometry->k0) && (this->k1 == geometry->k1);
+  if (false == valid) return false;
+
+  for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 4; ++j) if (this->projection[i][j] != geometry->projection[i][j]) return false;
+      if (this->center[i] != geometry->center[i]) return false;
+    }
+  /* for */
+
+  return true;
+}
+/* CameraRayTable_::IsValidFor */
+
+
+
+//! Memory used by the table.
+/*!
+  Returns number of bytes used to store the ray directions.
+
+  \return Size in bytes.
+*/
+size_t
+CameraRayTable_::SizeInBytes(
+                             void
+                             ) const
+{
+  size_t size = 0;
+  if ( (NULL != this->vx) && (NULL != this->vx->data) ) size += this->vx->step[0] * (size_t)(this->vx->rows);
+  if ( (NULL != this->vy) && (NULL != this->vy->data) ) size += this->vy->step[0] * (size_t)(this->vy->rows);
+  if ( (NULL != this->vz) && (NULL != this->vz->data) ) size += this->vz->step[0] * (size_t)(this->vz->rows);
+  return size;
+}
+/* CameraRayTable_::SizeInBytes */
+
+
+
+//! Parallel computation of the camera ray table.
+/*!
+  Each invocation computes unit ray directions for all pixels in a band of rows.
+  Rays are computed in double precision and are then rounded to single precision.
+*/
+struct CameraRayTableParallel_ : public cv::ParallelLoopBody
+{
+  CameraRayTable * table; //!< Ray table to fill.
+  double Pinv[12]; //!< Pseudoinverse of the projection matrix.
+
+  //! Constructor.
+  CameraRayTableParallel_(
+                          CameraRayTable * const table_in,
+                          ProjectiveGeometry * const geometry_in
+                          )
+  {
+    this->table = table_in;
+    GetProjectionPseudoinverse_inline(geometry_in, this->Pinv);
+  }
+
+  //! Fills a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const width = this->table->width;
+
+    for (int j = r.start; j < r.end; ++j)
+      {
+        float * const row_vx = (float *)( (BYTE *)(this->table->vx->data) + this->table->vx->step[0] * j );
+        float * const row_vy = (float *)( (BYTE *)(this->table->vy->data) + this->table->vy->step[0] * j );
+        float * const row_vz = (float *)( (BYTE *)(this->table->vz->data) + this->table->vz->step[0] * j );
+
+        for (int i = 0; i < width; ++i)
+          {
+            double vx, vy, vz;
+            GetCameraRayForPixel_inline(this->table, this->Pinv, i, j, &vx, &vy, &vz);
+
+            row_vx[i] = (float)( vx );
+            row_vy[i] = (float)( vy );
+            row_vz[i] = (float)( vz );
+          }
+        /* for */
+      }
+    /* for */
+  }
+};
+/* CameraRayTableParallel_ */
+
+
+
+//! Copy camera parameters to ray table.
+/*!
+  Copies camera parameters and sensor size which define camera rays to the table.
+  Ray direction arrays are not allocated.
+
+  \param table  Pointer to camera ray table.
+  \param geometry       Pointer to camera geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices.
+  \param shift_y        Row shift applied to pixel indices.
+*/
+inline
+void
+CameraRayTableSetGeometry_inline(
+                                 CameraRayTable * const table,
+                                 ProjectiveGeometry const * const geometry,
+                                 int const width,
+                                 int const height,
+                                 int const shift_x,
+                                 int const shift_y
+                                 )
+{
+  assert( (NULL != table) && (NULL != geometry) );
+
+  table->name = (NULL != geometry->name)? *(geometry->name) : std::wstring();
+  table->fx = geometry->fx;
+  table->fy = geometry->fy;
+  table->cx = geometry->cx;
+  table->cy = geometry->cy;
+  table->k0 = geometry->k0;
+  table->k1 = geometry->k1;
+  for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 4; ++j) table->projection[i][j] = geometry->projection[i][j];
+      table->center[i] = geometry->center[i];
+    }
+  /* for */
+  table->shift_x = shift_x;
+  table->shift_y = shift_y;
+  table->width = width;
+  table->height = height;
+}
+/* CameraRayTableSetGeometry_inline */
+
+
+
+//! Compute camera ray table.
+/*!
+  Computes unit ray directions for every pixel of the sensor.
+  Returned table is not cached and must be deleted by the caller;
+  use CameraRayTableCacheGet to obtain shared tables.
+
+  \param geometry       Pointer to camera geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices. Set to 1 if internal camera parameters were computed for Matlab indices, and to 0 otherwise.
+  \param shift_y        Row shift applied to pixel indices.
+  \return Returns pointer to the table or NULL if unsuccessfull.
+*/
+CameraRayTable_ *
+CameraRayTableCompute(
+                      ProjectiveGeometry_ * const geometry,
+                      int const width,
+                      int const height,
+                      int const shift_x,
+                      int const shift_y
+                      )
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return NULL;
+
+  assert( (0 < width) && (0 < height) );
+  if ( (0 >= width) || (0 >= height) ) return NULL;
+
+  CameraRayTable * table = new CameraRayTable();
+  assert(NULL != table);
+  if (NULL == table) return NULL;
+
+  CameraRayTableSetGeometry_inline(table, geometry, width, height, shift_x, shift_y);
+
+  table->vx = new cv::Mat(height, width, CV_32FC1);
+  table->vy = new cv::Mat(height, width, CV_32FC1);
+  table->vz = new cv::Mat(height, width, CV_32FC1);
+  assert( (NULL != table->vx) && (NULL != table->vx->data) );
+  assert( (NULL != table->vy) && (NULL != table->vy->data) );
+  assert( (NULL != table->vz) && (NULL != table->vz->data) );
+  if ( (NULL == table->vx) || (NULL == table->vx->data) ||
+       (NULL == table->vy) || (NULL == table->vy->data) ||
+       (NULL == table->vz) || (NULL == table->vz->data)
+       )
+    {
+      SAFE_DELETE( table );
+      return NULL;
+    }
+  /* if */
+
+  {
+    CameraRayTableParallel_ body(table, geometry);
+    cv::parallel_for_(cv::Range(0, height), body, (double)(height) / (double)(CAMERA_RAY_TABLE_BAND_HEIGHT));
+  }
+
+  return table;
+}
+/* CameraRayTableCompute */
+
+
+
+//! Find cached table.
+/*!
+  Searches the cache for a table computed for the named camera.
+  Cache lock must be held by the caller.
+
+  \param name   Unique camera name.
+  \param idx_out        Address where the index of the table in the cache will be stored. May be NULL.
+  \return Returns pointer to the table or NULL if there is no such table.
+*/
+inline
+CameraRayTable *
+CameraRayTableCacheFind_inline(
+                               std::wstring const & name,
+                               int * const idx_out
+                               )
+{
+  int const i_max = (int)( gCameraRayTableCache.size() );
+  for (int i = 0; i < i_max; ++i)
+    {
+      CameraRayTable * const table = gCameraRayTableCache[i];
+      if ( (NULL != table) && (table->name == name) )
+        {
+          if (NULL != idx_out) *idx_out = i;
+          return table;
+        }
+      /* if */
+    }
+  /* for */
+  if (NULL != idx_out) *idx_out = -1;
+  return NULL;
+}
+/* CameraRayTableCacheFind_inline */
+
+
+
+//! Get cached camera ray table.
+/*!
+  Returns table of unit ray directions for every pixel of the sensor.
+  There is one table per camera name; if camera geometry or sensor size
+  changed then the table is recomputed and replaces the old one.
+  Table uses 12 bytes per pixel, e.g. 60 MB for a 5 MP and 144 MB for a 12 MP sensor;
+  if the table would be larger than CAMERA_RAY_TABLE_MAX_SIZE then it is not computed.
+
+  Returned table is owned by the cache and must not be modified or deleted.
+  Caller must release the returned table by calling CameraRayTableCacheRelease
+  once it is no longer used.
+  A table which is replaced by a table for changed geometry of the same camera is deleted
+  when its last user releases it.
+
+  \param geometry       Pointer to camera geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices. Set to 1 if internal camera parameters were computed for Matlab indices, and to 0 otherwise.
+  \param shift_y        Row shift applied to pixel indices.
+  \return Returns pointer to the table or NULL if table is too large or if unsuccessfull.
+*/
+CameraRayTable_ *
+CameraRayTableCacheGet(
+                       ProjectiveGeometry_ * const geometry,
+                       int const width,
+                       int const height,
+                       int const shift_x,
+                       int const shift_y
+                       )
+{
+  assert(NULL != geometry);
+  if (NULL == geometry) return NULL;
+
+  assert( (0 < width) && (0 < height) );
+  if ( (0 >= width) || (0 >= height) ) return NULL;
+
+  // Skip tables which do not fit into the memory budget.
+  size_t const table_size = 3 * sizeof(float) * (size_t)(width) * (size_t)(height);
+  if (CAMERA_RAY_TABLE_MAX_SIZE < table_size) return NULL;
+
+  std::wstring const name = (NULL != geometry->name)? *(geometry->name) : std::wstring();
+
+  CameraRayTable * table = NULL;
+
+  // Check in-memory cache.
+  AcquireSRWLockShared( &gCameraRayTableCacheLock );
+  table = CameraRayTableCacheFind_inline(name, NULL);
+  if ( (NULL != table) && (false == table->IsValidFor(geometry, width, height, shift_x, shift_y)) ) table = NULL;
+  if (NULL != table) InterlockedIncrement( &(table->refcount) );
+  ReleaseSRWLockShared( &gCameraRayTableCacheLock );
+
+  if (NULL != table) return table;
+
+  // Compute new table.
+  DEBUG_TIMER * const debug_timer = DebugTimerInit();
+
+  CameraRayTable * new_table = CameraRayTableCompute(geometry, width, height, shift_x, shift_y);
+  assert(NULL != new_table);
+  if (NULL == new_table)
+    {
+      DebugTimerDestroy( debug_timer );
+      return NULL;
+    }
+  /* if */
+
+  double const duration = DebugTimerQueryStart( debug_timer );
+  DebugTimerDestroy( debug_timer );
+
+  // Store the table; another thread may have stored the same table in the meantime.
+  size_t cache_size = 0;
+  int cache_count = 0;
+
+  CameraRayTable * replaced = NULL;
+
+  AcquireSRWLockExclusive( &gCameraRayTableCacheLock );
+
+  int idx = -1;
+  table = CameraRayTableCacheFind_inline(name, &idx);
+  if ( (NULL != table) && (true == table->IsValidFor(geometry, width, height, shift_x, shift_y)) )
+    {
+      // Keep existing table.
+    }
+  else if (NULL != table)
+    {
+      assert( (0 <= idx) && (idx < (int)(gCameraRayTableCache.size())) );
+      // Retire replaced table if it is in use, otherwise delete it after the lock is released.
+      if (0 < table->refcount) gCameraRayTableRetired.push_back( table );
+      else replaced = table;
+      gCameraRayTableCache[idx] = NULL;
+      table = NULL;
+      SWAP_ONE_VALID_PTR( table, new_table );
+      gCameraRayTableCache[idx] = table;
+    }
+  else
+    {
+      gCameraRayTableCache.push_back(new_table);
+      SWAP_ONE_VALID_PTR( table, new_table );
+    }
+  /* if */
+
+  // Caller holds the returned table until it calls CameraRayTableCacheRelease.
+  InterlockedIncrement( &(table->refcount) );
+
+  cache_count = (int)( gCameraRayTableCache.size() );
+  for (int i = 0; i < cache_count; ++i)
+    {
+      if (NULL != gCameraRayTableCache[i]) cache_size += gCameraRayTableCache[i]->SizeInBytes();
+    }
+  /* for */
+
+  ReleaseSRWLockExclusive( &gCameraRayTableCacheLock );
+
+  if (NULL == new_table)
+    {
+      Debugfwprintf(
+                    stderr, gDbgCameraRayTableComputed,
+                    width, height, name.c_str(), duration,
+                    (double)( table->SizeInBytes() ) / 1048576.0, cache_count, (double)(cache_size) / 1048576.0
+                    );
+    }
+  /* if */
+
+  SAFE_DELETE( new_table );
+  SAFE_DELETE( replaced );
+
+  return table;
+}
+/* CameraRayTableCacheGet */
+
+
+
+//! Release cached camera ray table.
+/*!
+  Releases table returned by CameraRayTableCacheGet. Every returned table must be released
+  exactly once. A table which was replaced in the cache is deleted when
+  its last user releases it.
+
+  \param table  Pointer to the table. May be NULL.
+*/
+void
+CameraRayTableCacheRelease(
+                           CameraRayTable_ const * const table
+                           )
+{
+  if (NULL == table) return;
+
+  CameraRayTable * retired = NULL;
+
+  AcquireSRWLockExclusive( &gCameraRayTableCacheLock );
+
+  assert(0 < table->refcount);
+  LONG const refcount = InterlockedDecrement( &(table->refcount) );
+  if (0 == refcount)
+    {
+      int const k_max = (int)( gCameraRayTableRetired.size() );
+      for (int k = 0; k < k_max; ++k)
+        {
+          if (table != gCameraRayTableRetired[k]) continue;
+          retired = gCameraRayTableRetired[k];
+          gCameraRayTableRetired.erase( gCameraRayTableRetired.begin() + k );
+          break;
+        }
+      /* for */
+    }
+  /* if */
+
+  ReleaseSRWLockExclusive( &gCameraRayTableCacheLock );
+
+  SAFE_DELETE( retired );
+}
+/* CameraRayTableCacheRelease */
+
+
+
+//! Clear camera ray table cache.
+/*!
+  Deletes all cached and retired camera ray tables.
+  Function must not be called while any reconstruction is in progress.
+*/
+void
+CameraRayTableCacheClear(
+                         void
+                         )
+{
+  AcquireSRWLockExclusive( &gCameraRayTableCacheLock );
+
+  int const i_max = (int)( gCameraRayTableCache.size() );
+  for (int i = 0; i < i_max; ++i) SAFE_DELETE( gCameraRayTableCache[i] );
+  gCameraRayTableCache.clear();
+
+  int const k_max = (int)( gCameraRayTableRetired.size() );
+  for (int k = 0; k < k_max; ++k) SAFE_DELETE( gCameraRayTableRetired[k] );
+  gCameraRayTableRetired.clear();
+
+  ReleaseSRWLockExclusive( &gCameraRayTableCacheLock );
+}
+/* CameraRayTableCacheClear */
+
+
+
+//! Triangulates two views using camera ray table.
+/*!
+  Function computes intersections of the camera view and the projector view.
+  Camera rays are fetched from the camera ray table by pixel index so
+  distorted camera coordinates do not have to be undistorted and rays
+  do not have to be recomputed; pixels outside of the table are processed directly.
+  Note that at most one of x2 and y2 may be NULL; if so then dst2 will not be computed.
+
+  As rays are stored in single precision triangulated points differ from
+  the ones returned by TriangulateTwoViews for undistorted coordinates;
+  for well-conditioned geometry the difference is about 2e-7 of the distance
+  from the camera center and it grows as rays become parallel to projector planes.
+
+  \param PG1    Projective geometry for the first view (camera).
+  \param table  Camera ray table computed for PG1.
+  \param x1     Image column indices for the first view relative to the offset. Must be CV_32S.
+  \param y1     Image row indices for the first view relative to the offset. Must be CV_32S.
+  \param offset_x       Column of the first pixel of the image in the sensor, e.g. non-zero if the image is a ROI.
+  \param offset_y       Row of the first pixel of the image in the sensor.
+  \param PG2    Projective geometry for the second view (projector).
+  \param x2     Undistorted image x coordinates for the second view.
+  \param y2     Undistorted image y coordinates for the second view.
+  \param x_out  Address where x coordinates of intersection points will be stored.
+  \param y_out  Address where y coordinates of intersection points will be stored.
+  \param z_out  Address where z coordinates of intersection points will be stored.
+  \param dst2_out Squared length of the shortest line segment that connects two rays.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+TriangulateTwoViewsUsingRayTable(
+                                 ProjectiveGeometry * const PG1,
+                                 CameraRayTable_ const * const table,
+                                 cv::Mat * const x1,
+                                 cv::Mat * const y1,
+                                 int const offset_x,
+                                 int const offset_y,
+                                 ProjectiveGeometry * const PG2,
+                                 cv::Mat * const x2,
+                                 cv::Mat * const y2,
+                                 cv::Mat * * const x_out,
+                                 cv::Mat * * const y_out,
+                                 cv::Mat * * const z_out,
+                                 cv::Mat * * const dst2_out
+                                 )
+{
+  bool const valid1 = CheckCoordinateArrays_inline(x1, y1, CV_32S);
+  assert(true == valid1);
+  if (true != valid1) return false;
+
+  int const num_valid = CheckRowArrays_inline(CV_64F, (NULL != x2)? x2 : y2, (NULL != x2)? y2 : NULL);
+  assert( 1 <= num_valid );
+  if (1 > num_valid) return false;
+
+  assert( (NULL != PG1) && (NULL != PG2) );
+  if ( (NULL == PG1) || (NULL == PG2) ) return false;
+
+  assert( (NULL != table) && (true == table->IsValidFor(PG1, table->width, table->height, table->shift_x, table->shift_y)) );
+  if ( (NULL == table) || (NULL == table->vx) || (NULL == table->vy) || (NULL == table->vz) ) return false;
+
+  int const N = x1->cols;
+  assert( N == ( (NULL != x2)? x2->cols : y2->cols ) );
+  if ( N != ( (NULL != x2)? x2->cols : y2->cols ) ) return false;
+
+  bool result = true; // Assume success.
+
+  bool const ray_ray = ( (NULL != x2) && (NULL != y2) );
+
+  // Allocate outputs.
+  cv::Mat * x = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x);
+
+  cv::Mat * y = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y);
+
+  cv::Mat * z = new cv::Mat(1, N, CV_64F);
+  assert(NULL != z);
+
+  cv::Mat * dst2 = (true == ray_ray)? new cv::Mat(1, N, CV_64F) : NULL;
+  assert( (NULL != dst2) || (false == ray_ray) );
+
+  if ( (NULL == x) || (NULL == y) || (NULL == z) || ( (NULL == dst2) && (true == ray_ray) ) )
+    {
+      result = false;
+      goto TriangulateTwoViewsUsingRayTable_EXIT;
+    }
+  /* if */
+
+  // Triangulate views.
+  if (0 < N)
+    {
+      int const num_chunks = (N + TRIANGULATION_CHUNK_SIZE - 1) / TRIANGULATION_CHUNK_SIZE;
+      TriangulateTwoViewsParallel_ body(PG1, x1, y1, PG2, x2, y2, x, y, z, dst2, table, offset_x, offset_y, 0);
+      cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
+    }
+  /* if */
+
+  SAFE_ASSIGN_PTR( x, x_out );
+  SAFE_ASSIGN_PTR( y, y_out );
+  SAFE_ASSIGN_PTR( z, z_out );
+  SAFE_ASSIGN_PTR( dst2, dst2_out );
+
+ TriangulateTwoViewsUsingRayTable_EXIT:
+
+  SAFE_DELETE( x );
+  SAFE_DELETE( y );
+  SAFE_DELETE( z );
+  SAFE_DELETE( dst2 );
+
+  return result;
+}
+/* TriangulateTwoViewsUsingRayTable */
+
+
+
+/****** SINGLE-DIRECTION TRIANGULATION ******/
+
+//! Triangulates two views when only one projector coordinate is known.
+/*!
+  Function computes intersections of camera rays and projector planes of the
+  known distorted projector coordinate, estimates the missing projector
+  coordinate by projecting points to the projector, undistorts both projector
+  coordinates, and computes ray-ray intersections. Refinement is repeated for
+  a fixed number of iterations and every point is processed in registers so
+  only the output arrays are allocated and data is traversed once.
+
+  One iteration gives the same result as TriangulateTwoViews followed by
+  ProjectPoints, UndistortImageCoordinatesForRadialDistorsion and ray-ray
+  triangulation. Further iterations distort the estimated coordinate before
+  undistortion so the point converges to the point whose distorted projection
+  matches the known projector coordinate.
+
+  \param PG1    Projective geometry for the first view (camera).
+  \param table  Camera ray table computed for PG1. May be NULL.
+  \param x1     Image x coordinates for the first view. If table is given then these are CV_32S
+  column indices relative to the offset; otherwise these are undistorted CV_64F image coordinates.
+  \param y1     Image y coordinates for the first view. Must be of the same type as x1.
+  \param offset_x       Column of the first pixel of the image in the sensor; used only if table is given.
+  \param offset_y       Row of the first pixel of the image in the sensor; used only if table is given.
+  \param PG2    Projective geometry for the second view (projector).
+  \param x2     Distorted projector column coordinates or NULL.
+  \param y2     Distorted projector row coordinates or NULL.
+  \param iterations     Number of refinement iterations; must be at least 1.
+  \param x_out  Address where x coordinates of intersection points will be stored.
+  \param y_out  Address where y coordinates of intersection points will be stored.
+  \param z_out  Address where z coordinates of intersection points will be stored.
+  \param dst2_out       Address where squared distances between rays of the last iteration will be stored.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+TriangulateSingleDirection(
+                           ProjectiveGeometry * const PG1,
+                           CameraRayTable_ const * const table,
+                           cv::Mat * const x1,
+                           cv::Mat * const y1,
+                           int const offset_x,
+                           int const offset_y,
+                           ProjectiveGeometry * const PG2,
+                           cv::Mat * const x2,
+                           cv::Mat * const y2,
+                           int const iterations,
+                           cv::Mat * * const x_out,
+                           cv::Mat * * const y_out,
+                           cv::Mat * * const z_out,
+                           cv::Mat * * const dst2_out
+                           )
+{
+  assert( (NULL == x2) != (NULL == y2) );
+  if ( (NULL == x2) == (NULL == y2) ) return false;
+
+  cv::Mat * const u = (NULL != x2)? x2 : y2;
+
+  if (NULL != table)
+    {
+      bool const valid1 = CheckCoordinateArrays_inline(x1, y1, CV_32S);
+      assert(true == valid1);
+      if (true != valid1) return false;
+
+      int const num_valid = CheckRowArrays_inline(CV_64F, u);
+      assert(1 == num_valid);
+      if (1 != num_valid) return false;
+
+      assert( true == table->IsValidFor(PG1, table->width, table->height, table->shift_x, table->shift_y) );
+      if ( (NULL == table->vx) || (NULL == table->vy) || (NULL == table->vz) ) return false;
+    }
+  else
+    {
+      int const num_valid = CheckRowArrays_inline(CV_64F, x1, y1, u);
+      assert(3 == num_valid);
+      if (3 != num_valid) return false;
+    }
+  /* if */
+
+  assert( (NULL != PG1) && (NULL != PG2) );
+  if ( (NULL == PG1) || (NULL == PG2) ) return false;
+
+  assert(0 < iterations);
+  if (0 >= iterations) return false;
+
+  int const N = x1->cols;
+  assert( N == u->cols );
+  if ( N != u->cols ) return false;
+
+  bool result = true; // Assume success.
+
+  // Allocate outputs.
+  cv::Mat * x = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x);
+
+  cv::Mat * y = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y);
+
+  cv::Mat * z = new cv::Mat(1, N, CV_64F);
+  assert(NULL != z);
+
+  cv::Mat * dst2 = new cv::Mat(1, N, CV_64F);
+  assert(NULL != dst2);
+
+  if ( (NULL == x) || (NULL == y) || (NULL == z) || (NULL == dst2) )
+    {
+      result = false;
+      goto TriangulateSingleDirection_EXIT;
+    }
+  /* if */
+
+  // Triangulate and refine points.
+  if (0 < N)
+    {
+      int const num_chunks = (N + TRIANGULATION_CHUNK_SIZE - 1) / TRIANGULATION_CHUNK_SIZE;
+      TriangulateTwoViewsParallel_ body(PG1, x1, y1, PG2, x2, y2, x, y, z, dst2, table, offset_x, offset_y, iterations);
+      cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
+    }
+  /* if */
+
+  SAFE_ASSIGN_PTR( x, x_out );
+  SAFE_ASSIGN_PTR( y, y_out );
+  SAFE_ASSIGN_PTR( z, z_out );
+  SAFE_ASSIGN_PTR( dst2, dst2_out );
+
+ TriangulateSingleDirection_EXIT:
+
+  SAFE_DELETE( x );
+  SAFE_DELETE( y );
+  SAFE_DELETE( z );
+  SAFE_DELETE( dst2 );
+
+  return result;
+}
+/* TriangulateSingleDirection */
+
+
+
+
+/****** PHASE-TO-XYZ MODELS ******/
+
+//! Constructor.
+/*!
+  Blanks class variables.
+*/
+PhaseToXYZModel_::PhaseToXYZModel_()
+{
+  this->Blank();
+}
+/* PhaseToXYZModel_::PhaseToXYZModel_ */
+
+
+
+//! Destructor.
+/*!
+  Deletes geometry copies and model coefficients.
+*/
+PhaseToXYZModel_::~PhaseToXYZModel_()
+{
+  SAFE_DELETE( this->camera );
+  SAFE_DELETE( this->projector );
+  SAFE_DELETE( this->coefficients );
+
+  this->Blank();
+}
+/* PhaseToXYZModel_::~PhaseToXYZModel_ */
+
+
+
+//! Blank class variables.
+/*!
+  Initializes all class variables.
+*/
+void
+PhaseToXYZModel_::Blank(
+                        void
+                        )
+{
+  this->camera = NULL;
+  this->projector = NULL;
+
+  this->shift_x = 0;
+  this->shift_y = 0;
+  this->width = 0;
+  this->height = 0;
+
+  this->row = -1;
+  this->size = BATCHACQUISITION_qNaN_dv;
+
+  this->depth_min = BATCHACQUISITION_qNaN_dv;
+  this->depth_max = BATCHACQUISITION_qNaN_dv;
+  this->max_error = BATCHACQUISITION_qNaN_dv;
+  this->num_valid = 0;
+
+  this->coefficients = NULL;
+
+  this->refcount = 0;
+}
+/* PhaseToXYZModel_::Blank */
+
+
+
+//! Compare geometry.
+/*!
+  Checks if two geometries have the same internal and external parameters.
+  Parameters must match exactly as they are always read from the same geometry file.
+
+  \param A      Pointer to first geometry.
+  \param B      Pointer to second geometry.
+  \return Returns true if geometries are the same.
+*/
+inline
+bool
+IsSameGeometry_inline(
+                      ProjectiveGeometry const * const A,
+                      ProjectiveGeometry const * const B
+                      )
+{
+  if ( (NULL == A) || (NULL == B) ) return false;
+
+  bool const same =
+    (A->fx == B->fx) && (A->fy == B->fy) &&
+    (A->cx == B->cx) && (A->cy == B->cy) &&
+    (A->k0 == B->k0) && (A->k1 == B->k1);
+  if (false == same) return false;
+
+  for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 4; ++j) if (A->projection[i][j] != B->projection[i][j]) return false;
+      if (A->center[i] != B->center[i]) return false;
+    }
+  /* for */
+
+  return true;
+}
+/* IsSameGeometry_inline */
+
+
+
+//! Check if model matches geometry.
+/*!
+  Checks if the model was computed for the given camera and projector geometry,
+  sensor size, projector coordinate, and projector resolution.
+  Rejected models which have no coefficients are matched as well.
+
+  \param camera_in      Pointer to camera geometry.
+  \param projector_in   Pointer to projector geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices.
+  \param shift_y        Row shift applied to pixel indices.
+  \param row    Projector coordinate; 0 for columns and 1 for rows.
+  \param size   Projector width or height in pixels.
+  \return Returns true if model is valid for the given geometry.
+*/
+bool
+PhaseToXYZModel_::IsValidFor(
+                             ProjectiveGeometry_ const * const camera_in,
+                             ProjectiveGeometry_ const * const projector_in,
+                             int const width,
+                             int const height,
+                             int const shift_x,
+                             int const shift_y,
+                             int const row,
+                             double const size
+                             ) const
+{
+  assert( (NULL != camera_in) && (NULL != projector_in) );
+  if ( (NULL == camera_in) || (NULL == projector_in) ) return false;
+
+  bool const valid =
+    (this->width == width) && (this->height == height) &&
+    (this->shift_x == shift_x) && (this->shift_y == shift_y) &&
+    (this->row == row) && (this->size == size);
+  if (false == valid) return false;
+
+  return IsSameGeometry_inline(this->camera, camera_in) && IsSameGeometry_inline(this->projector, projector_in);
+}
+/* PhaseToXYZModel_::IsValidFor */
+
+
+
+//! Memory used by the model.
+/*!
+  Returns number of bytes used to store the model coefficients.
+
+  \return Size in bytes.
+*/
+size_t
+PhaseToXYZModel_::SizeInBytes(
+                              void
+                              ) const
+{
+  if ( (NULL == this->coefficients) || (NULL == this->coefficients->data) ) return 0;
+  return this->coefficients->step[0] * (size_t)(this->coefficients->rows);
+}
+/* PhaseToXYZModel_::SizeInBytes */
+
+
+
+//! Distorts a point.
+/*!
+  Inverts the radial distortion model of UndistortImageCoordinatesForRadialDistorsion,
+  i.e. function finds the distorted point which is mapped to the given undistorted point.
+  Distortion is radial so only the distorted radius r is found by solving
+  r = r_un (1 + k0 r^2 + k1 r^4) using Newton's method.
+
+  \param geometry       Pointer to geometry which holds distortion parameters.
+  \param x_un   Undistorted x coordinate.
+  \param y_un   Undistorted y coordinate.
+  \param x_dis  Address where distorted x coordinate will be stored.
+  \param y_dis  Address where distorted y coordinate will be stored.
+  \return Returns true if iteration converged.
+*/
+inline
+bool
+DistortPointForRadialDistorsion_inline(
+                                       ProjectiveGeometry const * const geometry,
+                                       double const x_un,
+                                       double const y_un,
+                                       double * const x_dis,
+                                       double * const y_dis
+                                       )
+{
+  assert(NULL != geometry);
+
+  double const xu = ( x_un - geometry->cx ) / geometry->fx;
+  double const yu = ( y_un - geometry->cy ) / geometry->fy;
+
+  double const r_un = sqrt(xu*xu + yu*yu);
+
+  double const r2_un = r_un * r_un;
+  double r = r_un * ( 1.0 + (geometry->k0 + geometry->k1 * r2_un) * r2_un );
+  for (int i = 0; i < 16; ++i)
+    {
+      double const r2 = r * r;
+      double const f = r - r_un * ( 1.0 + (geometry->k0 + geometry->k1 * r2) * r2 );
+      double const df = 1.0 - r_un * (2.0 * geometry->k0 + 4.0 * geometry->k1 * r2) * r;
+      double const change = f / df;
+      r -= change;
+      if ( !(fabs(change) > 1.0e-14 * r) ) break;
+    }
+  /* for */
+
+  double const scale = (0.0 < r_un)? r / r_un : 1.0;
+  double const x = xu * scale;
+  double const y = yu * scale;
+
+  // Comparisons are written so NaN values are rejected.
+  double const r2 = x*x + y*y;
+  double const L = 1.0 + (geometry->k0 + geometry->k1 * r2) * r2;
+  if ( !(0.0 < L) ) return false;
+  if ( !(fabs(x / L - xu) + fabs(y / L - yu) <= 1.0e-12) ) return false;
+
+  *x_dis = geometry->cx + geometry->fx * x;
+  *y_dis = geometry->cy + geometry->fy * y;
+
+  return true;
+}
+/* DistortPointForRadialDistorsion_inline */
+
+
+
+//! Solves small linear system.
+/*!
+  Solves linear system using Gaussian elimination with partial pivoting.
+
+  \param A      Row-major n x n system matrix; it is overwritten.
+  \param b      Right hand side; it is overwritten by the solution.
+  \param n      System size.
+  \return Returns false if system is singular.
+*/
+inline
+bool
+SolveLinearSystem_inline(
+                         double * const A,
+                         double * const b,
+                         int const n
+                         )
+{
+  for (int i = 0; i < n; ++i)
+    {
+      int p = i;
+      for (int j = i + 1; j < n; ++j) if ( fabs(A[j * n + i]) > fabs(A[p * n + i]) ) p = j;
+      if ( !(0.0 != A[p * n + i]) ) return false;
+
+      if (p != i)
+        {
+          for (int k = 0; k < n; ++k)
+            {
+              double const tmp = A[i * n + k];
+              A[i * n + k] = A[p * n + k];
+              A[p * n + k] = tmp;
+            }
+          /* for */
+          double const tmp = b[i];
+          b[i] = b[p];
+          b[p] = tmp;
+        }
+      /* if */
+
+      for (int j = i + 1; j < n; ++j)
+        {
+          double const f = A[j * n + i] / A[i * n + i];
+          for (int k = i; k < n; ++k) A[j * n + k] -= f * A[i * n + k];
+          b[j] -= f * b[i];
+        }
+      /* for */
+    }
+  /* for */
+
+  for (int i = n - 1; 0 <= i; --i)
+    {
+      double s = b[i];
+      for (int k = i + 1; k < n; ++k) s -= A[i * n + k] * b[k];
+      b[i] = s / A[i * n + i];
+    }
+  /* for */
+
+  return true;
+}
+/* SolveLinearSystem_inline */
+
+
+
+//! Gets orientation of projection matrix.
+/*!
+  Returns the sign of the determinant of the left 3x3 submatrix of the
+  projection matrix. Point X is in front of the camera if the third
+  homogeneous coordinate of its projection multiplied by this sign is positive.
+
+  \param geometry       Pointer to projective geometry.
+  \return Returns 1.0 or -1.0.
+*/
+inline
+double
+ProjectionOrientation_inline(
+                             ProjectiveGeometry const * const geometry
+                             )
+{
+  assert(NULL != geometry);
+
+  double const (* const P)[4] = geometry->projection;
+  double const det =
+    P[0][0] * ( P[1][1] * P[2][2] - P[1][2] * P[2][1] ) -
+    P[0][1] * ( P[1][0] * P[2][2] - P[1][2] * P[2][0] ) +
+    P[0][2] * ( P[1][0] * P[2][1] - P[1][1] * P[2][0] );
+
+  return (0.0 > det)? -1.0 : 1.0;
+}
+/* ProjectionOrientation_inline */
+
+
+
+//! Evaluates phase-to-XYZ model.
+/*!
+  Computes distance along the camera ray for one pixel.
+
+  \param c      Pointer to model coefficients of the pixel.
+  \param u      Distorted projector coordinate.
+  \return Returns distance from the camera center.
+*/
+inline
+double
+PhaseToXYZModelDistance_inline(
+                               float const * const c,
+                               double const u
+                               )
+{
+  double const s = u - (double)( c[3] );
+  double d = (double)( c[8] );
+  d = d * s + (double)( c[7] );
+  d = d * s + (double)( c[6] );
+  d = d * s + (double)( c[5] );
+  d = d * s + (double)( c[4] );
+  d = d * s;
+  return ( (double)( c[9] ) - (double)( c[10] ) * d ) / ( 1.0 + (double)( c[11] ) * d );
+}
+/* PhaseToXYZModelDistance_inline */
+
+
+
+//! Parallel fitting of the phase-to-XYZ model.
+/*!
+  Each invocation fits models of all pixels in a band of rows.
+
+  Along the camera ray C + t v the undistorted projector coordinate is a
+  projective function u = (ar + br t) / (aw + bw t) of the distance t.
+  Coordinates are sampled at Chebyshev nodes of the interval which is visible
+  to the projector within the modelled depth range, samples are distorted using
+  the projector distortion model, and a polynomial which maps distorted to
+  undistorted coordinates is fitted by least squares. The projective function
+  is then inverted exactly. The fit is validated at interval ends and midway
+  between samples using single precision coefficients and the largest error
+  and the number of valid pixels are stored for each row.
+*/
+struct PhaseToXYZModelParallel_ : public cv::ParallelLoopBody
+{
+  PhaseToXYZModel * model; //!< Model to fill.
+  CameraRayTable rays; //!< Camera parameters; ray direction arrays are not allocated.
+  double Pinv[12]; //!< Pseudoinverse of the camera projection matrix.
+  double camera_orientation; //!< Orientation of the camera projection matrix.
+  double projector_orientation; //!< Orientation of the projector projection matrix.
+  double node[PHASE_TO_XYZ_MODEL_SAMPLES]; //!< Chebyshev nodes in [-1,1].
+  double * row_error; //!< Largest validation error of each row.
+  int * row_valid; //!< Number of valid pixels of each row.
+
+  //! Constructor.
+  PhaseToXYZModelParallel_(
+                           PhaseToXYZModel * const model_in,
+                           double * const row_error_in,
+                           int * const row_valid_in
+                           )
+  {
+    this->model = model_in;
+    this->row_error = row_error_in;
+    this->row_valid = row_valid_in;
+
+    CameraRayTableSetGeometry_inline(&(this->rays), this->model->camera, this->model->width, this->model->height, this->model->shift_x, this->model->shift_y);
+    GetProjectionPseudoinverse_inline(this->model->camera, this->Pinv);
+    this->camera_orientation = ProjectionOrientation_inline(this->model->camera);
+    this->projector_orientation = ProjectionOrientation_inline(this->model->projector);
+
+    double const pi = 3.141592653589793238462643383279502884197169399375;
+    int const K = PHASE_TO_XYZ_MODEL_SAMPLES;
+    for (int k = 0; k < K; ++k) this->node[k] = -cos( pi * ( (double)(k) + 0.5 ) / (double)(K) );
+  }
+
+  //! Distorts projector coordinate.
+  /*!
+    Computes point on the camera ray which projects to the undistorted projector
+    coordinate u and returns its distorted projector coordinate.
+  */
+  inline bool Distort(double const u, double const * const a, double const * const b, double * const u_dis) const
+  {
+    double const t = (a[0] - u * a[2]) / (u * b[2] - b[0]);
+    double const w = a[2] + b[2] * t;
+    double const v = (a[1] + b[1] * t) / w;
+
+    double const x_un = (0 == this->model->row)? u : v;
+    double const y_un = (0 == this->model->row)? v : u;
+
+    double x_dis, y_dis;
+    if ( false == DistortPointForRadialDistorsion_inline(this->model->projector, x_un, y_un, &x_dis, &y_dis) ) return false;
+
+    *u_dis = (0 == this->model->row)? x_dis : y_dis;
+    return true;
+  }
+
+  //! Fits model of one pixel.
+  inline bool Fit(int const x, int const y, float * const c, double * const error) const
+  {
+    int const K = PHASE_TO_XYZ_MODEL_SAMPLES;
+    int const M = 6; // Constant term and five polynomial coefficients.
+
+    *error = 0.0;
+
+    double v[3];
+    GetCameraRayForPixel_inline(&(this->rays), this->Pinv, x, y, v + 0, v + 1, v + 2);
+
+    // Orient the ray so positive distances are in front of the camera.
+    double const * const Pc = this->model->camera->projection[2];
+    if ( 0.0 > this->camera_orientation * (Pc[0] * v[0] + Pc[1] * v[1] + Pc[2] * v[2]) )
+      {
+        v[0] = -v[0];
+        v[1] = -v[1];
+        v[2] = -v[2];
+      }
+    /* if */
+
+    // Get coefficients of projective functions along the ray for modelled coordinate, other coordinate, and depth;
+    // coefficients are oriented so depth is positive in front of the projector.
+    double const o = this->projector_orientation;
+    double const * const C = this->rays.center;
+    double const * const Pr = this->model->projector->projection[this->model->row];
+    double const * const Po = this->model->projector->projection[1 - this->model->row];
+    double const * const Pw = this->model->projector->projection[2];
+    double const a[3] = {
+      o * (Pr[0] * C[0] + Pr[1] * C[1] + Pr[2] * C[2] + Pr[3]),
+      o * (Po[0] * C[0] + Po[1] * C[1] + Po[2] * C[2] + Po[3]),
+      o * (Pw[0] * C[0] + Pw[1] * C[1] + Pw[2] * C[2] + Pw[3])
+    };
+    double const b[3] = {
+      o * (Pr[0] * v[0] + Pr[1] * v[1] + Pr[2] * v[2]),
+      o * (Po[0] * v[0] + Po[1] * v[1] + Po[2] * v[2]),
+      o * (Pw[0] * v[0] + Pw[1] * v[1] + Pw[2] * v[2])
+    };
+
+    // Find interval of projector coordinates visible within the depth range; comparisons are written so NaN values are rejected.
+    double const w_min = a[2] + b[2] * this->model->depth_min;
+    double const w_max = a[2] + b[2] * this->model->depth_max;
+    if ( !(0.0 < w_min) ) return false;
+
+    double const u_a = (a[0] + b[0] * this->model->depth_min) / w_min;
+    double u_b = (a[0] + b[0] * this->model->depth_max) / w_max;
+    if ( !(0.0 < w_max) ) u_b = (0.0 < b[0] * a[2] - a[0] * b[2])? BATCHACQUISITION_pINF_dv : -BATCHACQUISITION_pINF_dv;
+
+    double const margin = (double)( PHASE_TO_XYZ_MODEL_MARGIN );
+    double u_min = (u_a < u_b)? u_a : u_b;
+    double u_max = (u_a < u_b)? u_b : u_a;
+    if (u_min < -margin) u_min = -margin;
+    if (u_max > this->model->size + margin) u_max = this->model->size + margin;
+    if ( !(1.0 <= u_max - u_min) ) return false;
+
+    double const u_mid = 0.5 * (u_min + u_max);
+    double const u_half = 0.5 * (u_max - u_min);
+
+    // Sample distorted coordinates.
+    double u_dis[PHASE_TO_XYZ_MODEL_SAMPLES];
+    double u_dis_min = BATCHACQUISITION_pINF_dv;
+    double u_dis_max = -BATCHACQUISITION_pINF_dv;
+    for (int k = 0; k < K; ++k)
+      {
+        if ( false == this->Distort(u_mid + u_half * this->node[k], a, b, u_dis + k) ) return false;
+        if (u_dis[k] < u_dis_min) u_dis_min = u_dis[k];
+        if (u_dis[k] > u_dis_max) u_dis_max = u_dis[k];
+      }
+    /* for */
+    if ( !(u_dis_min < u_dis_max) ) return false;
+
+    // Center is rounded to single precision so stored coefficients match it exactly.
+    double const u0 = (double)( (float)( 0.5 * (u_dis_min + u_dis_max) ) );
+    double const scale = 2.0 / (u_dis_max - u_dis_min);
+
+    // Fit polynomial using normalized coordinates.
+    double A[M * M];
+    double p[M];
+    for (int l = 0; l < M * M; ++l) A[l] = 0.0;
+    for (int l = 0; l < M; ++l) p[l] = 0.0;
+    for (int k = 0; k < K; ++k)
+      {
+        double const s = (u_dis[k] - u0) * scale;
+        double const u = u_mid + u_half * this->node[k];
+
+        double basis[M];
+        basis[0] = 1.0;
+        for (int l = 1; l < M; ++l) basis[l] = basis[l - 1] * s;
+
+        for (int l = 0; l < M; ++l)
+          {
+            for (int m = 0; m < M; ++m) A[l * M + m] += basis[l] * basis[m];
+            p[l] += basis[l] * (u - u0);
+          }
+        /* for */
+      }
+    /* for */
+    if ( false == SolveLinearSystem_inline(A, p, M) ) return false;
+
+    // Invert projective function at the undistorted center; remaining polynomial has no constant term.
+    double const uc = u0 + p[0];
+    double const num0 = a[0] - uc * a[2];
+    double const den0 = uc * b[2] - b[0];
+    if ( !(0.0 != den0) ) return false;
+
+    double coefficients[PHASE_TO_XYZ_MODEL_COEFFICIENTS];
+    coefficients[0] = v[0];
+    coefficients[1] = v[1];
+    coefficients[2] = v[2];
+    coefficients[3] = u0;
+    double scale_l = scale;
+    for (int l = 1; l < M; ++l)
+      {
+        coefficients[3 + l] = p[l] * scale_l;
+        scale_l *= scale;
+      }
+    /* for */
+    coefficients[9] = num0 / den0;
+    coefficients[10] = a[2] / den0;
+    coefficients[11] = b[2] / den0;
+
+    for (int l = 0; l < PHASE_TO_XYZ_MODEL_COEFFICIENTS; ++l)
+      {
+        c[l] = (float)( coefficients[l] );
+        if ( isnanorinf_inline(c[l]) ) return false;
+      }
+    /* for */
+
+    // Validate at interval ends and midway between samples.
+    double max_error = 0.0;
+    for (int k = 0; k <= K; ++k)
+      {
+        double u = 0.0;
+        if (0 == k) u = u_min;
+        else if (K == k) u = u_max;
+        else u = u_mid + 0.5 * u_half * (this->node[k - 1] + this->node[k]);
+
+        double u_dis_k = 0.0;
+        if ( false == this->Distort(u, a, b, &u_dis_k) ) return false;
+
+        double const t = PhaseToXYZModelDistance_inline(c, u_dis_k);
+        double const u_t = (a[0] + b[0] * t) / (a[2] + b[2] * t);
+        double const e = fabs(u_t - u);
+
+        // Comparison is written so NaN error is propagated.
+        if ( !(e <= max_error) ) max_error = e;
+      }
+    /* for */
+
+    *error = max_error;
+    return true;
+  }
+
+  //! Fits a band of rows.
+  virtual void operator()(const cv::Range & r) const
+  {
+    int const width = this->model->width;
+
+    for (int j = r.start; j < r.end; ++j)
+      {
+        float * const row_c = (float *)( (BYTE *)(this->model->coefficients->data) + this->model->coefficients->step[0] * j );
+
+        double max_error = 0.0;
+        int num_valid = 0;
+        for (int i = 0; i < width; ++i)
+          {
+            double error = 0.0;
+            bool const valid = this->Fit(i, j, row_c + PHASE_TO_XYZ_MODEL_COEFFICIENTS * i, &error);
+            if (false == valid)
+              {
+                for (int l = 0; l < PHASE_TO_XYZ_MODEL_COEFFICIENTS; ++l) row_c[PHASE_TO_XYZ_MODEL_COEFFICIENTS * i + l] = BATCHACQUISITION_qNaN_fv;
+                continue;
+              }
+            /* if */
+
+            ++num_valid;
+
+            // Comparison is written so NaN error is propagated.
+            if ( !(error <= max_error) ) max_error = error;
+          }
+        /* for */
+
+        this->row_error[j] = max_error;
+        this->row_valid[j] = num_valid;
+      }
+    /* for */
+  }
+};
+/* PhaseToXYZModelParallel_ */
+
+
+
+//! Compute phase-to-XYZ model.
+/*!
+  Fits phase-to-XYZ model for every pixel of the sensor and validates it.
+  Modelled depth range is set from PHASE_TO_XYZ_MODEL_DEPTH_MIN and
+  PHASE_TO_XYZ_MODEL_DEPTH_MAX and the distance between camera and projector centers.
+  Returned model is not cached and must be deleted by the caller;
+  use PhaseToXYZModelCacheGet to obtain shared models.
+
+  \param camera Pointer to camera geometry.
+  \param projector      Pointer to projector geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices. Set to 1 if internal camera parameters were computed for Matlab indices, and to 0 otherwise.
+  \param shift_y        Row shift applied to pixel indices.
+  \param row    Projector coordinate; 0 for columns and 1 for rows.
+  \param size   Projector width or height in pixels; absolute phase is multiplied by this value to get projector coordinate.
+  \return Returns pointer to the model or NULL if unsuccessfull.
+*/
+PhaseToXYZModel_ *
+PhaseToXYZModelCompute(
+                       ProjectiveGeometry_ * const camera,
+                       ProjectiveGeometry_ * const projector,
+                       int const width,
+                       int const height,
+                       int const shift_x,
+                       int const shift_y,
+                       int const row,
+                       double const size
+                       )
+{
+  assert( (NULL != camera) && (NULL != projector) );
+  if ( (NULL == camera) || (NULL == projector) ) return NULL;
+
+  assert( (0 < width) && (0 < height) );
+  if ( (0 >= width) || (0 >= height) ) return NULL;
+
+  assert( (0 == row) || (1 == row) );
+  if ( (0 != row) && (1 != row) ) return NULL;
+
+  // Comparisons are written so NaN resolution is rejected.
+  if ( !( (1.0 <= size) && (size <= 65536.0) ) ) return NULL;
+
+  double const dx = camera->center[0] - projector->center[0];
+  double const dy = camera->center[1] - projector->center[1];
+  double const dz = camera->center[2] - projector->center[2];
+  double const baseline = sqrt(dx * dx + dy * dy + dz * dz);
+  if ( !(0.0 < baseline) ) return NULL;
+
+  PhaseToXYZModel * model = new PhaseToXYZModel();
+  assert(NULL != model);
+  if (NULL == model) return NULL;
+
+  model->camera = new ProjectiveGeometry(*camera);
+  model->projector = new ProjectiveGeometry(*projector);
+  model->shift_x = shift_x;
+  model->shift_y = shift_y;
+  model->width = width;
+  model->height = height;
+  model->row = row;
+  model->size = size;
+  model->depth_min = PHASE_TO_XYZ_MODEL_DEPTH_MIN * baseline;
+  model->depth_max = PHASE_TO_XYZ_MODEL_DEPTH_MAX * baseline;
+
+  model->coefficients = new cv::Mat(height, width, CV_32FC(PHASE_TO_XYZ_MODEL_COEFFICIENTS));
+  assert( (NULL != model->camera) && (NULL != model->projector) );
+  assert( (NULL != model->coefficients) && (NULL != model->coefficients->data) );
+  if ( (NULL == model->camera) || (NULL == model->projector) ||
+       (NULL == model->coefficients) || (NULL == model->coefficients->data)
+       )
+    {
+      SAFE_DELETE( model );
+      return NULL;
+    }
+  /* if */
+
+  std::vector<double> row_error(height, 0.0);
+  std::vector<int> row_valid(height, 0);
+
+  {
+    PhaseToXYZModelParallel_ body(model, &(row_error[0]), &(row_valid[0]));
+    cv::parallel_for_(cv::Range(0, height), body, (double)(height) / (double)(PHASE_TO_XYZ_MODEL_BAND_HEIGHT));
+  }
+
+  model->max_error = 0.0;
+  model->num_valid = 0;
+  for (int j = 0; j < height; ++j)
+    {
+      // Comparison is written so NaN error is propagated.
+      if ( !(row_error[j] <= model->max_error) ) model->max_error = row_error[j];
+      model->num_valid += row_valid[j];
+    }
+  /* for */
+
+  return model;
+}
+/* PhaseToXYZModelCompute */
+
+
+
+//! Find cached model.
+/*!
+  Searches the cache for a model computed for the named camera and projector
+  and the given projector coordinate.
+  Cache lock must be held by the caller.
+
+  \param camera_name    Unique camera name.
+  \param projector_name Unique projector name.
+  \param row    Projector coordinate; 0 for columns and 1 for rows.
+  \param idx_out        Address where the index of the model in the cache will be stored. May be NULL.
+  \return Returns pointer to the model or NULL if there is no such model.
+*/
+inline
+PhaseToXYZModel *
+PhaseToXYZModelCacheFind_inline(
+                                std::wstring const & camera_name,
+                                std::wstring const & projector_name,
+                                int const row,
+                                int * const idx_out
+                                )
+{
+  int const i_max = (int)( gPhaseToXYZModelCache.size() );
+  for (int i = 0; i < i_max; ++i)
+    {
+      PhaseToXYZModel * const model = gPhaseToXYZModelCache[i];
+      if ( (NULL != model) && (model->row == row) &&
+           (NULL != model->camera) && (NULL != model->camera->name) && (*(model->camera->name) == camera_name) &&
+           (NULL != model->projector) && (NULL != model->projector->name) && (*(model->projector->name) == projector_name)
+           )
+        {
+          if (NULL != idx_out) *idx_out = i;
+          return model;
         }
       /* if */
+    }
+  /* for */
+  if (NULL != idx_out) *idx_out = -1;
+  return NULL;
+}
+/* PhaseToXYZModelCacheFind_inline */
+
+
+
+//! Get cached phase-to-XYZ model.
+/*!
+  Returns phase-to-XYZ model for every pixel of the sensor.
+  There is one model per camera name, projector name, and projector coordinate;
+  if geometry, sensor size, or projector resolution changed then the model is
+  recomputed and replaces the old one. Model uses 48 bytes per pixel, e.g. 230 MB
+  for a 5 MP and 550 MB for a 12 MP sensor; if the model would be larger than
+  PHASE_TO_XYZ_MODEL_MAX_SIZE then it is not computed.
+
+  Each new model is validated. Model whose fitting error exceeds PHASE_TO_XYZ_MODEL_TOLERANCE
+  or which has no valid pixels is rejected and NULL is returned so the caller may fall back
+  to triangulation. Rejected models are cached without coefficients so fitting is not
+  repeated for every reconstruction.
+
+  Returned model is owned by the cache and must not be modified or deleted.
+  Caller must release the returned model by calling PhaseToXYZModelCacheRelease
+  once it is no longer used.
+  A model which is replaced by a model for changed geometry of the same camera and projector is deleted
+  when its last user releases it.
+
+  \param camera Pointer to camera geometry.
+  \param projector      Pointer to projector geometry.
+  \param width  Sensor width in pixels.
+  \param height Sensor height in pixels.
+  \param shift_x        Column shift applied to pixel indices. Set to 1 if internal camera parameters were computed for Matlab indices, and to 0 otherwise.
+  \param shift_y        Row shift applied to pixel indices.
+  \param row    Projector coordinate; 0 for columns and 1 for rows.
+  \param size   Projector width or height in pixels; absolute phase is multiplied by this value to get projector coordinate.
+  \return Returns pointer to the model or NULL if model is too large, rejected, or if unsuccessfull.
+*/
+PhaseToXYZModel_ *
+PhaseToXYZModelCacheGet(
+                        ProjectiveGeometry_ * const camera,
+                        ProjectiveGeometry_ * const projector,
+                        int const width,
+                        int const height,
+                        int const shift_x,
+                        int const shift_y,
+                        int const row,
+                        double const size
+                        )
+{
+  assert( (NULL != camera) && (NULL != projector) );
+  if ( (NULL == camera) || (NULL == projector) ) return NULL;
+
+  assert( (0 < width) && (0 < height) );
+  if ( (0 >= width) || (0 >= height) ) return NULL;
+
+  // Skip models which do not fit into the memory budget.
+  size_t const model_size = PHASE_TO_XYZ_MODEL_COEFFICIENTS * sizeof(float) * (size_t)(width) * (size_t)(height);
+  if (PHASE_TO_XYZ_MODEL_MAX_SIZE < model_size) return NULL;
+
+  std::wstring const camera_name = (NULL != camera->name)? *(camera->name) : std::wstring();
+  std::wstring const projector_name = (NULL != projector->name)? *(projector->name) : std::wstring();
+
+  PhaseToXYZModel * model = NULL;
+
+  // Check in-memory cache.
+  bool found = false;
+  AcquireSRWLockShared( &gPhaseToXYZModelCacheLock );
+  model = PhaseToXYZModelCacheFind_inline(camera_name, projector_name, row, NULL);
+  if ( (NULL != model) && (false == model->IsValidFor(camera, projector, width, height, shift_x, shift_y, row, size)) ) model = NULL;
+  found = (NULL != model);
+  if ( (NULL != model) && (NULL == model->coefficients) ) model = NULL;
+  if (NULL != model) InterlockedIncrement( &(model->refcount) );
+  ReleaseSRWLockShared( &gPhaseToXYZModelCacheLock );
+
+  if (true == found) return model;
+
+  // Compute new model.
+  DEBUG_TIMER * const debug_timer = DebugTimerInit();
+
+  PhaseToXYZModel * new_model = PhaseToXYZModelCompute(camera, projector, width, height, shift_x, shift_y, row, size);
+  if (NULL == new_model)
+    {
+      DebugTimerDestroy( debug_timer );
+      return NULL;
+    }
+  /* if */
+
+  double const duration = DebugTimerQueryStart( debug_timer );
+  DebugTimerDestroy( debug_timer );
+
+  Debugfwprintf(
+                stderr, gDbgPhaseToXYZModelComputed,
+                (0 == row)? L"column" : L"row", camera_name.c_str(), projector_name.c_str(), width, height, duration,
+                new_model->num_valid, new_model->max_error, PHASE_TO_XYZ_MODEL_TOLERANCE
+                );
+
+  // Comparison is written so NaN error is rejected.
+  if ( !(new_model->max_error <= PHASE_TO_XYZ_MODEL_TOLERANCE) || (0 == new_model->num_valid) )
+    {
+      Debugfwprintf(stderr, gDbgPhaseToXYZModelRejected, camera_name.c_str(), projector_name.c_str());
+      SAFE_DELETE( new_model->coefficients );
+    }
+  /* if */
+
+  // Store the model; another thread may have stored the same model in the meantime.
+  size_t cache_size = 0;
+  int cache_count = 0;
+
+  PhaseToXYZModel * replaced = NULL;
+
+  AcquireSRWLockExclusive( &gPhaseToXYZModelCacheLock );
+
+  int idx = -1;
+  model = PhaseToXYZModelCacheFind_inline(camera_name, projector_name, row, &idx);
+  if ( (NULL != model) && (true == model->IsValidFor(camera, projector, width, height, shift_x, shift_y, row, size)) )
+    {
+      // Keep existing model.
+    }
+  else if (NULL != model)
+    {
+      assert( (0 <= idx) && (idx < (int)(gPhaseToXYZModelCache.size())) );
+      // Retire replaced model if it is in use, otherwise delete it after the lock is released.
+      if (0 < model->refcount) gPhaseToXYZModelRetired.push_back( model );
+      else replaced = model;
+      gPhaseToXYZModelCache[idx] = NULL;
+      model = NULL;
+      SWAP_ONE_VALID_PTR( model, new_model );
+      gPhaseToXYZModelCache[idx] = model;
+    }
+  else
+    {
+      gPhaseToXYZModelCache.push_back(new_model);
+      SWAP_ONE_VALID_PTR( model, new_model );
+    }
+  /* if */
+
+  // Caller holds the returned model until it calls PhaseToXYZModelCacheRelease; rejected models are not returned.
+  if (NULL != model->coefficients) InterlockedIncrement( &(model->refcount) );
+
+  cache_count = (int)( gPhaseToXYZModelCache.size() );
+  for (int i = 0; i < cache_count; ++i)
+    {
+      if (NULL != gPhaseToXYZModelCache[i]) cache_size += gPhaseToXYZModelCache[i]->SizeInBytes();
+    }
+  /* for */
+
+  ReleaseSRWLockExclusive( &gPhaseToXYZModelCacheLock );
+
+  if ( (NULL == new_model) && (NULL != model->coefficients) )
+    {
+      Debugfwprintf(
+                    stderr, gDbgPhaseToXYZModelCached,
+                    (double)( model->SizeInBytes() ) / 1048576.0, cache_count, (double)(cache_size) / 1048576.0
+                    );
+    }
+  /* if */
+
+  SAFE_DELETE( new_model );
+  SAFE_DELETE( replaced );
+
+  if (NULL == model->coefficients) return NULL;
+
+  return model;
+}
+/* PhaseToXYZModelCacheGet */
+
+
+
+//! Release cached phase-to-XYZ model.
+/*!
+  Releases model returned by PhaseToXYZModelCacheGet. Every returned model must be released
+  exactly once. A model which was replaced in the cache is deleted when
+  its last user releases it.
+
+  \param model  Pointer to the model. May be NULL.
+*/
+void
+PhaseToXYZModelCacheRelease(
+                            PhaseToXYZModel_ const * const model
+                            )
+{
+  if (NULL == model) return;
+
+  PhaseToXYZModel * retired = NULL;
+
+  AcquireSRWLockExclusive( &gPhaseToXYZModelCacheLock );
+
+  assert(0 < model->refcount);
+  LONG const refcount = InterlockedDecrement( &(model->refcount) );
+  if (0 == refcount)
+    {
+      int const k_max = (int)( gPhaseToXYZModelRetired.size() );
+      for (int k = 0; k < k_max; ++k)
+        {
+          if (model != gPhaseToXYZModelRetired[k]) continue;
+          retired = gPhaseToXYZModelRetired[k];
+          gPhaseToXYZModelRetired.erase( gPhaseToXYZModelRetired.begin() + k );
+          break;
+        }
+      /* for */
+    }
+  /* if */
+
+  ReleaseSRWLockExclusive( &gPhaseToXYZModelCacheLock );
+
+  SAFE_DELETE( retired );
+}
+/* PhaseToXYZModelCacheRelease */
+
+
+
+//! Clear phase-to-XYZ model cache.
+/*!
+  Deletes all cached and retired phase-to-XYZ models.
+  Function must not be called while any reconstruction is in progress.
+*/
+void
+PhaseToXYZModelCacheClear(
+                          void
+                          )
+{
+  AcquireSRWLockExclusive( &gPhaseToXYZModelCacheLock );
+
+  int const i_max = (int)( gPhaseToXYZModelCache.size() );
+  for (int i = 0; i < i_max; ++i) SAFE_DELETE( gPhaseToXYZModelCache[i] );
+  gPhaseToXYZModelCache.clear();
+
+  int const k_max = (int)( gPhaseToXYZModelRetired.size() );
+  for (int k = 0; k < k_max; ++k) SAFE_DELETE( gPhaseToXYZModelRetired[k] );
+  gPhaseToXYZModelRetired.clear();
+
+  ReleaseSRWLockExclusive( &gPhaseToXYZModelCacheLock );
+}
+/* PhaseToXYZModelCacheClear */
+
+
+
+//! Parallel evaluation of the phase-to-XYZ model.
+/*!
+  Evaluates model for two points at once using SSE2. Coefficients of each
+  pixel are loaded as three packed single precision vectors, transposed,
+  and converted to double precision so all computations are done in
+  double precision. Points are split into chunks of TRIANGULATION_CHUNK_SIZE
+  points which are processed in parallel.
+*/
+struct TriangulateUsingPhaseToXYZModelParallel_ : public cv::ParallelLoopBody
+{
+  int N; //!< Number of points.
+
+  int const * row_i; //!< Column indices relative to the offset.
+  int const * row_j; //!< Row indices relative to the offset.
+  cv::Mat const * abs_phase; //!< Absolute phase.
+
+  double * row_x; //!< Output x coordinates.
+  double * row_y; //!< Output y coordinates.
+  double * row_z; //!< Output z coordinates.
+
+  PhaseToXYZModel const * model; //!< Phase-to-XYZ model.
+  int offset_x; //!< Column of the first pixel of the image in the sensor.
+  int offset_y; //!< Row of the first pixel of the image in the sensor.
+
+  float invalid[PHASE_TO_XYZ_MODEL_COEFFICIENTS]; //!< Coefficients used for pixels outside of the model.
+
+  //! Constructor.
+  TriangulateUsingPhaseToXYZModelParallel_(
+                                           PhaseToXYZModel const * const model_in,
+                                           cv::Mat * const x1_in,
+                                           cv::Mat * const y1_in,
+                                           int const offset_x_in,
+                                           int const offset_y_in,
+                                           cv::Mat * const abs_phase_in,
+                                           cv::Mat * const x_in,
+                                           cv::Mat * const y_in,
+                                           cv::Mat * const z_in
+                                           )
+  {
+    assert( (NULL != model_in) && (NULL != x1_in) && (NULL != y1_in) && (NULL != abs_phase_in) );
+
+    this->N = x1_in->cols;
+
+    this->row_i = (int *)( (BYTE *)(x1_in->data) + x1_in->step[0] * 0 );
+    this->row_j = (int *)( (BYTE *)(y1_in->data) + y1_in->step[0] * 0 );
+    this->abs_phase = abs_phase_in;
+
+    this->row_x = (double *)( (BYTE *)(x_in->data) + x_in->step[0] * 0 );
+    this->row_y = (double *)( (BYTE *)(y_in->data) + y_in->step[0] * 0 );
+    this->row_z = (double *)( (BYTE *)(z_in->data) + z_in->step[0] * 0 );
+
+    this->model = model_in;
+    this->offset_x = offset_x_in;
+    this->offset_y = offset_y_in;
+
+    for (int l = 0; l < PHASE_TO_XYZ_MODEL_COEFFICIENTS; ++l) this->invalid[l] = BATCHACQUISITION_qNaN_fv;
+  }
+
+  //! Gets model coefficients and projector coordinate of one point.
+  inline float const * GetPoint(int const i, double * const u) const
+  {
+    int const x = this->row_i[i];
+    int const y = this->row_j[i];
+    assert( (0 <= y) && (y < this->abs_phase->rows) );
+    assert( (0 <= x) && (x < this->abs_phase->cols) );
+
+    *u = ( (double *)( (BYTE *)(this->abs_phase->data) + this->abs_phase->step[0] * y ) )[x] * this->model->size;
+
+    int const xs = x + this->offset_x;
+    int const ys = y + this->offset_y;
+    if ( (0 <= xs) && (xs < this->model->width) && (0 <= ys) && (ys < this->model->height) )
+      {
+        return (float *)( (BYTE *)(this->model->coefficients->data) + this->model->coefficients->step[0] * ys ) + PHASE_TO_XYZ_MODEL_COEFFICIENTS * xs;
+      }
+    /* if */
+
+    return this->invalid;
+  }
+
+  //! Triangulates one or two points.
+  inline void Triangulate(int const i, int const n) const
+  {
+    double u[2] = {0.0, 0.0};
+    float const * const c0 = this->GetPoint(i, u + 0);
+    float const * const c1 = (2 == n)? this->GetPoint(i + 1, u + 1) : c0;
+
+    // Transpose coefficients of two pixels.
+    __m128 const a0 = _mm_loadu_ps(c0 + 0);
+    __m128 const a1 = _mm_loadu_ps(c0 + 4);
+    __m128 const a2 = _mm_loadu_ps(c0 + 8);
+    __m128 const b0 = _mm_loadu_ps(c1 + 0);
+    __m128 const b1 = _mm_loadu_ps(c1 + 4);
+    __m128 const b2 = _mm_loadu_ps(c1 + 8);
+
+    __m128 const lo0 = _mm_unpacklo_ps(a0, b0);
+    __m128 const hi0 = _mm_unpackhi_ps(a0, b0);
+    __m128 const lo1 = _mm_unpacklo_ps(a1, b1);
+    __m128 const hi1 = _mm_unpackhi_ps(a1, b1);
+    __m128 const lo2 = _mm_unpacklo_ps(a2, b2);
+    __m128 const hi2 = _mm_unpackhi_ps(a2, b2);
+
+    __m128d const vx = _mm_cvtps_pd(lo0);
+    __m128d const vy = _mm_cvtps_pd( _mm_movehl_ps(lo0, lo0) );
+    __m128d const vz = _mm_cvtps_pd(hi0);
+    __m128d const u0 = _mm_cvtps_pd( _mm_movehl_ps(hi0, hi0) );
+    __m128d const p1 = _mm_cvtps_pd(lo1);
+    __m128d const p2 = _mm_cvtps_pd( _mm_movehl_ps(lo1, lo1) );
+    __m128d const p3 = _mm_cvtps_pd(hi1);
+    __m128d const p4 = _mm_cvtps_pd( _mm_movehl_ps(hi1, hi1) );
+    __m128d const p5 = _mm_cvtps_pd(lo2);
+    __m128d const m0 = _mm_cvtps_pd( _mm_movehl_ps(lo2, lo2) );
+    __m128d const m1 = _mm_cvtps_pd(hi2);
+    __m128d const m2 = _mm_cvtps_pd( _mm_movehl_ps(hi2, hi2) );
+
+    // Remove projector distortion and get distance along the ray.
+    __m128d const s = _mm_sub_pd( _mm_loadu_pd(u), u0 );
+
+    __m128d d = _mm_add_pd( _mm_mul_pd(p5, s), p4 );
+    d = _mm_add_pd( _mm_mul_pd(d, s), p3 );
+    d = _mm_add_pd( _mm_mul_pd(d, s), p2 );
+    d = _mm_add_pd( _mm_mul_pd(d, s), p1 );
+    d = _mm_mul_pd(d, s);
+
+    __m128d const t = _mm_div_pd( _mm_sub_pd( m0, _mm_mul_pd(m1, d) ), _mm_add_pd( _mm_set1_pd(1.0), _mm_mul_pd(m2, d) ) );
+
+    // Comparisons are false for NaN so unmodelled pixels and invalid phases are rejected.
+    __m128d const valid = _mm_and_pd(
+                                     _mm_cmpge_pd( t, _mm_set1_pd(this->model->depth_min) ),
+                                     _mm_cmple_pd( t, _mm_set1_pd(this->model->depth_max) )
+                                     );
+
+    double const * const C = this->model->camera->center;
+
+    StorePacked_inline(this->row_x + i, SelectValidOrNaNPacked_inline( _mm_add_pd( _mm_set1_pd(C[0]), _mm_mul_pd(t, vx) ), valid ), n);
+    StorePacked_inline(this->row_y + i, SelectValidOrNaNPacked_inline( _mm_add_pd( _mm_set1_pd(C[1]), _mm_mul_pd(t, vy) ), valid ), n);
+    StorePacked_inline(this->row_z + i, SelectValidOrNaNPacked_inline( _mm_add_pd( _mm_set1_pd(C[2]), _mm_mul_pd(t, vz) ), valid ), n);
+  }
+
+  //! Triangulates a range of chunks.
+  virtual void operator()(const cv::Range & r) const
+  {
+    for (int j = r.start; j < r.end; ++j)
+      {
+        int const start = j * TRIANGULATION_CHUNK_SIZE;
+        int const end = (start + TRIANGULATION_CHUNK_SIZE < this->N)? start + TRIANGULATION_CHUNK_SIZE : this->N;
+
+        int i = start;
+        int const max_i = end - 1;
+        for (; i < max_i; i += 2) this->Triangulate(i, 2);
+
+        // Complete to end.
+        if (i < end) this->Triangulate(i, 1);
+      }
+    /* for */
+  }
+};
+/* TriangulateUsingPhaseToXYZModelParallel_ */
+
+
+
+//! Triangulates points using phase-to-XYZ model.
+/*!
+  Function computes 3D points directly from absolute phase of single-direction
+  codes using the phase-to-XYZ model. Camera coordinates are not undistorted,
+  projector coordinates are not computed, and points are not re-projected and
+  re-triangulated as the model already includes camera and projector distortion.
+
+  Model gives the point on the camera ray whose projection to the projector,
+  after applying projector distortion, has the decoded projector coordinate.
+  Points outside of the modelled depth range and points of pixels outside
+  of the model or without valid coefficients are triangulated using
+  TriangulateSingleDirection so no point with a valid phase is discarded.
+  Points with invalid phase are set to NaN.
+
+  \param model  Phase-to-XYZ model.
+  \param table  Camera ray table of the sensor which is used for points rejected by the model. May be NULL.
+  If NULL or if the table was not computed for the camera and the sensor of the model then pixel coordinates are undistorted.
+  \param x1     Image column indices relative to the offset. Must be CV_32S.
+  \param y1     Image row indices relative to the offset. Must be CV_32S.
+  \param offset_x       Column of the first pixel of the image in the sensor, e.g. non-zero if the image is a ROI.
+  \param offset_y       Row of the first pixel of the image in the sensor.
+  \param abs_phase      Absolute phase image for the projector coordinate of the model. Must be CV_64F.
+  \param x_out  Address where x coordinates of points will be stored.
+  \param y_out  Address where y coordinates of points will be stored.
+  \param z_out  Address where z coordinates of points will be stored.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+TriangulateUsingPhaseToXYZModel(
+                                PhaseToXYZModel_ const * const model,
+                                CameraRayTable_ const * const table,
+                                cv::Mat * const x1,
+                                cv::Mat * const y1,
+                                int const offset_x,
+                                int const offset_y,
+                                cv::Mat * const abs_phase,
+                                cv::Mat * * const x_out,
+                                cv::Mat * * const y_out,
+                                cv::Mat * * const z_out
+                                )
+{
+  bool const valid1 = CheckCoordinateArrays_inline(x1, y1, CV_32S);
+  assert(true == valid1);
+  if (true != valid1) return false;
+
+  assert( (NULL != model) && (NULL != model->coefficients) && (NULL != model->camera) );
+  if ( (NULL == model) || (NULL == model->coefficients) || (NULL == model->coefficients->data) || (NULL == model->camera) ) return false;
+
+  assert( (NULL != abs_phase) && (NULL != abs_phase->data) );
+  if ( (NULL == abs_phase) || (NULL == abs_phase->data) ) return false;
+
+  assert( (CV_MAT_DEPTH(abs_phase->type()) == CV_64F) && (CV_MAT_CN(abs_phase->type()) == 1) );
+  if ( (CV_MAT_DEPTH(abs_phase->type()) != CV_64F) || (CV_MAT_CN(abs_phase->type()) != 1) ) return false;
+
+  int const N = x1->cols;
+
+  bool result = true; // Assume success.
+
+  std::vector<int> fallback; // Indices of points which are triangulated.
+  int M = 0;
+
+  cv::Mat * x1_fallback = NULL;
+  cv::Mat * y1_fallback = NULL;
+  cv::Mat * u_fallback = NULL;
+  cv::Mat * x_camera = NULL;
+  cv::Mat * y_camera = NULL;
+  cv::Mat * x_fallback = NULL;
+  cv::Mat * y_fallback = NULL;
+  cv::Mat * z_fallback = NULL;
+  cv::Mat * dst2_fallback = NULL;
+  CameraRayTable const * rays = NULL;
+
+  // Allocate outputs.
+  cv::Mat * x = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x);
+
+  cv::Mat * y = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y);
+
+  cv::Mat * z = new cv::Mat(1, N, CV_64F);
+  assert(NULL != z);
+
+  if ( (NULL == x) || (NULL == y) || (NULL == z) )
+    {
+      result = false;
+      goto TriangulateUsingPhaseToXYZModel_EXIT;
+    }
+  /* if */
+
+  // Evaluate model.
+  if (0 < N)
+    {
+      int const num_chunks = (N + TRIANGULATION_CHUNK_SIZE - 1) / TRIANGULATION_CHUNK_SIZE;
+      TriangulateUsingPhaseToXYZModelParallel_ body(model, x1, y1, offset_x, offset_y, abs_phase, x, y, z);
+      cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
+    }
+  /* if */
 
-      // Allocate storage for texture.
-      if (true == have_texture)
+  // Collect points which were rejected by the model but have valid phase.
+  {
+    int const * const row_i1 = (int *)( (BYTE *)(x1->data) + x1->step[0] * 0 );
+    int const * const row_j1 = (int *)( (BYTE *)(y1->data) + y1->step[0] * 0 );
+    double const * const row_z = (double *)( (BYTE *)(z->data) + z->step[0] * 0 );
+    for (int i = 0; i < N; ++i)
+      {
+        if (false == isnan_inline(row_z[i])) continue;
+        double const phase = ( (double *)( (BYTE *)(abs_phase->data) + abs_phase->step[0] * row_j1[i] ) )[ row_i1[i] ];
+        if (false == isnan_inline(phase)) fallback.push_back(i);
+      }
+    /* for */
+  }
+
+  M = (int)( fallback.size() );
+  if (0 == M) goto TriangulateUsingPhaseToXYZModel_ASSIGN;
+
+  x1_fallback = new cv::Mat(1, M, CV_32S);
+  assert(NULL != x1_fallback);
+
+  y1_fallback = new cv::Mat(1, M, CV_32S);
+  assert(NULL != y1_fallback);
+
+  u_fallback = new cv::Mat(1, M, CV_64F);
+  assert(NULL != u_fallback);
+
+  if ( (NULL == x1_fallback) || (NULL == y1_fallback) || (NULL == u_fallback) )
+    {
+      result = false;
+      goto TriangulateUsingPhaseToXYZModel_EXIT;
+    }
+  /* if */
+
+  {
+    int const * const row_i1 = (int *)( (BYTE *)(x1->data) + x1->step[0] * 0 );
+    int const * const row_j1 = (int *)( (BYTE *)(y1->data) + y1->step[0] * 0 );
+    int * const row_i = (int *)( (BYTE *)(x1_fallback->data) + x1_fallback->step[0] * 0 );
+    int * const row_j = (int *)( (BYTE *)(y1_fallback->data) + y1_fallback->step[0] * 0 );
+    double * const row_u = (double *)( (BYTE *)(u_fallback->data) + u_fallback->step[0] * 0 );
+    for (int k = 0; k < M; ++k)
+      {
+        int const i = fallback[k];
+        row_i[k] = row_i1[i];
+        row_j[k] = row_j1[i];
+        row_u[k] = ( (double *)( (BYTE *)(abs_phase->data) + abs_phase->step[0] * row_j1[i] ) )[ row_i1[i] ] * model->size;
+      }
+    /* for */
+  }
+
+  // Fetch camera rays from the given table; if there is no matching table then pixel coordinates are undistorted.
+  if ( (NULL != table) && (true == table->IsValidFor(model->camera, model->width, model->height, model->shift_x, model->shift_y)) ) rays = table;
+  if (NULL == rays)
+    {
+      bool const res = UndistortImageCoordinatesForRadialDistorsion(
+                                                                    x1_fallback, y1_fallback,
+                                                                    model->shift_x + offset_x, model->shift_y + offset_y,
+                                                                    model->camera->fx, model->camera->fy,
+                                                                    model->camera->cx, model->camera->cy,
+                                                                    model->camera->k0, model->camera->k1,
+                                                                    &x_camera, &y_camera
+                                                                    );
+      assert(true == res);
+      if (true != res)
         {
-          colors = new cv::Mat(N, is_grayscale ? 1 : 3, CV_8U);
-          assert( (NULL != colors) && (NULL != colors->data) );
-          if ( (NULL == colors) || (NULL == colors->data) )
-            {
-              result = false;
-              goto SelectValidPointsAndAssembleDataForVTK_EXIT;
-            }
-          /* if */
+          result = false;
+          goto TriangulateUsingPhaseToXYZModel_EXIT;
         }
       /* if */
     }
   /* if */
 
+  {
+    bool const res = TriangulateSingleDirection(
+                                                model->camera, rays,
+                                                (NULL != rays)? x1_fallback : x_camera,
+                                                (NULL != rays)? y1_fallback : y_camera,
+                                                offset_x, offset_y,
+                                                model->projector,
+                                                (0 == model->row)? u_fallback : NULL,
+                                                (0 == model->row)? NULL : u_fallback,
+                                                SINGLE_DIRECTION_TRIANGULATION_ITERATIONS,
+                                                &x_fallback, &y_fallback, &z_fallback, &dst2_fallback
+                                                );
+    assert(true == res);
+    if (true != res)
+      {
+        result = false;
+        goto TriangulateUsingPhaseToXYZModel_EXIT;
+      }
+    /* if */
+  }
+
+  // Merge triangulated points.
+  {
+    double const * const row_x_fallback = (double *)( (BYTE *)(x_fallback->data) + x_fallback->step[0] * 0 );
+    double const * const row_y_fallback = (double *)( (BYTE *)(y_fallback->data) + y_fallback->step[0] * 0 );
+    double const * const row_z_fallback = (double *)( (BYTE *)(z_fallback->data) + z_fallback->step[0] * 0 );
+    double * const row_x = (double *)( (BYTE *)(x->data) + x->step[0] * 0 );
+    double * const row_y = (double *)( (BYTE *)(y->data) + y->step[0] * 0 );
+    double * const row_z = (double *)( (BYTE *)(z->data) + z->step[0] * 0 );
+    for (int k = 0; k < M; ++k)
+      {
+        int const i = fallback[k];
+        row_x[i] = row_x_fallback[k];
+        row_y[i] = row_y_fallback[k];
+        row_z[i] = row_z_fallback[k];
+      }
+    /* for */
+  }
+
+ TriangulateUsingPhaseToXYZModel_ASSIGN:
+
+  SAFE_ASSIGN_PTR( x, x_out );
+  SAFE_ASSIGN_PTR( y, y_out );
+  SAFE_ASSIGN_PTR( z, z_out );
+
+ TriangulateUsingPhaseToXYZModel_EXIT:
+
+  SAFE_DELETE( x );
+  SAFE_DELETE( y );
+  SAFE_DELETE( z );
+
+  SAFE_DELETE( x1_fallback );
+  SAFE_DELETE( y1_fallback );
+  SAFE_DELETE( u_fallback );
+  SAFE_DELETE( x_camera );
+  SAFE_DELETE( y_camera );
+  SAFE_DELETE( x_fallback );
+  SAFE_DELETE( y_fallback );
+  SAFE_DELETE( z_fallback );
+  SAFE_DELETE( dst2_fallback );
+
+  return result;
+}
+/* TriangulateUsingPhaseToXYZModel */
+
+
+
+/****** PROJECTION ******/
+
+//! Projects points.
+/*!
+  Function projects points in 3D to 2D using pinhole camera model.
+
+  \param PG     Pinhole camera geometry.
+  \param x_3D   X coordinates in 3D.
+  \param y_3D   Y coordinates in 3D.
+  \param z_3D   Z coordinates in 3D.
+  \param x_2D_out       Address where x coordinates in 2D will be stored.
+  \param y_2D_out       Address where y coordiantes in 2D will be stored.
+  \return Function returns true if successfull, false otherwise.
+*/
+bool
+ProjectPoints(
+              ProjectiveGeometry * const PG,
+              cv::Mat * const x_3D,
+              cv::Mat * const y_3D,
+              cv::Mat * const z_3D,
+              cv::Mat * * const x_2D_out,
+              cv::Mat * * const y_2D_out
+              )
+{
+  assert(NULL != PG);
+  if (NULL == PG) return false;
+
+  int const num_3D = CheckRowArrays_inline(CV_64F, x_3D, y_3D, z_3D);
+  assert(3 == num_3D);
+  if (3 != num_3D) return false;
+
+  bool result = true; // Assume success.
+
+  int const N = x_3D->cols;
+
+  cv::Mat * x_2D = new cv::Mat(1, N, CV_64F);
+  assert(NULL != x_2D);
+
+  cv::Mat * y_2D = new cv::Mat(1, N, CV_64F);
+  assert(NULL != y_2D);
+
+  if ( (NULL == x_2D) || (NULL == y_2D) )
+    {
+      result = false;
+      goto ProjectPoints_EXIT;
+    }
+  /* if */
+
   // Get row pointers.
   double const * const row_x_3D = (double *)( (BYTE *)(x_3D->data) + x_3D->step[0] * 0 );
   double const * const row_y_3D = (double *)( (BYTE *)(y_3D->data) + y_3D->step[0] * 0 );
   double const * const row_z_3D = (double *)( (BYTE *)(z_3D->data) + z_3D->step[0] * 0 );
-  double const * const row_dst2_3D = (true == prune)? (double *)( (BYTE *)(dst2_3D->data) + dst2_3D->step[0] * 0 ) : NULL;
-  int const * const row_x_img = (true == have_texture)? (int *)( (BYTE *)(x_img->data) + x_img->step[0] * 0 ) : NULL;
-  int const * const row_y_img = (true == have_texture)? (int *)( (BYTE *)(y_img->data) + y_img->step[0] * 0 ) : NULL;
-  float const * const row_range_img = (true == have_range)? (float *)( (BYTE *)(range_img->data) + range_img->step[0] * 0 ) : NULL;
+  double * const row_x_2D = (double *)( (BYTE *)(x_2D->data) + x_2D->step[0] * 0 );
+  double * const row_y_2D = (double *)( (BYTE *)(y_2D->data) + y_2D->step[0] * 0 );
+
+  // Get projection matrix coefficients.
+  double const pxx = PG->projection[0][0];
+  double const pxy = PG->projection[0][1];
+  double const pxz = PG->projection[0][2];
+  double const pxh = PG->projection[0][3];
+
+  double const pyx = PG->projection[1][0];
+  double const pyy = PG->projection[1][1];
+  double const pyz = PG->projection[1][2];
+  double const pyh = PG->projection[1][3];
+
+  double const phx = PG->projection[2][0];
+  double const phy = PG->projection[2][1];
+  double const phz = PG->projection[2][2];
+  double const phh = PG->projection[2][3];
 
-  // Copy point coordinates.
-  int k = 0;
+  // Project points.
   for (int i = 0; i < N; ++i)
     {
-      if ( (true == prune) && (dst2_thr < row_dst2_3D[i]) ) continue;
+      double const x2 = pxx * row_x_3D[i] + pxy * row_y_3D[i] + pxz * row_z_3D[i] + pxh;
+      double const y2 = pyx * row_x_3D[i] + pyy * row_y_3D[i] + pyz * row_z_3D[i] + pyh;
+      double const h2 = phx * row_x_3D[i] + phy * row_y_3D[i] + phz * row_z_3D[i] + phh;
 
-      double const x3 = row_x_3D[i];
-      double const y3 = row_y_3D[i];
-      double const z3 = row_z_3D[i];
+      double const h2_inv = 1.0 / h2;
 
-      if ( isnanorinf_inline(x3) || isnanorinf_inline(y3) || isnanorinf_inline(z3) ) continue;
+      row_x_2D[i] = x2 * h2_inv;
+      row_y_2D[i] = y2 * h2_inv;
+    }
+  /* for */
 
-      assert( (0 <= k) && (k < points->rows) );
-      double * const row_points = (double *)( (BYTE *)(points->data) + points->step[0] * k );
 
-      row_points[0] = x3;
-      row_points[1] = y3;
-      row_points[2] = z3;
+  SAFE_ASSIGN_PTR( x_2D, x_2D_out );
+  SAFE_ASSIGN_PTR( y_2D, y_2D_out );
 
-      if ( true == have_data )
-        {
-          assert( (NULL != data) && (NULL != data->data) );
+ ProjectPoints_EXIT:
 
-          int const x = row_x_img[i];
-          int const y = row_y_img[i];
-          assert( (0 <= x) && (0 <= y) && (0 <= k) );
+  SAFE_DELETE( x_2D );
+  SAFE_DELETE( y_2D );
 
-          if (true == have_texture)
-            {
-              assert( k < colors->rows );
-              UINT8 * const row_colors = (UINT8 *)( (BYTE *)(colors->data) + colors->step[0] * k );
-
-              assert( (x < texture->cols) && (y < texture->rows) );
-              if (y != y_prev_tex)
-                {
-                  row_tex = (UINT8 const *)( (BYTE *)(texture->data) + texture->step[0] * y );
-                  y_prev_tex = y;
-                }
-              /* if */
-
-              if (false == is_grayscale)
-                {
-                  row_colors[0] = row_tex[3*x + 2];
-                  row_colors[1] = row_tex[3*x + 1];
-                  row_colors[2] = row_tex[3*x    ];
-                }
-              else
-                {
-                  row_colors[0] = row_tex[x];
-                }
-              /* if */
-            }
-          /* if */
+  return result;
+}
+/* ProjectPoints */
 
-          assert( k < data->rows );
-          float * const row_data = (float *)( (BYTE *)(data->data) + data->step[0] * k );
 
-          if (true == have_range)
-            {
-              row_data[0] = row_range_img[i];
-              row_data[1] = (float)( sqrt(row_dst2_3D[i]) );
-            }
-          /* if */
 
-          if (true == have_phase_distance)
-            {
-              assert( (x < abs_phase_distance->cols) && (y < abs_phase_distance->rows) );
-              if (y != y_prev_phase_distance)
-                {
-                  row_phase_distance = (float const *)( (BYTE *)(abs_phase_distance->data) + abs_phase_distance->step[0] * y );
-                  y_prev_phase_distance = y;
-                }
-              /* if */
-              row_data[2] = row_phase_distance[x];
-            }
-          /* if */
+/****** AUXILIARY FUNCTIONS ******/
+
+//! Parallel selection of valid points.
+/*!
+  Selection of valid points is done as a two-pass parallel compaction
+  over chunks of TRIANGULATION_CHUNK_SIZE points. The first pass counts valid points
+  in each chunk. The prefix sum of counts is then the output offset of each chunk
+  so the second pass may copy valid points and their data to the output
+  in parallel while preserving the order of points.
+*/
+struct SelectValidPointsParallel_ : public cv::ParallelLoopBody
+{
+  int N; //!< Number of points.
+  bool fill; //!< Flag to indicate the pass; if false then valid points are counted, if true then they are copied.
+  bool prune; //!< Flag to indicate points are pruned using the ray-to-ray distance.
+  bool is_grayscale; //!< Flag to indicate texture is grayscale.
+  double dst2_thr; //!< Threshold for squared ray-to-ray distance.
+
+  double const * row_x_3D; //!< X coordinates.
+  double const * row_y_3D; //!< Y coordinates.
+  double const * row_z_3D; //!< Z coordinates.
+  double const * row_dst2_3D; //!< Squared ray-to-ray distances; may be NULL.
+  int const * row_x_img; //!< Image x coordinates; may be NULL if there is no additional data.
+  int const * row_y_img; //!< Image y coordinates; may be NULL if there is no additional data.
+  float const * row_range_img; //!< Dynamic range; may be NULL.
+
+  cv::Mat * texture; //!< Texture image; may be NULL.
+  cv::Mat * abs_phase_distance; //!< Distance to constellation of the absolute phase; may be NULL.
+  cv::Mat * abs_phase_deviation; //!< Deviation of the absolute phase; may be NULL.
+
+  int * counts; //!< Number of valid points in each chunk in the first pass and output offset of each chunk in the second pass.
+
+  cv::Mat * points; //!< Output point coordinates (CV_32F, three columns).
+  cv::Mat * colors; //!< Output point colors (CV_8U, four columns); may be NULL.
+  cv::Mat * data; //!< Output additional data (CV_32F, four columns); may be NULL.
+
+  //! Constructor.
+  SelectValidPointsParallel_()
+  {
+    this->N = 0;
+    this->fill = false;
+    this->prune = false;
+    this->is_grayscale = false;
+    this->dst2_thr = 0.0;
+
+    this->row_x_3D = NULL;
+    this->row_y_3D = NULL;
+    this->row_z_3D = NULL;
+    this->row_dst2_3D = NULL;
+    this->row_x_img = NULL;
+    this->row_y_img = NULL;
+    this->row_range_img = NULL;
+
+    this->texture = NULL;
+    this->abs_phase_distance = NULL;
+    this->abs_phase_deviation = NULL;
+
+    this->counts = NULL;
+
+    this->points = NULL;
+    this->colors = NULL;
+    this->data = NULL;
+  }
+
+  //! Tests if point is valid.
+  inline bool IsValid(int const i) const
+  {
+    if ( (true == this->prune) && (this->dst2_thr < this->row_dst2_3D[i]) ) return false;
+    if ( isnanorinf_inline(this->row_x_3D[i]) || isnanorinf_inline(this->row_y_3D[i]) || isnanorinf_inline(this->row_z_3D[i]) ) return false;
+    return true;
+  }
+
+  //! Counts or copies valid points of a range of chunks.
+  virtual void operator()(const cv::Range & r) const
+  {
+    for (int j = r.start; j < r.end; ++j)
+      {
+        int const start = j * TRIANGULATION_CHUNK_SIZE;
+        int const end = (start + TRIANGULATION_CHUNK_SIZE < this->N)? start + TRIANGULATION_CHUNK_SIZE : this->N;
+
+        if (false == this->fill)
+          {
+            int count = 0;
+            for (int i = start; i < end; ++i) if (true == this->IsValid(i)) ++count;
+            this->counts[j] = count;
+          }
+        else
+          {
+            this->Copy(start, end, this->counts[j]);
+          }
+        /* if */
+      }
+    /* for */
+  }
+
+  //! Copies valid points of one chunk.
+  void Copy(int const start, int const end, int k) const
+  {
+    // Row indices into images are cached per chunk as consecutive points are mostly in the same image row.
+    int y_prev_tex = -1;
+    int y_prev_phase_distance = -1;
+    int y_prev_phase_deviation = -1;
+
+    UINT8 const * row_tex = NULL;
+    float const * row_phase_distance = NULL;
+    float const * row_phase_deviation = NULL;
+
+    for (int i = start; i < end; ++i)
+      {
+        if (false == this->IsValid(i)) continue;
+
+        assert( (0 <= k) && (k < this->points->rows) );
+        float * const row_points = (float *)( (BYTE *)(this->points->data) + this->points->step[0] * k );
+
+        row_points[0] = (float)( this->row_x_3D[i] );
+        row_points[1] = (float)( this->row_y_3D[i] );
+        row_points[2] = (float)( this->row_z_3D[i] );
+
+        if (NULL != this->data)
+          {
+            int const x = this->row_x_img[i];
+            int const y = this->row_y_img[i];
+            assert( (0 <= x) && (0 <= y) );
+
+            if (NULL != this->colors)
+              {
+                assert( k < this->colors->rows );
+                UINT8 * const row_colors = (UINT8 *)( (BYTE *)(this->colors->data) + this->colors->step[0] * k );
+
+                assert( (x < this->texture->cols) && (y < this->texture->rows) );
+                if (y != y_prev_tex)
+                  {
+                    row_tex = (UINT8 const *)( (BYTE *)(this->texture->data) + this->texture->step[0] * y );
+                    y_prev_tex = y;
+                  }
+                /* if */
+
+                if (false == this->is_grayscale)
+                  {
+                    row_colors[0] = row_tex[3*x + 2];
+                    row_colors[1] = row_tex[3*x + 1];
+                    row_colors[2] = row_tex[3*x    ];
+                  }
+                else
+                  {
+                    row_colors[0] = row_tex[x];
+                    row_colors[1] = row_tex[x];
+                    row_colors[2] = row_tex[x];
+                  }
+                /* if */
+                row_colors[3] = 255;
+              }
+            /* if */
+
+            assert( k < this->data->rows );
+            float * const row_data = (float *)( (BYTE *)(this->data->data) + this->data->step[0] * k );
+
+            row_data[0] = (NULL != this->row_range_img)? this->row_range_img[i] : 0.0f;
+            row_data[1] = (NULL != this->row_dst2_3D)? (float)( sqrt(this->row_dst2_3D[i]) ) : 0.0f;
+            row_data[2] = 0.0f;
+            row_data[3] = 0.0f;
+
+            if (NULL != this->abs_phase_distance)
+              {
+                assert( (x < this->abs_phase_distance->cols) && (y < this->abs_phase_distance->rows) );
+                if (y != y_prev_phase_distance)
+                  {
+                    row_phase_distance = (float const *)( (BYTE *)(this->abs_phase_distance->data) + this->abs_phase_distance->step[0] * y );
+                    y_prev_phase_distance = y;
+                  }
+                /* if */
+                row_data[2] = row_phase_distance[x];
+              }
+            /* if */
+
+            if (NULL != this->abs_phase_deviation)
+              {
+                assert( (x < this->abs_phase_deviation->cols) && (y < this->abs_phase_deviation->rows) );
+                if (y != y_prev_phase_deviation)
+                  {
+                    row_phase_deviation = (float const *)( (BYTE *)(this->abs_phase_deviation->data) + this->abs_phase_deviation->step[0] * y );
+                    y_prev_phase_deviation = y;
+                  }
+                /* if */
+                row_data[3] = row_phase_deviation[x];
+              }
+            /* if */
+          }
+        /* if */
+
+        ++k;
+      }
+    /* for */
+  }
+};
+/* SelectValidPointsParallel_ */
+
 
-          if (true == have_phase_deviation)
+
+//! Data assembly for VTK visualization.
+/*!
+  Creates inputs required for VTK visualization.
+
+  Valid points are selected using parallel compaction and are copied directly
+  to buffers in the layout used by VTK: point coordinates are stored in single precision
+  and colors are stored as RGBA. All output buffers are continuous so VTKCreatePointCloudData
+  may share them with the point cloud instead of copying.
+
+  \param x_3D   Array of x coordinates.
+  \param y_3D   Array of y coordinates.
+  \param z_3D   Array of z coordinates.
+  \param dst2_3D        Array of squared distances between rays. May be NULL, e.g. if points were computed using phase-to-XYZ model.
+  \param dst2_thr       Threshold for the array of squared distances. Only points having distance lower than this threshold will be output.
+  \param x_img  Image x coordinate.
+  \param y_img  Image y coordinate.
+  \param range_img Dynamic range of selected points.
+  \param AllImages      Pointer to all captured images. If NULL then points will not have color information.
+  \param texture      Pointer to cv::Mat which stores texture image. Texture image must be either grayscale or BGR with 8 bits per pixel.
+  \param abs_phase_distance  Image storing distance to constellation of the absolute phase.
+  \param abs_phase_deviation  Image storing deviation of the absolute phase.
+  \param points_out     Address where selected 3D points will be stored (CV_32F, three columns).
+  \param colors_out     Address where RGBA texture information for 3D points will be stored (CV_8U, four columns).
+  \param data_out       Address where additional data for 3D points will be stored (CV_32F, four columns).
+  \return Returns true if successfull.
+*/
+bool
+SelectValidPointsAndAssembleDataForVTK(
+                                       cv::Mat * const x_3D,
+                                       cv::Mat * const y_3D,
+                                       cv::Mat * const z_3D,
+                                       cv::Mat * const dst2_3D,
+                                       double const dst2_thr,
+                                       cv::Mat * const x_img,
+                                       cv::Mat * const y_img,
+                                       cv::Mat * const range_img,
+                                       ImageSet * const AllImages,
+                                       cv::Mat * const texture,
+                                       cv::Mat * const abs_phase_distance,
+                                       cv::Mat * const abs_phase_deviation,
+                                       cv::Mat * * const points_out,
+                                       cv::Mat * * const colors_out,
+                                       cv::Mat * * const data_out
+                                       )
+{
+  int const num_3D = CheckRowArrays_inline(CV_64F, x_3D, y_3D, z_3D, dst2_3D);
+  assert( 3 <= num_3D );
+  if (3 > num_3D) return false;
+
+  int const N = x_3D->cols;
+
+  cv::Mat * points = NULL;
+  cv::Mat * colors = NULL;
+  cv::Mat * data = NULL;
+
+  bool const have_dst2 = (NULL != dst2_3D) && (NULL != dst2_3D->data);
+  bool const prune = (true == have_dst2) && (0.0 != dst2_thr);
+  bool const is_grayscale = (NULL != AllImages) && (true == AllImages->IsGrayscale());
+  bool const have_texture = (NULL != texture) && (NULL != texture->data);
+  bool const have_range = (NULL != range_img) && (NULL != range_img->data);
+  bool const have_phase_distance = (NULL != abs_phase_distance) && (NULL != abs_phase_distance->data);
+  bool const have_phase_deviation = (NULL != abs_phase_deviation) && (NULL != abs_phase_deviation->data);
+
+  bool const have_data = (true == have_texture) || (true == have_range) || (true == have_phase_distance) || (true == have_phase_deviation);
+  if ( true == have_data )
+    {
+      int const num_2D = CheckRowArrays_inline(CV_32S, x_img, y_img);
+      assert(2 == num_2D);
+      if (2 != num_2D) return false;
+
+      assert(N == x_img->cols);
+      if (N != x_img->cols) return false;
+
+      if (true == have_texture)
+        {
+          assert( (CV_MAT_DEPTH(texture->type()) == CV_8U) &&
+                  ( (true == is_grayscale) ?
+                    (CV_MAT_CN(texture->type()) == 1) :
+                    (CV_MAT_CN(texture->type()) == 3)
+                    )
+                  );
+          if ( (CV_MAT_DEPTH(texture->type()) != CV_8U) ||
+               ( (true == is_grayscale) ?
+                 (CV_MAT_CN(texture->type()) != 1) :
+                 (CV_MAT_CN(texture->type()) != 3)
+                 )
+               )
             {
-              assert( (x < abs_phase_deviation->cols) && (y < abs_phase_deviation->rows) );
-              if (y != y_prev_phase_deviation)
-                {
-                  row_phase_deviation = (float const *)( (BYTE *)(abs_phase_deviation->data) + abs_phase_deviation->step[0] * y );
-                  y_prev_phase_deviation = y;
-                }
-              /* if */
-              row_data[3] = row_phase_deviation[x];
+              return false;
             }
           /* if */
         }
       /* if */
 
-      ++k;
+      if (true == have_range)
+        {
+          bool const range_valid = CheckRowArray_inline(CV_32F, range_img);
+          assert(true == range_valid);
+          if (true != range_valid) return false;
+
+          assert(N == range_img->cols);
+          if (N != range_img->cols) return false;
+        }
+      /* if */
     }
-  /* for */
+  /* if */
 
-  // Create new cv::Mat headers for output buffers. Note that we do not reallocate
-  // allocated storage; instead only header data of cv::Mat is changed to reflect
-  // the correct number of valid points.
-  cv::Range r[2] = {cv::Range(0, k), cv::Range::all()};
+  bool result = true; // Assume success.
 
-  if (0 < k)
+  int const num_chunks = (N + TRIANGULATION_CHUNK_SIZE - 1) / TRIANGULATION_CHUNK_SIZE;
+  std::vector<int> counts(num_chunks + 1, 0);
+
+  SelectValidPointsParallel_ body;
+  body.N = N;
+  body.prune = prune;
+  body.is_grayscale = is_grayscale;
+  body.dst2_thr = dst2_thr;
+  body.row_x_3D = (double *)( (BYTE *)(x_3D->data) + x_3D->step[0] * 0 );
+  body.row_y_3D = (double *)( (BYTE *)(y_3D->data) + y_3D->step[0] * 0 );
+  body.row_z_3D = (double *)( (BYTE *)(z_3D->data) + z_3D->step[0] * 0 );
+  body.row_dst2_3D = (true == have_dst2)? (double *)( (BYTE *)(dst2_3D->data) + dst2_3D->step[0] * 0 ) : NULL;
+  body.row_x_img = (true == have_data)? (int *)( (BYTE *)(x_img->data) + x_img->step[0] * 0 ) : NULL;
+  body.row_y_img = (true == have_data)? (int *)( (BYTE *)(y_img->data) + y_img->step[0] * 0 ) : NULL;
+  body.row_range_img = (true == have_range)? (float *)( (BYTE *)(range_img->data) + range_img->step[0] * 0 ) : NULL;
+  body.texture = (true == have_texture)? texture : NULL;
+  body.abs_phase_distance = (true == have_phase_distance)? abs_phase_distance : NULL;
+  body.abs_phase_deviation = (true == have_phase_deviation)? abs_phase_deviation : NULL;
+  body.counts = &( counts.front() );
+
+  // Count valid points in each chunk.
+  if (0 < num_chunks)
     {
-      cv::Mat * points_tmp = new cv::Mat(*points, r);
-      assert(NULL != points_tmp);
-      if (NULL != points_tmp)
-        {
-          SAFE_DELETE(points);
-          points = points_tmp;
-          points_tmp = NULL;
-        }
-      else
+      body.fill = false;
+      cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
+    }
+  /* if */
+
+  // Convert counts to output offsets; last element holds the total number of valid points.
+  {
+    int offset = 0;
+    for (int j = 0; j <= num_chunks; ++j)
+      {
+        int const count = counts[j];
+        counts[j] = offset;
+        offset += count;
+      }
+    /* for */
+  }
+  int const k = counts[num_chunks];
+  assert( (0 <= k) && (k <= N) );
+
+  // Allocate storage for exactly k points.
+  points = new cv::Mat(k, 3, CV_32F);
+  assert(NULL != points);
+  if (NULL == points)
+    {
+      result = false;
+      goto SelectValidPointsAndAssembleDataForVTK_EXIT;
+    }
+  /* if */
+
+  if ( true == have_data )
+    {
+      data = new cv::Mat(k, 4, CV_32F);
+      assert(NULL != data);
+      if (NULL == data)
         {
           result = false;
+          goto SelectValidPointsAndAssembleDataForVTK_EXIT;
         }
       /* if */
 
       if (true == have_texture)
         {
-          cv::Mat * colors_tmp = new cv::Mat(*colors, r);
-          assert(NULL != colors_tmp);
-          if (NULL != colors_tmp)
-            {
-              SAFE_DELETE(colors);
-              colors = colors_tmp;
-              colors_tmp = NULL;
-            }
-          else
-            {
-              result = false;
-            }
-          /* if */
-        }
-      /* if */
-
-      if (true == have_data)
-        {
-          cv::Mat * data_tmp = new cv::Mat(*data, r);
-          assert(NULL != data_tmp);
-          if (NULL != data_tmp)
-            {
-              SAFE_DELETE(data);
-              data = data_tmp;
-              data_tmp = NULL;
-            }
-          else
+          colors = new cv::Mat(k, 4, CV_8U);
+          assert(NULL != colors);
+          if (NULL == colors)
             {
               result = false;
+              goto SelectValidPointsAndAssembleDataForVTK_EXIT;
             }
           /* if */
         }
       /* if */
     }
-  else
+  /* if */
+
+  // Copy valid points.
+  if (0 < k)
     {
-      points->create(0, 3, CV_64F);
-      if (true == have_texture) colors->create(0, is_grayscale ? 1 : 3, CV_8U);
-      if (true == have_range) data->create(0, 2, CV_32F);
-      assert(true == result);
+      body.fill = true;
+      body.points = points;
+      body.colors = colors;
+      body.data = data;
+      cv::parallel_for_( cv::Range(0, num_chunks), body, (double)(num_chunks) );
     }
   /* if */
 
-
   SAFE_ASSIGN_PTR( points, points_out );
   SAFE_ASSIGN_PTR( colors, colors_out );
   SAFE_ASSIGN_PTR( data, data_out );
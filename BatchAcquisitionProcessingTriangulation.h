@@ -83,6 +83,24 @@ bool GetCameraRays(cv::Mat * const, cv::Mat * const, ProjectiveGeometry * const,
 
 /****** TRIANGULATION ******/
 
+//! Relative tolerance of the fused triangulation kernel w.r.t. the reference implementation.
+#define TRIANGULATION_FUSED_TOLERANCE 1.0e-9
+
+//! Triangulates two views (reference implementation).
+bool
+TriangulateTwoViewsReference(
+                             ProjectiveGeometry * const,
+                             cv::Mat * const,
+                             cv::Mat * const,
+                             ProjectiveGeometry * const,
+                             cv::Mat * const,
+                             cv::Mat * const,
+                             cv::Mat * * const,
+                             cv::Mat * * const,
+                             cv::Mat * * const,
+                             cv::Mat * * const
+                             );
+
 //! Triangulates two views.
 bool
 TriangulateTwoViews(
@@ -99,6 +117,276 @@ TriangulateTwoViews(
                     );
 
 
+/****** CAMERA RAY TABLES ******/
+
+//! Largest allowed size of one camera ray table in bytes; tables are not used for larger sensors. Set to 0 to disable ray tables.
+#define CAMERA_RAY_TABLE_MAX_SIZE ((size_t)(512) * 1048576)
+
+
+//! Camera ray table.
+/*!
+  Structure holds unit ray directions of every pixel of the camera sensor.
+  Ray directions are computed from undistorted pixel coordinates and are stored
+  in single precision as three separate arrays (structure of arrays).
+  The table depends only on camera geometry and on the sensor size
+  so it may be reused for all reconstructions which use the same camera.
+*/
+typedef
+struct CameraRayTable_
+{
+  std::wstring name; //!< Unique name of the camera.
+
+  double fx; //!< Focus along x direction.
+  double fy; //!< Focus along y direction.
+  double cx; //!< Image center in x direction.
+  double cy; //!< Image center in y direction.
+  double k0; //!< First parameter for radial distortion; multiplies r^2.
+  double k1; //!< Second parameter for radial distortion; multiplies r^4.
+  double projection[3][4]; //!< Full perspective projection matrix.
+  double center[3]; //!< Camera center.
+
+  int shift_x; //!< Column shift applied to pixel indices.
+  int shift_y; //!< Row shift applied to pixel indices.
+  int width; //!< Sensor width in pixels.
+  int height; //!< Sensor height in pixels.
+
+  cv::Mat * vx; //!< Ray direction components along x coordinate (CV_32FC1 of sensor size).
+  cv::Mat * vy; //!< Ray direction components along y coordinate (CV_32FC1 of sensor size).
+  cv::Mat * vz; //!< Ray direction components along z coordinate (CV_32FC1 of sensor size).
+
+  mutable volatile LONG refcount; //!< Number of callers which hold the table; changed only by CameraRayTableCacheGet and CameraRayTableCacheRelease.
+
+  //! Constructor.
+  CameraRayTable_();
+
+  //! Destructor.
+  ~CameraRayTable_();
+
+  //! Blank class variables.
+  void Blank(void);
+
+  //! Check if table matches geometry.
+  bool IsValidFor(ProjectiveGeometry_ const * const, int const, int const, int const, int const) const;
+
+  //! Memory used by the table.
+  size_t SizeInBytes(void) const;
+
+} CameraRayTable;
+
+
+//! Compute camera ray table.
+CameraRayTable_ *
+CameraRayTableCompute(
+                      ProjectiveGeometry_ * const,
+                      int const,
+                      int const,
+                      int const,
+                      int const
+                      );
+
+//! Get cached camera ray table.
+CameraRayTable_ *
+CameraRayTableCacheGet(
+                       ProjectiveGeometry_ * const,
+                       int const,
+                       int const,
+                       int const,
+                       int const
+                       );
+
+//! Release cached camera ray table.
+void
+CameraRayTableCacheRelease(
+                           CameraRayTable_ const * const
+                           );
+
+//! Clear camera ray table cache.
+void
+CameraRayTableCacheClear(
+                         void
+                         );
+
+//! Triangulates two views using camera ray table.
+bool
+TriangulateTwoViewsUsingRayTable(
+                                 ProjectiveGeometry * const,
+                                 CameraRayTable_ const * const,
+                                 cv::Mat * const,
+                                 cv::Mat * const,
+                                 int const,
+                                 int const,
+                                 ProjectiveGeometry * const,
+                                 cv::Mat * const,
+                                 cv::Mat * const,
+                                 cv::Mat * * const,
+                                 cv::Mat * * const,
+                                 cv::Mat * * const,
+                                 cv::Mat * * const
+                                 );
+
+
+/****** SINGLE-DIRECTION TRIANGULATION ******/
+
+//! Number of refinement iterations when only one projector coordinate is known; one iteration matches reprojection followed by re-triangulation.
+#define SINGLE_DIRECTION_TRIANGULATION_ITERATIONS 2
+
+
+//! Triangulates two views when only one projector coordinate is known.
+bool
+TriangulateSingleDirection(
+                           ProjectiveGeometry * const,
+                           CameraRayTable_ const * const,
+                           cv::Mat * const,
+                           cv::Mat * const,
+                           int const,
+                           int const,
+                           ProjectiveGeometry * const,
+                           cv::Mat * const,
+                           cv::Mat * const,
+                           int const,
+                           cv::Mat * * const,
+                           cv::Mat * * const,
+                           cv::Mat * * const,
+                           cv::Mat * * const
+                           );
+
+
+/****** PHASE-TO-XYZ MODELS ******/
+
+//! Largest allowed size of one phase-to-XYZ model in bytes; models are not used for larger sensors. Set to 0 to disable phase-to-XYZ models.
+#define PHASE_TO_XYZ_MODEL_MAX_SIZE ((size_t)(768) * 1048576)
+
+//! Nearest modelled distance from the camera center as a multiple of the distance between camera and projector centers.
+#define PHASE_TO_XYZ_MODEL_DEPTH_MIN 0.5
+
+//! Farthest modelled distance from the camera center as a multiple of the distance between camera and projector centers.
+#define PHASE_TO_XYZ_MODEL_DEPTH_MAX 20.0
+
+//! Number of samples along the camera ray used to fit the model of one pixel.
+#define PHASE_TO_XYZ_MODEL_SAMPLES 10
+
+//! Largest allowed fitting error of phase-to-XYZ model in projector pixels.
+#define PHASE_TO_XYZ_MODEL_TOLERANCE 1.0e-3
+
+
+//! Phase-to-XYZ model.
+/*!
+  Structure holds a per-pixel model which maps distorted projector coordinate,
+  i.e. scaled absolute phase, directly to the distance along the camera ray.
+  For each pixel of the camera sensor twelve single precision coefficients are stored:
+  unit ray direction vx, vy, and vz, center u0 of the modelled projector coordinates,
+  coefficients c1 to c5 of a polynomial which removes projector distortion
+  along the epipolar line, and coefficients m0, m1, and m2 of the projective
+  mapping from the projector coordinate to the distance. For the projector
+  coordinate u the triangulated point is
+
+    s = u - u0,
+    d = c1 s + c2 s^2 + c3 s^3 + c4 s^4 + c5 s^5,
+    t = (m0 - m1 d) / (1 + m2 d),
+    X = C + t v,
+
+  where C is the camera center. Pixels whose rays do not reach the projector
+  within the modelled depth range have NaN coefficients.
+
+  The model depends only on camera and projector geometry, on the sensor size,
+  and on the projector resolution so it may be reused for all reconstructions
+  which use the same camera and projector.
+*/
+typedef
+struct PhaseToXYZModel_
+{
+  ProjectiveGeometry_ * camera; //!< Camera geometry.
+  ProjectiveGeometry_ * projector; //!< Projector geometry.
+
+  int shift_x; //!< Column shift applied to pixel indices.
+  int shift_y; //!< Row shift applied to pixel indices.
+  int width; //!< Sensor width in pixels.
+  int height; //!< Sensor height in pixels.
+
+  int row; //!< Projector coordinate; 0 for columns and 1 for rows.
+  double size; //!< Projector width or height in pixels; absolute phase of one is mapped to this coordinate.
+
+  double depth_min; //!< Nearest modelled distance from the camera center.
+  double depth_max; //!< Farthest modelled distance from the camera center.
+  double max_error; //!< Largest fitting error in projector pixels measured during validation.
+  int num_valid; //!< Number of pixels which have valid coefficients.
+
+  cv::Mat * coefficients; //!< Per-pixel model coefficients (CV_32FC(12) of sensor size); NULL if the model was rejected.
+
+  mutable volatile LONG refcount; //!< Number of callers which hold the model; changed only by PhaseToXYZModelCacheGet and PhaseToXYZModelCacheRelease.
+
+  //! Constructor.
+  PhaseToXYZModel_();
+
+  //! Destructor.
+  ~PhaseToXYZModel_();
+
+  //! Blank class variables.
+  void Blank(void);
+
+  //! Check if model matches geometry.
+  bool IsValidFor(ProjectiveGeometry_ const * const, ProjectiveGeometry_ const * const, int const, int const, int const, int const, int const, double const) const;
+
+  //! Memory used by the model.
+  size_t SizeInBytes(void) const;
+
+} PhaseToXYZModel;
+
+
+//! Compute phase-to-XYZ model.
+PhaseToXYZModel_ *
+PhaseToXYZModelCompute(
+                       ProjectiveGeometry_ * const,
+                       ProjectiveGeometry_ * const,
+                       int const,
+                       int const,
+                       int const,
+                       int const,
+                       int const,
+                       double const
+                       );
+
+//! Get cached phase-to-XYZ model.
+PhaseToXYZModel_ *
+PhaseToXYZModelCacheGet(
+                        ProjectiveGeometry_ * const,
+                        ProjectiveGeometry_ * const,
+                        int const,
+                        int const,
+                        int const,
+                        int const,
+                        int const,
+                        double const
+                        );
+
+//! Release cached phase-to-XYZ model.
+void
+PhaseToXYZModelCacheRelease(
+                            PhaseToXYZModel_ const * const
+                            );
+
+//! Clear phase-to-XYZ model cache.
+void
+PhaseToXYZModelCacheClear(
+                          void
+                          );
+
+//! Triangulates points using phase-to-XYZ model.
+bool
+TriangulateUsingPhaseToXYZModel(
+                                PhaseToXYZModel_ const * const,
+                                CameraRayTable_ const * const,
+                                cv::Mat * const,
+                                cv::Mat * const,
+                                int const,
+                                int const,
+                                cv::Mat * const,
+                                cv::Mat * * const,
+                                cv::Mat * * const,
+                                cv::Mat * * const
+                                );
+
+
 /****** PROJECTION ******/
 
 //! Projects points.
@@ -46,6 +46,8 @@
 #include <tchar.h>
 #include <process.h>
 #include <math.h>
+#include <intrin.h>
+#include <immintrin.h>
 
 #include <cassert>
 #include <cfloat>
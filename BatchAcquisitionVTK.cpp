@@ -150,6 +150,9 @@ VTKBlankPointCloudData_inline(
   P->ColorsMapped = NULL;
   P->ColorsOriginal = NULL;
 
+  P->pPoints = NULL;
+  P->pColors = NULL;
+
   P->CloudPoints = NULL;
   P->PointsToVertexes = NULL;
   P->CloudVertexes = NULL;
@@ -3644,6 +3647,10 @@ VTKDeletePointCloudData(
   VTKDeleteSurfaceData(P->surface);
   VTKDeleteOutlineData(P->outline);
 
+  // Shared buffers are released last as VTK objects above may reference them.
+  SAFE_DELETE( P->pPoints );
+  SAFE_DELETE( P->pColors );
+
   VTKBlankPointCloudData_inline( P );
 
   free( P );
@@ -3659,10 +3666,13 @@ VTKDeletePointCloudData(
   Default obtained points are colored in blue.
 
   \param points Pointer to cv::Mat matrix having 3 columns and at least one row that contains point coordinates.
-  Type of matrix must be CV_32F or CV_64F.
-  \param colors Pointer to cv::Mat matrix having 1 or 3 columns and the same number of rows as points matrix.
+  Type of matrix must be CV_32F or CV_64F. Continuous CV_32F matrix is not copied; instead its buffer
+  is shared with the created point cloud which keeps a reference to it.
+  \param colors Pointer to cv::Mat matrix having 1, 3, or 4 columns and the same number of rows as points matrix.
   If matrix has one column then value is interpreted as graylevel intensity, if matrix has three columns
-  then columns contain red, green, and blue color components. Type of the matrix must be CV_8U.
+  then columns contain red, green, and blue color components, and if matrix has four columns
+  then columns contain red, green, blue, and opacity. Type of the matrix must be CV_8U.
+  Continuous matrix having four columns is shared with the created point cloud in the same way as points.
   \param data Pointer to cv::Mat matrix having several columns which contain additional data.
   The matrix data must have the same number of rows as points matrix.
   The first column contains dynamic range of the input, the second column contains minimal
@@ -3765,63 +3775,94 @@ VTKCreatePointCloudData(
   int const points_depth = CV_MAT_DEPTH(points_type);
   assert( 1 == CV_MAT_CN(points_type) );
 
-  /* Copy supplied coordinates. We may set the data using method InsertPoint or SetPoint.
-     Note that InsertPoint does boundary checking on each insert while the SetPoint does not.
-     Therefore, memory pre-allocation when using SetNumberOfPoints is necessary.
-     However, once memory is pre-allocated we may fetch the data pointer directly and avoid
-     the overhead of tuple copy loop in SetPoint method.
-  */
-  P->Cloud->SetNumberOfPoints(N); // Pre-allocate storage.
-
-  int const type = P->Cloud->GetDataType();
-  assert(VTK_FLOAT == type);
-  if (VTK_FLOAT != type)
+  bool const share_points = (CV_32F == points_depth) && (true == points->isContinuous());
+  if (true == share_points)
     {
-      VTKDeletePointCloudData( P );
-      return NULL;
-    }
-  /* if */
+      /* Supplied coordinates already are in the layout of VTK float array
+         so the array is set to point to the supplied buffer instead of copying it.
+         VTK will not free the buffer; instead we keep a reference to it
+         which is released when the point cloud is destroyed.
+      */
+      vtkFloatArray * coordinates = vtkFloatArray::New();
+      assert(NULL != coordinates);
+
+      P->pPoints = new cv::Mat( *points );
+      assert(NULL != P->pPoints);
 
-  float * const dst_pt = (float *)( P->Cloud->GetVoidPointer(0) ); // Fetch data pointer.
+      if ( (NULL == coordinates) || (NULL == P->pPoints) )
+        {
+          SAFE_VTK_DELETE( coordinates );
+          VTKDeletePointCloudData( P );
+          return NULL;
+        }
+      /* if */
 
-  switch (points_depth)
+      coordinates->SetNumberOfComponents(3);
+      coordinates->SetArray( (float *)( P->pPoints->data ), (vtkIdType)(3) * (vtkIdType)(N), 1 );
+      P->Cloud->SetData( coordinates );
+      SAFE_VTK_DELETE( coordinates ); // Cloud holds the reference.
+    }
+  else
     {
-    case CV_32F:
-      {
-        for (int i = 0; i < N; ++i)
+      /* Copy supplied coordinates. We may set the data using method InsertPoint or SetPoint.
+         Note that InsertPoint does boundary checking on each insert while the SetPoint does not.
+         Therefore, memory pre-allocation when using SetNumberOfPoints is necessary.
+         However, once memory is pre-allocated we may fetch the data pointer directly and avoid
+         the overhead of tuple copy loop in SetPoint method.
+      */
+      P->Cloud->SetNumberOfPoints(N); // Pre-allocate storage.
+
+      int const type = P->Cloud->GetDataType();
+      assert(VTK_FLOAT == type);
+      if (VTK_FLOAT != type)
+        {
+          VTKDeletePointCloudData( P );
+          return NULL;
+        }
+      /* if */
+
+      float * const dst_pt = (float *)( P->Cloud->GetVoidPointer(0) ); // Fetch data pointer.
+
+      switch (points_depth)
+        {
+        case CV_32F:
           {
-            float const * const rowptr = (float *)( (BYTE *)( points->data ) + i * points->step[0] );
-            int const adr = 3 * i;
-            dst_pt[adr    ] = rowptr[0];
-            dst_pt[adr + 1] = rowptr[1];
-            dst_pt[adr + 2] = rowptr[2];
+            for (int i = 0; i < N; ++i)
+              {
+                float const * const rowptr = (float *)( (BYTE *)( points->data ) + i * points->step[0] );
+                int const adr = 3 * i;
+                dst_pt[adr    ] = rowptr[0];
+                dst_pt[adr + 1] = rowptr[1];
+                dst_pt[adr + 2] = rowptr[2];
+              }
+            /* for */
           }
-        /* for */
-      }
-      break;
+          break;
 
-    case CV_64F:
-      {
-        for (int i = 0; i < N; ++i)
+        case CV_64F:
           {
-            double const * const rowptr = (double *)( (BYTE *)( points->data ) + i * points->step[0] );
-            int const adr = 3 * i;
-            dst_pt[adr    ] = (float)( rowptr[0] );
-            dst_pt[adr + 1] = (float)( rowptr[1] );
-            dst_pt[adr + 2] = (float)( rowptr[2] );
+            for (int i = 0; i < N; ++i)
+              {
+                double const * const rowptr = (double *)( (BYTE *)( points->data ) + i * points->step[0] );
+                int const adr = 3 * i;
+                dst_pt[adr    ] = (float)( rowptr[0] );
+                dst_pt[adr + 1] = (float)( rowptr[1] );
+                dst_pt[adr + 2] = (float)( rowptr[2] );
+              }
+            /* for */
           }
-        /* for */
-      }
-      break;
+          break;
 
-    default:
-      {
-        // Unsupported input.
-        VTKDeletePointCloudData( P );
-        return NULL;
-      }
+        default:
+          {
+            // Unsupported input.
+            VTKDeletePointCloudData( P );
+            return NULL;
+          }
+        }
+      /* switch */
     }
-  /* switch */
+  /* if */
 
   /* Copy supplied colors. Colors are in RGBA mode where last value is opacity.
      Opacity of 0 means the vertex associated with the point will be completely
@@ -3834,11 +3875,37 @@ VTKCreatePointCloudData(
   assert( 1.0f == P->colorScale );
   assert( 0.0f == P->colorOffset );
 
+  bool const share_colors =
+    (NULL != colors) && (NULL != colors->data) &&
+    (N == colors->rows) && (4 == colors->cols) && (CV_8U == colors->type()) &&
+    (true == colors->isContinuous());
+
   P->ColorsOriginal->SetNumberOfComponents(4);
-  P->ColorsOriginal->SetNumberOfTuples(N);
+  if (false == share_colors) P->ColorsOriginal->SetNumberOfTuples(N);
   P->ColorsMapped->SetNumberOfComponents(4);
   P->ColorsMapped->SetNumberOfTuples(N);
-  if ( (NULL != colors) && (NULL != colors->data) )
+  if (true == share_colors)
+    {
+      /* Original colors are shared in the same way as coordinates.
+         Mapped colors are changed by color scaling and thresholding
+         so they must be stored in a separate buffer.
+      */
+      P->pColors = new cv::Mat( *colors );
+      assert(NULL != P->pColors);
+      if (NULL == P->pColors)
+        {
+          VTKDeletePointCloudData( P );
+          return NULL;
+        }
+      /* if */
+
+      P->ColorsOriginal->SetArray( (unsigned char *)( P->pColors->data ), (vtkIdType)(4) * (vtkIdType)(N), 1 );
+
+      unsigned char * const dst = P->ColorsMapped->WritePointer(0, 4 * N);
+      assert(NULL != dst);
+      if (NULL != dst) memcpy( dst, P->pColors->data, (size_t)(4) * (size_t)(N) );
+    }
+  else if ( (NULL != colors) && (NULL != colors->data) )
     {
       int const colors_type = colors->type();
       int const colors_depth = CV_MAT_DEPTH(colors_type);
@@ -7176,8 +7243,8 @@ VTKPushProjectorGeometryToDisplayThread(
 
     if ( (NULL != P->projector_geometriesNEW) && (0 <= ProjectorID) && (ProjectorID < (int)(P->projector_geometriesNEW->size())) )
       {
+        // Several cameras may share one projector so geometry pushed by another camera may still be pending.
         ProjectiveGeometry_ * geometryNEW = ( *(P->projector_geometriesNEW) )[ProjectorID];
-        assert(NULL == geometryNEW);
         SAFE_DELETE(geometryNEW);
 
         geometryNEW = geometry;
@@ -190,6 +190,9 @@ typedef struct VTKpointclouddata_
   vtkUnsignedCharArray * ColorsMapped; /*!< Container where we stored mapped colors for all points. */
   vtkUnsignedCharArray * ColorsOriginal; /*!< Container where we copy the color for all points. */
 
+  cv::Mat * pPoints; /*!< Buffer of point coordinates shared with Cloud; NULL if coordinates were copied. */
+  cv::Mat * pColors; /*!< Buffer of RGBA colors shared with ColorsOriginal; NULL if colors were copied. */
+
   vtkPolyData * CloudPoints; /*!< Container for point data. */
   vtkVertexGlyphFilter * PointsToVertexes; /*!< Filter to produce vertexes for all points. */
   vtkPolyData * CloudVertexes; /*!< Container for colored point data. */